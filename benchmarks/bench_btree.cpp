@@ -0,0 +1,273 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - B+tree Benchmarks                                                ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <benchmark/benchmark.h>
+
+#include "internal/storage/btree.hpp"
+#include "internal/storage/index_sorter.hpp"
+#include "internal/storage/buffer_pool.hpp"
+#include "internal/storage/disk_manager.hpp"
+#include "internal/storage/wal.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace datyredb::storage;
+
+// ==============================================================================
+// Масштабирование по потокам: lookups/s и inserts/s
+// ==============================================================================
+//
+// Все потоки работают с одним деревом (создаётся потоком 0 до барьера в
+// начале цикла). Дерево целиком резидентно, WAL без fsync — измеряется
+// синхронизация узлов, а не I/O.
+
+namespace {
+
+constexpr std::size_t kPoolSize = 16384;
+constexpr std::size_t kPreloaded = 500000;
+
+/// 8 байт big-endian: порядок ключей совпадает с порядком чисел
+std::string key_of(uint64_t n) {
+    std::string key(sizeof(n), '\0');
+    for (std::size_t i = 0; i < sizeof(n); ++i) {
+        key[i] = static_cast<char>(n >> (8 * (sizeof(n) - 1 - i)));
+    }
+    return key;
+}
+
+RecordId rid_of(uint64_t n) {
+    return RecordId{static_cast<PageId>(n >> 16), static_cast<uint16_t>(n & 0xFFFF)};
+}
+
+struct SharedTree {
+    std::filesystem::path dir;
+    std::shared_ptr<CheckpointMetrics> metrics;
+    std::shared_ptr<DiskManager> disk_manager;
+    std::shared_ptr<WriteAheadLog> wal;
+    std::shared_ptr<BufferPool> pool;
+    std::unique_ptr<BTree> tree;
+    std::atomic<TxnId> next_txn{1};
+};
+
+SharedTree g_tree;
+
+/// Дерево с kPreloaded чётными ключами
+void setup_tree() {
+    g_tree.dir = std::filesystem::temp_directory_path() / "datyredb_bench_btree";
+    std::filesystem::remove_all(g_tree.dir);
+    
+    SyncConfig sync;
+    sync.policy = SyncPolicy::None;
+    g_tree.metrics = std::make_shared<CheckpointMetrics>();
+    g_tree.disk_manager = std::make_shared<DiskManager>(g_tree.dir / "data");
+    g_tree.disk_manager->initialize();
+    g_tree.wal = std::make_shared<WriteAheadLog>(
+        g_tree.dir / "wal", 64 * 1024 * 1024, g_tree.metrics, nullptr, sync);
+    g_tree.wal->initialize();
+    g_tree.pool = std::make_shared<BufferPool>(kPoolSize, g_tree.disk_manager, g_tree.metrics,
+                                               BufferPoolConfig{}, g_tree.wal);
+    
+    TxnContext txn;
+    txn.txn_id = g_tree.next_txn++;
+    PageId root = BTree::create(*g_tree.pool, *g_tree.wal, txn);
+    g_tree.tree = std::make_unique<BTree>(g_tree.pool, g_tree.wal, root);
+    
+    uint64_t next = 0;
+    g_tree.tree->bulk_load(txn, [&](IndexEntry& entry) {
+        if (next == kPreloaded) {
+            return false;
+        }
+        entry.key = key_of(next * 2);
+        entry.rid = rid_of(next);
+        ++next;
+        return true;
+    });
+}
+
+void teardown_tree() {
+    g_tree.tree.reset();
+    g_tree.pool.reset();
+    g_tree.wal->shutdown();
+    g_tree.disk_manager->shutdown();
+    g_tree.wal.reset();
+    g_tree.disk_manager.reset();
+    std::filesystem::remove_all(g_tree.dir);
+}
+
+} // namespace
+
+static void BM_BTreeLookupConcurrent(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        setup_tree();
+    }
+    
+    // Разные стартовые точки, шаг взаимно простой с числом ключей
+    uint64_t idx = static_cast<uint64_t>(state.thread_index()) * 7919;
+    for (auto _ : state) {
+        auto rids = g_tree.tree->lookup(key_of((idx % kPreloaded) * 2));
+        benchmark::DoNotOptimize(rids);
+        idx += 31;
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    
+    if (state.thread_index() == 0) {
+        teardown_tree();
+    }
+}
+BENCHMARK(BM_BTreeLookupConcurrent)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+static void BM_BTreeInsertConcurrent(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        setup_tree();
+    }
+    
+    // Нечётные ключи, свои у каждого потока: вставки расходятся по всему
+    // дереву и делят листья
+    TxnContext txn;
+    txn.txn_id = g_tree.next_txn++;
+    auto threads = static_cast<uint64_t>(state.threads());
+    uint64_t n = static_cast<uint64_t>(state.thread_index());
+    for (auto _ : state) {
+        uint64_t spread = (n * 2654435761ULL) % (kPreloaded * 2);
+        g_tree.tree->insert(txn, key_of(spread | 1), rid_of(n));
+        txn.undo.clear();
+        n += threads;
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    
+    if (state.thread_index() == 0) {
+        teardown_tree();
+    }
+}
+BENCHMARK(BM_BTreeInsertConcurrent)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+// ==============================================================================
+// Построение индекса: вставками по одной против сортировки и bulk load'а
+// ==============================================================================
+//
+// Ключи приходят в случайном порядке, как из heap file'а. Bulk: внешняя
+// сортировка в 1/16 pool'а (со spill'ом) и загрузка снизу вверх с fill
+// factor 0.9.
+
+namespace {
+
+struct BuildStack {
+    explicit BuildStack(const std::filesystem::path& path) : dir(path) {
+        std::filesystem::remove_all(dir);
+        SyncConfig sync;
+        sync.policy = SyncPolicy::None;
+        metrics = std::make_shared<CheckpointMetrics>();
+        disk_manager = std::make_shared<DiskManager>(dir / "data");
+        disk_manager->initialize();
+        wal = std::make_shared<WriteAheadLog>(dir / "wal", 64 * 1024 * 1024, metrics, nullptr, sync);
+        wal->initialize();
+        pool = std::make_shared<BufferPool>(kPoolSize / 4, disk_manager, metrics,
+                                            BufferPoolConfig{}, wal);
+    }
+    
+    ~BuildStack() {
+        pool.reset();
+        wal->shutdown();
+        disk_manager->shutdown();
+        std::filesystem::remove_all(dir);
+    }
+    
+    std::filesystem::path dir;
+    std::shared_ptr<CheckpointMetrics> metrics;
+    std::shared_ptr<DiskManager> disk_manager;
+    std::shared_ptr<WriteAheadLog> wal;
+    std::shared_ptr<BufferPool> pool;
+};
+
+std::vector<uint64_t> shuffled_keys(std::size_t count) {
+    std::vector<uint64_t> keys(count);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(42));
+    return keys;
+}
+
+} // namespace
+
+static void BM_BTreeBuildByInserts(benchmark::State& state) {
+    auto keys = shuffled_keys(static_cast<std::size_t>(state.range(0)));
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto stack = std::make_unique<BuildStack>(
+            std::filesystem::temp_directory_path() / "datyredb_bench_btree_build");
+        TxnContext txn;
+        txn.txn_id = 1;
+        PageId root = BTree::create(*stack->pool, *stack->wal, txn);
+        BTree tree(stack->pool, stack->wal, root);
+        state.ResumeTiming();
+        
+        for (uint64_t key : keys) {
+            tree.insert(txn, key_of(key), rid_of(key));
+            txn.undo.clear();
+        }
+        
+        state.PauseTiming();
+        state.counters["wal_mb"] = static_cast<double>(stack->wal->current_lsn()) / (1024 * 1024);
+        state.counters["pages"] = static_cast<double>(txn.allocated.size());
+        stack.reset();
+        state.ResumeTiming();
+    }
+    
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BTreeBuildByInserts)
+    ->Arg(200000)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_BTreeBuildBulk(benchmark::State& state) {
+    auto keys = shuffled_keys(static_cast<std::size_t>(state.range(0)));
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto stack = std::make_unique<BuildStack>(
+            std::filesystem::temp_directory_path() / "datyredb_bench_btree_build");
+        TxnContext txn;
+        txn.txn_id = 1;
+        PageId root = BTree::create(*stack->pool, *stack->wal, txn);
+        BTree tree(stack->pool, stack->wal, root);
+        state.ResumeTiming();
+        
+        std::size_t runs = 0;
+        {
+            IndexSorter sorter(*stack->pool, stack->pool->capacity() / 16, stack->dir);
+            for (uint64_t key : keys) {
+                sorter.add(key_of(key), rid_of(key));
+            }
+            sorter.finish();
+            tree.bulk_load(txn, [&](IndexEntry& entry) { return sorter.next(entry); });
+            runs = sorter.spilled_runs();
+        }
+        
+        state.PauseTiming();
+        state.counters["wal_mb"] = static_cast<double>(stack->wal->current_lsn()) / (1024 * 1024);
+        state.counters["pages"] = static_cast<double>(txn.allocated.size());
+        state.counters["runs"] = static_cast<double>(runs);
+        stack.reset();
+        state.ResumeTiming();
+    }
+    
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BTreeBuildBulk)
+    ->Arg(200000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -9,6 +9,7 @@
 
 #include <filesystem>
 #include <memory>
+#include <vector>
 
 using namespace datyredb::storage;
 
@@ -21,7 +22,7 @@ public:
         
         metrics_ = std::make_shared<CheckpointMetrics>();
         disk_manager_ = std::make_shared<DiskManager>(test_dir_);
-        disk_manager_->open();
+        disk_manager_->initialize();
         
         buffer_pool_ = std::make_shared<BufferPool>(
             static_cast<std::size_t>(state.range(0)),
@@ -32,7 +33,7 @@ public:
     
     void TearDown(benchmark::State&) override {
         buffer_pool_.reset();
-        disk_manager_->close();
+        disk_manager_->shutdown();
         disk_manager_.reset();
         std::filesystem::remove_all(test_dir_);
     }
@@ -46,9 +47,10 @@ protected:
 
 BENCHMARK_DEFINE_F(BufferPoolBenchmark, NewPage)(benchmark::State& state) {
     for (auto _ : state) {
-        auto result = buffer_pool_->new_page();
-        if (result) {
-            buffer_pool_->unpin_page((*result)->id(), false);
+        PageId page_id;
+        Page* page = buffer_pool_->new_page(&page_id);
+        if (page) {
+            buffer_pool_->unpin_page(page_id, false);
         }
     }
 }
@@ -58,10 +60,11 @@ BENCHMARK_DEFINE_F(BufferPoolBenchmark, FetchPage)(benchmark::State& state) {
     // Pre-create pages
     std::vector<PageId> page_ids;
     for (int i = 0; i < 100; ++i) {
-        auto result = buffer_pool_->new_page();
-        if (result) {
-            page_ids.push_back((*result)->id());
-            buffer_pool_->unpin_page((*result)->id(), true);
+        PageId page_id;
+        Page* page = buffer_pool_->new_page(&page_id);
+        if (page) {
+            page_ids.push_back(page_id);
+            buffer_pool_->unpin_page(page_id, true);
         }
     }
     buffer_pool_->flush_pages(page_ids);
@@ -69,8 +72,8 @@ BENCHMARK_DEFINE_F(BufferPoolBenchmark, FetchPage)(benchmark::State& state) {
     std::size_t idx = 0;
     for (auto _ : state) {
         PageId page_id = page_ids[idx % page_ids.size()];
-        auto result = buffer_pool_->fetch_page(page_id);
-        if (result) {
+        Page* page = buffer_pool_->fetch_page(page_id);
+        if (page) {
             buffer_pool_->unpin_page(page_id, false);
         }
         ++idx;
@@ -78,4 +81,289 @@ BENCHMARK_DEFINE_F(BufferPoolBenchmark, FetchPage)(benchmark::State& state) {
 }
 BENCHMARK_REGISTER_F(BufferPoolBenchmark, FetchPage)->Arg(1000);
 
+// ==============================================================================
+// Concurrent FetchPage — масштабирование по потокам
+// ==============================================================================
+//
+// Все потоки работают с одним pool (создаётся потоком 0 до барьера в начале
+// цикла). Рабочий набор целиком резидентен, поэтому измеряется только
+// стоимость hit'а: lookup + pin + unpin.
+
+namespace {
+
+struct SharedPool {
+    std::filesystem::path dir;
+    std::shared_ptr<CheckpointMetrics> metrics;
+    std::shared_ptr<DiskManager> disk_manager;
+    std::shared_ptr<BufferPool> pool;
+    std::vector<PageId> page_ids;
+};
+
+SharedPool g_shared;
+
+} // namespace
+
+static void BM_FetchPageConcurrent(benchmark::State& state) {
+    constexpr std::size_t kPoolSize = 4096;
+    constexpr std::size_t kWorkingSet = 2048;
+    
+    if (state.thread_index() == 0) {
+        g_shared.dir = std::filesystem::temp_directory_path() / "datyredb_bench_mt";
+        std::filesystem::remove_all(g_shared.dir);
+        std::filesystem::create_directories(g_shared.dir);
+        
+        BufferPoolConfig config;
+        config.partition_count = static_cast<std::size_t>(state.range(0));
+        
+        g_shared.metrics = std::make_shared<CheckpointMetrics>();
+        g_shared.disk_manager = std::make_shared<DiskManager>(g_shared.dir);
+        g_shared.disk_manager->initialize();
+        g_shared.pool = std::make_shared<BufferPool>(
+            kPoolSize, g_shared.disk_manager, g_shared.metrics, config);
+        
+        g_shared.page_ids.clear();
+        for (std::size_t i = 0; i < kWorkingSet; ++i) {
+            PageId page_id;
+            Page* page = g_shared.pool->new_page(&page_id);
+            if (page) {
+                g_shared.page_ids.push_back(page_id);
+                g_shared.pool->unpin_page(page_id, false);
+            }
+        }
+    }
+    
+    // Разные стартовые точки, шаг взаимно простой с размером набора
+    std::size_t idx = static_cast<std::size_t>(state.thread_index()) * 7919;
+    for (auto _ : state) {
+        const auto& ids = g_shared.page_ids;
+        PageId page_id = ids[idx % ids.size()];
+        Page* page = g_shared.pool->fetch_page(page_id);
+        if (page) {
+            g_shared.pool->unpin_page(page_id, false);
+        }
+        idx += 31;
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    
+    if (state.thread_index() == 0) {
+        g_shared.pool.reset();
+        g_shared.disk_manager->shutdown();
+        g_shared.disk_manager.reset();
+        std::filesystem::remove_all(g_shared.dir);
+    }
+}
+// Arg — количество партиций: 1 (эквивалент глобального latch) против 64
+BENCHMARK(BM_FetchPageConcurrent)
+    ->Arg(1)->Arg(64)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+// ==============================================================================
+// Dirty eviction — запись victim'а и latch партиции
+// ==============================================================================
+//
+// Рабочий набор в 16 раз больше pool'а, каждое обращение пачкает страницу:
+// почти каждый miss вытесняет dirty frame (double-write + fdatasync).
+// Одна партиция — все потоки делят один latch; запись victim'а идёт без
+// него, поэтому fdatasync'и потоков перекрываются.
+
+static void BM_DirtyEvictionConcurrent(benchmark::State& state) {
+    constexpr std::size_t kPoolSize = 64;
+    constexpr std::size_t kWorkingSet = kPoolSize * 16;
+    
+    if (state.thread_index() == 0) {
+        g_shared.dir = std::filesystem::temp_directory_path() / "datyredb_bench_evict";
+        std::filesystem::remove_all(g_shared.dir);
+        std::filesystem::create_directories(g_shared.dir);
+        
+        BufferPoolConfig config;
+        config.partition_count = 1;
+        
+        g_shared.metrics = std::make_shared<CheckpointMetrics>();
+        g_shared.disk_manager = std::make_shared<DiskManager>(g_shared.dir);
+        g_shared.disk_manager->initialize();
+        g_shared.pool = std::make_shared<BufferPool>(
+            kPoolSize, g_shared.disk_manager, g_shared.metrics, config);
+        
+        g_shared.page_ids.clear();
+        for (std::size_t i = 0; i < kWorkingSet; ++i) {
+            PageId page_id;
+            Page* page = g_shared.pool->new_page(&page_id);
+            if (page) {
+                g_shared.page_ids.push_back(page_id);
+                g_shared.pool->unpin_page(page_id, false);
+            }
+        }
+    }
+    
+    std::size_t idx = static_cast<std::size_t>(state.thread_index()) * 7919;
+    for (auto _ : state) {
+        const auto& ids = g_shared.page_ids;
+        PageId page_id = ids[idx % ids.size()];
+        Page* page = g_shared.pool->fetch_page(page_id);
+        if (page) {
+            page->payload()[0] = static_cast<char>(idx);
+            g_shared.pool->unpin_page(page_id, true);
+        }
+        idx += 31;
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    
+    if (state.thread_index() == 0) {
+        state.counters["evictions"] = static_cast<double>(g_shared.pool->metrics().evictions);
+        g_shared.pool.reset();
+        g_shared.disk_manager->shutdown();
+        g_shared.disk_manager.reset();
+        std::filesystem::remove_all(g_shared.dir);
+    }
+}
+BENCHMARK(BM_DirtyEvictionConcurrent)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+// ==============================================================================
+// Eviction policies — смешанный trace: point lookups + scan'ы
+// ==============================================================================
+//
+// Точечные обращения в горячий набор (1/4 pool); каждые 10 000 обращений —
+// последовательный scan холодного диапазона длиной в pool.
+// Clock-sweep теряет горячий набор на каждом scan'е; LRU-K и ARC — нет.
+
+static void BM_EvictionPolicyTrace(benchmark::State& state) {
+    constexpr std::size_t kPoolSize = 1024;
+    constexpr std::size_t kHotPages = kPoolSize / 4;
+    constexpr std::size_t kTotalPages = kPoolSize * 8;
+    
+    auto policy = static_cast<EvictionPolicyType>(state.range(0));
+    state.SetLabel(eviction_policy_name(policy));
+    
+    auto dir = std::filesystem::temp_directory_path() / "datyredb_bench_policy";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    
+    BufferPoolConfig config;
+    config.partition_count = 1;
+    config.eviction_policy = policy;
+    
+    auto metrics = std::make_shared<CheckpointMetrics>();
+    auto disk_manager = std::make_shared<DiskManager>(dir);
+    disk_manager->initialize();
+    auto pool = std::make_shared<BufferPool>(kPoolSize, disk_manager, metrics, config);
+    
+    std::vector<PageId> page_ids;
+    for (std::size_t i = 0; i < kTotalPages; ++i) {
+        PageId page_id;
+        Page* page = pool->new_page(&page_id);
+        if (page) {
+            page_ids.push_back(page_id);
+            pool->unpin_page(page_id, true);
+        }
+    }
+    
+    auto access = [&](PageId page_id) {
+        Page* page = pool->fetch_page(page_id);
+        if (page) {
+            pool->unpin_page(page_id, false);
+        }
+    };
+    
+    auto before = pool->metrics();
+    uint64_t rng = 42;
+    std::size_t scan_pos = kHotPages;
+    std::size_t ops = 0;
+    
+    for (auto _ : state) {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        access(page_ids[(rng >> 33) % kHotPages]);
+        
+        if (++ops % 10000 == 0) {
+            for (std::size_t i = 0; i < kPoolSize; ++i) {
+                access(page_ids[scan_pos]);
+                scan_pos = scan_pos + 1 < page_ids.size() ? scan_pos + 1 : kHotPages;
+            }
+        }
+    }
+    
+    auto after = pool->metrics();
+    BufferPoolMetrics delta;
+    delta.hits = after.hits - before.hits;
+    delta.misses = after.misses - before.misses;
+    state.counters["hit_ratio"] = delta.hit_ratio();
+    state.counters["evictions"] = static_cast<double>(after.evictions - before.evictions);
+    
+    pool.reset();
+    disk_manager->shutdown();
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_EvictionPolicyTrace)
+    ->Arg(static_cast<int>(EvictionPolicyType::ClockSweep))
+    ->Arg(static_cast<int>(EvictionPolicyType::LruK))
+    ->Arg(static_cast<int>(EvictionPolicyType::Arc))
+    ->Iterations(200000);
+
+// ==============================================================================
+// Read-ahead — холодный последовательный скан
+// ==============================================================================
+
+static void BM_ColdSequentialScan(benchmark::State& state) {
+    constexpr std::size_t kPages = 4096;
+    constexpr std::size_t kPoolSize = 1024;
+    
+    auto dir = std::filesystem::temp_directory_path() / "datyredb_bench_scan";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    
+    auto metrics = std::make_shared<CheckpointMetrics>();
+    auto disk_manager = std::make_shared<DiskManager>(dir);
+    disk_manager->initialize();
+    
+    std::vector<PageId> page_ids;
+    {
+        auto writer = std::make_shared<BufferPool>(kPoolSize, disk_manager, metrics);
+        for (std::size_t i = 0; i < kPages; ++i) {
+            PageId page_id;
+            Page* page = writer->new_page(&page_id);
+            if (page) {
+                page_ids.push_back(page_id);
+                writer->unpin_page(page_id, true);
+            }
+        }
+    }
+    
+    BufferPoolConfig config;
+    config.read_ahead = state.range(0) != 0;
+    config.read_ahead_window = 64;
+    
+    uint64_t checksum = 0;
+    for (auto _ : state) {
+        // Каждый проход — с пустым pool
+        state.PauseTiming();
+        auto pool = std::make_shared<BufferPool>(kPoolSize, disk_manager, metrics, config);
+        state.ResumeTiming();
+        
+        for (PageId page_id : page_ids) {
+            Page* page = pool->fetch_page(page_id);
+            if (page) {
+                checksum += static_cast<unsigned char>(page->payload()[0]);
+                pool->unpin_page(page_id, false);
+            }
+        }
+        
+        state.PauseTiming();
+        state.counters["misses"] = static_cast<double>(pool->metrics().misses);
+        pool.reset();
+        state.ResumeTiming();
+    }
+    benchmark::DoNotOptimize(checksum);
+    
+    state.SetBytesProcessed(state.iterations() * page_ids.size() * PAGE_SIZE);
+    state.SetLabel(config.read_ahead ? "read_ahead" : "no_read_ahead");
+    
+    disk_manager->shutdown();
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_ColdSequentialScan)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
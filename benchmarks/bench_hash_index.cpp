@@ -0,0 +1,107 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - Hash Index Benchmarks                                            ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <benchmark/benchmark.h>
+
+#include "internal/storage/hash_index.hpp"
+
+#include <memory>
+#include <string>
+
+using namespace datyredb::storage;
+
+namespace {
+
+constexpr std::size_t kPreloaded = 500000;
+
+std::string key_of(uint64_t n) {
+    return std::to_string(n);
+}
+
+RecordId rid_of(uint64_t n) {
+    return RecordId{static_cast<PageId>(n >> 16), static_cast<uint16_t>(n & 0xFFFF)};
+}
+
+std::unique_ptr<HashIndex> g_index;
+
+/// Индекс с kPreloaded ключами, построенный без переноса
+void setup_index() {
+    g_index = std::make_unique<HashIndex>();
+    g_index->reserve(kPreloaded);
+    for (uint64_t n = 0; n < kPreloaded; ++n) {
+        g_index->insert(key_of(n), rid_of(n));
+    }
+}
+
+} // namespace
+
+// ==============================================================================
+// Точечный поиск: lookups/s по потокам
+// ==============================================================================
+//
+// Сравнимо с BM_BTreeLookupConcurrent (bench_btree): те же 500k ключей,
+// читатели без блокировок.
+
+static void BM_HashIndexLookupConcurrent(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        setup_index();
+    }
+    
+    uint64_t idx = static_cast<uint64_t>(state.thread_index()) * 7919;
+    for (auto _ : state) {
+        auto rids = g_index->lookup(key_of(idx % kPreloaded));
+        benchmark::DoNotOptimize(rids);
+        idx += 31;
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    
+    if (state.thread_index() == 0) {
+        g_index.reset();
+    }
+}
+BENCHMARK(BM_HashIndexLookupConcurrent)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+// ==============================================================================
+// Поиск во время роста: поток 0 вставляет, остальные читают
+// ==============================================================================
+//
+// Индекс растёт от 64 корзин, перенос идёт постоянно; задержка читателей
+// не должна зависеть от него.
+
+static void BM_HashIndexLookupDuringResize(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        g_index = std::make_unique<HashIndex>();
+        for (uint64_t n = 0; n < 1024; ++n) {
+            g_index->insert(key_of(n), rid_of(n));
+        }
+    }
+    
+    uint64_t n = 1024;
+    uint64_t idx = static_cast<uint64_t>(state.thread_index());
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            g_index->insert(key_of(n), rid_of(n));
+            ++n;
+        } else {
+            auto rids = g_index->lookup(key_of(idx % 1024));
+            benchmark::DoNotOptimize(rids);
+            idx += 31;
+        }
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    
+    if (state.thread_index() == 0) {
+        state.counters["buckets"] = static_cast<double>(g_index->bucket_count());
+        g_index.reset();
+    }
+}
+BENCHMARK(BM_HashIndexLookupDuringResize)
+    ->ThreadRange(2, 16)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,290 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - I/O Backend Benchmarks                                           ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <benchmark/benchmark.h>
+
+#include "internal/storage/disk_manager.hpp"
+#include "internal/storage/wal.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+using namespace datyredb::storage;
+
+namespace {
+
+constexpr std::size_t kFilePages = 8192;
+constexpr std::size_t kBatchPages = 256;
+
+/// Пакет из страниц через одну: каждая страница — отдельная серия,
+/// как у checkpoint'а с разреженными dirty pages
+class ScatteredBatch {
+public:
+    explicit ScatteredBatch(std::size_t batch_index)
+        : pages_(kBatchPages)
+    {
+        std::size_t first = (batch_index * kBatchPages * 2) % kFilePages;
+        for (std::size_t i = 0; i < kBatchPages; ++i) {
+            auto page_id = static_cast<PageId>(first + i * 2);
+            pages_[i].set_page_id(page_id);
+            pages_[i].payload()[0] = static_cast<char>(i);
+            batch_.push_back({page_id, &pages_[i]});
+        }
+    }
+    
+    std::vector<PageIo>& batch() { return batch_; }
+
+private:
+    std::vector<Page> pages_;
+    std::vector<PageIo> batch_;
+};
+
+std::shared_ptr<DiskManager> open_disk_manager(const std::filesystem::path& dir,
+                                               IoBackendType backend,
+                                               bool double_write = true) {
+    std::filesystem::remove_all(dir);
+    
+    IoConfig config;
+    config.backend = backend;
+    config.double_write = double_write;
+    auto disk_manager = std::make_shared<DiskManager>(dir, config);
+    disk_manager->initialize();
+    
+    while (disk_manager->page_count() < kFilePages) {
+        disk_manager->allocate_page();
+    }
+    return disk_manager;
+}
+
+/// Страниц файла в page cache ядра (mincore по отображению файла)
+std::size_t page_cache_pages(const std::filesystem::path& file) {
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    
+    std::size_t size = std::filesystem::file_size(file);
+    std::size_t resident = 0;
+    void* map = size > 0 ? ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (map != MAP_FAILED) {
+        long os_page = ::sysconf(_SC_PAGESIZE);
+        std::vector<unsigned char> vec((size + os_page - 1) / os_page);
+        if (::mincore(map, size, vec.data()) == 0) {
+            for (unsigned char v : vec) {
+                resident += v & 1;
+            }
+        }
+        ::munmap(map, size);
+    }
+    ::close(fd);
+    return resident;
+}
+
+/// Выбросить файл из page cache
+void drop_page_cache(const std::filesystem::path& file) {
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+}
+
+void set_backend_label(benchmark::State& state, const DiskManager& disk_manager) {
+    auto backend = disk_manager.io_backend();
+    state.SetLabel(io_backend_name(backend ? backend->type() : IoBackendType::Sync));
+}
+
+} // namespace
+
+// ==============================================================================
+// Пакетная запись и чтение страниц
+// ==============================================================================
+
+static void BM_ScatteredWritePages(benchmark::State& state) {
+    auto backend = static_cast<IoBackendType>(state.range(0));
+    auto dir = std::filesystem::temp_directory_path() / "datyredb_bench_io";
+    auto disk_manager = open_disk_manager(dir, backend);
+    set_backend_label(state, *disk_manager);
+    
+    std::size_t batch_index = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        ScatteredBatch batch(batch_index++);
+        state.ResumeTiming();
+        
+        benchmark::DoNotOptimize(disk_manager->write_pages(batch.batch()));
+    }
+    
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kBatchPages));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * kBatchPages * PAGE_SIZE));
+    
+    disk_manager.reset();
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_ScatteredWritePages)
+    ->Arg(static_cast<int>(IoBackendType::Sync))
+    ->Arg(static_cast<int>(IoBackendType::ThreadPool))
+    ->Arg(static_cast<int>(IoBackendType::IoUring))
+    ->Unit(benchmark::kMicrosecond);
+
+/// Пакет checkpoint'а с последующим fdatasync: Arg 0 — без double-write,
+/// Arg 1 — через doublewrite.db (лишний последовательный pwritev и
+/// fdatasync на пакет)
+static void BM_CheckpointBatchDoubleWrite(benchmark::State& state) {
+    bool double_write = state.range(0) != 0;
+    auto dir = std::filesystem::temp_directory_path() / "datyredb_bench_io";
+    auto disk_manager = open_disk_manager(dir, IoBackendType::Sync, double_write);
+    state.SetLabel(disk_manager->double_write() ? "double_write" : "in_place");
+    
+    std::size_t batch_index = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        ScatteredBatch batch(batch_index++);
+        state.ResumeTiming();
+        
+        benchmark::DoNotOptimize(disk_manager->write_pages(batch.batch()));
+        disk_manager->sync();
+    }
+    
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kBatchPages));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * kBatchPages * PAGE_SIZE));
+    
+    disk_manager.reset();
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_CheckpointBatchDoubleWrite)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+static void BM_ScatteredReadPages(benchmark::State& state) {
+    auto backend = static_cast<IoBackendType>(state.range(0));
+    auto dir = std::filesystem::temp_directory_path() / "datyredb_bench_io";
+    auto disk_manager = open_disk_manager(dir, backend);
+    set_backend_label(state, *disk_manager);
+    
+    // Заполняем файл валидными страницами (checksum)
+    for (std::size_t i = 0; i < kFilePages / (kBatchPages * 2); ++i) {
+        ScatteredBatch batch(i);
+        disk_manager->write_pages(batch.batch());
+    }
+    
+    std::size_t batch_index = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        ScatteredBatch batch(batch_index++);
+        state.ResumeTiming();
+        
+        benchmark::DoNotOptimize(disk_manager->read_pages(batch.batch()));
+    }
+    
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kBatchPages));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * kBatchPages * PAGE_SIZE));
+    
+    disk_manager.reset();
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_ScatteredReadPages)
+    ->Arg(static_cast<int>(IoBackendType::Sync))
+    ->Arg(static_cast<int>(IoBackendType::ThreadPool))
+    ->Arg(static_cast<int>(IoBackendType::IoUring))
+    ->Unit(benchmark::kMicrosecond);
+
+// ==============================================================================
+// O_DIRECT: двойное кэширование
+// ==============================================================================
+
+/// Запись и повторное чтение всего файла; page_cache_mb — сколько файла
+/// осело в page cache ядра поверх копий в памяти процесса
+static void BM_DirectIoFootprint(benchmark::State& state) {
+    auto dir = std::filesystem::temp_directory_path() / "datyredb_bench_direct";
+    std::filesystem::remove_all(dir);
+    
+    IoConfig config;
+    config.direct_io = state.range(0) != 0;
+    auto disk_manager = std::make_shared<DiskManager>(dir, config);
+    disk_manager->initialize();
+    while (disk_manager->page_count() < kFilePages) {
+        disk_manager->allocate_page();
+    }
+    state.SetLabel(disk_manager->direct_io() ? "direct" : "buffered");
+    
+    std::size_t cached = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        drop_page_cache(dir / "data.db");
+        state.ResumeTiming();
+        
+        for (std::size_t i = 0; i < kFilePages / kBatchPages; ++i) {
+            std::vector<Page> pages(kBatchPages);
+            std::vector<PageIo> batch;
+            for (std::size_t j = 0; j < kBatchPages; ++j) {
+                auto page_id = static_cast<PageId>(i * kBatchPages + j);
+                pages[j].set_page_id(page_id);
+                batch.push_back({page_id, &pages[j]});
+            }
+            disk_manager->write_pages(batch);
+            benchmark::DoNotOptimize(disk_manager->read_pages(batch));
+        }
+        
+        state.PauseTiming();
+        cached = page_cache_pages(dir / "data.db");
+        state.ResumeTiming();
+    }
+    
+    state.counters["page_cache_mb"] =
+        static_cast<double>(cached * ::sysconf(_SC_PAGESIZE)) / (1024 * 1024);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * kFilePages * PAGE_SIZE * 2));
+    
+    disk_manager.reset();
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_DirectIoFootprint)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// ==============================================================================
+// WAL
+// ==============================================================================
+
+static void BM_WalAppendForce(benchmark::State& state) {
+    auto backend_type = static_cast<IoBackendType>(state.range(0));
+    auto dir = std::filesystem::temp_directory_path() / "datyredb_bench_io_wal";
+    std::filesystem::remove_all(dir);
+    
+    IoConfig config;
+    config.backend = backend_type;
+    std::shared_ptr<IoBackend> backend = make_io_backend(config);
+    state.SetLabel(io_backend_name(backend ? backend->type() : IoBackendType::Sync));
+    
+    auto metrics = std::make_shared<CheckpointMetrics>();
+    auto wal = std::make_unique<WriteAheadLog>(dir, 256 * 1024 * 1024, metrics, backend);
+    wal->initialize();
+    
+    LogRecord rec;
+    rec.type = LogRecordType::UPDATE;
+    rec.data.assign(200, 'w');
+    
+    // 1000 записей на force — несколько WRITE_CHUNK блоков в полёте
+    for (auto _ : state) {
+        Lsn last = INVALID_LSN;
+        for (int i = 0; i < 1000; ++i) {
+            last = wal->append(rec);
+        }
+        wal->force(last);
+    }
+    
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * 1000));
+    
+    wal.reset();
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_WalAppendForce)
+    ->Arg(static_cast<int>(IoBackendType::Sync))
+    ->Arg(static_cast<int>(IoBackendType::ThreadPool))
+    ->Arg(static_cast<int>(IoBackendType::IoUring))
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
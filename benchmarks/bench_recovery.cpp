@@ -0,0 +1,240 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - Recovery Benchmarks                                              ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <benchmark/benchmark.h>
+
+#include "internal/storage/recovery.hpp"
+#include "internal/storage/checkpoint.hpp"
+#include "internal/storage/buffer_pool.hpp"
+#include "internal/storage/disk_manager.hpp"
+#include "internal/storage/wal.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>
+
+using namespace datyredb::storage;
+
+namespace {
+
+constexpr std::size_t kSegmentSize = 64 * 1024 * 1024;
+constexpr PageId kPages = 32768;            // 128 MB данных
+constexpr uint16_t kImageSize = 64;
+constexpr int kUpdatesPerTxn = 8;
+
+std::filesystem::path bench_dir() {
+    return std::filesystem::temp_directory_path() / "datyredb_bench_recovery";
+}
+
+/// Сгенерировать WAL из закоммиченных транзакций размером ~wal_mb MB.
+/// Лог генерируется один раз на размер и переиспользуется итерациями
+std::filesystem::path generate_wal(std::size_t wal_mb) {
+    static std::map<std::size_t, std::filesystem::path> generated;
+    if (auto it = generated.find(wal_mb); it != generated.end()) {
+        return it->second;
+    }
+    
+    auto dir = bench_dir() / ("wal_" + std::to_string(wal_mb));
+    std::filesystem::remove_all(dir);
+    
+    SyncConfig sync;
+    sync.policy = SyncPolicy::None;
+    auto wal = std::make_unique<WriteAheadLog>(
+        dir, kSegmentSize, std::make_shared<CheckpointMetrics>(), nullptr, sync);
+    wal->initialize();
+    
+    std::mt19937 rng(42);
+    LogRecord update;
+    update.type = LogRecordType::UPDATE;
+    update.length = kImageSize;
+    update.data.assign(2 * kImageSize, 'x');
+    
+    uint64_t target = static_cast<uint64_t>(wal_mb) * 1024 * 1024;
+    for (TxnId txn = 1; wal->current_lsn() < target; ++txn) {
+        LogRecord begin;
+        begin.type = LogRecordType::TXN_BEGIN;
+        begin.txn_id = txn;
+        Lsn prev = wal->append(begin);
+        
+        for (int i = 0; i < kUpdatesPerTxn; ++i) {
+            update.txn_id = txn;
+            update.page_id = static_cast<PageId>(rng() % kPages);
+            update.offset = static_cast<uint16_t>((rng() % 32) * kImageSize);
+            update.prev_lsn = prev;
+            update.data[kImageSize] = static_cast<char>(txn);
+            prev = wal->append(update);
+        }
+        
+        LogRecord commit;
+        commit.type = LogRecordType::TXN_COMMIT;
+        commit.txn_id = txn;
+        commit.prev_lsn = prev;
+        wal->append(commit);
+    }
+    wal->shutdown();
+    
+    generated[wal_mb] = dir;
+    return dir;
+}
+
+} // namespace
+
+// ==============================================================================
+// Startup после сбоя: analysis + redo по сгенерированному WAL
+// ==============================================================================
+
+static void BM_RecoveryRedo(benchmark::State& state) {
+    auto wal_dir = generate_wal(static_cast<std::size_t>(state.range(0)));
+    auto data_dir = bench_dir() / "data";
+    
+    RecoveryConfig config;
+    config.redo_threads = static_cast<std::size_t>(state.range(1));
+    
+    RecoveryStats stats;
+    for (auto _ : state) {
+        // Каждая итерация — с пустым файлом данных: redo применяет всё
+        state.PauseTiming();
+        std::filesystem::remove_all(data_dir);
+        auto metrics = std::make_shared<CheckpointMetrics>();
+        auto disk_manager = std::make_shared<DiskManager>(data_dir);
+        disk_manager->initialize();
+        auto wal = std::make_shared<WriteAheadLog>(wal_dir, kSegmentSize, metrics);
+        wal->initialize();
+        auto buffer_pool = std::make_shared<BufferPool>(kPages, disk_manager, metrics,
+                                                        BufferPoolConfig{}, wal);
+        state.ResumeTiming();
+        
+        RecoveryManager recovery(wal, buffer_pool, disk_manager, config);
+        if (!recovery.recover()) {
+            state.SkipWithError("recovery failed");
+            break;
+        }
+        stats = recovery.stats();
+        
+        state.PauseTiming();
+        buffer_pool.reset();
+        wal->shutdown();
+        disk_manager->shutdown();
+        state.ResumeTiming();
+    }
+    
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * stats.records_scanned));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * stats.end_lsn));
+    state.counters["records_redone"] = static_cast<double>(stats.records_redone);
+    state.counters["redo_threads"] = static_cast<double>(stats.redo_threads);
+}
+BENCHMARK(BM_RecoveryRedo)
+    ->ArgsProduct({{2048}, {1, 2, 4, 8}})
+    ->ArgNames({"wal_mb", "threads"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->Iterations(3);
+
+// ==============================================================================
+// Checkpoint под нагрузкой: хвост латентности транзакций
+// ==============================================================================
+
+/// Транзакции по одному UPDATE 8 байт в горячем наборе страниц, пока
+/// соседний поток делает checkpoint каждые 20 ms: Arg 0 — fuzzy
+/// (таблицы в END), Arg 1 — с записью всех dirty pages, как раньше
+/// делал каждый checkpoint. txn_p99_us и txn_max_us — влияние
+/// checkpoint'а на foreground
+static void BM_TxnLatencyDuringCheckpoint(benchmark::State& state) {
+    constexpr PageId kHotPages = 4096;
+    bool sharp = state.range(0) != 0;
+    auto dir = bench_dir() / "checkpoint";
+    std::filesystem::remove_all(dir);
+    
+    auto metrics = std::make_shared<CheckpointMetrics>();
+    auto disk_manager = std::make_shared<DiskManager>(dir);
+    disk_manager->initialize();
+    SyncConfig sync;
+    sync.policy = SyncPolicy::Group;
+    auto wal = std::make_shared<WriteAheadLog>(dir / "wal", kSegmentSize, metrics,
+                                               nullptr, sync);
+    wal->initialize();
+    auto buffer_pool = std::make_shared<BufferPool>(2 * kHotPages, disk_manager, metrics,
+                                                    BufferPoolConfig{}, wal);
+    for (PageId i = 0; i < kHotPages; ++i) {
+        disk_manager->allocate_page();
+    }
+    
+    auto checkpoint = std::make_unique<CheckpointManager>(CheckpointConfig{}, buffer_pool,
+                                                          wal, metrics);
+    std::atomic<bool> stop{false};
+    std::thread checkpointer([&] {
+        while (!stop.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            if (sharp) {
+                checkpoint->manual_checkpoint();
+            } else {
+                checkpoint->fuzzy_checkpoint();
+            }
+        }
+    });
+    
+    std::mt19937 rng(7);
+    LogRecord update;
+    update.type = LogRecordType::UPDATE;
+    update.length = sizeof(uint64_t);
+    update.data.assign(2 * sizeof(uint64_t), 0);
+    LogRecord commit;
+    commit.type = LogRecordType::TXN_COMMIT;
+    
+    LatencyHistogram latency;
+    TxnId txn = 1;
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+        
+        PageId page_id = static_cast<PageId>(rng() % kHotPages);
+        Page* page = buffer_pool->fetch_page(page_id);
+        if (!page) {
+            state.SkipWithError("fetch_page failed");
+            break;
+        }
+        update.txn_id = txn;
+        update.page_id = page_id;
+        update.offset = static_cast<uint16_t>((txn % 64) * sizeof(uint64_t));
+        std::memcpy(update.data.data() + sizeof(uint64_t), &txn, sizeof(txn));
+        Lsn lsn = wal->append(update);
+        std::memcpy(page->payload() + update.offset, &txn, sizeof(txn));
+        page->set_lsn(lsn);
+        buffer_pool->unpin_page(page_id, true);
+        
+        commit.txn_id = txn;
+        commit.prev_lsn = lsn;
+        wal->force(wal->append(commit));
+        ++txn;
+        
+        latency.record(std::chrono::steady_clock::now() - start);
+    }
+    
+    stop.store(true);
+    checkpointer.join();
+    
+    state.SetItemsProcessed(state.iterations());
+    state.counters["checkpoints"] = static_cast<double>(metrics->checkpoint_count.load());
+    state.counters["txn_p50_us"] = static_cast<double>(latency.percentile_us(0.5));
+    state.counters["txn_p99_us"] = static_cast<double>(latency.percentile_us(0.99));
+    state.counters["txn_max_us"] = static_cast<double>(latency.max_us.load());
+    
+    checkpoint.reset();
+    buffer_pool.reset();
+    wal->shutdown();
+    disk_manager->shutdown();
+    std::filesystem::remove_all(dir);
+}
+// Arg — 0: fuzzy checkpoint, 1: с записью всех dirty pages
+BENCHMARK(BM_TxnLatencyDuringCheckpoint)
+    ->Arg(0)
+    ->Arg(1)
+    ->MinTime(2.0)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,213 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - WAL Benchmarks                                                   ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <benchmark/benchmark.h>
+
+#include "internal/storage/wal.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+
+using namespace datyredb::storage;
+
+namespace {
+
+struct SharedWal {
+    std::filesystem::path dir;
+    std::shared_ptr<CheckpointMetrics> metrics;
+    std::unique_ptr<WriteAheadLog> wal;
+};
+
+SharedWal g_shared;
+std::atomic<uint64_t> g_commits{0};
+
+void open_shared_wal(SyncPolicy policy) {
+    g_shared.dir = std::filesystem::temp_directory_path() / "datyredb_bench_wal";
+    std::filesystem::remove_all(g_shared.dir);
+    
+    SyncConfig sync;
+    sync.policy = policy;
+    
+    g_shared.metrics = std::make_shared<CheckpointMetrics>();
+    g_shared.wal = std::make_unique<WriteAheadLog>(
+        g_shared.dir, 64 * 1024 * 1024, g_shared.metrics, nullptr, sync);
+    g_shared.wal->initialize();
+}
+
+void close_shared_wal() {
+    g_shared.wal.reset();
+    std::filesystem::remove_all(g_shared.dir);
+}
+
+} // namespace
+
+// ==============================================================================
+// Group commit: commit = append + force, N клиентов
+// ==============================================================================
+
+static void BM_CommitThroughput(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        open_shared_wal(static_cast<SyncPolicy>(state.range(0)));
+        g_commits.store(0);
+    }
+    
+    LogRecord record;
+    record.type = LogRecordType::TXN_COMMIT;
+    record.txn_id = static_cast<TxnId>(state.thread_index() + 1);
+    record.data.assign(64, 'c');
+    
+    for (auto _ : state) {
+        Lsn lsn = g_shared.wal->append(record);
+        g_shared.wal->force(lsn);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    g_commits.fetch_add(state.iterations());
+    
+    if (state.thread_index() == 0) {
+        const auto& latency = g_shared.wal->sync_latency();
+        uint64_t syncs = latency.count.load();
+        state.counters["syncs"] = static_cast<double>(syncs);
+        state.counters["sync_p50_us"] = static_cast<double>(latency.percentile_us(0.5));
+        state.counters["sync_p99_us"] = static_cast<double>(latency.percentile_us(0.99));
+        state.counters["commits_per_flush"] =
+            static_cast<double>(g_commits.load()) /
+            static_cast<double>(std::max<uint64_t>(g_shared.wal->flush_count(), 1));
+        
+        close_shared_wal();
+    }
+}
+// Arg — SyncPolicy: per_commit и group; commits/s растёт с числом клиентов,
+// потому что один fdatasync подтверждает всю накопленную группу
+BENCHMARK(BM_CommitThroughput)
+    ->Arg(static_cast<int>(SyncPolicy::PerCommit))
+    ->Arg(static_cast<int>(SyncPolicy::Group))
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+// ==============================================================================
+// Lock-free буфер лога: латентность append
+// ==============================================================================
+
+/// append без force: резервирование места и сериализация в кольцо.
+/// Время итерации — латентность одного append'а в потоке; при росте
+/// числа потоков оно должно оставаться в пределах небольшого множителя
+static void BM_AppendLatency(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        open_shared_wal(SyncPolicy::None);
+    }
+    
+    LogRecord record;
+    record.type = LogRecordType::UPDATE;
+    record.txn_id = static_cast<TxnId>(state.thread_index() + 1);
+    record.data.assign(static_cast<std::size_t>(state.range(0)), 'a');
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(g_shared.wal->append(record));
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * record.serialized_size()));
+    
+    if (state.thread_index() == 0) {
+        close_shared_wal();
+    }
+}
+// Arg — размер данных записи
+BENCHMARK(BM_AppendLatency)
+    ->Arg(64)
+    ->Arg(512)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// ==============================================================================
+// Физиологическая дельта: объём лога на UPDATE
+// ==============================================================================
+
+/// UPDATE кортежа в 128 байт, в котором меняются первые Arg байт.
+/// bytes_per_record — место записи в логе с выравниванием; полные
+/// образы заняли бы ~300 байт независимо от изменения
+static void BM_AppendUpdate(benchmark::State& state) {
+    open_shared_wal(SyncPolicy::None);
+    
+    constexpr uint16_t kTuple = 128;
+    auto changed = static_cast<std::size_t>(state.range(0));
+    
+    LogRecord record;
+    record.type = LogRecordType::UPDATE;
+    record.txn_id = 1;
+    record.page_id = 42;
+    record.offset = 256;
+    record.length = kTuple;
+    record.data.assign(2 * kTuple, 't');
+    std::fill_n(record.data.begin() + kTuple, changed, 'u');
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(g_shared.wal->append(record));
+    }
+    
+    auto stored = WriteAheadLog::aligned_size(record.serialized_size());
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * stored));
+    state.counters["bytes_per_record"] = static_cast<double>(stored);
+    
+    close_shared_wal();
+}
+// Arg — изменённых байт кортежа
+BENCHMARK(BM_AppendUpdate)
+    ->Arg(8)
+    ->Arg(32)
+    ->Arg(128);
+
+// ==============================================================================
+// Ротация сегментов: хвост латентности commit'а
+// ==============================================================================
+
+/// commit по 4 KB на маленьких сегментах: ротация каждые Arg KB лога.
+/// Старые сегменты освобождаются, как после checkpoint'а, и уходят в
+/// запас. commit_p99_us и commit_max_us показывают, выделяется ли
+/// ротация в хвосте латентности
+static void BM_CommitAcrossRotation(benchmark::State& state) {
+    open_shared_wal(SyncPolicy::PerCommit);
+    g_shared.wal.reset();
+    std::size_t segment_size = static_cast<std::size_t>(state.range(0)) * 1024;
+    g_shared.wal = std::make_unique<WriteAheadLog>(
+        g_shared.dir, segment_size, g_shared.metrics, nullptr, SyncConfig{});
+    g_shared.wal->initialize();
+    
+    LogRecord record;
+    record.type = LogRecordType::TXN_COMMIT;
+    record.txn_id = 1;
+    record.data.assign(4096, 'r');
+    
+    LatencyHistogram latency;
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+        g_shared.wal->force(g_shared.wal->append(record));
+        latency.record(std::chrono::steady_clock::now() - start);
+        
+        Lsn lsn = g_shared.wal->current_lsn();
+        if (lsn > 2 * segment_size) {
+            g_shared.wal->truncate_before(lsn - 2 * segment_size);
+        }
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.counters["segments"] = static_cast<double>(g_shared.wal->current_lsn() / segment_size);
+    state.counters["commit_p50_us"] = static_cast<double>(latency.percentile_us(0.5));
+    state.counters["commit_p99_us"] = static_cast<double>(latency.percentile_us(0.99));
+    state.counters["commit_max_us"] = static_cast<double>(latency.max_us.load());
+    
+    close_shared_wal();
+}
+// Arg — размер сегмента в KB
+BENCHMARK(BM_CommitAcrossRotation)
+    ->Arg(256)
+    ->Arg(4096)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
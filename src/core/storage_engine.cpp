@@ -5,9 +5,140 @@
 #include <algorithm>
 #include <cstring>
 #include <fstream>
+#include <iterator>
+#include <string_view>
 
 namespace datyredb {
 
+namespace {
+
+// Строка: uint32 число значений, за ним uint32 длина и байты каждого
+void put_u32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool get_u32(std::string_view& in, uint32_t& value) {
+    if (in.size() < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, in.data(), sizeof(value));
+    in.remove_prefix(sizeof(value));
+    return true;
+}
+
+void append_row(std::string& out, const std::vector<std::string>& values) {
+    put_u32(out, static_cast<uint32_t>(values.size()));
+    for (const auto& value : values) {
+        put_u32(out, static_cast<uint32_t>(value.size()));
+        out.append(value);
+    }
+}
+
+std::string encode_row(const std::vector<std::string>& values) {
+    std::string out;
+    append_row(out, values);
+    return out;
+}
+
+bool get_row(std::string_view& in, std::vector<std::string>& values) {
+    uint32_t count = 0;
+    if (!get_u32(in, count)) {
+        return false;
+    }
+    values.clear();
+    values.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t size = 0;
+        if (!get_u32(in, size) || in.size() < size) {
+            return false;
+        }
+        values.emplace_back(in.substr(0, size));
+        in.remove_prefix(size);
+    }
+    return true;
+}
+
+bool decode_row(std::string_view in, std::vector<std::string>& values) {
+    return get_row(in, values);
+}
+
+/// Индекс в записи каталога: колонка и корень B+tree; у хеш-индекса
+/// корня нет (INVALID_PAGE_ID) — он строится при открытии
+struct IndexDef {
+    uint32_t column;
+    storage::PageId root;
+};
+
+// Запись каталога: uint32 первая страница heap file'а, строка {имя,
+// колонки...}, затем uint32 число индексов и пары {колонка, корень};
+// корень INVALID_PAGE_ID — хеш-индекс. Записи без индексов могут
+// заканчиваться после строки
+std::string encode_catalog(storage::PageId first_page, const std::string& name,
+                           const std::vector<std::string>& columns,
+                           const std::vector<IndexDef>& indexes = {}) {
+    std::vector<std::string> values;
+    values.reserve(columns.size() + 1);
+    values.push_back(name);
+    values.insert(values.end(), columns.begin(), columns.end());
+    
+    std::string out;
+    put_u32(out, first_page);
+    append_row(out, values);
+    put_u32(out, static_cast<uint32_t>(indexes.size()));
+    for (const auto& index : indexes) {
+        put_u32(out, index.column);
+        put_u32(out, index.root);
+    }
+    return out;
+}
+
+bool decode_catalog(std::string_view in, storage::PageId& first_page,
+                    std::string& name, std::vector<std::string>& columns,
+                    std::vector<IndexDef>& indexes) {
+    std::vector<std::string> values;
+    if (!get_u32(in, first_page) || !get_row(in, values) || values.empty()) {
+        return false;
+    }
+    name = std::move(values.front());
+    columns.assign(std::make_move_iterator(values.begin() + 1),
+                   std::make_move_iterator(values.end()));
+    
+    indexes.clear();
+    uint32_t count = 0;
+    if (in.empty()) {
+        return true;
+    }
+    if (!get_u32(in, count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        IndexDef index{};
+        if (!get_u32(in, index.column) || !get_u32(in, index.root) ||
+            index.column >= columns.size()) {
+            return false;
+        }
+        indexes.push_back(index);
+    }
+    return true;
+}
+
+/// Ключ индекса — значение, обрезанное до MAX_KEY_SIZE: совпадение ключа
+/// проверяется по самой строке
+std::string_view index_key(std::string_view value) {
+    return value.substr(0, std::min(value.size(), storage::BTree::MAX_KEY_SIZE));
+}
+
+std::optional<std::size_t> column_of(const std::vector<std::string>& columns,
+                                     const std::string& column) {
+    auto it = std::find(columns.begin(), columns.end(), column);
+    if (it == columns.end()) {
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(it - columns.begin());
+}
+
+} // namespace
+
 StorageEngine::StorageEngine() 
     : StorageEngine(Config{})
 {
@@ -44,7 +175,8 @@ bool StorageEngine::initialize() {
     // 2. Инициализируем Disk Manager
     // =========================================================================
     disk_manager_ = std::make_shared<storage::DiskManager>(
-        std::filesystem::path(config_.data_path)
+        std::filesystem::path(config_.data_path),
+        config_.io
     );
     
     if (!disk_manager_->initialize()) {
@@ -59,7 +191,9 @@ bool StorageEngine::initialize() {
     wal_ = std::make_shared<storage::WriteAheadLog>(
         wal_path,
         64 * 1024 * 1024,  // 64 MB segments
-        metrics_
+        metrics_,
+        disk_manager_->io_backend(),
+        config_.io.sync
     );
     
     if (!wal_->initialize()) {
@@ -73,11 +207,36 @@ bool StorageEngine::initialize() {
     buffer_pool_ = std::make_shared<storage::BufferPool>(
         config_.buffer_pool_pages,
         disk_manager_,
-        metrics_
+        metrics_,
+        config_.buffer_pool,
+        wal_
     );
     
     // =========================================================================
-    // 5. Инициализируем Checkpoint Manager
+    // 5. Recovery: analysis / redo / undo с последнего checkpoint'а
+    // =========================================================================
+    storage::RecoveryManager recovery(wal_, buffer_pool_, disk_manager_, config_.recovery);
+    if (!recovery.recover()) {
+        Logger::error("Crash recovery failed");
+        return false;
+    }
+    
+    // ID транзакций — от конца лога: каждая транзакция пишет в лог больше
+    // байта, поэтому ID не повторяют выданные до перезапуска
+    next_txn_id_.store(std::max<storage::TxnId>(wal_->current_lsn(), 1),
+                       std::memory_order_relaxed);
+    
+    // =========================================================================
+    // 6. Каталог таблиц
+    // =========================================================================
+    bool catalog_created = false;
+    if (!open_catalog(catalog_created)) {
+        Logger::error("Failed to open table catalog");
+        return false;
+    }
+    
+    // =========================================================================
+    // 7. Инициализируем Checkpoint Manager
     // =========================================================================
     checkpoint_manager_ = std::make_shared<storage::CheckpointManager>(
         config_.checkpoint,
@@ -89,22 +248,31 @@ bool StorageEngine::initialize() {
     // Запускаем фоновый поток checkpoint'ов
     checkpoint_manager_->start();
     
+    // Восстановленные страницы — сразу на диск: следующий recovery
+    // начнётся с этого checkpoint'а
+    const auto& recovered = recovery.stats();
+    if (recovered.records_redone > 0 || recovered.records_undone > 0) {
+        checkpoint_manager_->manual_checkpoint();
+    }
+    
     // =========================================================================
-    // 6. Создаём demo таблицы (для тестирования)
+    // 8. Создаём demo таблицы в новой базе (для тестирования)
     // =========================================================================
-    create_table("users", {"id", "name", "email", "created_at"});
-    insert("users", {"1", "Alice", "alice@example.com", "2024-01-01"});
-    insert("users", {"2", "Bob", "bob@example.com", "2024-01-02"});
-    insert("users", {"3", "Charlie", "charlie@example.com", "2024-01-03"});
-
-    create_table("products", {"id", "name", "price", "stock"});
-    insert("products", {"1", "Laptop", "999.99", "10"});
-    insert("products", {"2", "Mouse", "29.99", "50"});
-    insert("products", {"3", "Keyboard", "79.99", "30"});
-
-    create_table("orders", {"id", "user_id", "product_id", "quantity", "total"});
-    insert("orders", {"1", "1", "1", "1", "999.99"});
-    insert("orders", {"2", "2", "2", "2", "59.98"});
+    if (catalog_created) {
+        create_table("users", {"id", "name", "email", "created_at"});
+        insert("users", {"1", "Alice", "alice@example.com", "2024-01-01"});
+        insert("users", {"2", "Bob", "bob@example.com", "2024-01-02"});
+        insert("users", {"3", "Charlie", "charlie@example.com", "2024-01-03"});
+        
+        create_table("products", {"id", "name", "price", "stock"});
+        insert("products", {"1", "Laptop", "999.99", "10"});
+        insert("products", {"2", "Mouse", "29.99", "50"});
+        insert("products", {"3", "Keyboard", "79.99", "30"});
+        
+        create_table("orders", {"id", "user_id", "product_id", "quantity", "total"});
+        insert("orders", {"1", "1", "1", "1", "999.99"});
+        insert("orders", {"2", "2", "2", "2", "59.98"});
+    }
     
     initialized_ = true;
     
@@ -129,29 +297,31 @@ void StorageEngine::shutdown() {
         checkpoint_manager_.reset();
     }
     
-    // 2. Закрываем buffer pool (flush все dirty pages)
+    // 2. Закрываем таблицы: heap file'ы держат buffer pool и WAL
+    {
+        std::unique_lock lock(mutex_);
+        std::unique_lock catalog(catalog_mutex_);
+        tables_.clear();
+        catalog_.reset();
+    }
+    
+    // 3. Закрываем buffer pool (flush все dirty pages)
     if (buffer_pool_) {
         buffer_pool_.reset();
     }
     
-    // 3. Закрываем WAL
+    // 4. Закрываем WAL
     if (wal_) {
         wal_->shutdown();
         wal_.reset();
     }
     
-    // 4. Закрываем disk manager
+    // 5. Закрываем disk manager
     if (disk_manager_) {
         disk_manager_->shutdown();
         disk_manager_.reset();
     }
     
-    // 5. Очищаем in-memory таблицы
-    {
-        std::unique_lock lock(mutex_);
-        tables_.clear();
-    }
-    
     initialized_ = false;
     
     Logger::info("Storage engine shutdown complete");
@@ -163,29 +333,71 @@ void StorageEngine::shutdown() {
 
 bool StorageEngine::create_table(const std::string& name, 
                                   const std::vector<std::string>& columns) {
-    std::unique_lock lock(mutex_);
-
-    if (tables_.find(name) != tables_.end()) {
-        Logger::warn("Table '{}' already exists", name);
+    storage::Lsn commit_lsn = storage::INVALID_LSN;
+    {
+        std::unique_lock lock(mutex_);
+        
+        if (tables_.find(name) != tables_.end()) {
+            Logger::warn("Table '{}' already exists", name);
+            return false;
+        }
+        
+        storage::TxnContext txn = begin_txn();
+        storage::PageId first_page = storage::HeapFile::create(*buffer_pool_, *wal_, txn);
+        std::optional<storage::RecordId> rid;
+        if (first_page != storage::INVALID_PAGE_ID) {
+            rid = catalog_->insert(txn, encode_catalog(first_page, name, columns));
+        }
+        if (!rid) {
+            Logger::error("Failed to create table '{}'", name);
+            abort_txn(txn);
+            return false;
+        }
+        commit_lsn = commit_txn(txn);
+        
+        std::unique_lock catalog(catalog_mutex_);
+        tables_.emplace(name, Table{columns, storage::HeapFile(buffer_pool_, wal_, first_page), *rid, {}, {}});
+    }
+    if (!wal_->force(commit_lsn)) {
+        Logger::error("Commit of table '{}' is not durable", name);
         return false;
     }
-
-    tables_[name] = Table{columns, {}, 0};
     
     Logger::info("Table '{}' created with {} columns", name, columns.size());
     return true;
 }
 
 bool StorageEngine::drop_table(const std::string& name) {
-    std::unique_lock lock(mutex_);
-
-    auto it = tables_.find(name);
-    if (it == tables_.end()) {
-        Logger::warn("Table '{}' not found", name);
+    storage::Lsn commit_lsn = storage::INVALID_LSN;
+    {
+        std::unique_lock lock(mutex_);
+        
+        auto it = tables_.find(name);
+        if (it == tables_.end()) {
+            Logger::warn("Table '{}' not found", name);
+            return false;
+        }
+        
+        // Страницы heap file'а и индексов возвращаются DiskManager'у после
+        // commit
+        storage::TxnContext txn = begin_txn();
+        bool ok = it->second.heap.destroy(txn);
+        for (auto& index : it->second.indexes) {
+            ok = ok && index.tree.destroy(txn);
+        }
+        if (!ok || !catalog_->remove(txn, it->second.catalog_rid)) {
+            abort_txn(txn);
+            return false;
+        }
+        commit_lsn = commit_txn(txn);
+        
+        std::unique_lock catalog(catalog_mutex_);
+        tables_.erase(it);
+    }
+    if (!wal_->force(commit_lsn)) {
+        Logger::error("Drop of table '{}' is not durable", name);
         return false;
     }
-
-    tables_.erase(it);
     
     Logger::info("Table '{}' dropped", name);
     return true;
@@ -193,26 +405,26 @@ bool StorageEngine::drop_table(const std::string& name) {
 
 std::vector<std::string> StorageEngine::list_tables() const {
     std::shared_lock lock(mutex_);
-
+    
     std::vector<std::string> result;
     result.reserve(tables_.size());
-
+    
     for (const auto& [name, table] : tables_) {
         (void)table;
         result.push_back(name);
     }
-
+    
     return result;
 }
 
 std::vector<std::string> StorageEngine::get_table_columns(const std::string& table) const {
     std::shared_lock lock(mutex_);
-
+    
     auto it = tables_.find(table);
     if (it == tables_.end()) {
         return {};
     }
-
+    
     return it->second.columns;
 }
 
@@ -227,43 +439,57 @@ bool StorageEngine::insert(const std::string& table,
         checkpoint_manager_->check_pressure();
     }
     
-    std::unique_lock lock(mutex_);
-
-    auto it = tables_.find(table);
-    if (it == tables_.end()) {
-        Logger::warn("Table '{}' not found for insert", table);
-        return false;
-    }
-
-    auto& tbl = it->second;
-
-    if (values.size() != tbl.columns.size()) {
-        Logger::warn("Column count mismatch for table '{}': expected {}, got {}",
-                     table, tbl.columns.size(), values.size());
-        return false;
+    storage::Lsn commit_lsn = storage::INVALID_LSN;
+    {
+        std::unique_lock lock(mutex_);
+        
+        auto it = tables_.find(table);
+        if (it == tables_.end()) {
+            Logger::warn("Table '{}' not found for insert", table);
+            return false;
+        }
+        
+        auto& tbl = it->second;
+        
+        if (values.size() != tbl.columns.size()) {
+            Logger::warn("Column count mismatch for table '{}': expected {}, got {}",
+                         table, tbl.columns.size(), values.size());
+            return false;
+        }
+        
+        storage::TxnContext txn = begin_txn();
+        auto rid = tbl.heap.insert(txn, encode_row(values));
+        if (!rid || !index_row(tbl, txn, *rid, values, true)) {
+            abort_txn(txn);
+            return false;
+        }
+        hash_row(tbl, *rid, values, true);
+        track_insert(tbl, *rid);
+        commit_lsn = commit_txn(txn);
     }
-
-    tbl.rows.push_back(values);
-    tbl.size_bytes = calculate_table_size(tbl);
-
-    // TODO: Записать в WAL для durability
-    // LogRecord rec;
-    // rec.type = storage::LogRecordType::INSERT;
-    // wal_->append(rec);
-
-    return true;
+    
+    // Force вне mutex_: коммиты других операций ложатся в тот же flush.
+    // false — commit не durable: строка видна, но может не пережить сбой
+    return wal_->force(commit_lsn);
 }
 
 std::vector<std::vector<std::string>> StorageEngine::select(const std::string& table) {
     std::shared_lock lock(mutex_);
-
+    
     auto it = tables_.find(table);
     if (it == tables_.end()) {
         return {};
     }
-
-    ++cache_hits_;  // Simplified cache tracking
-    return it->second.rows;
+    
+    std::vector<std::vector<std::string>> rows;
+    it->second.heap.scan([&](storage::RecordId, std::string_view record) {
+        std::vector<std::string> row;
+        if (decode_row(record, row)) {
+            rows.push_back(std::move(row));
+        }
+        return true;
+    });
+    return rows;
 }
 
 bool StorageEngine::update(const std::string& table, 
@@ -273,51 +499,291 @@ bool StorageEngine::update(const std::string& table,
         checkpoint_manager_->check_pressure();
     }
     
-    std::unique_lock lock(mutex_);
-
-    auto it = tables_.find(table);
-    if (it == tables_.end()) {
-        return false;
+    storage::Lsn commit_lsn = storage::INVALID_LSN;
+    {
+        std::unique_lock lock(mutex_);
+        
+        auto it = tables_.find(table);
+        if (it == tables_.end()) {
+            return false;
+        }
+        
+        auto& tbl = it->second;
+        
+        if (values.size() != tbl.columns.size()) {
+            return false;
+        }
+        
+        auto rid = locate(tbl, row_id);
+        if (!rid) {
+            return false;
+        }
+        
+        std::vector<std::string> old_values;
+        if (!tbl.indexes.empty() || !tbl.hash_indexes.empty()) {
+            auto record = tbl.heap.get(*rid);
+            if (!record || !decode_row(*record, old_values)) {
+                return false;
+            }
+        }
+        
+        // RecordId при update не меняется: индексы правятся только по
+        // изменившимся ключам
+        storage::TxnContext txn = begin_txn();
+        bool ok = tbl.heap.update(txn, *rid, encode_row(values));
+        for (auto& index : tbl.indexes) {
+            auto old_key = index_key(old_values[index.column]);
+            auto new_key = index_key(values[index.column]);
+            if (ok && old_key != new_key) {
+                ok = index.tree.remove(txn, old_key, *rid) &&
+                     index.tree.insert(txn, new_key, *rid);
+            }
+        }
+        if (!ok) {
+            abort_txn(txn);
+            return false;
+        }
+        for (auto& index : tbl.hash_indexes) {
+            if (old_values[index.column] != values[index.column]) {
+                index.map->remove(old_values[index.column], *rid);
+                index.map->insert(values[index.column], *rid);
+            }
+        }
+        commit_lsn = commit_txn(txn);
     }
+    return wal_->force(commit_lsn);
+}
 
-    auto& tbl = it->second;
-    
-    if (row_id >= tbl.rows.size()) {
-        return false;
+bool StorageEngine::remove(const std::string& table, std::size_t row_id) {
+    if (checkpoint_manager_) {
+        checkpoint_manager_->check_pressure();
     }
     
-    if (values.size() != tbl.columns.size()) {
-        return false;
+    storage::Lsn commit_lsn = storage::INVALID_LSN;
+    {
+        std::unique_lock lock(mutex_);
+        
+        auto it = tables_.find(table);
+        if (it == tables_.end()) {
+            return false;
+        }
+        
+        auto& tbl = it->second;
+        
+        auto rid = locate(tbl, row_id);
+        if (!rid) {
+            return false;
+        }
+        
+        std::vector<std::string> old_values;
+        if (!tbl.indexes.empty() || !tbl.hash_indexes.empty()) {
+            auto record = tbl.heap.get(*rid);
+            if (!record || !decode_row(*record, old_values)) {
+                return false;
+            }
+        }
+        
+        storage::TxnContext txn = begin_txn();
+        if (!tbl.heap.remove(txn, *rid) || !index_row(tbl, txn, *rid, old_values, false)) {
+            abort_txn(txn);
+            return false;
+        }
+        hash_row(tbl, *rid, old_values, false);
+        tbl.row_ids.erase(tbl.row_ids.begin() + static_cast<std::ptrdiff_t>(row_id));
+        commit_lsn = commit_txn(txn);
     }
+    return wal_->force(commit_lsn);
+}
 
-    tbl.rows[row_id] = values;
-    tbl.size_bytes = calculate_table_size(tbl);
+// ============================================================================
+// Index operations
+// ============================================================================
 
+bool StorageEngine::create_index(const std::string& table, const std::string& column,
+                                 IndexMethod method) {
+    storage::Lsn commit_lsn = storage::INVALID_LSN;
+    {
+        std::unique_lock lock(mutex_);
+        
+        auto it = tables_.find(table);
+        if (it == tables_.end()) {
+            Logger::warn("Table '{}' not found for index", table);
+            return false;
+        }
+        auto& tbl = it->second;
+        
+        auto col = column_of(tbl.columns, column);
+        if (!col) {
+            Logger::warn("Column '{}' not found in table '{}'", column, table);
+            return false;
+        }
+        bool hash = method == IndexMethod::Hash;
+        if (hash ? find_hash_index(tbl, *col) != nullptr : find_index(tbl, *col) != nullptr) {
+            Logger::warn("Index on '{}.{}' already exists", table, column);
+            return false;
+        }
+        
+        std::vector<IndexDef> defs;
+        for (const auto& index : tbl.indexes) {
+            defs.push_back(IndexDef{static_cast<uint32_t>(index.column), index.tree.root_page()});
+        }
+        for (const auto& index : tbl.hash_indexes) {
+            defs.push_back(IndexDef{static_cast<uint32_t>(index.column), storage::INVALID_PAGE_ID});
+        }
+        
+        // Хеш-индекс живёт в памяти: в каталог пишется только его колонка
+        storage::TxnContext txn = begin_txn();
+        std::unique_ptr<storage::HashIndex> map;
+        storage::PageId root = storage::INVALID_PAGE_ID;
+        bool ok = hash ? (map = build_hash_index(tbl, *col)) != nullptr
+                       : (root = build_btree_index(tbl, *col, txn)) != storage::INVALID_PAGE_ID;
+        
+        defs.push_back(IndexDef{static_cast<uint32_t>(*col), root});
+        if (!ok || !catalog_->update(txn, tbl.catalog_rid,
+                                     encode_catalog(tbl.heap.first_page(), table, tbl.columns, defs))) {
+            Logger::error("Failed to create index on '{}.{}'", table, column);
+            abort_txn(txn);
+            return false;
+        }
+        commit_lsn = commit_txn(txn);
+        
+        std::unique_lock catalog(catalog_mutex_);
+        if (hash) {
+            tbl.hash_indexes.push_back(HashIndex{*col, std::move(map)});
+        } else {
+            tbl.indexes.push_back(Index{*col, storage::BTree(buffer_pool_, wal_, root)});
+        }
+    }
+    if (!wal_->force(commit_lsn)) {
+        Logger::error("Index on '{}.{}' is not durable", table, column);
+        return false;
+    }
+    
+    Logger::info("Index on '{}.{}' created", table, column);
     return true;
 }
 
-bool StorageEngine::remove(const std::string& table, std::size_t row_id) {
-    if (checkpoint_manager_) {
-        checkpoint_manager_->check_pressure();
+std::vector<std::vector<std::string>> StorageEngine::select_where(const std::string& table,
+                                                                  const std::string& column,
+                                                                  const std::string& value) {
+    std::vector<std::vector<std::string>> rows;
+    std::vector<std::string> row;
+    
+    // Хеш-индекс — O(1) без спуска по дереву и без mutex_: индекс читается
+    // без блокировок, строка — оптимистично под version latch'ем страницы.
+    // Кандидаты с совпавшим хешем проверяются по строке; хеш-индекс
+    // правится после успеха операции, поэтому незакоммиченное новое
+    // значение не находится, а строка, удаляемая в этот момент, может
+    // уже не найтись
+    {
+        std::shared_lock catalog(catalog_mutex_);
+        
+        auto it = tables_.find(table);
+        if (it == tables_.end()) {
+            return {};
+        }
+        const auto& tbl = it->second;
+        auto col = column_of(tbl.columns, column);
+        if (!col) {
+            return {};
+        }
+        
+        if (const HashIndex* index = find_hash_index(tbl, *col)) {
+            for (storage::RecordId rid : index->map->lookup(value)) {
+                auto record = tbl.heap.get(rid);
+                if (record && decode_row(*record, row) && *col < row.size() && row[*col] == value) {
+                    rows.push_back(std::move(row));
+                }
+            }
+            return rows;
+        }
     }
     
-    std::unique_lock lock(mutex_);
-
+    std::shared_lock lock(mutex_);
+    
     auto it = tables_.find(table);
     if (it == tables_.end()) {
-        return false;
+        return {};
+    }
+    const auto& tbl = it->second;
+    auto col = column_of(tbl.columns, column);
+    if (!col) {
+        return {};
     }
-
-    auto& tbl = it->second;
     
-    if (row_id >= tbl.rows.size()) {
-        return false;
+    if (const Index* index = find_index(tbl, *col)) {
+        for (storage::RecordId rid : index->tree.lookup(index_key(value))) {
+            auto record = tbl.heap.get(rid);
+            if (record && decode_row(*record, row) && row[*col] == value) {
+                rows.push_back(std::move(row));
+            }
+        }
+        return rows;
     }
+    
+    tbl.heap.scan([&](storage::RecordId, std::string_view record) {
+        if (decode_row(record, row) && *col < row.size() && row[*col] == value) {
+            rows.push_back(std::move(row));
+        }
+        return true;
+    });
+    return rows;
+}
 
-    tbl.rows.erase(tbl.rows.begin() + static_cast<std::ptrdiff_t>(row_id));
-    tbl.size_bytes = calculate_table_size(tbl);
-
-    return true;
+std::vector<std::vector<std::string>> StorageEngine::select_range(const std::string& table,
+                                                                  const std::string& column,
+                                                                  const std::string& from,
+                                                                  const std::string& to) {
+    std::shared_lock lock(mutex_);
+    
+    auto it = tables_.find(table);
+    if (it == tables_.end()) {
+        return {};
+    }
+    const auto& tbl = it->second;
+    auto col = column_of(tbl.columns, column);
+    if (!col) {
+        return {};
+    }
+    
+    std::vector<std::vector<std::string>> rows;
+    std::vector<std::string> row;
+    auto in_range = [&](const std::vector<std::string>& values) {
+        return *col < values.size() && values[*col] >= from && values[*col] <= to;
+    };
+    
+    if (const Index* index = find_index(tbl, *col)) {
+        // Ключи обрезаны: граница сравнивается по обрезанному значению, а
+        // точное попадание — по строке
+        std::string_view last = index_key(to);
+        index->tree.scan(index_key(from), [&](std::string_view key, storage::RecordId rid) {
+            if (key > last) {
+                return false;
+            }
+            auto record = tbl.heap.get(rid);
+            if (record && decode_row(*record, row) && in_range(row)) {
+                rows.push_back(std::move(row));
+            }
+            return true;
+        });
+        
+        // Строки с одинаковым обрезанным ключом идут в порядке RecordId
+        std::stable_sort(rows.begin(), rows.end(), [&](const auto& a, const auto& b) {
+            return a[*col] < b[*col];
+        });
+        return rows;
+    }
+    
+    tbl.heap.scan([&](storage::RecordId, std::string_view record) {
+        if (decode_row(record, row) && in_range(row)) {
+            rows.push_back(std::move(row));
+        }
+        return true;
+    });
+    std::stable_sort(rows.begin(), rows.end(), [&](const auto& a, const auto& b) {
+        return a[*col] < b[*col];
+    });
+    return rows;
 }
 
 // ============================================================================
@@ -353,7 +819,7 @@ std::size_t StorageEngine::total_records() const {
     std::size_t total = 0;
     for (const auto& [name, table] : tables_) {
         (void)name;
-        total += table.rows.size();
+        total += table.heap.record_count();
     }
     return total;
 }
@@ -364,24 +830,28 @@ std::size_t StorageEngine::total_size() const {
     std::size_t total = 0;
     for (const auto& [name, table] : tables_) {
         (void)name;
-        total += table.size_bytes;
+        total += table.heap.data_bytes();
     }
     return total;
 }
 
 std::size_t StorageEngine::index_count() const {
-    // TODO: implement when indexes are added
-    return 0;
+    std::shared_lock lock(mutex_);
+    
+    std::size_t total = 0;
+    for (const auto& [name, table] : tables_) {
+        (void)name;
+        total += table.indexes.size() + table.hash_indexes.size();
+    }
+    return total;
 }
 
 std::size_t StorageEngine::memory_usage() const {
-    std::size_t usage = total_size();
-    
+    // Строки живут в страницах buffer pool'а
     if (buffer_pool_) {
-        usage += buffer_pool_->page_count() * storage::PAGE_SIZE;
+        return buffer_pool_->page_count() * storage::PAGE_SIZE;
     }
-    
-    return usage;
+    return 0;
 }
 
 std::size_t StorageEngine::disk_usage() const {
@@ -392,6 +862,10 @@ std::size_t StorageEngine::disk_usage() const {
 }
 
 float StorageEngine::cache_hit_ratio() const {
+    if (buffer_pool_) {
+        return static_cast<float>(buffer_pool_->metrics().hit_ratio());
+    }
+    
     uint64_t total = cache_hits_ + cache_misses_;
     if (total == 0) return 1.0f;
     return static_cast<float>(cache_hits_) / static_cast<float>(total);
@@ -404,7 +878,7 @@ std::size_t StorageEngine::table_record_count(const std::string& table) const {
     if (it == tables_.end()) {
         return 0;
     }
-    return it->second.rows.size();
+    return it->second.heap.record_count();
 }
 
 std::size_t StorageEngine::table_size(const std::string& table) const {
@@ -414,7 +888,7 @@ std::size_t StorageEngine::table_size(const std::string& table) const {
     if (it == tables_.end()) {
         return 0;
     }
-    return it->second.size_bytes;
+    return it->second.heap.data_bytes();
 }
 
 std::size_t StorageEngine::dirty_page_count() const {
@@ -471,7 +945,7 @@ bool StorageEngine::create_backup(const std::string& path) {
         
         Logger::info("Backup created at {}", path);
         return true;
-        
+    
     } catch (const std::exception& e) {
         Logger::error("Backup failed: {}", e.what());
         return false;
@@ -482,22 +956,218 @@ bool StorageEngine::create_backup(const std::string& path) {
 // Private helpers
 // ============================================================================
 
-std::size_t StorageEngine::calculate_table_size(const Table& table) {
-    std::size_t size = 0;
+bool StorageEngine::open_catalog(bool& created) {
+    using storage::HeapFile;
     
-    // Columns
-    for (const auto& col : table.columns) {
-        size += col.size();
+    // Каталог создаётся в пустом файле данных; страница 0 может остаться
+    // неразмеченной, если сбой пришёлся на создание
+    created = disk_manager_->page_count() == 0 ||
+              !HeapFile::is_formatted(*buffer_pool_, CATALOG_PAGE);
+    if (created) {
+        storage::TxnContext txn = begin_txn();
+        bool ok = disk_manager_->page_count() == 0
+            ? HeapFile::create(*buffer_pool_, *wal_, txn) == CATALOG_PAGE
+            : HeapFile::format(*buffer_pool_, *wal_, txn, CATALOG_PAGE);
+        if (!ok) {
+            abort_txn(txn);
+            return false;
+        }
+        if (!wal_->force(commit_txn(txn))) {
+            return false;
+        }
     }
     
-    // Rows
-    for (const auto& row : table.rows) {
-        for (const auto& cell : row) {
-            size += cell.size();
+    catalog_ = std::make_unique<HeapFile>(buffer_pool_, wal_, CATALOG_PAGE);
+    
+    std::unique_lock lock(mutex_);
+    std::unique_lock catalog(catalog_mutex_);
+    bool rebuilt = true;
+    bool scanned = catalog_->scan([&](storage::RecordId rid, std::string_view record) {
+        storage::PageId first_page = storage::INVALID_PAGE_ID;
+        std::string name;
+        std::vector<std::string> columns;
+        std::vector<IndexDef> defs;
+        if (!decode_catalog(record, first_page, name, columns, defs)) {
+            Logger::error("Corrupted catalog record at page {} slot {}", rid.page_id, rid.slot);
+            return true;
+        }
+        
+        // Хеш-индексы строятся заново: каталог открывается после recovery,
+        // и heap file уже согласован
+        Table table{std::move(columns), HeapFile(buffer_pool_, wal_, first_page), rid, {}, {}};
+        for (const auto& def : defs) {
+            if (def.root != storage::INVALID_PAGE_ID) {
+                table.indexes.push_back(Index{def.column, storage::BTree(buffer_pool_, wal_, def.root)});
+                continue;
+            }
+            auto map = build_hash_index(table, def.column);
+            if (!map) {
+                Logger::error("Failed to rebuild hash index of table '{}'", name);
+                rebuilt = false;
+                return false;
+            }
+            table.hash_indexes.push_back(HashIndex{def.column, std::move(map)});
+        }
+        tables_.emplace(name, std::move(table));
+        return true;
+    });
+    return scanned && rebuilt;
+}
+
+storage::TxnContext StorageEngine::begin_txn() {
+    storage::TxnContext txn;
+    txn.txn_id = next_txn_id_.fetch_add(1, std::memory_order_relaxed);
+    
+    storage::LogRecord record;
+    record.type = storage::LogRecordType::TXN_BEGIN;
+    record.txn_id = txn.txn_id;
+    txn.last_lsn = wal_->append(record);
+    return txn;
+}
+
+storage::Lsn StorageEngine::commit_txn(storage::TxnContext& txn) {
+    storage::LogRecord record;
+    record.type = storage::LogRecordType::TXN_COMMIT;
+    record.txn_id = txn.txn_id;
+    record.prev_lsn = txn.last_lsn;
+    txn.last_lsn = wal_->append(record);
+    txn.undo.clear();
+    storage::HeapFile::release_pages(*buffer_pool_, txn, txn.last_lsn);
+    return txn.last_lsn;
+}
+
+void StorageEngine::abort_txn(storage::TxnContext& txn) {
+    if (!storage::HeapFile::rollback(*buffer_pool_, *wal_, txn)) {
+        Logger::error("Rollback of txn {} incomplete", txn.txn_id);
+    }
+}
+
+bool StorageEngine::index_row(Table& table, storage::TxnContext& txn, storage::RecordId rid,
+                              const std::vector<std::string>& values, bool insert) {
+    for (auto& index : table.indexes) {
+        auto key = index_key(values[index.column]);
+        if (insert ? !index.tree.insert(txn, key, rid) : !index.tree.remove(txn, key, rid)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StorageEngine::hash_row(Table& table, storage::RecordId rid,
+                             const std::vector<std::string>& values, bool insert) {
+    for (auto& index : table.hash_indexes) {
+        if (insert) {
+            index.map->insert(values[index.column], rid);
+        } else {
+            index.map->remove(values[index.column], rid);
         }
     }
+}
+
+const StorageEngine::Index* StorageEngine::find_index(const Table& table, std::size_t column) {
+    for (const auto& index : table.indexes) {
+        if (index.column == column) {
+            return &index;
+        }
+    }
+    return nullptr;
+}
+
+const StorageEngine::HashIndex* StorageEngine::find_hash_index(const Table& table,
+                                                               std::size_t column) {
+    for (const auto& index : table.hash_indexes) {
+        if (index.column == column) {
+            return &index;
+        }
+    }
+    return nullptr;
+}
+
+storage::PageId StorageEngine::build_btree_index(const Table& table, std::size_t column,
+                                                 storage::TxnContext& txn) {
+    // Пары (ключ, RecordId) сортируются в памяти, занятой у buffer
+    // pool'а, и загружаются снизу вверх
+    auto sort_pages = static_cast<std::size_t>(
+        static_cast<double>(config_.buffer_pool_pages) * config_.index_build.sort_memory_fraction);
+    storage::IndexSorter sorter(*buffer_pool_, std::max<std::size_t>(sort_pages, 3),
+                                config_.data_path);
+    bool scanned = table.heap.scan([&](storage::RecordId rid, std::string_view record) {
+        std::vector<std::string> values;
+        if (decode_row(record, values) && column < values.size()) {
+            return sorter.add(index_key(values[column]), rid);
+        }
+        return true;
+    });
+    if (!scanned || sorter.failed() || !sorter.finish()) {
+        Logger::error("Failed to sort entries for index on column {}", column);
+        return storage::INVALID_PAGE_ID;
+    }
     
-    return size;
+    storage::PageId root = storage::BTree::create(*buffer_pool_, *wal_, txn);
+    storage::BTree tree(buffer_pool_, wal_, root);
+    bool ok = root != storage::INVALID_PAGE_ID &&
+              tree.bulk_load(txn, [&](storage::IndexEntry& entry) {
+                  return sorter.next(entry);
+              }, config_.index_build) &&
+              !sorter.failed();
+    return ok ? root : storage::INVALID_PAGE_ID;
+}
+
+std::unique_ptr<storage::HashIndex> StorageEngine::build_hash_index(const Table& table,
+                                                                    std::size_t column) {
+    // Число записей известно заранее: таблица не растёт по ходу построения
+    auto map = std::make_unique<storage::HashIndex>();
+    map->reserve(table.heap.record_count());
+    bool scanned = table.heap.scan([&](storage::RecordId rid, std::string_view record) {
+        std::vector<std::string> values;
+        if (decode_row(record, values) && column < values.size()) {
+            map->insert(values[column], rid);
+        }
+        return true;
+    });
+    return scanned ? std::move(map) : nullptr;
+}
+
+std::optional<storage::RecordId> StorageEngine::locate(Table& table, std::size_t row_id) {
+    // Один scan на таблицу, а не на каждый update/remove
+    if (!table.row_ids_built) {
+        table.row_ids.clear();
+        bool scanned = table.heap.scan([&](storage::RecordId rid, std::string_view) {
+            table.row_ids.push_back(rid);
+            return true;
+        });
+        if (!scanned) {
+            table.row_ids.clear();
+            return std::nullopt;
+        }
+        table.row_ids_built = true;
+    }
+    
+    if (row_id >= table.row_ids.size()) {
+        return std::nullopt;
+    }
+    return table.row_ids[row_id];
+}
+
+void StorageEngine::track_insert(Table& table, storage::RecordId rid) {
+    if (!table.row_ids_built) {
+        return;
+    }
+    
+    // insert() берёт слот за последним на странице: строка встаёт сразу за
+    // последней строкой своей страницы. Страница без строк — первая
+    // страница файла (из цепочки не выходит) или новая в конце цепочки
+    auto& ids = table.row_ids;
+    auto same_page = std::find_if(ids.rbegin(), ids.rend(), [&](const storage::RecordId& id) {
+        return id.page_id == rid.page_id;
+    });
+    if (same_page != ids.rend()) {
+        ids.insert(same_page.base(), rid);
+    } else if (rid.page_id == table.heap.first_page()) {
+        ids.insert(ids.begin(), rid);
+    } else {
+        ids.push_back(rid);
+    }
 }
 
 } // namespace datyredb
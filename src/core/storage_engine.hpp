@@ -5,12 +5,19 @@
 #include "storage/buffer_pool.hpp"
 #include "storage/wal.hpp"
 #include "storage/checkpoint.hpp"
+#include "storage/recovery.hpp"
+#include "storage/heap_file.hpp"
+#include "storage/btree.hpp"
+#include "storage/index_sorter.hpp"
+#include "storage/hash_index.hpp"
 
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <shared_mutex>
 #include <memory>
+#include <atomic>
+#include <optional>
 #include <cstdint>
 #include <filesystem>
 
@@ -22,7 +29,11 @@ public:
     struct Config {
         std::string data_path = "./data";
         std::size_t buffer_pool_pages = 10000;  // ~40 MB при 4KB страницах
+        storage::BufferPoolConfig buffer_pool;
+        storage::IoConfig io;
         storage::CheckpointConfig checkpoint;
+        storage::RecoveryConfig recovery;
+        storage::IndexBuildConfig index_build;
     };
     
     StorageEngine();
@@ -49,12 +60,41 @@ public:
     // Data operations
     // ========================================================================
     
+    /// insert/update/remove и DDL: false — операция не выполнена или её
+    /// commit не доведён до диска (ошибка записи WAL)
     bool insert(const std::string& table, const std::vector<std::string>& values);
     std::vector<std::vector<std::string>> select(const std::string& table);
     bool update(const std::string& table, std::size_t row_id, 
                 const std::vector<std::string>& values);
     bool remove(const std::string& table, std::size_t row_id);
 
+    // ========================================================================
+    // Index operations
+    // ========================================================================
+    
+    /// Вид индекса (CREATE INDEX ... USING BTREE | HASH)
+    enum class IndexMethod {
+        BTree,  // На диске; равенство и диапазоны
+        Hash    // В памяти, строится при открытии; только равенство
+    };
+    
+    /// Индекс по колонке; на колонке — не больше одного индекса каждого
+    /// вида. B+tree: существующие строки сортируются внешней сортировкой и
+    /// загружаются bulk load'ом (Config::index_build)
+    bool create_index(const std::string& table, const std::string& column,
+                      IndexMethod method = IndexMethod::BTree);
+    
+    /// Строки, где column == value: хеш-индексом, B+tree или полным scan'ом
+    std::vector<std::vector<std::string>> select_where(const std::string& table,
+                                                       const std::string& column,
+                                                       const std::string& value);
+    
+    /// Строки с from <= column <= to (сравнение байтов) по возрастанию column
+    std::vector<std::vector<std::string>> select_range(const std::string& table,
+                                                       const std::string& column,
+                                                       const std::string& from,
+                                                       const std::string& to);
+
     // ========================================================================
     // Checkpoint API
     // ========================================================================
@@ -101,15 +141,76 @@ public:
     bool create_backup(const std::string& path);
 
 private:
-    // In-memory table structure (временно, пока нет B-tree)
+    /// Индекс: B+tree по значению колонки (первые MAX_KEY_SIZE байт)
+    struct Index {
+        std::size_t column;
+        storage::BTree tree;
+    };
+
+    /// Хеш-индекс: полное значение колонки; в каталоге — без корня
+    struct HashIndex {
+        std::size_t column;
+        std::unique_ptr<storage::HashIndex> map;
+    };
+
+    /// Таблица: схема из каталога, heap file со строками и индексы
     struct Table {
         std::vector<std::string> columns;
-        std::vector<std::vector<std::string>> rows;
-        std::size_t size_bytes = 0;
+        storage::HeapFile heap;
+        storage::RecordId catalog_rid;
+        std::vector<Index> indexes;
+        std::vector<HashIndex> hash_indexes;
+        
+        /// RecordId строк в порядке scan: номер строки — индекс. Строится
+        /// первым locate(), дальше правится insert/remove (под mutex_)
+        std::vector<storage::RecordId> row_ids{};
+        bool row_ids_built = false;
     };
 
-    /// Вычислить размер таблицы в байтах
-    static std::size_t calculate_table_size(const Table& table);
+    /// Каталог таблиц — heap file с первой страницей 0
+    static constexpr storage::PageId CATALOG_PAGE = 0;
+
+    /// Открыть каталог (создать в пустом файле) и загрузить таблицы.
+    /// created — каталог создан заново
+    bool open_catalog(bool& created);
+
+    /// Транзакция одной операции: TXN_BEGIN в лог
+    storage::TxnContext begin_txn();
+
+    /// TXN_COMMIT в лог и освобождённые страницы — DiskManager'у; force —
+    /// вызывающему, после снятия mutex_
+    storage::Lsn commit_txn(storage::TxnContext& txn);
+
+    /// Откатить транзакцию неудавшейся операции
+    void abort_txn(storage::TxnContext& txn);
+
+    /// RecordId строки по её номеру в порядке scan
+    static std::optional<storage::RecordId> locate(Table& table, std::size_t row_id);
+    
+    /// Учесть вставленную строку rid в номерах строк таблицы
+    static void track_insert(Table& table, storage::RecordId rid);
+
+    /// Записать в индексы (insert) или убрать из них строку rid
+    static bool index_row(Table& table, storage::TxnContext& txn, storage::RecordId rid,
+                          const std::vector<std::string>& values, bool insert);
+
+    /// Записать в хеш-индексы (insert) или убрать из них строку rid.
+    /// Хеш-индексы не откатываются — вызывается после успеха операции
+    static void hash_row(Table& table, storage::RecordId rid,
+                         const std::vector<std::string>& values, bool insert);
+
+    /// Индекс таблицы по колонке; nullptr — нет
+    static const Index* find_index(const Table& table, std::size_t column);
+    static const HashIndex* find_hash_index(const Table& table, std::size_t column);
+
+    /// Построить B+tree по колонке внешней сортировкой и bulk load'ом;
+    /// корень или INVALID_PAGE_ID
+    storage::PageId build_btree_index(const Table& table, std::size_t column,
+                                      storage::TxnContext& txn);
+
+    /// Построить хеш-индекс scan'ом heap file'а; nullptr — ошибка чтения
+    static std::unique_ptr<storage::HashIndex> build_hash_index(const Table& table,
+                                                                std::size_t column);
 
     Config config_;
     bool initialized_ = false;
@@ -121,9 +222,16 @@ private:
     std::shared_ptr<storage::WriteAheadLog> wal_;
     std::shared_ptr<storage::CheckpointManager> checkpoint_manager_;
 
-    // In-memory tables
+    // Таблицы: изменения под unique lock, чтение под shared
     mutable std::shared_mutex mutex_;
+    std::unique_ptr<storage::HeapFile> catalog_;
     std::unordered_map<std::string, Table> tables_;
+    
+    // Состав tables_ и индексов таблиц: DDL меняет его под mutex_ и
+    // unique catalog_mutex_; поиск по хеш-индексу берёт только shared
+    // catalog_mutex_ и не ждёт insert/update/remove
+    mutable std::shared_mutex catalog_mutex_;
+    std::atomic<storage::TxnId> next_txn_id_{1};
 
     // Statistics
     mutable uint64_t cache_hits_ = 0;
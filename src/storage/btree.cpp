@@ -0,0 +1,877 @@
+#include "storage/btree.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace datyredb::storage {
+
+namespace {
+
+constexpr std::size_t PAYLOAD_SIZE = Page::payload_size();
+
+#pragma pack(push, 1)
+/// Заголовок узла
+struct NodeHeader {
+    uint16_t count;
+    uint16_t level;           // 0 — лист
+    uint16_t free_end;        // Начало области записей
+    uint16_t garbage;         // Байты удалённых записей
+    PageId right_sibling;
+    PageId leftmost;          // Внутренний узел: ребёнок для ключей меньше первой записи
+};
+#pragma pack(pop)
+
+constexpr std::size_t HEADER_SIZE = sizeof(NodeHeader);
+constexpr std::size_t SLOT_SIZE = sizeof(uint16_t);
+constexpr std::size_t MAX_SLOTS = (PAYLOAD_SIZE - HEADER_SIZE) / SLOT_SIZE;
+
+std::size_t entry_size(std::size_t key_size, uint16_t level) {
+    return sizeof(uint16_t) + key_size + sizeof(uint64_t) + (level != 0 ? sizeof(PageId) : 0);
+}
+
+/// Место под запись с самым длинным ключом во внутреннем узле
+const std::size_t MAX_INTERNAL_ENTRY = entry_size(BTree::MAX_KEY_SIZE, 1);
+
+uint64_t pack(RecordId rid) {
+    return (static_cast<uint64_t>(rid.page_id) << 16) | rid.slot;
+}
+
+RecordId unpack(uint64_t rid) {
+    return RecordId{static_cast<PageId>(rid >> 16), static_cast<uint16_t>(rid & 0xFFFF)};
+}
+
+int compare(std::string_view a_key, uint64_t a_rid, std::string_view b_key, uint64_t b_rid) {
+    int result = a_key.compare(b_key);
+    if (result != 0) {
+        return result;
+    }
+    return a_rid < b_rid ? -1 : (a_rid > b_rid ? 1 : 0);
+}
+
+NodeHeader* node_header(char* payload) {
+    return reinterpret_cast<NodeHeader*>(payload);
+}
+
+const NodeHeader* node_header(const char* payload) {
+    return reinterpret_cast<const NodeHeader*>(payload);
+}
+
+// Оптимистичное чтение может застать узел посреди изменения: доступ
+// ограничен payload'ом, согласованность проверяет validate()
+
+std::size_t node_count(const char* payload) {
+    return std::min<std::size_t>(node_header(payload)->count, MAX_SLOTS);
+}
+
+uint16_t slot_offset(const char* payload, std::size_t index) {
+    uint16_t offset;
+    std::memcpy(&offset, payload + HEADER_SIZE + SLOT_SIZE * index, sizeof(offset));
+    return offset;
+}
+
+void set_slot_offset(char* payload, std::size_t index, uint16_t offset) {
+    std::memcpy(payload + HEADER_SIZE + SLOT_SIZE * index, &offset, sizeof(offset));
+}
+
+struct Entry {
+    std::string_view key;
+    uint64_t rid = 0;
+    PageId child = INVALID_PAGE_ID;
+};
+
+Entry read_entry(const char* payload, std::size_t index) {
+    Entry entry;
+    std::size_t offset = slot_offset(payload, index);
+    uint16_t level = node_header(payload)->level;
+    uint16_t key_size = 0;
+    if (offset + sizeof(key_size) > PAYLOAD_SIZE) {
+        return entry;
+    }
+    std::memcpy(&key_size, payload + offset, sizeof(key_size));
+    if (offset + entry_size(key_size, level) > PAYLOAD_SIZE) {
+        return entry;
+    }
+    
+    const char* data = payload + offset + sizeof(key_size);
+    entry.key = std::string_view(data, key_size);
+    std::memcpy(&entry.rid, data + key_size, sizeof(entry.rid));
+    if (level != 0) {
+        std::memcpy(&entry.child, data + key_size + sizeof(entry.rid), sizeof(entry.child));
+    }
+    return entry;
+}
+
+/// Первая запись не меньше (key, rid)
+std::size_t lower_bound(const char* payload, std::string_view key, uint64_t rid) {
+    std::size_t lo = 0;
+    std::size_t hi = node_count(payload);
+    while (lo < hi) {
+        std::size_t mid = (lo + hi) / 2;
+        Entry entry = read_entry(payload, mid);
+        if (compare(entry.key, entry.rid, key, rid) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/// Ребёнок внутреннего узла, покрывающий (key, rid)
+PageId child_for(const char* payload, std::string_view key, uint64_t rid) {
+    std::size_t lo = 0;
+    std::size_t hi = node_count(payload);
+    while (lo < hi) {
+        std::size_t mid = (lo + hi) / 2;
+        Entry entry = read_entry(payload, mid);
+        if (compare(entry.key, entry.rid, key, rid) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo == 0 ? node_header(payload)->leftmost : read_entry(payload, lo - 1).child;
+}
+
+std::size_t total_free(const char* payload) {
+    const NodeHeader* header = node_header(payload);
+    std::size_t slots_end = HEADER_SIZE + SLOT_SIZE * node_count(payload);
+    std::size_t contiguous = header->free_end > slots_end ? header->free_end - slots_end : 0;
+    return contiguous + header->garbage;
+}
+
+/// Поместится запись размера size вместе со слотом
+bool has_room(const char* payload, std::size_t size) {
+    return total_free(payload) >= size + SLOT_SIZE;
+}
+
+void init_node(char* payload, uint16_t level) {
+    std::memset(payload, 0, PAYLOAD_SIZE);
+    NodeHeader* header = node_header(payload);
+    header->level = level;
+    header->free_end = static_cast<uint16_t>(PAYLOAD_SIZE);
+    header->right_sibling = INVALID_PAGE_ID;
+    header->leftmost = INVALID_PAGE_ID;
+}
+
+/// Сдвинуть записи к концу страницы, убрав место удалённых
+void compact(char* payload) {
+    std::array<char, PAYLOAD_SIZE> copy;
+    std::memcpy(copy.data(), payload, PAYLOAD_SIZE);
+    
+    NodeHeader* header = node_header(payload);
+    std::size_t end = PAYLOAD_SIZE;
+    for (std::size_t i = 0; i < header->count; ++i) {
+        Entry entry = read_entry(copy.data(), i);
+        std::size_t size = entry_size(entry.key.size(), header->level);
+        end -= size;
+        std::memcpy(payload + end, copy.data() + slot_offset(copy.data(), i), size);
+        set_slot_offset(payload, i, static_cast<uint16_t>(end));
+    }
+    header->free_end = static_cast<uint16_t>(end);
+    header->garbage = 0;
+}
+
+/// Вставить запись на позицию index; место должно быть (has_room)
+void insert_entry(char* payload, std::size_t index, std::string_view key,
+                  uint64_t rid, PageId child) {
+    NodeHeader* header = node_header(payload);
+    std::size_t size = entry_size(key.size(), header->level);
+    if (header->free_end < HEADER_SIZE + SLOT_SIZE * (header->count + 1) + size) {
+        compact(payload);
+    }
+    
+    header->free_end = static_cast<uint16_t>(header->free_end - size);
+    char* data = payload + header->free_end;
+    auto key_size = static_cast<uint16_t>(key.size());
+    std::memcpy(data, &key_size, sizeof(key_size));
+    std::memcpy(data + sizeof(key_size), key.data(), key.size());
+    std::memcpy(data + sizeof(key_size) + key.size(), &rid, sizeof(rid));
+    if (header->level != 0) {
+        std::memcpy(data + sizeof(key_size) + key.size() + sizeof(rid), &child, sizeof(child));
+    }
+    
+    char* slot = payload + HEADER_SIZE + SLOT_SIZE * index;
+    std::memmove(slot + SLOT_SIZE, slot, SLOT_SIZE * (header->count - index));
+    set_slot_offset(payload, index, header->free_end);
+    header->count++;
+}
+
+void erase_entry(char* payload, std::size_t index) {
+    NodeHeader* header = node_header(payload);
+    Entry entry = read_entry(payload, index);
+    header->garbage = static_cast<uint16_t>(header->garbage + entry_size(entry.key.size(), header->level));
+    
+    char* slot = payload + HEADER_SIZE + SLOT_SIZE * index;
+    std::memmove(slot, slot + SLOT_SIZE, SLOT_SIZE * (header->count - index - 1));
+    header->count--;
+    if (header->count == 0) {
+        header->free_end = static_cast<uint16_t>(PAYLOAD_SIZE);
+        header->garbage = 0;
+    }
+}
+
+/// Записи [from, to) узла src — в конец узла dst
+void copy_entries(const char* src, std::size_t from, std::size_t to, char* dst) {
+    for (std::size_t i = from; i < to; ++i) {
+        Entry entry = read_entry(src, i);
+        insert_entry(dst, node_header(dst)->count, entry.key, entry.rid, entry.child);
+    }
+}
+
+/// Флаги заголовка страницы по уровню узла
+void mark_kind(Page* page) {
+    page->set_flags(node_header(page->payload())->level == 0 ? PageFlags::LEAF : PageFlags::INTERNAL);
+}
+
+/// Готовые узлы bulk load'а: копятся пакетом во frame'ах, занятых у
+/// buffer pool'а, и пишутся на диск одной записью мимо pool'а и лога.
+/// finish() доводит их до диска — раньше commit'а, после которого на
+/// них сошлётся корень
+class NodeWriter {
+public:
+    NodeWriter(BufferPool& buffer_pool, TxnContext& txn, std::size_t batch_pages)
+        : buffer_pool_(buffer_pool)
+        , txn_(txn)
+        , frames_(buffer_pool.borrow_frames(batch_pages))
+    {
+    }
+    
+    ~NodeWriter() {
+        buffer_pool_.release_frames(frames_);
+    }
+    
+    NodeWriter(const NodeWriter&) = delete;
+    NodeWriter& operator=(const NodeWriter&) = delete;
+    
+    /// false — не досталось ни одного frame'а
+    bool ready() const { return !frames_.empty(); }
+    
+    /// Страница под узел (запоминается в txn.allocated).
+    /// INVALID_PAGE_ID — файл не удалось расширить
+    PageId allocate() {
+        PageId page_id = buffer_pool_.disk_manager()->allocate_page();
+        if (page_id != INVALID_PAGE_ID) {
+            txn_.allocated.push_back(page_id);
+        }
+        return page_id;
+    }
+    
+    bool write(PageId page_id, const char* node) {
+        if (batch_.size() == frames_.size() && !flush()) {
+            return false;
+        }
+        
+        Page* page = frames_[batch_.size()];
+        page->clear();
+        page->set_page_id(page_id);
+        std::memcpy(page->payload(), node, PAYLOAD_SIZE);
+        mark_kind(page);
+        page->set_lsn(txn_.last_lsn);
+        batch_.push_back(PageIo{page_id, page});
+        return true;
+    }
+    
+    bool finish() {
+        return flush() && buffer_pool_.disk_manager()->sync();
+    }
+    
+private:
+    bool flush() {
+        if (batch_.empty()) {
+            return true;
+        }
+        bool ok = buffer_pool_.write_new_pages(batch_);
+        batch_.clear();
+        if (!ok) {
+            Logger::error("BTree: bulk load failed to write nodes");
+        }
+        return ok;
+    }
+    
+    BufferPool& buffer_pool_;
+    TxnContext& txn_;
+    std::vector<Page*> frames_;
+    std::vector<PageIo> batch_;
+};
+
+/// Уровни дерева, заполняемые слева направо все сразу. Узел пишется,
+/// когда следующий элемент в него не помещается (страница правого
+/// соседа к этому моменту выделена), и его первый ключ уходит уровнем
+/// выше. Единственный узел верхнего уровня — содержимое корня
+class BulkBuilder {
+public:
+    BulkBuilder(NodeWriter& writer, double fill_factor)
+        : writer_(writer)
+        , limit_(static_cast<std::size_t>(std::clamp(fill_factor, 0.1, 1.0) *
+                                          static_cast<double>(PAYLOAD_SIZE - HEADER_SIZE)))
+    {
+    }
+    
+    bool add(std::size_t level, std::string_view key, uint64_t rid, PageId child) {
+        if (level == levels_.size()) {
+            levels_.push_back(std::make_unique<Level>());
+            init_node(levels_.back()->node.data(), static_cast<uint16_t>(level));
+        }
+        Level& current = *levels_[level];
+        char* node = current.node.data();
+        
+        std::size_t size = entry_size(key.size(), static_cast<uint16_t>(level));
+        std::size_t used = PAYLOAD_SIZE - HEADER_SIZE - total_free(node);
+        if (current.started && (!has_room(node, size) || used + size + SLOT_SIZE > limit_)) {
+            if (current.page_id == INVALID_PAGE_ID) {
+                current.page_id = writer_.allocate();
+            }
+            PageId next_id = writer_.allocate();
+            if (current.page_id == INVALID_PAGE_ID || next_id == INVALID_PAGE_ID) {
+                return false;
+            }
+            node_header(node)->right_sibling = next_id;
+            if (!writer_.write(current.page_id, node)) {
+                return false;
+            }
+            
+            std::string first_key = std::move(current.first_key);
+            PageId page_id = current.page_id;
+            current.page_id = next_id;
+            current.started = false;
+            init_node(node, static_cast<uint16_t>(level));
+            if (!add(level + 1, first_key, current.first_rid, page_id)) {
+                return false;
+            }
+        }
+        
+        // Первый элемент внутреннего узла — его leftmost
+        if (!current.started) {
+            current.started = true;
+            current.first_key.assign(key.data(), key.size());
+            current.first_rid = rid;
+            if (level != 0) {
+                node_header(node)->leftmost = child;
+                return true;
+            }
+        }
+        insert_entry(node, node_header(node)->count, key, rid, child);
+        return true;
+    }
+    
+    /// Записать правые узлы уровней; узел верхнего уровня отдаётся
+    /// write_root. Без единого add() корень не меняется
+    bool finish(const std::function<bool(const char*)>& write_root) {
+        for (std::size_t level = 0; level < levels_.size(); ++level) {
+            Level& current = *levels_[level];
+            if (current.page_id == INVALID_PAGE_ID) {
+                return write_root(current.node.data());
+            }
+            if (!writer_.write(current.page_id, current.node.data()) ||
+                !add(level + 1, current.first_key, current.first_rid, current.page_id)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+private:
+    struct Level {
+        std::array<char, PAYLOAD_SIZE> node;
+        bool started = false;
+        std::string first_key;
+        uint64_t first_rid = 0;
+        
+        /// Страница текущего узла; у первого узла — с его записи
+        PageId page_id = INVALID_PAGE_ID;
+    };
+    
+    NodeWriter& writer_;
+    std::size_t limit_;
+    
+    // unique_ptr: add() следующего уровня не двигает текущий
+    std::vector<std::unique_ptr<Level>> levels_;
+};
+
+} // namespace
+
+// ============================================================================
+// BTree
+// ============================================================================
+
+BTree::BTree(std::shared_ptr<BufferPool> buffer_pool,
+             std::shared_ptr<WriteAheadLog> wal,
+             PageId root_page)
+    : buffer_pool_(std::move(buffer_pool))
+    , wal_(std::move(wal))
+    , root_page_(root_page)
+{
+}
+
+PageId BTree::create(BufferPool& buffer_pool, WriteAheadLog& wal, TxnContext& txn) {
+    PageId page_id = INVALID_PAGE_ID;
+    Page* page = new_txn_page(buffer_pool, txn, &page_id);
+    if (!page) {
+        return INVALID_PAGE_ID;
+    }
+    
+    modify_page(wal, txn, page, [&](char* payload) { init_node(payload, 0); });
+    mark_kind(page);
+    buffer_pool.unpin_page(page_id, true);
+    return page_id;
+}
+
+// ============================================================================
+// Modifications
+// ============================================================================
+
+bool BTree::insert(TxnContext& txn, std::string_view key, RecordId rid) {
+    if (key.size() > MAX_KEY_SIZE) {
+        return false;
+    }
+    
+    Outcome outcome;
+    while ((outcome = try_insert(txn, key, pack(rid))) == Outcome::RESTART) {
+    }
+    return outcome == Outcome::DONE;
+}
+
+bool BTree::remove(TxnContext& txn, std::string_view key, RecordId rid) {
+    if (key.size() > MAX_KEY_SIZE) {
+        return false;
+    }
+    
+    Outcome outcome;
+    while ((outcome = try_remove(txn, key, pack(rid))) == Outcome::RESTART) {
+    }
+    return outcome == Outcome::DONE;
+}
+
+bool BTree::bulk_load(TxnContext& txn, const std::function<bool(IndexEntry&)>& next,
+                      const IndexBuildConfig& config) {
+    Page* root = pin(root_page_);
+    if (!root) {
+        return false;
+    }
+    bool empty = node_count(root->payload()) == 0 && node_header(root->payload())->level == 0;
+    buffer_pool_->unpin_page(root_page_, false);
+    if (!empty) {
+        Logger::error("BTree: bulk load into non-empty tree {}", root_page_);
+        return false;
+    }
+    
+    std::size_t batch_pages = std::clamp<std::size_t>(config.write_batch_pages, 1,
+                                                      std::max<std::size_t>(buffer_pool_->capacity() / 4, 1));
+    NodeWriter writer(*buffer_pool_, txn, batch_pages);
+    if (!writer.ready()) {
+        Logger::error("BTree: no free frames for bulk load");
+        return false;
+    }
+    
+    // Листья — потоком из next, верхние уровни — из их первых ключей
+    BulkBuilder builder(writer, config.fill_factor);
+    IndexEntry entry;
+    std::string prev_key;
+    uint64_t prev_rid = 0;
+    bool first = true;
+    while (next(entry)) {
+        uint64_t rid = pack(entry.rid);
+        if (entry.key.size() > MAX_KEY_SIZE) {
+            Logger::error("BTree: bulk load key of {} bytes is too long", entry.key.size());
+            return false;
+        }
+        if (!first && compare(entry.key, rid, prev_key, prev_rid) <= 0) {
+            Logger::error("BTree: bulk load input is not sorted");
+            return false;
+        }
+        if (!builder.add(0, entry.key, rid, INVALID_PAGE_ID)) {
+            return false;
+        }
+        prev_key.swap(entry.key);
+        prev_rid = rid;
+        first = false;
+    }
+    
+    // Узлы на диске до изменения корня; в лог идёт только корень
+    std::array<char, PAYLOAD_SIZE> top;
+    bool has_top = false;
+    if (!builder.finish([&](const char* node) {
+            std::memcpy(top.data(), node, PAYLOAD_SIZE);
+            has_top = true;
+            return true;
+        }) || !writer.finish()) {
+        return false;
+    }
+    if (!has_top) {
+        return true;
+    }
+    
+    root = pin(root_page_);
+    if (!root) {
+        return false;
+    }
+    root->write_lock();
+    modify_page(*wal_, txn, root, [&](char* payload) {
+        std::memcpy(payload, top.data(), PAYLOAD_SIZE);
+    });
+    mark_kind(root);
+    root->write_unlock();
+    buffer_pool_->unpin_page(root_page_, true);
+    return true;
+}
+
+bool BTree::destroy(TxnContext& txn) {
+    std::vector<PageId> level{root_page_};
+    while (!level.empty()) {
+        std::vector<PageId> below;
+        for (PageId page_id : level) {
+            Page* page = pin(page_id);
+            if (!page) {
+                return false;
+            }
+            
+            const char* payload = page->payload();
+            if (node_header(payload)->level != 0) {
+                below.push_back(node_header(payload)->leftmost);
+                for (std::size_t i = 0; i < node_count(payload); ++i) {
+                    below.push_back(read_entry(payload, i).child);
+                }
+            }
+            buffer_pool_->unpin_page(page_id, false);
+            txn.freed.push_back(page_id);
+        }
+        level = std::move(below);
+    }
+    return true;
+}
+
+// ============================================================================
+// Lookups
+// ============================================================================
+
+std::vector<RecordId> BTree::lookup(std::string_view key) const {
+    std::vector<RecordId> rids;
+    scan(key, [&](std::string_view found, RecordId rid) {
+        if (found != key) {
+            return false;
+        }
+        rids.push_back(rid);
+        return true;
+    });
+    return rids;
+}
+
+bool BTree::scan(std::string_view from,
+                 const std::function<bool(std::string_view, RecordId)>& fn) const {
+    // Продолжение: первая пара не меньше (key, rid)
+    std::string key(from);
+    uint64_t rid = 0;
+    std::vector<std::pair<std::string, uint64_t>> batch;
+    
+    uint64_t version = 0;
+    Page* leaf = find_leaf(key, rid, version);
+    while (leaf) {
+        PageId leaf_id = leaf->page_id();
+        const char* payload = leaf->payload();
+        batch.clear();
+        for (std::size_t i = lower_bound(payload, key, rid), count = node_count(payload); i < count; ++i) {
+            Entry entry = read_entry(payload, i);
+            batch.emplace_back(entry.key, entry.rid);
+        }
+        PageId next = node_header(payload)->right_sibling;
+        bool valid = leaf->validate(version);
+        buffer_pool_->unpin_page(leaf_id, false);
+        
+        // Лист изменился во время чтения — заново от продолжения
+        if (!valid) {
+            leaf = find_leaf(key, rid, version);
+            continue;
+        }
+        
+        // fn — без пина: обработка записей не держит лист
+        for (const auto& [entry_key, entry_rid] : batch) {
+            if (!fn(entry_key, unpack(entry_rid))) {
+                return true;
+            }
+        }
+        if (!batch.empty()) {
+            key = batch.back().first;
+            rid = batch.back().second + 1;
+        }
+        if (next == INVALID_PAGE_ID) {
+            return true;
+        }
+        
+        leaf = pin(next);
+        if (leaf) {
+            version = leaf->read_version();
+        }
+    }
+    return false;
+}
+
+std::size_t BTree::height() const {
+    Page* root = pin(root_page_);
+    if (!root) {
+        return 0;
+    }
+    
+    std::size_t height;
+    uint64_t version;
+    do {
+        version = root->read_version();
+        height = node_header(root->payload())->level + 1u;
+    } while (!root->validate(version));
+    
+    buffer_pool_->unpin_page(root_page_, false);
+    return height;
+}
+
+// ============================================================================
+// Private helpers
+// ============================================================================
+
+BTree::Outcome BTree::try_insert(TxnContext& txn, std::string_view key, uint64_t rid) {
+    Page* node = pin(root_page_);
+    if (!node) {
+        return Outcome::FAILED;
+    }
+    uint64_t version = node->read_version();
+    Page* parent = nullptr;
+    uint64_t parent_version = 0;
+    
+    auto finish = [&](Outcome outcome, bool dirty) {
+        if (parent) {
+            buffer_pool_->unpin_page(parent->page_id(), dirty);
+        }
+        buffer_pool_->unpin_page(node->page_id(), dirty);
+        return outcome;
+    };
+    
+    while (true) {
+        const char* payload = node->payload();
+        bool leaf = node_header(payload)->level == 0;
+        
+        // Полный узел делится на спуске: у split'а ниже родитель с местом.
+        // Latch'и — сверху вниз, как и у всех писателей
+        if (!has_room(payload, leaf ? entry_size(key.size(), 0) : MAX_INTERNAL_ENTRY)) {
+            if (parent && !parent->try_upgrade(parent_version)) {
+                return finish(Outcome::RESTART, false);
+            }
+            if (!node->try_upgrade(version)) {
+                if (parent) {
+                    parent->write_unlock();
+                }
+                return finish(Outcome::RESTART, false);
+            }
+            
+            bool split_ok = split(txn, parent, node);
+            node->write_unlock();
+            if (parent) {
+                parent->write_unlock();
+            }
+            return finish(split_ok ? Outcome::RESTART : Outcome::FAILED, true);
+        }
+        if (leaf) {
+            break;
+        }
+        
+        PageId child_id = child_for(payload, key, rid);
+        if (!node->validate(version)) {
+            return finish(Outcome::RESTART, false);
+        }
+        Page* child = pin(child_id);
+        if (!child) {
+            return finish(Outcome::FAILED, false);
+        }
+        uint64_t child_version = child->read_version();
+        if (!node->validate(version)) {
+            buffer_pool_->unpin_page(child_id, false);
+            return finish(Outcome::RESTART, false);
+        }
+        
+        if (parent) {
+            buffer_pool_->unpin_page(parent->page_id(), false);
+        }
+        parent = node;
+        parent_version = version;
+        node = child;
+        version = child_version;
+    }
+    
+    // Версия листа не менялась с проверки родителя — ключ принадлежит ему
+    if (parent) {
+        buffer_pool_->unpin_page(parent->page_id(), false);
+        parent = nullptr;
+    }
+    if (!node->try_upgrade(version)) {
+        return finish(Outcome::RESTART, false);
+    }
+    
+    std::size_t index = lower_bound(node->payload(), key, rid);
+    bool exists = false;
+    if (index < node_count(node->payload())) {
+        Entry entry = read_entry(node->payload(), index);
+        exists = compare(entry.key, entry.rid, key, rid) == 0;
+    }
+    if (!exists) {
+        modify_page(*wal_, txn, node, [&](char* payload) {
+            insert_entry(payload, index, key, rid, INVALID_PAGE_ID);
+        });
+    }
+    node->write_unlock();
+    return finish(exists ? Outcome::FAILED : Outcome::DONE, !exists);
+}
+
+BTree::Outcome BTree::try_remove(TxnContext& txn, std::string_view key, uint64_t rid) {
+    uint64_t version = 0;
+    Page* leaf = find_leaf(key, rid, version);
+    if (!leaf) {
+        return Outcome::FAILED;
+    }
+    PageId leaf_id = leaf->page_id();
+    if (!leaf->try_upgrade(version)) {
+        buffer_pool_->unpin_page(leaf_id, false);
+        return Outcome::RESTART;
+    }
+    
+    std::size_t index = lower_bound(leaf->payload(), key, rid);
+    bool exists = false;
+    if (index < node_count(leaf->payload())) {
+        Entry entry = read_entry(leaf->payload(), index);
+        exists = compare(entry.key, entry.rid, key, rid) == 0;
+    }
+    if (exists) {
+        modify_page(*wal_, txn, leaf, [&](char* payload) { erase_entry(payload, index); });
+    }
+    leaf->write_unlock();
+    buffer_pool_->unpin_page(leaf_id, exists);
+    return exists ? Outcome::DONE : Outcome::FAILED;
+}
+
+bool BTree::split(TxnContext& txn, Page* parent, Page* node) {
+    std::array<char, PAYLOAD_SIZE> copy;
+    std::memcpy(copy.data(), node->payload(), PAYLOAD_SIZE);
+    const char* src = copy.data();
+    const NodeHeader* header = node_header(src);
+    std::size_t count = node_count(src);
+    
+    // Граница — середина занятых байт
+    std::size_t used = PAYLOAD_SIZE - HEADER_SIZE - total_free(src);
+    std::size_t mid = 0;
+    for (std::size_t acc = 0; mid + 1 < count && acc < used / 2; ++mid) {
+        acc += entry_size(read_entry(src, mid).key.size(), header->level) + SLOT_SIZE;
+    }
+    mid = std::max<std::size_t>(mid, 1);
+    
+    // Лист копирует первый ключ правой половины наверх, внутренний узел
+    // отдаёт его родителю вместе с ребёнком как leftmost правой половины
+    Entry separator = read_entry(src, mid);
+    bool leaf = header->level == 0;
+    std::size_t right_from = leaf ? mid : mid + 1;
+    PageId right_leftmost = leaf ? INVALID_PAGE_ID : separator.child;
+    
+    PageId right_id = INVALID_PAGE_ID;
+    Page* right = new_txn_page(*buffer_pool_, txn, &right_id);
+    if (!right) {
+        return false;
+    }
+    
+    if (!parent) {
+        // Корень остаётся на месте: левая половина тоже уходит в новый узел
+        PageId left_id = INVALID_PAGE_ID;
+        Page* left = new_txn_page(*buffer_pool_, txn, &left_id);
+        if (!left) {
+            buffer_pool_->unpin_page(right_id, false);
+            return false;
+        }
+        modify_page(*wal_, txn, left, [&](char* payload) {
+            init_node(payload, header->level);
+            node_header(payload)->leftmost = header->leftmost;
+            node_header(payload)->right_sibling = right_id;
+            copy_entries(src, 0, mid, payload);
+        });
+        modify_page(*wal_, txn, right, [&](char* payload) {
+            init_node(payload, header->level);
+            node_header(payload)->leftmost = right_leftmost;
+            copy_entries(src, right_from, count, payload);
+        });
+        modify_page(*wal_, txn, node, [&](char* payload) {
+            init_node(payload, static_cast<uint16_t>(header->level + 1));
+            node_header(payload)->leftmost = left_id;
+            insert_entry(payload, 0, separator.key, separator.rid, right_id);
+        });
+        mark_kind(left);
+        mark_kind(right);
+        mark_kind(node);
+        buffer_pool_->unpin_page(left_id, true);
+        buffer_pool_->unpin_page(right_id, true);
+        return true;
+    }
+    
+    // Правая половина заполняется до того, как на неё сошлются
+    modify_page(*wal_, txn, right, [&](char* payload) {
+        init_node(payload, header->level);
+        node_header(payload)->leftmost = right_leftmost;
+        node_header(payload)->right_sibling = header->right_sibling;
+        copy_entries(src, right_from, count, payload);
+    });
+    modify_page(*wal_, txn, node, [&](char* payload) {
+        init_node(payload, header->level);
+        node_header(payload)->leftmost = header->leftmost;
+        node_header(payload)->right_sibling = right_id;
+        copy_entries(src, 0, mid, payload);
+    });
+    modify_page(*wal_, txn, parent, [&](char* payload) {
+        std::size_t index = lower_bound(payload, separator.key, separator.rid);
+        insert_entry(payload, index, separator.key, separator.rid, right_id);
+    });
+    mark_kind(right);
+    buffer_pool_->unpin_page(right_id, true);
+    return true;
+}
+
+Page* BTree::find_leaf(std::string_view key, uint64_t rid, uint64_t& version) const {
+    while (true) {
+        Page* node = pin(root_page_);
+        if (!node) {
+            return nullptr;
+        }
+        version = node->read_version();
+        
+        bool restart = false;
+        while (node_header(node->payload())->level != 0) {
+            PageId child_id = child_for(node->payload(), key, rid);
+            if (!node->validate(version)) {
+                restart = true;
+                break;
+            }
+            Page* child = pin(child_id);
+            if (!child) {
+                buffer_pool_->unpin_page(node->page_id(), false);
+                return nullptr;
+            }
+            uint64_t child_version = child->read_version();
+            restart = !node->validate(version);
+            buffer_pool_->unpin_page(node->page_id(), false);
+            node = child;
+            version = child_version;
+            if (restart) {
+                break;
+            }
+        }
+        
+        if (!restart) {
+            return node;
+        }
+        buffer_pool_->unpin_page(node->page_id(), false);
+    }
+}
+
+Page* BTree::pin(PageId page_id) const {
+    Page* page = buffer_pool_->fetch_page(page_id);
+    if (!page) {
+        Logger::error("BTree: cannot pin page {}", page_id);
+    }
+    return page;
+}
+
+} // namespace datyredb::storage
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "storage/storage_types.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/wal.hpp"
+#include "storage/txn_context.hpp"
+#include "storage/heap_file.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace datyredb::storage {
+
+/// Элемент индекса: ключ и запись heap file'а
+struct IndexEntry {
+    std::string key;
+    RecordId rid;
+};
+
+/// B+tree на страницах buffer pool'а: ключи — байтовые строки (порядок
+/// memcmp), значения — RecordId. Пара (ключ, RecordId) уникальна, поэтому
+/// одинаковые ключи разных записей допустимы и лежат рядом.
+///
+/// Узел — slotted-страница: заголовок, за ним отсортированный каталог
+/// смещений записей {uint16 длина ключа, ключ, uint64 RecordId[, uint32
+/// ребёнок]}; записи лежат от конца payload вниз. Внутренний узел хранит
+/// ребёнка для ключей меньше первой записи в заголовке (leftmost).
+/// Листья связаны ссылками вправо — по ним идёт scan(). Корень не
+/// переезжает: при его split'е содержимое уходит в два новых узла, а
+/// корень становится их родителем, поэтому дерево задаётся страницей
+/// корня.
+///
+/// Конкурентность — optimistic lock coupling на version latch'ах
+/// страниц: спуск читает узлы без блокировок и проверяет версии,
+/// писатель захватывает только изменяемые узлы. Полные внутренние узлы
+/// делятся заранее на спуске, поэтому split листа меняет не больше
+/// одного родителя. Конфликт — повтор операции с корня. Узлы не
+/// сливаются: remove() только удаляет запись из листа.
+///
+/// Каждое изменение узла — UPDATE в лог через modify_page(); откат
+/// транзакции физическими образами корректен, пока её изменения узлов
+/// не перемешаны с чужими (StorageEngine выполняет транзакцию целиком
+/// под своим lock'ом). destroy() не потокобезопасен.
+class BTree {
+public:
+    /// Ключи длиннее не хранятся
+    static constexpr std::size_t MAX_KEY_SIZE = 256;
+    
+    BTree(std::shared_ptr<BufferPool> buffer_pool,
+          std::shared_ptr<WriteAheadLog> wal,
+          PageId root_page);
+    
+    /// Новое пустое дерево; INVALID_PAGE_ID — нет свободного frame'а
+    static PageId create(BufferPool& buffer_pool, WriteAheadLog& wal, TxnContext& txn);
+    
+    PageId root_page() const { return root_page_; }
+    
+    // ========================================================================
+    // Modifications
+    // ========================================================================
+    
+    /// false — ключ длиннее MAX_KEY_SIZE, пара уже есть или ошибка
+    bool insert(TxnContext& txn, std::string_view key, RecordId rid);
+    
+    /// false — пары нет или ошибка
+    bool remove(TxnContext& txn, std::string_view key, RecordId rid);
+    
+    /// Заполнить пустое дерево снизу вверх. next выдаёт элементы строго
+    /// по возрастанию (ключ, RecordId) и возвращает false в конце.
+    /// Узлы заполняются до config.fill_factor и пишутся на диск пакетами
+    /// мимо buffer pool'а и лога (с fdatasync до возврата); в лог идёт
+    /// только корень. Не совмещается с другими изменениями дерева
+    bool bulk_load(TxnContext& txn, const std::function<bool(IndexEntry&)>& next,
+                   const IndexBuildConfig& config = {});
+    
+    /// Все страницы дерева — в txn.freed; дерево больше не используется
+    bool destroy(TxnContext& txn);
+    
+    // ========================================================================
+    // Lookups
+    // ========================================================================
+    
+    /// Записи с ключом key
+    std::vector<RecordId> lookup(std::string_view key) const;
+    
+    /// Обход по возрастанию от первого ключа не меньше from; fn
+    /// возвращает false, чтобы остановиться. Вставки, конкурентные с
+    /// обходом, могут быть не видны. false — ошибка чтения страницы
+    bool scan(std::string_view from,
+              const std::function<bool(std::string_view, RecordId)>& fn) const;
+    
+    /// Число уровней (1 — корень-лист); 0 — ошибка чтения
+    std::size_t height() const;
+    
+private:
+    enum class Outcome { DONE, RESTART, FAILED };
+    
+    Outcome try_insert(TxnContext& txn, std::string_view key, uint64_t rid);
+    Outcome try_remove(TxnContext& txn, std::string_view key, uint64_t rid);
+    
+    /// Поделить узел, захваченный вызывающим вместе с родителем (nullptr —
+    /// узел является корнем)
+    bool split(TxnContext& txn, Page* parent, Page* node);
+    
+    /// Лист, где лежит или должна лежать пара (key, rid), с пином и
+    /// версией; nullptr — ошибка чтения
+    Page* find_leaf(std::string_view key, uint64_t rid, uint64_t& version) const;
+    
+    /// Страница с пином; nullptr — все frame'ы заняты
+    Page* pin(PageId page_id) const;
+    
+    std::shared_ptr<BufferPool> buffer_pool_;
+    std::shared_ptr<WriteAheadLog> wal_;
+    PageId root_page_;
+};
+
+} // namespace datyredb::storage
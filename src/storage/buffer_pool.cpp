@@ -1,27 +1,81 @@
 #include "storage/buffer_pool.hpp"
 #include "utils/logger.hpp"
 
+#include <algorithm>
+#include <thread>
+
 namespace datyredb::storage {
 
+// ============================================================================
+// Partition
+// ============================================================================
+
+BufferPool::Partition::Partition(std::size_t frame_count, const BufferPoolConfig& config,
+                                 PageArena& arena, std::size_t first_page)
+    : page_table(frame_count)
+    , policy(make_eviction_policy(config, frame_count))
+{
+    static_assert(sizeof(Frame) == 64, "frame metadata must fit one cache line");
+    
+    // reserve обязателен: перемещение Frame скопировало бы страницу из арены
+    frames.reserve(frame_count);
+    for (std::size_t i = 0; i < frame_count; ++i) {
+        frames.emplace_back(arena.page(first_page + i));
+        free_list.push_back(i);
+    }
+}
+
+// ============================================================================
+// BufferPool
+// ============================================================================
+
 BufferPool::BufferPool(std::size_t pool_size,
                        std::shared_ptr<DiskManager> disk_manager,
-                       std::shared_ptr<CheckpointMetrics> metrics)
+                       std::shared_ptr<CheckpointMetrics> metrics,
+                       BufferPoolConfig config,
+                       std::shared_ptr<WriteAheadLog> wal)
     : pool_size_(pool_size)
     , disk_manager_(std::move(disk_manager))
     , metrics_(std::move(metrics))
-    , frames_(pool_size)
+    , wal_(std::move(wal))
+    , arena_(pool_size, config.huge_pages)
+    , eviction_policy_(config.eviction_policy)
+    , read_ahead_(config.read_ahead)
+    , read_ahead_window_(std::clamp<std::size_t>(config.read_ahead_window, 1,
+                                                 std::max<std::size_t>(pool_size / 4, 1)))
+    , read_ahead_trigger_(std::max<std::size_t>(config.read_ahead_trigger, 1))
 {
-    // Инициализация free list
-    for (std::size_t i = 0; i < pool_size_; ++i) {
-        free_list_.push_back(i);
+    std::size_t count = choose_partition_count(pool_size_, config);
+    partition_mask_ = count - 1;
+    
+    // Фреймы делим поровну, остаток — первым партициям.
+    // Каждая партиция получает непрерывный участок арены
+    partitions_.reserve(count);
+    std::size_t first_page = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t frames = pool_size_ / count + (i < pool_size_ % count ? 1 : 0);
+        partitions_.push_back(std::make_unique<Partition>(frames, config, arena_, first_page));
+        first_page += frames;
+    }
+    
+    // Арена — зарегистрированный буфер io_uring: чтения и записи страниц
+    // идут как READ_FIXED/WRITE_FIXED без pinning'а памяти на каждый запрос
+    io_backend_ = disk_manager_->io_backend();
+    if (io_backend_) {
+        io_backend_->register_buffer(arena_.page(0), arena_.mapped_size());
     }
     
-    Logger::info("BufferPool initialized: {} frames ({} MB)",
-                 pool_size_, 
-                 (pool_size_ * PAGE_SIZE) / (1024 * 1024));
+    Logger::info("BufferPool initialized: {} frames ({} MB), {} partitions, eviction={}, huge_pages={}",
+                 pool_size_,
+                 (pool_size_ * PAGE_SIZE) / (1024 * 1024),
+                 count,
+                 eviction_policy_name(eviction_policy_),
+                 huge_pages_name(arena_.backing()));
 }
 
 BufferPool::~BufferPool() {
+    stop_prefetcher();
+    
     // Flush все dirty pages при shutdown
     auto dirty = get_dirty_pages();
     if (!dirty.empty()) {
@@ -29,66 +83,117 @@ BufferPool::~BufferPool() {
         flush_pages(dirty);
         sync_all();
     }
+    
+    // Адрес арены после munmap может достаться другому отображению
+    if (io_backend_) {
+        io_backend_->unregister_buffer(arena_.page(0));
+    }
 }
 
 Page* BufferPool::fetch_page(PageId page_id) {
-    std::unique_lock lock(latch_);
+    Partition& part = partition_for(page_id);
     
-    // Проверяем, есть ли страница в pool
-    auto it = page_table_.find(page_id);
-    if (it != page_table_.end()) {
-        auto& frame = frames_[it->second];
-        frame.page.pin();
-        frame.referenced = true;  // Для Clock-Sweep
-        return &frame.page;
+    // Быстрый путь: страница в pool — без latch
+    if (Page* page = try_fetch_resident(part, page_id)) {
+        return page;
     }
     
-    // Нужно загрузить с диска — ищем victim frame
-    Frame* frame = find_victim_frame();
-    if (!frame) {
-        Logger::error("BufferPool: no available frames (all pinned)");
-        return nullptr;
+    std::unique_lock lock(part.latch);
+    
+    Frame* frame = nullptr;
+    bool counted = false;
+    for (;;) {
+        // Перепроверяем под latch: страницу мог загрузить другой поток
+        std::size_t existing = part.page_table.find(page_id);
+        while (existing != PageTable::NOT_FOUND) {
+            auto& resident = part.frames[existing];
+            if (resident.page.try_pin()) {
+                if (frame) {
+                    release_to_free_list(part, frame);
+                }
+                part.policy->record_access(existing);
+                part.counters.hits.fetch_add(1, std::memory_order_relaxed);
+                return &resident.page;
+            }
+            
+            // Frame ещё читается read-ahead'ом или вытесняется (вне latch) —
+            // ждём завершения
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+            existing = part.page_table.find(page_id);
+        }
+        
+        if (frame) {
+            break;
+        }
+        
+        if (!counted) {
+            counted = true;
+            part.counters.misses.fetch_add(1, std::memory_order_relaxed);
+            note_miss(page_id);
+        }
+        
+        // Нужно загрузить с диска — ищем victim frame. Запись dirty victim'а
+        // отпускает latch, поэтому page table проверяется ещё раз
+        frame = find_victim_frame(part, lock);
+        if (!frame) {
+            Logger::error("BufferPool: no available frames (all pinned)");
+            return nullptr;
+        }
     }
     
+    std::size_t frame_idx = frame - part.frames.data();
+    
     // Читаем с диска
     if (!disk_manager_->read_page(page_id, frame->page)) {
         Logger::error("BufferPool: failed to read page {}", page_id);
-        // Возвращаем frame в free list
-        std::size_t idx = frame - frames_.data();
-        free_list_.push_back(idx);
+        release_to_free_list(part, frame);
         return nullptr;
     }
     
-    frame->page.pin();
     frame->page.mark_clean();
-    frame->referenced = true;
+    frame->readahead_mark.store(false, std::memory_order_relaxed);
+    part.policy->record_load(frame_idx, page_id);
     
-    // Обновляем page table
-    std::size_t frame_idx = frame - frames_.data();
-    page_table_[page_id] = frame_idx;
+    // Обновляем page table и публикуем frame с одним пином
+    part.page_table.insert(page_id, frame_idx);
+    frame->page.release_exclusive(1);
     
     return &frame->page;
 }
 
 Page* BufferPool::new_page(PageId* out_page_id) {
-    std::unique_lock lock(latch_);
+    // ID нужен заранее — по нему выбирается партиция
+    PageId new_id = disk_manager_->allocate_page();
+    if (new_id == INVALID_PAGE_ID) {
+        Logger::error("BufferPool: failed to allocate new page");
+        return nullptr;
+    }
     
-    Frame* frame = find_victim_frame();
+    Partition& part = partition_for(new_id);
+    std::unique_lock lock(part.latch);
+    
+    Frame* frame = find_victim_frame(part, lock);
     if (!frame) {
         Logger::error("BufferPool: no available frames for new page");
+        disk_manager_->deallocate_page(new_id);
         return nullptr;
     }
     
-    PageId new_id = disk_manager_->allocate_page();
+    // Страница могла быть освобождена и снова выдана: старый frame
+    // (например, загруженный read-ahead'ом после удаления) отбрасываем.
+    // После поиска victim'а — его запись могла отпускать latch
+    drop_stale(part, new_id, lock);
     
-    frame->page.reset();
+    frame->page.clear();
     frame->page.set_page_id(new_id);
-    frame->page.pin();
-    frame->page.mark_clean();
-    frame->referenced = true;
+    frame->readahead_mark.store(false, std::memory_order_relaxed);
     
-    std::size_t frame_idx = frame - frames_.data();
-    page_table_[new_id] = frame_idx;
+    std::size_t frame_idx = frame - part.frames.data();
+    part.policy->record_load(frame_idx, new_id);
+    part.page_table.insert(new_id, frame_idx);
+    frame->page.release_exclusive(1);
     
     if (out_page_id) {
         *out_page_id = new_id;
@@ -99,194 +204,686 @@ Page* BufferPool::new_page(PageId* out_page_id) {
 }
 
 bool BufferPool::unpin_page(PageId page_id, bool is_dirty) {
-    std::unique_lock lock(latch_);
+    Partition& part = partition_for(page_id);
+    
+    // Вызывающий держит пин — frame не может смениться, latch не нужен
+    std::size_t frame_idx = part.page_table.find(page_id);
+    if (frame_idx != PageTable::NOT_FOUND) {
+        auto& frame = part.frames[frame_idx];
+        if (frame.page.page_id() == page_id && frame.page.is_pinned()) {
+            if (is_dirty) {
+                mark_frame_dirty(frame);
+            }
+            frame.page.unpin();
+            return true;
+        }
+    }
+    
+    // Медленный путь — только для диагностики некорректных вызовов
+    std::shared_lock lock(part.latch);
     
-    auto it = page_table_.find(page_id);
-    if (it == page_table_.end()) {
+    frame_idx = part.page_table.find(page_id);
+    if (frame_idx == PageTable::NOT_FOUND) {
         Logger::warn("BufferPool: unpin on non-existent page {}", page_id);
         return false;
     }
     
-    auto& frame = frames_[it->second];
+    auto& frame = part.frames[frame_idx];
     
     if (frame.page.pin_count() <= 0) {
         Logger::warn("BufferPool: unpin on page {} with pin_count=0", page_id);
         return false;
     }
     
-    frame.page.unpin();
-    
     // Отмечаем dirty если нужно
-    if (is_dirty && !frame.page.is_dirty()) {
-        frame.page.mark_dirty();
-        std::size_t new_count = dirty_count_.fetch_add(1, std::memory_order_relaxed) + 1;
-        metrics_->dirty_page_count.store(new_count, std::memory_order_relaxed);
+    if (is_dirty) {
+        mark_frame_dirty(frame);
     }
     
+    frame.page.unpin();
+    
     return true;
 }
 
 bool BufferPool::flush_page(PageId page_id) {
-    std::unique_lock lock(latch_);
-    
-    auto it = page_table_.find(page_id);
-    if (it == page_table_.end()) {
-        return true;  // Страницы нет в pool — уже на диске
+    Partition& part = partition_for(page_id);
+    Frame* frame = nullptr;
+    {
+        std::shared_lock lock(part.latch);
+        
+        // Frame вытесняется или читается вне latch — ждём: после возврата
+        // страница на диске
+        std::size_t frame_idx = part.page_table.find(page_id);
+        while (frame_idx != PageTable::NOT_FOUND && !part.frames[frame_idx].page.try_pin()) {
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+            frame_idx = part.page_table.find(page_id);
+        }
+        
+        if (frame_idx == PageTable::NOT_FOUND) {
+            return true;  // Страницы нет в pool — уже на диске
+        }
+        frame = &part.frames[frame_idx];
     }
     
-    auto& frame = frames_[it->second];
-    
-    if (!frame.page.is_dirty()) {
-        return true;  // Не dirty — не нужно flush
-    }
+    // Пин держит страницу в pool; снимок, force лога и запись идут без
+    // latch — партиция не стоит на fdatasync, как при eviction
+    bool success = true;
     
-    if (!disk_manager_->write_page(page_id, frame.page)) {
-        Logger::error("BufferPool: failed to flush page {}", page_id);
-        return false;
+    // Сбрасываем флаг ДО записи: конкурентный unpin(dirty) пометит заново
+    if (frame->page.mark_clean()) {
+        if (disk_manager_->write_page(page_id, frame->page, write_ahead())) {
+            std::size_t new_count = dirty_count_.fetch_sub(1, std::memory_order_relaxed) - 1;
+            metrics_->dirty_page_count.store(new_count, std::memory_order_relaxed);
+        } else {
+            Logger::error("BufferPool: failed to flush page {}", page_id);
+            frame->page.mark_dirty();
+            success = false;
+        }
     }
     
-    frame.page.mark_clean();
-    std::size_t new_count = dirty_count_.fetch_sub(1, std::memory_order_relaxed) - 1;
-    metrics_->dirty_page_count.store(new_count, std::memory_order_relaxed);
-    
-    return true;
+    frame->page.unpin();
+    return success;
 }
 
-bool BufferPool::delete_page(PageId page_id) {
-    std::unique_lock lock(latch_);
+bool BufferPool::delete_page(PageId page_id, Lsn freed_lsn) {
+    Partition& part = partition_for(page_id);
+    std::unique_lock lock(part.latch);
+    
+    std::size_t frame_idx = part.page_table.find(page_id);
+    while (frame_idx != PageTable::NOT_FOUND && part.frames[frame_idx].page.pin_count() < 0) {
+        // Frame читается read-ahead'ом или вытесняется (вне latch) — ждём
+        lock.unlock();
+        std::this_thread::yield();
+        lock.lock();
+        frame_idx = part.page_table.find(page_id);
+    }
     
-    auto it = page_table_.find(page_id);
-    if (it == page_table_.end()) {
-        return true;  // Уже удалена
+    if (frame_idx == PageTable::NOT_FOUND) {
+        disk_manager_->deallocate_page(page_id, freed_lsn);
+        return true;
     }
     
-    auto& frame = frames_[it->second];
+    auto& frame = part.frames[frame_idx];
     
-    if (frame.page.is_pinned()) {
+    if (!frame.page.try_acquire_exclusive()) {
         Logger::error("BufferPool: cannot delete pinned page {}", page_id);
         return false;
     }
     
-    if (frame.page.is_dirty()) {
+    if (frame.page.mark_clean()) {
         dirty_count_.fetch_sub(1, std::memory_order_relaxed);
         metrics_->dirty_page_count.fetch_sub(1, std::memory_order_relaxed);
     }
     
-    std::size_t frame_idx = it->second;
-    page_table_.erase(it);
-    free_list_.push_back(frame_idx);
-    frame.page.reset();
+    part.page_table.erase(page_id);
+    part.policy->record_remove(frame_idx);
+    frame.readahead_mark.store(false, std::memory_order_relaxed);
+    frame.page.clear();
+    frame.page.release_exclusive(0);
+    part.free_list.push_back(frame_idx);
     
-    disk_manager_->deallocate_page(page_id);
+    disk_manager_->deallocate_page(page_id, freed_lsn);
     
     return true;
 }
 
-std::vector<PageId> BufferPool::get_dirty_pages() const {
-    std::shared_lock lock(latch_);
+// ============================================================================
+// Work memory
+// ============================================================================
+
+std::vector<Page*> BufferPool::borrow_frames(std::size_t count) {
+    std::vector<Page*> frames;
+    frames.reserve(count);
+    
+    // По кругу по партициям — ни одна не остаётся без свободных frame'ов
+    bool progress = true;
+    while (frames.size() < count && progress) {
+        progress = false;
+        for (auto& part : partitions_) {
+            if (frames.size() == count) {
+                break;
+            }
+            
+            std::unique_lock lock(part->latch);
+            Frame* frame = find_victim_frame(*part, lock);
+            if (!frame) {
+                continue;
+            }
+            
+            // Frame остаётся в эксклюзивном владении (pin count == -1):
+            // ни пин, ни политика вытеснения его не захватят
+            part->policy->record_remove(frame - part->frames.data());
+            frame->readahead_mark.store(false, std::memory_order_relaxed);
+            frame->page.clear();
+            frames.push_back(&frame->page);
+            progress = true;
+        }
+    }
     
+    return frames;
+}
+
+void BufferPool::release_frames(const std::vector<Page*>& frames) {
+    for (Page* page : frames) {
+        // Тела frame'ов партиции — непрерывный участок арены
+        for (auto& part : partitions_) {
+            const char* first = part->frames.front().page.data();
+            if (page->data() < first || page->data() >= first + part->frames.size() * PAGE_SIZE) {
+                continue;
+            }
+            auto offset = static_cast<std::size_t>(page->data() - first);
+            
+            std::unique_lock lock(part->latch);
+            page->clear();
+            page->release_exclusive(0);
+            part->free_list.push_back(offset / PAGE_SIZE);
+            break;
+        }
+    }
+}
+
+bool BufferPool::write_new_pages(std::vector<PageIo>& batch) {
+    std::size_t written = disk_manager_->write_new_pages(batch);
+    
+    // Frame со старым телом (read-ahead по освобождённой странице) иначе
+    // отдал бы его следующему fetch_page
+    for (const auto& io : batch) {
+        Partition& part = partition_for(io.page_id);
+        if (part.page_table.find(io.page_id) == PageTable::NOT_FOUND) {
+            continue;
+        }
+        std::unique_lock lock(part.latch);
+        drop_stale(part, io.page_id, lock);
+    }
+    
+    return written == batch.size();
+}
+
+std::vector<PageId> BufferPool::get_dirty_pages() const {
     std::vector<PageId> result;
     result.reserve(dirty_count_.load(std::memory_order_relaxed));
     
-    for (const auto& [page_id, frame_idx] : page_table_) {
-        if (frames_[frame_idx].page.is_dirty()) {
-            result.push_back(page_id);
-        }
+    for (const auto& part : partitions_) {
+        std::shared_lock lock(part->latch);
+        
+        part->page_table.for_each([&](PageId page_id, std::size_t frame_idx) {
+            if (part->frames[frame_idx].page.is_dirty()) {
+                result.push_back(page_id);
+            }
+        });
+    }
+    
+    return result;
+}
+
+std::vector<DirtyPageEntry> BufferPool::dirty_page_table() const {
+    std::vector<DirtyPageEntry> result;
+    result.reserve(dirty_count_.load(std::memory_order_relaxed));
+    
+    for (const auto& part : partitions_) {
+        std::shared_lock lock(part->latch);
+        
+        part->page_table.for_each([&](PageId page_id, std::size_t frame_idx) {
+            const Page& page = part->frames[frame_idx].page;
+            if (page.is_dirty()) {
+                // page_lsn без latch'а страницы — только эвристика
+                // «холодности» для фоновой записи
+                result.push_back({page_id, page.rec_lsn(), page.get_lsn()});
+            }
+        });
     }
     
     return result;
 }
 
 bool BufferPool::flush_pages(const std::vector<PageId>& pages) {
-    bool success = true;
+    // Собираем dirty страницы под пином (eviction их не тронет), пишем
+    // одним пакетом без latch'ей — DiskManager сольёт соседние в pwritev
+    std::vector<PageIo> batch;
+    std::vector<Frame*> frames;
+    batch.reserve(pages.size());
+    frames.reserve(pages.size());
     
     for (PageId page_id : pages) {
-        if (!flush_page(page_id)) {
-            Logger::error("BufferPool: failed to flush page {}", page_id);
+        Partition& part = partition_for(page_id);
+        std::shared_lock lock(part.latch);
+        
+        // Frame вытесняется или читается вне latch — ждём: checkpoint
+        // полагается на то, что после возврата страница на диске
+        std::size_t frame_idx = part.page_table.find(page_id);
+        while (frame_idx != PageTable::NOT_FOUND && !part.frames[frame_idx].page.try_pin()) {
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+            frame_idx = part.page_table.find(page_id);
+        }
+        
+        if (frame_idx == PageTable::NOT_FOUND) {
+            continue;  // Страницы нет в pool — уже на диске
+        }
+        
+        auto& frame = part.frames[frame_idx];
+        
+        // Сбрасываем флаг ДО записи: конкурентный unpin(dirty) пометит заново
+        if (!frame.page.mark_clean()) {
+            frame.page.unpin();
+            continue;
+        }
+        
+        batch.push_back({page_id, &frame.page});
+        frames.push_back(&frame);
+    }
+    
+    // Снимки страниц, один force лога до их самого свежего page_lsn и
+    // запись снимков — в DiskManager; без лога на диске ничего не пишется
+    disk_manager_->write_pages(batch, write_ahead());
+    
+    // Запускаем writeback всего пакета сразу: итоговый sync_all()
+    // checkpoint'а дожидается уже идущей записи, а не начинает её
+    if (!batch.empty()) {
+        auto [lo, hi] = std::minmax_element(batch.begin(), batch.end(),
+            [](const PageIo& a, const PageIo& b) { return a.page_id < b.page_id; });
+        disk_manager_->start_writeback(lo->page_id, hi->page_id);
+    }
+    
+    bool success = true;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].ok) {
+            std::size_t new_count = dirty_count_.fetch_sub(1, std::memory_order_relaxed) - 1;
+            metrics_->dirty_page_count.store(new_count, std::memory_order_relaxed);
+        } else {
+            Logger::error("BufferPool: failed to flush page {}", batch[i].page_id);
+            frames[i]->page.mark_dirty();
             success = false;
         }
+        frames[i]->page.unpin();
     }
     
     return success;
 }
 
-void BufferPool::sync_all() {
-    disk_manager_->sync();
+bool BufferPool::sync_all() {
+    return disk_manager_->sync();
+}
+
+void BufferPool::prefetch(PageId first, std::size_t count) {
+    if (count == 0) {
+        return;
+    }
+    enqueue_prefetch({first, std::min(count, pool_size_), false});
+}
+
+BufferPoolMetrics BufferPool::metrics() const {
+    BufferPoolMetrics result;
+    for (const auto& part : partitions_) {
+        result.hits += part->counters.hits.load(std::memory_order_relaxed);
+        result.misses += part->counters.misses.load(std::memory_order_relaxed);
+        result.evictions += part->counters.evictions.load(std::memory_order_relaxed);
+        result.prefetched += part->counters.prefetched.load(std::memory_order_relaxed);
+    }
+    return result;
 }
 
 std::size_t BufferPool::page_count() const {
-    std::shared_lock lock(latch_);
-    return page_table_.size();
+    std::size_t total = 0;
+    for (const auto& part : partitions_) {
+        std::shared_lock lock(part->latch);
+        total += part->page_table.size();
+    }
+    return total;
 }
 
-BufferPool::Frame* BufferPool::find_victim_frame() {
-    // Сначала проверяем free list
-    if (!free_list_.empty()) {
-        std::size_t idx = free_list_.front();
-        free_list_.pop_front();
-        return &frames_[idx];
+BufferPool::Partition& BufferPool::partition_for(PageId page_id) {
+    // Fibonacci hashing: последовательные ID равномерно ложатся по партициям
+    uint64_t hash = static_cast<uint64_t>(page_id) * 0x9E3779B97F4A7C15ULL;
+    return *partitions_[(hash >> 32) & partition_mask_];
+}
+
+Page* BufferPool::try_fetch_resident(Partition& part, PageId page_id) {
+    std::size_t frame_idx = part.page_table.find(page_id);
+    if (frame_idx == PageTable::NOT_FOUND) {
+        return nullptr;
     }
     
-    // Clock-Sweep eviction
-    return clock_sweep();
+    auto& frame = part.frames[frame_idx];
+    
+    // Frame захвачен eviction'ом/загрузкой — идём под latch
+    if (!frame.page.try_pin()) {
+        return nullptr;
+    }
+    
+    // Валидация: пока мы читали таблицу, frame мог смениться
+    if (frame.page.page_id() != page_id) {
+        frame.page.unpin();
+        return nullptr;
+    }
+    
+    part.policy->record_access(frame_idx);
+    part.counters.hits.fetch_add(1, std::memory_order_relaxed);
+    
+    // Сканер дошёл до маркера — пора читать следующее окно
+    if (frame.readahead_mark.load(std::memory_order_relaxed) &&
+        frame.readahead_mark.exchange(false, std::memory_order_relaxed)) {
+        schedule_read_ahead(page_id + std::max<std::size_t>(read_ahead_window_ / 2, 1));
+    }
+    
+    return &frame.page;
 }
 
-BufferPool::Frame* BufferPool::clock_sweep() {
-    // Два прохода: первый сбрасывает reference bit
-    for (int pass = 0; pass < 2; ++pass) {
-        for (std::size_t i = 0; i < pool_size_; ++i) {
-            std::size_t idx = (clock_hand_ + i) % pool_size_;
-            auto& frame = frames_[idx];
-            
-            // Пропускаем pinned
-            if (frame.page.is_pinned()) {
-                continue;
-            }
-            
-            // Пропускаем свободные
-            if (frame.page.page_id() == INVALID_PAGE_ID) {
-                continue;
-            }
-            
-            if (frame.referenced) {
-                // Сбрасываем reference bit — даём второй шанс
-                frame.referenced = false;
-                continue;
-            }
-            
-            // Нашли victim!
-            if (!evict_frame(&frame)) {
-                continue;  // Не удалось evict — ищем дальше
-            }
-            
-            clock_hand_ = (idx + 1) % pool_size_;
+BufferPool::Frame* BufferPool::find_victim_frame(Partition& part,
+                                                std::unique_lock<std::shared_mutex>& lock) {
+    // Сначала проверяем free list
+    for (auto it = part.free_list.begin(); it != part.free_list.end(); ++it) {
+        auto& frame = part.frames[*it];
+        // Свободный frame может быть кратко запинен читателем с устаревшим lookup
+        if (frame.page.try_acquire_exclusive()) {
+            part.free_list.erase(it);
             return &frame;
         }
     }
     
-    // Все страницы pinned или referenced
-    return nullptr;
+    // Victim выбирает политика; захват — здесь, flush — в evict_frame
+    std::size_t victim = part.policy->evict([&](std::size_t idx) {
+        auto& frame = part.frames[idx];
+        
+        // Пропускаем pinned и свободные
+        if (frame.page.is_pinned() || frame.page.page_id() == INVALID_PAGE_ID) {
+            return false;
+        }
+        
+        // Захват фрейма; не вышло — его только что запинили
+        return frame.page.try_acquire_exclusive();
+    });
+    
+    if (victim == EvictionPolicy::NO_VICTIM) {
+        // Все страницы pinned
+        return nullptr;
+    }
+    
+    Frame* frame = &part.frames[victim];
+    if (!evict_frame(part, frame, lock)) {
+        frame->page.release_exclusive(0);
+        return nullptr;
+    }
+    
+    part.counters.evictions.fetch_add(1, std::memory_order_relaxed);
+    return frame;
 }
 
-bool BufferPool::evict_frame(Frame* frame) {
+bool BufferPool::evict_frame(Partition& part, Frame* frame,
+                             std::unique_lock<std::shared_mutex>& lock) {
     PageId page_id = frame->page.page_id();
     
-    // Если dirty — сначала flush
+    // Если dirty — сначала flush. Frame захвачен (-1): его не запинят и не
+    // вытеснят, fetch_page этой страницы ждёт, как чтения read-ahead'а.
+    // Force лога и запись идут без latch — партиция не стоит на fdatasync
     if (frame->page.is_dirty()) {
-        if (!disk_manager_->write_page(page_id, frame->page)) {
+        lock.unlock();
+        bool written = disk_manager_->write_page(page_id, frame->page, write_ahead());
+        lock.lock();
+        
+        if (!written) {
             Logger::error("BufferPool: failed to evict dirty page {}", page_id);
+            // Политика уже исключила frame — возвращаем его на место
+            part.policy->record_load(frame - part.frames.data(), page_id);
             return false;
         }
-        dirty_count_.fetch_sub(1, std::memory_order_relaxed);
-        metrics_->dirty_page_count.fetch_sub(1, std::memory_order_relaxed);
+        
+        // Конкурентный flush_page мог уже снять флаг и учесть запись
+        if (frame->page.mark_clean()) {
+            std::size_t new_count = dirty_count_.fetch_sub(1, std::memory_order_relaxed) - 1;
+            metrics_->dirty_page_count.store(new_count, std::memory_order_relaxed);
+        }
     }
     
     // Удаляем из page table
-    page_table_.erase(page_id);
-    frame->page.reset();
-    frame->referenced = false;
+    part.page_table.erase(page_id);
+    frame->page.clear();
     
     return true;
 }
 
+void BufferPool::release_to_free_list(Partition& part, Frame* frame) {
+    frame->readahead_mark.store(false, std::memory_order_relaxed);
+    frame->page.clear();
+    frame->page.release_exclusive(0);
+    part.free_list.push_back(static_cast<std::size_t>(frame - part.frames.data()));
+}
+
+void BufferPool::drop_stale(Partition& part, PageId page_id,
+                            std::unique_lock<std::shared_mutex>& lock) {
+    std::size_t stale = part.page_table.find(page_id);
+    while (stale != PageTable::NOT_FOUND) {
+        auto& old = part.frames[stale];
+        if (old.page.try_acquire_exclusive()) {
+            if (old.page.mark_clean()) {
+                dirty_count_.fetch_sub(1, std::memory_order_relaxed);
+                metrics_->dirty_page_count.fetch_sub(1, std::memory_order_relaxed);
+            }
+            part.page_table.erase(page_id);
+            part.policy->record_remove(stale);
+            old.readahead_mark.store(false, std::memory_order_relaxed);
+            old.page.clear();
+            old.page.release_exclusive(0);
+            part.free_list.push_back(stale);
+            return;
+        }
+        
+        // Frame ещё читается read-ahead'ом — ждём завершения
+        lock.unlock();
+        std::this_thread::yield();
+        lock.lock();
+        stale = part.page_table.find(page_id);
+    }
+}
+
+void BufferPool::mark_frame_dirty(Frame& frame) {
+    if (frame.page.mark_dirty()) {
+        std::size_t new_count = dirty_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+        metrics_->dirty_page_count.store(new_count, std::memory_order_relaxed);
+        dirtied_total_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool BufferPool::force_log(Lsn page_lsn) {
+    if (wal_ && page_lsn != INVALID_LSN) {
+        return wal_->force_durable(page_lsn);
+    }
+    return true;
+}
+
+// ============================================================================
+// Read-ahead
+// ============================================================================
+
+void BufferPool::note_miss(PageId page_id) {
+    if (!read_ahead_) {
+        return;
+    }
+    
+    PageId prev = last_miss_.exchange(page_id, std::memory_order_relaxed);
+    if (prev == INVALID_PAGE_ID || page_id != prev + 1) {
+        sequential_misses_.store(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    if (sequential_misses_.fetch_add(1, std::memory_order_relaxed) + 1 < read_ahead_trigger_) {
+        return;
+    }
+    
+    // Окно уже запрошено — сканер просто обогнал фоновый поток
+    PageId until = read_ahead_until_.load(std::memory_order_relaxed);
+    if (page_id < until && page_id + read_ahead_window_ >= until) {
+        return;
+    }
+    
+    schedule_read_ahead(page_id + 1);
+}
+
+void BufferPool::schedule_read_ahead(PageId first) {
+    read_ahead_until_.store(static_cast<PageId>(first + read_ahead_window_),
+                            std::memory_order_relaxed);
+    enqueue_prefetch({first, read_ahead_window_, true});
+}
+
+void BufferPool::enqueue_prefetch(PrefetchRequest request) {
+    // Ограничение очереди: при отставании потока лишние окна отбрасываются
+    constexpr std::size_t MAX_PENDING = 64;
+    
+    {
+        std::lock_guard lock(prefetch_mutex_);
+        if (prefetch_stop_ || prefetch_queue_.size() >= MAX_PENDING) {
+            return;
+        }
+        if (!prefetch_thread_.joinable()) {
+            prefetch_thread_ = std::thread(&BufferPool::prefetch_loop, this);
+        }
+        prefetch_queue_.push_back(request);
+    }
+    prefetch_cv_.notify_one();
+}
+
+void BufferPool::prefetch_loop() {
+    std::size_t lookahead = std::max<std::size_t>(read_ahead_window_ / 2, 1);
+    std::vector<PageIo> batch;
+    std::vector<Frame*> frames;
+    
+    for (;;) {
+        PrefetchRequest request;
+        {
+            std::unique_lock lock(prefetch_mutex_);
+            prefetch_cv_.wait(lock, [this] {
+                return prefetch_stop_ || !prefetch_queue_.empty();
+            });
+            if (prefetch_stop_) {
+                return;
+            }
+            request = prefetch_queue_.front();
+            prefetch_queue_.pop_front();
+        }
+        
+        // Страницы за концом файла не читаем
+        uint64_t end = std::min<uint64_t>(static_cast<uint64_t>(request.first) + request.count,
+                                          disk_manager_->page_count());
+        uint64_t marker = request.marked && request.count > lookahead
+                        ? static_cast<uint64_t>(request.first) + request.count - lookahead
+                        : end;
+        
+        // Резервируем frame'ы под всё окно, читаем одним пакетом без latch'ей
+        batch.clear();
+        frames.clear();
+        for (uint64_t page_id = request.first; page_id < end; ++page_id) {
+            bool resident = false;
+            Frame* frame = reserve_frame(static_cast<PageId>(page_id), &resident);
+            if (!frame) {
+                if (resident) {
+                    continue;
+                }
+                break;  // Все frame'ы pinned — окно обрываем
+            }
+            batch.push_back({static_cast<PageId>(page_id), &frame->page});
+            frames.push_back(frame);
+        }
+        
+        disk_manager_->read_pages(batch);
+        
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            install_frame(batch[i].page_id, frames[i], batch[i].ok, batch[i].page_id == marker);
+        }
+    }
+}
+
+BufferPool::Frame* BufferPool::reserve_frame(PageId page_id, bool* resident) {
+    Partition& part = partition_for(page_id);
+    std::unique_lock lock(part.latch);
+    
+    if (part.page_table.find(page_id) != PageTable::NOT_FOUND) {
+        *resident = true;
+        return nullptr;
+    }
+    
+    Frame* frame = find_victim_frame(part, lock);
+    if (!frame) {
+        return nullptr;
+    }
+    
+    // Пока писался dirty victim, страницу мог загрузить fetch_page
+    if (part.page_table.find(page_id) != PageTable::NOT_FOUND) {
+        release_to_free_list(part, frame);
+        *resident = true;
+        return nullptr;
+    }
+    
+    // Frame остаётся захваченным (-1): fetch_page дождётся конца чтения,
+    // а не начнёт грузить ту же страницу во второй frame
+    frame->page.set_page_id(page_id);
+    frame->readahead_mark.store(false, std::memory_order_relaxed);
+    part.page_table.insert(page_id, frame - part.frames.data());
+    return frame;
+}
+
+void BufferPool::install_frame(PageId page_id, Frame* frame, bool loaded, bool mark) {
+    Partition& part = partition_for(page_id);
+    std::unique_lock lock(part.latch);
+    
+    std::size_t frame_idx = frame - part.frames.data();
+    
+    if (!loaded) {
+        part.page_table.erase(page_id);
+        frame->page.clear();
+        frame->page.release_exclusive(0);
+        part.free_list.push_back(frame_idx);
+        return;
+    }
+    
+    frame->page.mark_clean();
+    frame->readahead_mark.store(mark, std::memory_order_relaxed);
+    part.policy->record_load(frame_idx, page_id);
+    
+    // Публикуем без пина
+    frame->page.release_exclusive(0);
+    part.counters.prefetched.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BufferPool::stop_prefetcher() {
+    {
+        std::lock_guard lock(prefetch_mutex_);
+        prefetch_stop_ = true;
+        prefetch_queue_.clear();
+    }
+    prefetch_cv_.notify_all();
+    
+    if (prefetch_thread_.joinable()) {
+        prefetch_thread_.join();
+    }
+}
+
+std::size_t BufferPool::choose_partition_count(std::size_t pool_size,
+                                               const BufferPoolConfig& config) {
+    std::size_t wanted = config.partition_count;
+    
+    if (wanted == 0) {
+        // Авто: по числу ядер, но не мельче min_frames_per_partition
+        wanted = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+        std::size_t min_frames = std::max<std::size_t>(config.min_frames_per_partition, 1);
+        wanted = std::min(wanted, std::max<std::size_t>(pool_size / min_frames, 1));
+    }
+    
+    // Партиция без фреймов бесполезна
+    wanted = std::min(wanted, std::max<std::size_t>(pool_size, 1));
+    
+    // Округляем вверх до степени двойки (для маски), не превышая pool_size
+    std::size_t count = 1;
+    while (count < wanted) {
+        count <<= 1;
+    }
+    if (count > pool_size && count > 1) {
+        count >>= 1;
+    }
+    
+    return count;
+}
+
 } // namespace datyredb::storage
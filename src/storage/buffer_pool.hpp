@@ -3,23 +3,63 @@
 #include "storage/storage_types.hpp"
 #include "storage/page.hpp"
 #include "storage/disk_manager.hpp"
+#include "storage/page_table.hpp"
+#include "storage/eviction_policy.hpp"
+#include "storage/page_arena.hpp"
+#include "storage/wal.hpp"
 
-#include <unordered_map>
 #include <list>
+#include <deque>
 #include <vector>
 #include <shared_mutex>
 #include <memory>
 #include <atomic>
 #include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace datyredb::storage {
 
-/// Buffer Pool Manager с Clock-Sweep eviction и dirty page tracking
+/// Buffer Pool Manager с подключаемой политикой вытеснения и dirty page tracking.
+///
+/// Пул разбит на независимые партиции: page ID хешируется в партицию,
+/// у каждой свой page table, free list, политика вытеснения и latch. Обращения
+/// к страницам разных партиций не конкурируют друг с другом.
+///
+/// Hit в fetch_page/unpin_page не берёт latch вовсе: lookup идёт через
+/// lock-free PageTable, пин — CAS на pin count фрейма, учёт обращения —
+/// lock-free EvictionPolicy::record_access(). Latch партиции
+/// нужен только на miss, eviction, flush и delete. Eviction захватывает
+/// фрейм CAS'ом 0 -> -1 и пропускает фреймы, запиненные конкурентно.
+/// Dirty victim пишется (force лога, double-write, fdatasync) с отпущенным
+/// latch'ем: захваченный frame остаётся в page table, и обращения к его
+/// странице ждут конца записи, как чтения read-ahead'а.
+///
+/// Выбор victim'а делегирован EvictionPolicy (clock-sweep, LRU-K, ARC),
+/// по экземпляру на партицию; тип задаётся BufferPoolConfig.
+///
+/// Тела страниц лежат в одной PageArena (выровнены по 4KB, по возможности
+/// на huge pages), а фреймы хранят только метаданные — по cache line на
+/// фрейм. Проход политики по фреймам не тянет через кэш сами страницы.
+///
+/// Read-ahead: prefetch() и детектор последовательных miss'ов ставят
+/// окна страниц в очередь фонового потока, который загружает их в pool
+/// без пина. Страница в середине окна помечается маркером: hit по ней
+/// запрашивает следующее окно, пока сканер дочитывает текущее.
+///
+/// С WAL пул соблюдает правило write-ahead: перед записью страницы лог
+/// доводится до диска не меньше чем до её page_lsn.
+///
+/// У dirty страницы есть rec_lsn — первое изменение после записи на
+/// диск; dirty_page_table() отдаёт их checkpoint'у без записи страниц.
 class BufferPool {
 public:
     BufferPool(std::size_t pool_size, 
                std::shared_ptr<DiskManager> disk_manager,
-               std::shared_ptr<CheckpointMetrics> metrics);
+               std::shared_ptr<CheckpointMetrics> metrics,
+               BufferPoolConfig config = {},
+               std::shared_ptr<WriteAheadLog> wal = nullptr);
     ~BufferPool();
     
     // Запретить копирование
@@ -42,8 +82,29 @@ public:
     /// Flush страницы на диск
     bool flush_page(PageId page_id);
     
-    /// Удалить страницу
-    bool delete_page(PageId page_id);
+    /// Удалить страницу и освободить её в DiskManager. freed_lsn — см.
+    /// DiskManager::deallocate_page(). false — страница запинена
+    bool delete_page(PageId page_id, Lsn freed_lsn = INVALID_LSN);
+    
+    /// Асинхронно загрузить страницы [first, first + count) без пина
+    void prefetch(PageId first, std::size_t count);
+    
+    // ========================================================================
+    // Work memory
+    // ========================================================================
+    
+    /// Занять до count frame'ов под рабочую память (внешняя сортировка,
+    /// сборка индекса), вытесняя страницы. Frame'ы не видны page table'у
+    /// и не вытесняются до release_frames(); память — data() на PAGE_SIZE
+    std::vector<Page*> borrow_frames(std::size_t count);
+    
+    /// Вернуть занятые frame'ы в free list
+    void release_frames(const std::vector<Page*>& frames);
+    
+    /// Записать страницы на диск мимо pool'а (DiskManager::write_new_pages)
+    /// и отбросить устаревшие frame'ы тех же ID. Страницы выделены
+    /// вызывающим, и на них ещё ничего не ссылается. false — записаны не все
+    bool write_new_pages(std::vector<PageIo>& batch);
     
     // ========================================================================
     // Checkpoint support
@@ -52,11 +113,15 @@ public:
     /// Получить список dirty pages (snapshot для checkpoint)
     std::vector<PageId> get_dirty_pages() const;
     
+    /// Таблица dirty pages с rec_lsn — для fuzzy checkpoint'а и выбора
+    /// страниц фоновой записью
+    std::vector<DirtyPageEntry> dirty_page_table() const;
+    
     /// Flush батча страниц
     bool flush_pages(const std::vector<PageId>& pages);
     
-    /// Sync все файлы
-    void sync_all();
+    /// Sync все файлы (fdatasync по SyncPolicy)
+    bool sync_all();
     
     // ========================================================================
     // Stats
@@ -70,45 +135,184 @@ public:
         return dirty_count_.load(std::memory_order_relaxed); 
     }
     
+    /// Переходов clean -> dirty с создания pool'а — темп загрязнения
+    /// для фоновой записи
+    uint64_t pages_dirtied() const {
+        return dirtied_total_.load(std::memory_order_relaxed);
+    }
+    
     /// Текущее количество страниц в pool
     std::size_t page_count() const;
     
+    /// Количество партиций
+    std::size_t partition_count() const { return partitions_.size(); }
+    
+    /// Политика вытеснения
+    EvictionPolicyType eviction_policy() const { return eviction_policy_; }
+    
+    /// Диск под pool'ом: карта страниц, возврат освобождённых в оборот
+    const std::shared_ptr<DiskManager>& disk_manager() const { return disk_manager_; }
+    
+    /// Hits / misses / evictions (сумма по партициям)
+    BufferPoolMetrics metrics() const;
+    
+    /// Фактический режим huge pages арены
+    HugePages huge_pages() const { return arena_.backing(); }
+    
 private:
-    /// Frame в buffer pool
-    struct Frame {
+    /// Метаданные фрейма (одна cache line); тело страницы — в арене
+    struct alignas(64) Frame {
+        explicit Frame(char* buffer) : page(buffer) {}
+        
+        // Нужен std::vector; после reserve в Partition не вызывается
+        Frame(Frame&& other) noexcept
+            : page(std::move(other.page))
+            , readahead_mark(other.readahead_mark.load(std::memory_order_relaxed)) {}
+        
         Page page;
-        bool referenced = false;  // Для Clock-Sweep
+        
+        // Hit по странице запрашивает следующее окно read-ahead
+        std::atomic<bool> readahead_mark{false};
+    };
+    
+    /// Запрос на загрузку окна страниц
+    struct PrefetchRequest {
+        PageId first;
+        std::size_t count;
+        bool marked;  // Автоматический read-ahead — ставить маркер
+    };
+    
+    
+    /// Независимый шард buffer pool. Выровнен по cache line, чтобы latch'и
+    /// соседних партиций не делили одну линию (false sharing).
+    struct alignas(64) Partition {
+        Partition(std::size_t frame_count, const BufferPoolConfig& config,
+                  PageArena& arena, std::size_t first_page);
+        
+        // Метаданные фреймов партиции (тела — в арене)
+        std::vector<Frame> frames;
+        
+        // Page ID -> Frame index (внутри партиции), lock-free чтение
+        PageTable page_table;
+        
+        // Список свободных фреймов
+        std::list<std::size_t> free_list;
+        
+        // Политика вытеснения партиции
+        std::unique_ptr<EvictionPolicy> policy;
+        
+        mutable std::shared_mutex latch;
+        
+        // Счётчики на отдельной cache line — hit'ы не трогают линию latch'а
+        struct alignas(64) Counters {
+            std::atomic<uint64_t> hits{0};
+            std::atomic<uint64_t> misses{0};
+            std::atomic<uint64_t> evictions{0};
+            std::atomic<uint64_t> prefetched{0};
+        } counters;
     };
     
-    /// Найти свободный frame или evict
-    Frame* find_victim_frame();
+    /// Партиция, которой принадлежит страница
+    Partition& partition_for(PageId page_id);
     
-    /// Clock-Sweep eviction
-    Frame* clock_sweep();
+    /// Lock-free пин страницы, если она уже в pool. nullptr — идти медленным путём
+    Page* try_fetch_resident(Partition& part, PageId page_id);
     
-    /// Evict конкретный frame
-    bool evict_frame(Frame* frame);
+    /// Найти свободный frame или evict (под latch партиции).
+    /// Возвращает frame в эксклюзивном владении (pin count == -1).
+    /// Dirty victim пишется с отпущенным latch'ем: после возврата
+    /// вызывающий перепроверяет page table
+    Frame* find_victim_frame(Partition& part, std::unique_lock<std::shared_mutex>& lock);
+    
+    /// Evict захваченного эксклюзивно frame (под latch партиции; на время
+    /// записи dirty страницы latch отпускается)
+    bool evict_frame(Partition& part, Frame* frame, std::unique_lock<std::shared_mutex>& lock);
+    
+    /// Вернуть захваченный frame в free list (под latch партиции)
+    void release_to_free_list(Partition& part, Frame* frame);
+    
+    /// Отбросить frame страницы page_id, если он есть (под latch партиции;
+    /// latch отпускается на время ожидания чтения read-ahead'ом)
+    void drop_stale(Partition& part, PageId page_id,
+                    std::unique_lock<std::shared_mutex>& lock);
+    
+    /// Пометить страницу dirty с учётом счётчика
+    void mark_frame_dirty(Frame& frame);
+    
+    /// Write-ahead: лог до page_lsn на диске до записи страницы.
+    /// false — лог не доведён, страницу писать нельзя
+    bool force_log(Lsn page_lsn);
+    
+    /// force_log() для записи DiskManager'а: page_lsn берётся из снимка,
+    /// который и уходит на диск
+    DiskManager::LogForce write_ahead() {
+        return [this](Lsn page_lsn) { return force_log(page_lsn); };
+    }
+    
+    // ========================================================================
+    // Read-ahead
+    // ========================================================================
+    
+    /// Учёт miss'а детектором последовательного доступа
+    void note_miss(PageId page_id);
+    
+    /// Запросить окно read-ahead начиная с first
+    void schedule_read_ahead(PageId first);
+    
+    /// Поставить запрос в очередь (запускает поток при первом вызове)
+    void enqueue_prefetch(PrefetchRequest request);
+    
+    /// Фоновый поток загрузки
+    void prefetch_loop();
+    
+    /// Зарезервировать frame под чтение вне latch: frame захвачен эксклюзивно
+    /// и уже виден в page table. nullptr — страница уже в pool (*resident)
+    /// или свободного frame нет
+    Frame* reserve_frame(PageId page_id, bool* resident);
+    
+    /// Завершить чтение: опубликовать frame без пина или вернуть в free list
+    void install_frame(PageId page_id, Frame* frame, bool loaded, bool mark);
+    
+    /// Остановка фонового потока
+    void stop_prefetcher();
+    
+    /// Выбор количества партиций по конфигурации
+    static std::size_t choose_partition_count(std::size_t pool_size,
+                                              const BufferPoolConfig& config);
     
     std::size_t pool_size_;
     std::shared_ptr<DiskManager> disk_manager_;
     std::shared_ptr<CheckpointMetrics> metrics_;
+    std::shared_ptr<WriteAheadLog> wal_;
     
-    // Пул фреймов
-    std::vector<Frame> frames_;
+    // Тела всех страниц pool; объявлена до партиций — переживает их
+    PageArena arena_;
     
-    // Page ID -> Frame index
-    std::unordered_map<PageId, std::size_t> page_table_;
+    // Backend, в котором арена зарегистрирована (может пережить DiskManager)
+    std::shared_ptr<IoBackend> io_backend_;
     
-    // Список свободных фреймов
-    std::list<std::size_t> free_list_;
+    // Партиции (количество — степень двойки)
+    std::vector<std::unique_ptr<Partition>> partitions_;
+    std::size_t partition_mask_ = 0;
+    EvictionPolicyType eviction_policy_;
     
-    // Clock hand для eviction
-    std::size_t clock_hand_ = 0;
+    // Read-ahead
+    bool read_ahead_;
+    std::size_t read_ahead_window_;
+    std::size_t read_ahead_trigger_;
+    std::atomic<PageId> last_miss_{INVALID_PAGE_ID};
+    std::atomic<std::size_t> sequential_misses_{0};
+    std::atomic<PageId> read_ahead_until_{0};
+    
+    std::deque<PrefetchRequest> prefetch_queue_;
+    std::mutex prefetch_mutex_;
+    std::condition_variable prefetch_cv_;
+    std::thread prefetch_thread_;
+    bool prefetch_stop_ = false;
     
     // Dirty page counter
     std::atomic<std::size_t> dirty_count_{0};
-    
-    mutable std::shared_mutex latch_;
+    std::atomic<uint64_t> dirtied_total_{0};
 };
 
 } // namespace datyredb::storage
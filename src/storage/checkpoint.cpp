@@ -1,8 +1,72 @@
 #include "storage/checkpoint.hpp"
 #include "utils/logger.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
 namespace datyredb::storage {
 
+namespace {
+
+/// Вес нового измерения в EWMA темпов
+constexpr double RATE_ALPHA = 0.3;
+
+/// На сколько частей делится запись раунда
+constexpr std::size_t ROUND_SLICES = 8;
+
+/// Порядок записи: выбранные table[0, count) по возрастанию PageId плюс
+/// до extra соседних dirty страниц из остатка таблицы — соседи продлевают
+/// серии, которые DiskManager сливает в один pwritev
+std::vector<PageId> elevator_order(const std::vector<DirtyPageEntry>& table,
+                                   std::size_t count, std::size_t extra,
+                                   std::size_t* combined) {
+    std::vector<PageId> order;
+    order.reserve(count + extra);
+    for (std::size_t i = 0; i < count; ++i) {
+        order.push_back(table[i].page_id);
+    }
+    std::sort(order.begin(), order.end());
+    
+    *combined = 0;
+    if (extra > 0 && count < table.size()) {
+        std::unordered_set<PageId> rest;
+        rest.reserve(table.size() - count);
+        for (std::size_t i = count; i < table.size(); ++i) {
+            rest.insert(table[i].page_id);
+        }
+        
+        for (std::size_t i = 0, selected = order.size(); i < selected && *combined < extra; ++i) {
+            for (PageId next = order[i] + 1; *combined < extra && rest.erase(next); ++next) {
+                order.push_back(next);
+                ++*combined;
+            }
+            for (PageId prev = order[i]; prev > 0 && *combined < extra && rest.erase(prev - 1);
+                 --prev) {
+                order.push_back(prev - 1);
+                ++*combined;
+            }
+        }
+        std::sort(order.begin(), order.end());
+    }
+    
+    return order;
+}
+
+/// Число последовательных серий в отсортированном списке страниц
+std::size_t count_runs(std::vector<PageId>::const_iterator first,
+                       std::vector<PageId>::const_iterator last) {
+    std::size_t runs = 0;
+    for (auto it = first; it != last; ++it) {
+        if (it == first || *it != *(it - 1) + 1) {
+            ++runs;
+        }
+    }
+    return runs;
+}
+
+} // namespace
+
 CheckpointManager::CheckpointManager(
     CheckpointConfig config,
     std::shared_ptr<BufferPool> buffer_pool,
@@ -32,6 +96,10 @@ void CheckpointManager::start() {
         return;  // Уже запущен
     }
     
+    last_round_time_ = std::chrono::steady_clock::now();
+    last_dirtied_ = buffer_pool_->pages_dirtied();
+    last_wal_lsn_ = wal_->current_lsn();
+    
     background_thread_ = std::thread(&CheckpointManager::background_loop, this);
     Logger::info("CheckpointManager started");
 }
@@ -60,12 +128,17 @@ void CheckpointManager::manual_checkpoint() {
     do_checkpoint(CheckpointTrigger::Manual);
 }
 
+void CheckpointManager::fuzzy_checkpoint() {
+    std::lock_guard lock(checkpoint_mutex_);
+    do_checkpoint(CheckpointTrigger::Timer);
+}
+
 bool CheckpointManager::check_pressure() {
     if (!blocking_mode_.load(std::memory_order_relaxed)) {
         return false;
     }
     
-    // Ждём завершения blocking checkpoint
+    // Ждём, пока фоновая запись опустит долю dirty pages ниже hard limit
     std::unique_lock lock(block_mutex_);
     block_cv_.wait(lock, [this] { 
         return !blocking_mode_.load() || !running_.load(); 
@@ -75,14 +148,15 @@ bool CheckpointManager::check_pressure() {
 }
 
 void CheckpointManager::background_loop() {
+    auto deadline = std::chrono::steady_clock::now();
+    
     while (running_.load()) {
-        // Спим секунду между проверками
-        {
-            std::unique_lock lock(block_mutex_);
-            block_cv_.wait_for(lock, std::chrono::seconds(1), [this] {
-                return !running_.load();
-            });
-        }
+        if (!pause_until(deadline)) break;
+        
+        // Долгий checkpoint не копит пропущенные раунды
+        deadline = std::max(deadline, std::chrono::steady_clock::now()) +
+                   config_.background_flush_interval;
+        background_flush(deadline);
         
         if (!running_.load()) break;
         
@@ -93,6 +167,8 @@ void CheckpointManager::background_loop() {
             do_checkpoint(trigger.value());
         }
     }
+    
+    release_pressure();
 }
 
 std::optional<CheckpointTrigger> CheckpointManager::should_checkpoint() const {
@@ -102,7 +178,15 @@ std::optional<CheckpointTrigger> CheckpointManager::should_checkpoint() const {
     );
     
     // =========================================================================
-    // 1. HARD LIMIT — критично!
+    // 1. Минимальный интервал — checkpoint не пишет страниц, dirty pages
+    //    снимает фоновая запись
+    // =========================================================================
+    if (since_last < config_.min_interval) {
+        return std::nullopt;
+    }
+    
+    // =========================================================================
+    // 2. Hard limit: фоновая запись не успевает
     // =========================================================================
     std::size_t dirty_count = buffer_pool_->dirty_page_count();
     std::size_t capacity = buffer_pool_->capacity();
@@ -115,13 +199,6 @@ std::optional<CheckpointTrigger> CheckpointManager::should_checkpoint() const {
         return CheckpointTrigger::DirtyHardLimit;
     }
     
-    // =========================================================================
-    // 2. Минимальный интервал
-    // =========================================================================
-    if (since_last < config_.min_interval) {
-        return std::nullopt;
-    }
-    
     // =========================================================================
     // 3. WAL size
     // =========================================================================
@@ -156,89 +233,76 @@ void CheckpointManager::do_checkpoint(CheckpointTrigger trigger) {
     
     checkpoint_in_progress_ = true;
     
-    // При hard limit — блокируем новые транзакции
-    if (trigger == CheckpointTrigger::DirtyHardLimit) {
-        blocking_mode_ = true;
-        metrics_->blocking_checkpoint_count.fetch_add(1);
-        Logger::warn("BLOCKING CHECKPOINT: transactions will wait");
-    }
-    
     const char* trigger_name = checkpoint_trigger_name(trigger);
     
     Logger::info("Checkpoint BEGIN (trigger={})", trigger_name);
     
     // =========================================================================
-    // ФАЗА 1: BEGIN CHECKPOINT в WAL
+    // ФАЗА 1: Ручной и shutdown — сначала все dirty pages
     // =========================================================================
-    Lsn begin_lsn = wal_->write_checkpoint_begin();
+    std::size_t pages_written = 0;
+    if (trigger == CheckpointTrigger::Manual || trigger == CheckpointTrigger::Shutdown) {
+        bool complete = true;
+        pages_written = flush_batches(buffer_pool_->get_dirty_pages(), false, &complete);
+        if (!complete) {
+            // Незаписанные страницы попадут в таблицу dirty pages
+            Logger::warn("Checkpoint: not all dirty pages flushed, continuing fuzzy");
+        }
+    }
     
     // =========================================================================
-    // ФАЗА 2: Snapshot dirty pages
+    // ФАЗА 2: BEGIN CHECKPOINT в WAL
     // =========================================================================
-    auto dirty_pages = buffer_pool_->get_dirty_pages();
-    std::size_t total_pages = dirty_pages.size();
-    
-    if (total_pages == 0) {
-        Logger::info("Checkpoint: no dirty pages");
-        wal_->write_checkpoint_end(begin_lsn);
+    Lsn begin_lsn = wal_->write_checkpoint_begin();
+    if (begin_lsn == INVALID_LSN) {
+        Logger::error("Checkpoint: failed to write BEGIN, checkpoint aborted");
         checkpoint_in_progress_ = false;
-        blocking_mode_ = false;
-        block_cv_.notify_all();
-        last_checkpoint_time_ = std::chrono::steady_clock::now();
         return;
     }
     
     // =========================================================================
-    // ФАЗА 3: Flush dirty pages батчами
+    // ФАЗА 3: Таблицы dirty pages и активных транзакций — без записи страниц
     // =========================================================================
-    std::size_t pages_written = 0;
-    std::size_t batch_size = config_.checkpoint_batch_size;
-    
-    for (std::size_t i = 0; i < dirty_pages.size(); i += batch_size) {
-        if (!running_.load() && trigger != CheckpointTrigger::Shutdown) {
-            Logger::warn("Checkpoint interrupted");
-            break;
-        }
-        
-        std::size_t end = std::min(i + batch_size, dirty_pages.size());
-        std::vector<PageId> batch(dirty_pages.begin() + i, 
-                                   dirty_pages.begin() + end);
-        
-        if (!buffer_pool_->flush_pages(batch)) {
-            Logger::error("Checkpoint: failed to flush batch at {}", i);
-            continue;
-        }
-        
-        pages_written += batch.size();
-        
-        // Throttling для soft limit
-        if (trigger == CheckpointTrigger::DirtySoftLimit) {
-            std::this_thread::sleep_for(config_.batch_throttle_us);
-        }
-        
-        // Progress log каждые 25%
-        std::size_t quarter = total_pages / 4;
-        if (quarter > 0 && pages_written % quarter == 0) {
-            Logger::debug("Checkpoint progress: {}/{} ({:.0f}%)",
-                          pages_written, total_pages,
-                          100.0 * pages_written / total_pages);
-        }
+    CheckpointData data;
+    {
+        std::lock_guard lock(flush_mutex_);
+        data.dirty_pages = buffer_pool_->dirty_page_table();
+    }
+    if (!wal_->active_transactions(begin_lsn, data.active_txns)) {
+        // Без END: таблица транзакций неполна
+        Logger::error("Checkpoint: failed to collect active transactions, checkpoint aborted");
+        checkpoint_in_progress_ = false;
+        return;
     }
     
     // =========================================================================
-    // ФАЗА 4: Sync
+    // ФАЗА 4: Sync — страницы, которых нет в таблице, записаны до снимка;
+    // один fdatasync доводит их до диска
     // =========================================================================
-    buffer_pool_->sync_all();
+    if (!buffer_pool_->sync_all()) {
+        // Без END: WAL не обрезается, recovery начнёт с прошлого checkpoint'а
+        Logger::error("Checkpoint: data file sync failed, checkpoint aborted");
+        checkpoint_in_progress_ = false;
+        return;
+    }
     
     // =========================================================================
-    // ФАЗА 5: END CHECKPOINT
+    // ФАЗА 5: END CHECKPOINT с таблицами
     // =========================================================================
-    Lsn end_lsn = wal_->write_checkpoint_end(begin_lsn);
+    Lsn end_lsn = wal_->write_checkpoint_end(begin_lsn, data);
+    if (end_lsn == INVALID_LSN || wal_->checkpoint_end_lsn() != end_lsn) {
+        Logger::error("Checkpoint: END is not durable, checkpoint aborted");
+        checkpoint_in_progress_ = false;
+        return;
+    }
     
     // =========================================================================
-    // ФАЗА 6: Truncate WAL
+    // ФАЗА 6: Truncate WAL до min(rec_lsn, начала активных транзакций);
+    // страницы, освобождённые до начала redo, — снова в оборот
     // =========================================================================
-    wal_->truncate_before(begin_lsn);
+    Lsn redo_lsn = data.redo_lsn(begin_lsn);
+    wal_->truncate_before(data.truncation_lsn(begin_lsn));
+    buffer_pool_->disk_manager()->recycle_pages(redo_lsn);
     
     auto end_time = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -249,16 +313,269 @@ void CheckpointManager::do_checkpoint(CheckpointTrigger trigger) {
                        trigger != CheckpointTrigger::Manual);
     metrics_->record_checkpoint(duration, pages_written, was_forced);
     
-    Logger::info("Checkpoint END (trigger={}, pages={}/{}, duration={}ms, LSN={})",
-                 trigger_name, pages_written, total_pages, 
-                 duration.count(), end_lsn);
+    Logger::info("Checkpoint END (trigger={}, pages={}, dirty={}, active_txns={}, "
+                 "redo_lsn={}, duration={}ms, LSN={})",
+                 trigger_name, pages_written, data.dirty_pages.size(),
+                 data.active_txns.size(), redo_lsn, duration.count(), end_lsn);
     
-    // Снимаем блокировку
     checkpoint_in_progress_ = false;
-    blocking_mode_ = false;
-    block_cv_.notify_all();
-    
     last_checkpoint_time_ = end_time;
 }
 
+void CheckpointManager::background_flush(std::chrono::steady_clock::time_point deadline) {
+    auto now = std::chrono::steady_clock::now();
+    std::size_t capacity = buffer_pool_->capacity();
+    std::size_t dirty = buffer_pool_->dirty_page_count();
+    
+    if (static_cast<float>(dirty) >= config_.dirty_page_soft_limit_pct * capacity) {
+        // Пик обогнал квоту — пишем без пауз раунда
+        drain_dirty_pages();
+        dirty = buffer_pool_->dirty_page_count();
+    }
+    
+    // =========================================================================
+    // Темпы с прошлого раунда: новые dirty pages и рост WAL
+    // =========================================================================
+    uint64_t dirtied = buffer_pool_->pages_dirtied();
+    Lsn wal_lsn = wal_->current_lsn();
+    double elapsed = std::chrono::duration<double>(now - last_round_time_).count();
+    if (elapsed > 0) {
+        double dirty_rate = static_cast<double>(dirtied - last_dirtied_) / elapsed;
+        double wal_rate = static_cast<double>(wal_lsn - last_wal_lsn_) / elapsed;
+        dirty_rate_ += RATE_ALPHA * (dirty_rate - dirty_rate_);
+        wal_rate_ += RATE_ALPHA * (wal_rate - wal_rate_);
+    }
+    last_round_time_ = now;
+    last_dirtied_ = dirtied;
+    last_wal_lsn_ = wal_lsn;
+    
+    // =========================================================================
+    // Квота: приток, пока pool к концу раунда выходит за цель, плюс доля
+    // превышения над целью
+    // =========================================================================
+    double round = std::chrono::duration<double>(config_.background_flush_interval).count();
+    double target = config_.background_target_dirty_pct * static_cast<double>(capacity);
+    double incoming = dirty_rate_ * round;
+    double keep_up = std::clamp(static_cast<double>(dirty) + incoming - target, 0.0, incoming);
+    double catch_up = 0;
+    if (static_cast<double>(dirty) > target) {
+        catch_up = (static_cast<double>(dirty) - target) /
+                   static_cast<double>(std::max<std::size_t>(config_.background_catchup_rounds, 1));
+    }
+    auto quota = static_cast<std::size_t>(std::ceil(keep_up + catch_up));
+    
+    // Страницы с rec_lsn ниже горизонта к концу раунда выйдут за окно WAL
+    auto window = static_cast<Lsn>(config_.background_wal_target_pct *
+                                   static_cast<double>(config_.max_wal_size));
+    auto projected = wal_lsn + static_cast<Lsn>(wal_rate_ * round);
+    Lsn horizon = projected > window ? projected - window : INVALID_LSN;
+    
+    // Страницы, dirty с до BEGIN прошлого checkpoint'а, держат обрезку WAL
+    // на следующем: пишем их равными долями до checkpoint_completion_target
+    // интервала
+    Lsn checkpoint_lsn = wal_->checkpoint_lsn();
+    auto completion = std::chrono::duration<double>(config_.max_interval) *
+                      config_.checkpoint_completion_target;
+    double rounds_left = std::max(
+        1.0, std::chrono::duration<double>(last_checkpoint_time_ + completion - now).count() /
+             round);
+    Lsn holds_before = std::max(horizon, checkpoint_lsn);
+    
+    std::vector<DirtyPageEntry> table;
+    std::size_t wal_pages = 0;
+    std::size_t lagging_pages = 0;
+    if (quota > 0 || holds_before != INVALID_LSN) {
+        table = buffer_pool_->dirty_page_table();
+        
+        // Держащие WAL — в начало, по rec_lsn: сначала выходящие за окно
+        auto holds_end = std::partition(table.begin(), table.end(),
+            [holds_before](const DirtyPageEntry& entry) {
+                return entry.rec_lsn != INVALID_LSN && entry.rec_lsn < holds_before;
+            });
+        std::sort(table.begin(), holds_end,
+            [](const DirtyPageEntry& a, const DirtyPageEntry& b) {
+                return a.rec_lsn < b.rec_lsn;
+            });
+        auto urgent_end = std::partition_point(table.begin(), holds_end,
+            [horizon](const DirtyPageEntry& entry) { return entry.rec_lsn < horizon; });
+        wal_pages = static_cast<std::size_t>(urgent_end - table.begin());
+        lagging_pages = static_cast<std::size_t>(std::ceil(
+            static_cast<double>(holds_end - urgent_end) / rounds_left));
+        
+        std::size_t required = wal_pages + lagging_pages;
+        quota = std::min(std::max(quota, required), table.size());
+        
+        // Остаток квоты — самые холодные
+        std::partial_sort(table.begin() + required, table.begin() + quota, table.end(),
+            [](const DirtyPageEntry& a, const DirtyPageEntry& b) {
+                return a.page_lsn < b.page_lsn;
+            });
+    }
+    
+    // Квота по возрастанию PageId, дополненная соседями до длинных серий
+    std::size_t combined = 0;
+    auto extra = static_cast<std::size_t>(config_.write_combine_pct * static_cast<double>(quota));
+    std::vector<PageId> order = elevator_order(table, quota, extra, &combined);
+    
+    metrics_->background_rounds.fetch_add(1, std::memory_order_relaxed);
+    metrics_->background_dirty_rate.store(static_cast<uint64_t>(dirty_rate_),
+                                          std::memory_order_relaxed);
+    metrics_->background_wal_rate.store(static_cast<uint64_t>(wal_rate_),
+                                        std::memory_order_relaxed);
+    metrics_->background_round_quota.store(quota, std::memory_order_relaxed);
+    metrics_->background_wal_pages.store(wal_pages, std::memory_order_relaxed);
+    metrics_->background_lagging_pages.store(lagging_pages, std::memory_order_relaxed);
+    
+    if (order.empty()) {
+        return;
+    }
+    
+    // =========================================================================
+    // Запись равными частями, распределёнными до deadline; граница части
+    // не разрывает серию
+    // =========================================================================
+    std::size_t slices = std::min(ROUND_SLICES, order.size());
+    auto span = deadline - std::chrono::steady_clock::now();
+    auto slice_start = std::chrono::steady_clock::now();
+    std::size_t written = 0;
+    std::size_t begin = 0;
+    
+    for (std::size_t slice = 0; slice < slices && begin < order.size(); ++slice) {
+        std::size_t end = std::max(begin, order.size() * (slice + 1) / slices);
+        while (end > begin && end < order.size() && order[end] == order[end - 1] + 1) {
+            ++end;
+        }
+        std::vector<PageId> batch(order.begin() + begin, order.begin() + end);
+        
+        bool ok;
+        {
+            std::lock_guard lock(flush_mutex_);
+            ok = buffer_pool_->flush_pages(batch);
+        }
+        if (!ok) {
+            Logger::error("Checkpoint: background flush failed, retry next round");
+            break;
+        }
+        written += batch.size();
+        metrics_->write_runs_total.fetch_add(count_runs(batch.begin(), batch.end()),
+                                             std::memory_order_relaxed);
+        begin = end;
+        
+        if (begin < order.size() &&
+            !pause_until(slice_start + span * static_cast<long>(slice + 1) /
+                                       static_cast<long>(slices))) {
+            break;
+        }
+    }
+    
+    metrics_->background_pages_written.fetch_add(written, std::memory_order_relaxed);
+    metrics_->background_wal_pages_total.fetch_add(std::min(written, wal_pages),
+                                                   std::memory_order_relaxed);
+    metrics_->combined_pages_total.fetch_add(written == order.size() ? combined : 0,
+                                             std::memory_order_relaxed);
+}
+
+void CheckpointManager::drain_dirty_pages() {
+    std::size_t batch_size = std::max<std::size_t>(config_.checkpoint_batch_size, 1);
+    
+    do {
+        auto table = buffer_pool_->dirty_page_table();
+        if (table.empty()) {
+            break;
+        }
+        
+        // Самые старые rec_lsn сдерживают обрезку WAL
+        std::size_t count = std::min(table.size(), batch_size);
+        std::partial_sort(table.begin(), table.begin() + count, table.end(),
+            [](const DirtyPageEntry& a, const DirtyPageEntry& b) {
+                return a.rec_lsn < b.rec_lsn;
+            });
+        std::size_t combined = 0;
+        auto extra = static_cast<std::size_t>(config_.write_combine_pct *
+                                              static_cast<double>(count));
+        std::vector<PageId> batch = elevator_order(table, count, extra, &combined);
+        
+        float ratio = dirty_ratio();
+        bool hard = ratio >= config_.dirty_page_hard_limit_pct;
+        if (hard && !blocking_mode_.exchange(true)) {
+            metrics_->blocking_checkpoint_count.fetch_add(1);
+            Logger::warn("HARD LIMIT: dirty pages {:.1f}% >= {:.0f}%, transactions will wait",
+                         ratio * 100, config_.dirty_page_hard_limit_pct * 100);
+        } else if (!hard) {
+            release_pressure();
+        }
+        
+        bool complete = true;
+        std::size_t written = flush_batches(batch, !hard, &complete);
+        metrics_->background_pages_written.fetch_add(written, std::memory_order_relaxed);
+        metrics_->combined_pages_total.fetch_add(complete ? combined : 0,
+                                                 std::memory_order_relaxed);
+        
+        if (!complete) {
+            break;  // Ошибка записи — повторим на следующем раунде
+        }
+    } while (running_.load() && dirty_ratio() >= config_.dirty_page_soft_limit_pct);
+    
+    release_pressure();
+}
+
+bool CheckpointManager::pause_until(std::chrono::steady_clock::time_point until) {
+    std::unique_lock lock(block_mutex_);
+    return !block_cv_.wait_until(lock, until, [this] { return !running_.load(); });
+}
+
+std::size_t CheckpointManager::flush_batches(const std::vector<PageId>& pages,
+                                             bool throttle, bool* complete) {
+    std::size_t pages_written = 0;
+    std::size_t batch_size = std::max<std::size_t>(config_.checkpoint_batch_size, 1);
+    
+    // Один проход по файлу по возрастанию PageId; граница батча не
+    // разрывает последовательную серию
+    std::vector<PageId> sorted(pages);
+    std::sort(sorted.begin(), sorted.end());
+    
+    for (std::size_t i = 0, end = 0; i < sorted.size(); i = end) {
+        end = std::min(i + batch_size, sorted.size());
+        while (end < sorted.size() && sorted[end] == sorted[end - 1] + 1) {
+            ++end;
+        }
+        std::vector<PageId> batch(sorted.begin() + i, sorted.begin() + end);
+        
+        bool ok;
+        {
+            std::lock_guard lock(flush_mutex_);
+            ok = buffer_pool_->flush_pages(batch);
+        }
+        if (!ok) {
+            Logger::error("Checkpoint: failed to flush batch at {}", i);
+            *complete = false;
+            continue;
+        }
+        
+        pages_written += batch.size();
+        metrics_->write_runs_total.fetch_add(count_runs(batch.begin(), batch.end()),
+                                             std::memory_order_relaxed);
+        
+        if (throttle) {
+            std::this_thread::sleep_for(config_.batch_throttle_us);
+        }
+    }
+    
+    return pages_written;
+}
+
+float CheckpointManager::dirty_ratio() const {
+    return static_cast<float>(buffer_pool_->dirty_page_count()) /
+           static_cast<float>(buffer_pool_->capacity());
+}
+
+void CheckpointManager::release_pressure() {
+    if (blocking_mode_.exchange(false)) {
+        {
+            std::lock_guard lock(block_mutex_);
+        }
+        block_cv_.notify_all();
+    }
+}
+
 } // namespace datyredb::storage
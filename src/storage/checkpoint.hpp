@@ -11,10 +11,36 @@
 #include <condition_variable>
 #include <chrono>
 #include <optional>
+#include <vector>
 
 namespace datyredb::storage {
 
 /// Production-grade Checkpoint Manager
+///
+/// Checkpoint fuzzy: BEGIN, снимок таблицы dirty pages (PageId -> rec_lsn)
+/// и таблицы активных транзакций, END с обеими таблицами. Страницы
+/// checkpoint не пишет и транзакции не останавливает; WAL обрезается до
+/// самого старого rec_lsn или начала активной транзакции.
+///
+/// Между checkpoint'ами фоновый поток пишет dirty pages раундами. Квота
+/// раунда — приток новых dirty pages (EWMA по pages_dirtied()) плюс доля
+/// превышения над background_target_dirty_pct; страницы, чей rec_lsn к
+/// концу раунда окажется дальше окна WAL, пишутся сверх квоты. Страницы,
+/// dirty с до BEGIN прошлого checkpoint'а, держат обрезку WAL на следующем —
+/// они пишутся равными долями к checkpoint_completion_target интервала.
+/// Остаток квоты — самые холодные по page_lsn.
+///
+/// Выбранные страницы пишутся по возрастанию PageId вместе с соседними
+/// dirty страницами (write_combine_pct квоты): DiskManager сливает серии в
+/// один pwritev. Запись делится на части, равномерно распределённые по
+/// раунду, не разрывая серий. Решения раунда — в CheckpointMetrics.
+///
+/// Если пик всё же поднял долю выше мягкого лимита, фоновый поток пишет
+/// батчами до его снятия, выше жёсткого — без throttle, а check_pressure()
+/// задерживает транзакции, пока доля не опустится ниже.
+///
+/// Ручной checkpoint и checkpoint при остановке сначала пишут все dirty
+/// страницы: после них recovery начинается с BEGIN.
 class CheckpointManager {
 public:
     CheckpointManager(CheckpointConfig config,
@@ -33,9 +59,12 @@ public:
     /// Остановка
     void shutdown();
     
-    /// Ручной checkpoint
+    /// Ручной checkpoint: все dirty pages на диск, затем checkpoint
     void manual_checkpoint();
     
+    /// Fuzzy checkpoint без записи страниц — как по таймеру
+    void fuzzy_checkpoint();
+    
     /// Проверка давления (вызывается перед транзакцией)
     /// Возвращает true если транзакция должна подождать
     bool check_pressure();
@@ -55,6 +84,27 @@ private:
     /// Выполнение checkpoint
     void do_checkpoint(CheckpointTrigger trigger);
     
+    /// Раунд фоновой записи: квота по темпам, запись равномерно до deadline
+    void background_flush(std::chrono::steady_clock::time_point deadline);
+    
+    /// Запись без пауз между раундами, пока доля выше soft limit
+    void drain_dirty_pages();
+    
+    /// Подождать до момента или остановки. false — менеджер остановлен
+    bool pause_until(std::chrono::steady_clock::time_point until);
+    
+    /// Записать страницы по возрастанию PageId батчами по
+    /// checkpoint_batch_size. Возвращает
+    /// число записанных; *complete — все батчи записаны без ошибок
+    std::size_t flush_batches(const std::vector<PageId>& pages, bool throttle,
+                              bool* complete);
+    
+    /// Доля dirty pages в buffer pool
+    float dirty_ratio() const;
+    
+    /// Снять задержку транзакций
+    void release_pressure();
+    
     CheckpointConfig config_;
     std::shared_ptr<BufferPool> buffer_pool_;
     std::shared_ptr<WriteAheadLog> wal_;
@@ -64,14 +114,26 @@ private:
     std::atomic<bool> running_{false};
     std::atomic<bool> checkpoint_in_progress_{false};
     
-    // Для блокировки при hard limit
+    // Задержка транзакций выше hard limit, пока фоновая запись не
+    // опустит долю dirty pages
     std::mutex block_mutex_;
     std::condition_variable block_cv_;
     std::atomic<bool> blocking_mode_{false};
     
     std::chrono::steady_clock::time_point last_checkpoint_time_;
     
+    // Темпы для квоты фоновой записи — только фоновый поток
+    std::chrono::steady_clock::time_point last_round_time_;
+    uint64_t last_dirtied_ = 0;
+    Lsn last_wal_lsn_ = INVALID_LSN;
+    double dirty_rate_ = 0;  // страниц/с
+    double wal_rate_ = 0;    // байт/с
+    
     std::mutex checkpoint_mutex_;
+    
+    // Батч flush_pages сбрасывает dirty flag до записи: снимок таблицы
+    // dirty pages не должен попасть между ними
+    std::mutex flush_mutex_;
 };
 
 } // namespace datyredb::storage
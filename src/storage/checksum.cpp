@@ -0,0 +1,272 @@
+#include "storage/checksum.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#define DATYREDB_HAVE_CRC32C_SSE42 1
+#elif defined(__aarch64__) && defined(__linux__)
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#define DATYREDB_HAVE_CRC32C_ARMV8 1
+#endif
+
+namespace datyredb::storage {
+
+namespace {
+
+/// Полином CRC32C в отражённом представлении
+constexpr uint32_t CRC32C_POLY = 0x82F63B78;
+
+// ============================================================================
+// Slicing-by-8
+// ============================================================================
+
+using Crc32cTables = std::array<std::array<uint32_t, 256>, 8>;
+
+/// tables[k][b] — CRC байта b, за которым следуют k нулевых байт
+constexpr Crc32cTables make_tables() {
+    Crc32cTables tables{};
+    for (uint32_t b = 0; b < 256; ++b) {
+        uint32_t crc = b;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        }
+        tables[0][b] = crc;
+    }
+    for (std::size_t k = 1; k < 8; ++k) {
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint32_t prev = tables[k - 1][b];
+            tables[k][b] = (prev >> 8) ^ tables[0][prev & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr Crc32cTables CRC32C_TABLES = make_tables();
+
+/// Состояние — CRC без финальной инверсии
+uint32_t crc32c_slicing8(uint32_t state, const unsigned char* p, std::size_t size) {
+    const auto& t = CRC32C_TABLES;
+    if constexpr (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) {
+        for (; size >= 8; p += 8, size -= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            word ^= state;
+            state = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^
+                    t[5][(word >> 16) & 0xFF] ^ t[4][(word >> 24) & 0xFF] ^
+                    t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^
+                    t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+        }
+    }
+    for (; size > 0; ++p, --size) {
+        state = (state >> 8) ^ t[0][(state ^ *p) & 0xFF];
+    }
+    return state;
+}
+
+// ============================================================================
+// Склейка потоков
+// ============================================================================
+
+/// Произведение a·b по модулю полинома (отражённое представление,
+/// старший бит — x^0)
+uint32_t multiply_mod_poly(uint32_t a, uint32_t b) {
+    uint32_t product = 0;
+    for (uint32_t mask = 1u << 31; mask != 0; mask >>= 1) {
+        if (a & mask) {
+            product ^= b;
+        }
+        b = (b & 1) ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+    }
+    return product;
+}
+
+/// x^(8·bytes) по модулю полинома: сдвиг состояния на bytes нулевых байт
+uint32_t shift_operator(std::size_t bytes) {
+    uint32_t result = 1u << 31;  // x^0
+    uint32_t power = 1u << 23;   // x^8
+    for (; bytes != 0; bytes >>= 1) {
+        if (bytes & 1) {
+            result = multiply_mod_poly(power, result);
+        }
+        power = multiply_mod_poly(power, power);
+    }
+    return result;
+}
+
+/// Аппаратная инструкция CRC: задержка ~3 такта при пропускной
+/// способности 1 за такт. Три независимых потока по BLOCK байт
+/// загружают конвейер, затем состояния склеиваются сдвигом
+struct Interleave {
+    static constexpr std::size_t LARGE_BLOCK = 1024;
+    static constexpr std::size_t SMALL_BLOCK = 128;
+    
+    uint32_t large_shift = shift_operator(LARGE_BLOCK);
+    uint32_t small_shift = shift_operator(SMALL_BLOCK);
+};
+
+[[maybe_unused]] const Interleave& interleave() {
+    static const Interleave constants;
+    return constants;
+}
+
+/// Состояние после a, затем b: b посчитано отдельно с нулевого
+/// состояния, shift — оператор сдвига на длину b
+[[maybe_unused]] uint32_t combine(uint32_t a, uint32_t b, uint32_t shift) {
+    return multiply_mod_poly(shift, a) ^ b;
+}
+
+// ============================================================================
+// SSE4.2
+// ============================================================================
+
+#ifdef DATYREDB_HAVE_CRC32C_SSE42
+
+__attribute__((target("sse4.2")))
+uint64_t sse42_stream(uint64_t state, const unsigned char* p, std::size_t size) {
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        state = _mm_crc32_u64(state, word);
+    }
+    return state;
+}
+
+template <std::size_t Block>
+__attribute__((target("sse4.2")))
+uint64_t sse42_interleaved(uint64_t state, const unsigned char*& p, std::size_t& size,
+                           uint32_t shift) {
+    for (; size >= 3 * Block; p += 3 * Block, size -= 3 * Block) {
+        uint64_t s0 = state;
+        uint64_t s1 = 0;
+        uint64_t s2 = 0;
+        for (std::size_t i = 0; i < Block; i += 8) {
+            uint64_t w0, w1, w2;
+            std::memcpy(&w0, p + i, sizeof(w0));
+            std::memcpy(&w1, p + Block + i, sizeof(w1));
+            std::memcpy(&w2, p + 2 * Block + i, sizeof(w2));
+            s0 = _mm_crc32_u64(s0, w0);
+            s1 = _mm_crc32_u64(s1, w1);
+            s2 = _mm_crc32_u64(s2, w2);
+        }
+        uint32_t merged = combine(static_cast<uint32_t>(s0), static_cast<uint32_t>(s1), shift);
+        state = combine(merged, static_cast<uint32_t>(s2), shift);
+    }
+    return state;
+}
+
+__attribute__((target("sse4.2")))
+uint32_t crc32c_sse42(uint32_t state, const unsigned char* p, std::size_t size) {
+    const auto& constants = interleave();
+    uint64_t s = state;
+    s = sse42_interleaved<Interleave::LARGE_BLOCK>(s, p, size, constants.large_shift);
+    s = sse42_interleaved<Interleave::SMALL_BLOCK>(s, p, size, constants.small_shift);
+    s = sse42_stream(s, p, size);
+    
+    uint32_t tail_state = static_cast<uint32_t>(s);
+    p += size & ~std::size_t{7};
+    for (size &= 7; size > 0; ++p, --size) {
+        tail_state = _mm_crc32_u8(tail_state, *p);
+    }
+    return tail_state;
+}
+
+#endif
+
+// ============================================================================
+// ARMv8 CRC
+// ============================================================================
+
+#ifdef DATYREDB_HAVE_CRC32C_ARMV8
+
+__attribute__((target("+crc")))
+uint32_t armv8_stream(uint32_t state, const unsigned char* p, std::size_t size) {
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        state = __crc32cd(state, word);
+    }
+    return state;
+}
+
+template <std::size_t Block>
+__attribute__((target("+crc")))
+uint32_t armv8_interleaved(uint32_t state, const unsigned char*& p, std::size_t& size,
+                           uint32_t shift) {
+    for (; size >= 3 * Block; p += 3 * Block, size -= 3 * Block) {
+        uint32_t s0 = state;
+        uint32_t s1 = 0;
+        uint32_t s2 = 0;
+        for (std::size_t i = 0; i < Block; i += 8) {
+            uint64_t w0, w1, w2;
+            std::memcpy(&w0, p + i, sizeof(w0));
+            std::memcpy(&w1, p + Block + i, sizeof(w1));
+            std::memcpy(&w2, p + 2 * Block + i, sizeof(w2));
+            s0 = __crc32cd(s0, w0);
+            s1 = __crc32cd(s1, w1);
+            s2 = __crc32cd(s2, w2);
+        }
+        state = combine(combine(s0, s1, shift), s2, shift);
+    }
+    return state;
+}
+
+__attribute__((target("+crc")))
+uint32_t crc32c_armv8(uint32_t state, const unsigned char* p, std::size_t size) {
+    const auto& constants = interleave();
+    state = armv8_interleaved<Interleave::LARGE_BLOCK>(state, p, size, constants.large_shift);
+    state = armv8_interleaved<Interleave::SMALL_BLOCK>(state, p, size, constants.small_shift);
+    state = armv8_stream(state, p, size);
+    
+    p += size & ~std::size_t{7};
+    for (size &= 7; size > 0; ++p, --size) {
+        state = __crc32cb(state, *p);
+    }
+    return state;
+}
+
+#endif
+
+// ============================================================================
+// Выбор реализации
+// ============================================================================
+
+using Crc32cFn = uint32_t (*)(uint32_t, const unsigned char*, std::size_t);
+
+Crc32cFn select_crc32c() {
+#if defined(DATYREDB_HAVE_CRC32C_SSE42)
+    if (__builtin_cpu_supports("sse4.2")) {
+        return crc32c_sse42;
+    }
+#elif defined(DATYREDB_HAVE_CRC32C_ARMV8)
+    if (::getauxval(AT_HWCAP) & HWCAP_CRC32) {
+        return crc32c_armv8;
+    }
+#endif
+    return crc32c_slicing8;
+}
+
+Crc32cFn crc32c_impl() {
+    static const Crc32cFn impl = select_crc32c();
+    return impl;
+}
+
+} // namespace
+
+uint32_t crc32c(const void* data, std::size_t size, uint32_t crc) {
+    auto state = crc32c_impl()(~crc, static_cast<const unsigned char*>(data), size);
+    return ~state;
+}
+
+uint32_t crc32c_portable(const void* data, std::size_t size, uint32_t crc) {
+    return ~crc32c_slicing8(~crc, static_cast<const unsigned char*>(data), size);
+}
+
+bool crc32c_hardware() {
+    return crc32c_impl() != crc32c_slicing8;
+}
+
+} // namespace datyredb::storage
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace datyredb::storage {
+
+/// CRC32C (Castagnoli) от size байт data. crc — результат по предыдущим
+/// байтам потока: crc32c(b, n2, crc32c(a, n1)) == CRC склейки a и b.
+/// Реализация выбирается при первом вызове: инструкции SSE4.2 / ARMv8
+/// CRC, если процессор их поддерживает, иначе slicing-by-8
+uint32_t crc32c(const void* data, std::size_t size, uint32_t crc = 0);
+
+/// Табличная реализация (slicing-by-8): fallback и эталон для проверки
+/// аппаратной
+uint32_t crc32c_portable(const void* data, std::size_t size, uint32_t crc = 0);
+
+/// Выбрана ли аппаратная реализация
+bool crc32c_hardware();
+
+} // namespace datyredb::storage
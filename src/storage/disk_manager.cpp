@@ -1,13 +1,75 @@
 #include "storage/disk_manager.hpp"
 #include "utils/logger.hpp"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <cstring>
+#include <memory>
+#include <unordered_map>
 
 namespace datyredb::storage {
 
-DiskManager::DiskManager(const std::filesystem::path& db_path)
+namespace {
+
+// Не больше IOV_MAX страниц в одном preadv/pwritev
+constexpr std::size_t MAX_RUN_PAGES = std::min<std::size_t>(IOV_MAX, 256);
+
+off_t page_offset(PageId page_id) {
+    return static_cast<off_t>(page_id) * static_cast<off_t>(PAGE_SIZE);
+}
+
+/// pread/pwrite до полного объёма (короткие операции и EINTR)
+template <typename Op, typename Ptr>
+bool transfer_full(Op op, int fd, Ptr buf, std::size_t size, off_t offset) {
+    std::size_t done = 0;
+    while (done < size) {
+        ssize_t n = op(fd, buf + done, size - done, offset + static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+/// Страница из одних нулей
+bool is_zero_page(const char* data) {
+    return data[0] == 0 && std::memcmp(data, data + 1, PAGE_SIZE - 1) == 0;
+}
+
+// doublewrite.db: область пакетов, затем слоты одиночных записей
+constexpr std::size_t DW_BATCH_PAGES = MAX_RUN_PAGES;
+constexpr std::size_t DW_SINGLE_SLOTS = 16;
+
+// Байт карты страницы, освобождённой, но ещё не возвращённой в оборот.
+// На диск пишется как занятая
+constexpr uint8_t PENDING_PAGE = 0xFE;
+constexpr uint8_t MAX_SPACE_HINT = 0xFD;
+
+/// fdatasync служебной записи (без учёта в sync_latency)
+bool durable(int fd) {
+    if (::fdatasync(fd) != 0) {
+        Logger::error("DiskManager: fdatasync failed: {}", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+DiskManager::DiskManager(const std::filesystem::path& db_path, IoConfig io_config)
     : db_path_(db_path)
     , data_file_path_(db_path / "data.db")
+    , io_config_(io_config)
 {
 }
 
@@ -29,42 +91,75 @@ bool DiskManager::initialize() {
         return false;
     }
     
-    // Открываем файл данных
-    data_file_.open(data_file_path_, 
-                    std::ios::in | std::ios::out | std::ios::binary);
-    
-    if (!data_file_.is_open()) {
-        // Файл не существует — создаём новый
-        data_file_.open(data_file_path_, 
-                        std::ios::out | std::ios::binary);
-        if (!data_file_.is_open()) {
-            Logger::error("DiskManager: failed to create data file: {}",
-                          data_file_path_.string());
-            return false;
+    // Открываем (или создаём) файл данных
+    int flags = O_RDWR | O_CREAT | O_CLOEXEC;
+    direct_io_ = false;
+#ifdef O_DIRECT
+    if (io_config_.direct_io) {
+        fd_ = ::open(data_file_path_.c_str(), flags | O_DIRECT, 0644);
+        if (fd_ >= 0) {
+            direct_io_ = true;
+        } else if (errno == EINVAL) {
+            // tmpfs и часть сетевых ФС отвергают O_DIRECT
+            Logger::warn("DiskManager: O_DIRECT not supported for {}, using buffered I/O",
+                         data_file_path_.string());
         }
-        data_file_.close();
-        
-        // Переоткрываем для чтения/записи
-        data_file_.open(data_file_path_,
-                        std::ios::in | std::ios::out | std::ios::binary);
     }
-    
-    if (!data_file_.is_open()) {
-        Logger::error("DiskManager: failed to open data file: {}",
-                      data_file_path_.string());
+#endif
+    if (!direct_io_) {
+        fd_ = ::open(data_file_path_.c_str(), flags, 0644);
+    }
+    if (fd_ < 0) {
+        Logger::error("DiskManager: failed to open data file {}: {}",
+                      data_file_path_.string(), std::strerror(errno));
         return false;
     }
     
     // Определяем количество существующих страниц
-    data_file_.seekg(0, std::ios::end);
-    auto file_size = static_cast<uint64_t>(data_file_.tellg());
-    next_page_id_.store(static_cast<PageId>(file_size / PAGE_SIZE));
+    struct stat st {};
+    if (::fstat(fd_, &st) != 0) {
+        Logger::error("DiskManager: fstat failed for {}: {}",
+                      data_file_path_.string(), std::strerror(errno));
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    auto file_size = static_cast<uint64_t>(st.st_size);
+    file_pages_ = static_cast<PageId>(file_size / PAGE_SIZE);
+    next_page_id_.store(file_pages_);
+    
+    if (io_config_.double_write && io_config_.sync.policy != SyncPolicy::None &&
+        !open_double_write()) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    
+    // После восстановления порванных страниц: хвост из нулей — заранее
+    // выделенное место, а не страницы
+    trim_zero_tail();
+    
+    if (!open_free_map()) {
+        ::close(fd_);
+        fd_ = -1;
+        if (dw_fd_ >= 0) {
+            ::close(dw_fd_);
+            dw_fd_ = -1;
+        }
+        return false;
+    }
+    
+    io_backend_ = make_io_backend(io_config_);
     
     initialized_ = true;
     
-    Logger::info("DiskManager initialized: path={}, pages={}", 
-                 data_file_path_.string(), 
-                 next_page_id_.load());
+    Logger::info("DiskManager initialized: path={}, pages={}, free={}, io={}, "
+                 "direct_io={}, double_write={}",
+                 data_file_path_.string(),
+                 next_page_id_.load(),
+                 free_pages_.size(),
+                 io_backend_name(io_backend_ ? io_backend_->type() : IoBackendType::Sync),
+                 direct_io_, dw_fd_ >= 0);
     
     return true;
 }
@@ -74,11 +169,22 @@ void DiskManager::shutdown() {
         return;
     }
     
-    std::lock_guard lock(io_mutex_);
+    // Backend может пережить DiskManager (общий с WAL), но в полёте
+    // операций над fd_ к этому моменту нет — read/write_pages синхронны
+    io_backend_.reset();
     
-    if (data_file_.is_open()) {
-        data_file_.flush();
-        data_file_.close();
+    if (map_fd_ >= 0) {
+        write_free_map(true);
+        ::close(map_fd_);
+        map_fd_ = -1;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (dw_fd_ >= 0) {
+        ::close(dw_fd_);
+        dw_fd_ = -1;
     }
     
     initialized_ = false;
@@ -86,32 +192,308 @@ void DiskManager::shutdown() {
 }
 
 bool DiskManager::read_page(PageId page_id, Page& page) {
-    std::lock_guard lock(io_mutex_);
-    
     if (page_id >= next_page_id_.load()) {
-        Logger::error("DiskManager: read invalid page_id={} (max={})", 
+        Logger::error("DiskManager: read invalid page_id={} (max={})",
                       page_id, next_page_id_.load());
         return false;
     }
     
-    auto offset = static_cast<std::streamoff>(page_id) * PAGE_SIZE;
-    data_file_.seekg(offset);
+    if (!transfer_full(::pread, fd_, page.data(), PAGE_SIZE, page_offset(page_id))) {
+        Logger::error("DiskManager: read failed for page {}", page_id);
+        return false;
+    }
     
-    if (!data_file_) {
-        Logger::error("DiskManager: seekg failed for page {}", page_id);
+    return finish_read(page_id, page);
+}
+
+bool DiskManager::write_page(PageId page_id, const Page& page, const LogForce& force_log) {
+    // Checksum — в копии: page может быть фреймом pool'а, который в это
+    // время читают. Лог — до page_lsn именно того, что будет записано
+    Page copy;
+    page.snapshot(copy);
+    if (force_log && !force_log(copy.get_lsn())) {
         return false;
     }
+    copy.update_checksum();
     
-    if (!data_file_.read(page.data(), PAGE_SIZE)) {
-        Logger::error("DiskManager: read failed for page {}", page_id);
+    if (dw_fd_ < 0) {
+        return write_page_in_place(page_id, copy);
+    }
+    
+    // Свободный одиночный слот; занятые освобождаются после fdatasync данных
+    std::size_t slot;
+    {
+        std::unique_lock lock(dw_slot_mutex_);
+        dw_slot_cv_.wait(lock, [this] { return !dw_free_slots_.empty(); });
+        slot = dw_free_slots_.back();
+        dw_free_slots_.pop_back();
+    }
+    
+    bool ok = stage_double_write({&copy}, slot) &&
+              write_page_in_place(page_id, copy) &&
+              durable(fd_);
+    
+    {
+        std::lock_guard lock(dw_slot_mutex_);
+        dw_free_slots_.push_back(slot);
+    }
+    dw_slot_cv_.notify_one();
+    
+    return ok;
+}
+
+bool DiskManager::write_page_in_place(PageId page_id, const Page& page) {
+    if (!transfer_full(::pwrite, fd_, page.data(), PAGE_SIZE, page_offset(page_id))) {
+        Logger::error("DiskManager: write failed for page {}", page_id);
         return false;
     }
     
+    return true;
+}
+
+template <typename Fn>
+void DiskManager::for_each_run(const std::vector<PageIo>& batch, Fn&& fn) {
+    std::vector<std::size_t> order(batch.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return batch[a].page_id < batch[b].page_id;
+    });
+    
+    std::size_t start = 0;
+    while (start < order.size()) {
+        std::size_t end = start + 1;
+        while (end < order.size() && end - start < MAX_RUN_PAGES &&
+               batch[order[end]].page_id == batch[order[end - 1]].page_id + 1) {
+            ++end;
+        }
+        fn(order.data() + start, end - start);
+        start = end;
+    }
+}
+
+template <typename Fn>
+void DiskManager::submit_runs(std::vector<PageIo>& batch, IoRequest::Op op, Fn&& fn) {
+    struct Run {
+        std::vector<std::size_t> indices;
+        std::vector<iovec> iov;
+        int64_t result = 0;
+    };
+    
+    // Серии и их iovec живут до завершения всех операций
+    std::vector<Run> runs;
+    for_each_run(batch, [&](const std::size_t* run, std::size_t count) {
+        Run& r = runs.emplace_back();
+        r.indices.assign(run, run + count);
+        r.iov.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            r.iov[i].iov_base = batch[run[i]].page->data();
+            r.iov[i].iov_len = PAGE_SIZE;
+        }
+    });
+    
+    IoWaitGroup wait_group;
+    wait_group.add(runs.size());
+    
+    std::vector<IoRequest> requests;
+    requests.reserve(runs.size());
+    for (auto& r : runs) {
+        IoRequest& request = requests.emplace_back();
+        request.op = op;
+        request.fd = fd_;
+        request.iov = r.iov.data();
+        request.iov_count = static_cast<unsigned>(r.iov.size());
+        request.offset = static_cast<uint64_t>(page_offset(batch[r.indices[0]].page_id));
+        request.callback = [&r, &wait_group](int64_t result) {
+            r.result = result;
+            wait_group.done();
+        };
+    }
+    
+    io_backend_->submit(requests);
+    wait_group.wait();
+    
+    for (auto& r : runs) {
+        bool ok = r.result == static_cast<int64_t>(r.indices.size() * PAGE_SIZE);
+        fn(r.indices.data(), r.indices.size(), ok);
+    }
+}
+
+std::size_t DiskManager::read_pages(std::vector<PageIo>& batch) {
+    std::size_t succeeded = 0;
+    PageId page_count = next_page_id_.load();
+    
+    auto finish_run = [&](const std::size_t* run, std::size_t count, bool run_ok) {
+        for (std::size_t i = 0; i < count; ++i) {
+            PageIo& io = batch[run[i]];
+            // Одиночная страница или короткое чтение — постранично
+            io.ok = run_ok ? finish_read(io.page_id, *io.page)
+                           : read_page(io.page_id, *io.page);
+            succeeded += io.ok ? 1 : 0;
+        }
+    };
+    
+    if (io_backend_) {
+        // Страницы за концом файла сразу уходят в read_page (ошибка)
+        bool in_range = std::all_of(batch.begin(), batch.end(), [&](const PageIo& io) {
+            return io.page_id < page_count;
+        });
+        if (in_range) {
+            submit_runs(batch, IoRequest::Op::Read, finish_run);
+            return succeeded;
+        }
+    }
+    
+    for_each_run(batch, [&](const std::size_t* run, std::size_t count) {
+        PageId first = batch[run[0]].page_id;
+        
+        bool run_ok = false;
+        if (first + count <= page_count && count > 1) {
+            iovec iov[MAX_RUN_PAGES];
+            for (std::size_t i = 0; i < count; ++i) {
+                iov[i].iov_base = batch[run[i]].page->data();
+                iov[i].iov_len = PAGE_SIZE;
+            }
+            
+            ssize_t n;
+            do {
+                n = ::preadv(fd_, iov, static_cast<int>(count), page_offset(first));
+            } while (n < 0 && errno == EINTR);
+            run_ok = n == static_cast<ssize_t>(count * PAGE_SIZE);
+        }
+        
+        finish_run(run, count, run_ok);
+    });
+    
+    return succeeded;
+}
+
+std::size_t DiskManager::write_pages(std::vector<PageIo>& batch, const LogForce& force_log) {
+    // Пишутся копии с checksum'ом, как в write_page; ok — обратно в batch
+    std::vector<Page> copies(batch.size());
+    std::vector<PageIo> writes(batch);
+    Lsn max_lsn = INVALID_LSN;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        batch[i].page->snapshot(copies[i]);
+        max_lsn = std::max(max_lsn, copies[i].get_lsn());
+        writes[i].page = &copies[i];
+    }
+    
+    // Один force лога на весь пакет — до самого свежего page_lsn снимков
+    if (force_log && !batch.empty() && !force_log(max_lsn)) {
+        for (auto& io : batch) {
+            io.ok = false;
+        }
+        return 0;
+    }
+    for (auto& copy : copies) {
+        copy.update_checksum();
+    }
+    
+    std::size_t succeeded = write_copies(writes);
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        batch[i].ok = writes[i].ok;
+    }
+    return succeeded;
+}
+
+std::size_t DiskManager::write_copies(std::vector<PageIo>& batch) {
+    if (dw_fd_ < 0) {
+        return write_pages_in_place(batch);
+    }
+    
+    // Частями по области пакетов: копии на диске до записи на место,
+    // записи на месте на диске до повторного использования области
+    std::lock_guard lock(dw_batch_mutex_);
+    std::size_t succeeded = 0;
+    
+    for (std::size_t start = 0; start < batch.size(); start += DW_BATCH_PAGES) {
+        std::size_t end = std::min(start + DW_BATCH_PAGES, batch.size());
+        std::vector<PageIo> part(batch.begin() + start, batch.begin() + end);
+        std::vector<const Page*> pages;
+        pages.reserve(part.size());
+        for (const auto& io : part) {
+            pages.push_back(io.page);
+        }
+        
+        std::size_t written = 0;
+        if (stage_double_write(pages, 0)) {
+            written = write_pages_in_place(part);
+            if (!durable(fd_)) {
+                written = 0;
+                for (auto& io : part) {
+                    io.ok = false;
+                }
+            }
+        }
+        
+        for (std::size_t i = 0; i < part.size(); ++i) {
+            batch[start + i].ok = part[i].ok;
+        }
+        succeeded += written;
+    }
+    
+    return succeeded;
+}
+
+std::size_t DiskManager::write_new_pages(std::vector<PageIo>& batch) {
+    for (auto& io : batch) {
+        io.page->update_checksum();
+    }
+    return write_pages_in_place(batch);
+}
+
+std::size_t DiskManager::write_pages_in_place(std::vector<PageIo>& batch) {
+    std::size_t succeeded = 0;
+    
+    auto finish_run = [&](const std::size_t* run, std::size_t count, bool run_ok) {
+        for (std::size_t i = 0; i < count; ++i) {
+            PageIo& io = batch[run[i]];
+            // Короткая запись — дописываем постранично (запись идемпотентна)
+            io.ok = run_ok || write_page_in_place(io.page_id, *io.page);
+            succeeded += io.ok ? 1 : 0;
+        }
+    };
+    
+    if (io_backend_) {
+        submit_runs(batch, IoRequest::Op::Write, finish_run);
+        return succeeded;
+    }
+    
+    for_each_run(batch, [&](const std::size_t* run, std::size_t count) {
+        PageId first = batch[run[0]].page_id;
+        
+        bool run_ok = false;
+        if (count > 1) {
+            iovec iov[MAX_RUN_PAGES];
+            for (std::size_t i = 0; i < count; ++i) {
+                iov[i].iov_base = batch[run[i]].page->data();
+                iov[i].iov_len = PAGE_SIZE;
+            }
+            
+            ssize_t n;
+            do {
+                n = ::pwritev(fd_, iov, static_cast<int>(count), page_offset(first));
+            } while (n < 0 && errno == EINTR);
+            run_ok = n == static_cast<ssize_t>(count * PAGE_SIZE);
+        }
+        
+        finish_run(run, count, run_ok);
+    });
+    
+    return succeeded;
+}
+
+bool DiskManager::finish_read(PageId page_id, Page& page) {
+    // Проверка checksum. Выделенная, но ни разу не записанная страница
+    // (сбой до первого flush) читается нулями — это пустая страница
+    bool valid = page.verify_checksum() || is_zero_page(page.data());
+    
     page.set_page_id(page_id);
     page.mark_clean();
     
-    // Проверка checksum
-    if (!page.verify_checksum()) {
+    if (!valid) {
         Logger::error("DiskManager: checksum mismatch for page {}", page_id);
         return false;
     }
@@ -119,56 +501,428 @@ bool DiskManager::read_page(PageId page_id, Page& page) {
     return true;
 }
 
-bool DiskManager::write_page(PageId page_id, const Page& page) {
-    std::lock_guard lock(io_mutex_);
+bool DiskManager::open_double_write() {
+    auto path = db_path_ / "doublewrite.db";
+    dw_fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (dw_fd_ < 0) {
+        Logger::error("DiskManager: failed to open double-write file {}: {}",
+                      path.string(), std::strerror(errno));
+        return false;
+    }
+    
+    if (!repair_torn_pages()) {
+        ::close(dw_fd_);
+        dw_fd_ = -1;
+        return false;
+    }
+    
+    dw_free_slots_.clear();
+    for (std::size_t i = 0; i < DW_SINGLE_SLOTS; ++i) {
+        dw_free_slots_.push_back(DW_BATCH_PAGES + i);
+    }
+    return true;
+}
+
+bool DiskManager::stage_double_write(const std::vector<const Page*>& pages,
+                                     std::size_t first_slot) {
+    off_t offset = page_offset(static_cast<PageId>(first_slot));
     
-    // Обновляем checksum перед записью
-    Page& mutable_page = const_cast<Page&>(page);
-    mutable_page.update_checksum();
+    bool written = false;
+    if (pages.size() > 1) {
+        std::vector<iovec> iov(pages.size());
+        for (std::size_t i = 0; i < pages.size(); ++i) {
+            iov[i].iov_base = const_cast<char*>(pages[i]->data());
+            iov[i].iov_len = PAGE_SIZE;
+        }
+        ssize_t n;
+        do {
+            n = ::pwritev(dw_fd_, iov.data(), static_cast<int>(iov.size()), offset);
+        } while (n < 0 && errno == EINTR);
+        written = n == static_cast<ssize_t>(pages.size() * PAGE_SIZE);
+    }
     
-    auto offset = static_cast<std::streamoff>(page_id) * PAGE_SIZE;
-    data_file_.seekp(offset);
+    // Одиночная страница или короткий pwritev — постранично
+    for (std::size_t i = 0; !written && i < pages.size(); ++i) {
+        if (!transfer_full(::pwrite, dw_fd_, pages[i]->data(), PAGE_SIZE,
+                           offset + page_offset(static_cast<PageId>(i)))) {
+            Logger::error("DiskManager: double-write failed at slot {}", first_slot + i);
+            return false;
+        }
+        written = i + 1 == pages.size();
+    }
     
-    if (!data_file_) {
-        Logger::error("DiskManager: seekp failed for page {}", page_id);
+    if (!durable(dw_fd_)) {
         return false;
     }
     
-    if (!data_file_.write(page.data(), PAGE_SIZE)) {
-        Logger::error("DiskManager: write failed for page {}", page_id);
+    double_write_pages_.fetch_add(pages.size(), std::memory_order_relaxed);
+    return true;
+}
+
+bool DiskManager::repair_torn_pages() {
+    struct stat st {};
+    if (::fstat(dw_fd_, &st) != 0) {
+        Logger::error("DiskManager: fstat failed for double-write file: {}",
+                      std::strerror(errno));
         return false;
     }
+    auto slots = static_cast<std::size_t>(st.st_size) / PAGE_SIZE;
     
+    // Самая свежая по page_lsn целая копия каждой страницы
+    std::unordered_map<PageId, std::unique_ptr<Page>> copies;
+    auto slot = std::make_unique<Page>();
+    for (std::size_t i = 0; i < slots; ++i) {
+        if (!transfer_full(::pread, dw_fd_, slot->data(), PAGE_SIZE,
+                           page_offset(static_cast<PageId>(i))) ||
+            is_zero_page(slot->data()) || !slot->verify_checksum()) {
+            continue;  // Пустой слот или копия, порванная до записи на место
+        }
+        
+        PageHeader header;
+        std::memcpy(&header, slot->data(), sizeof(header));
+        auto& best = copies[header.page_id];
+        if (!best || best->get_lsn() <= header.page_lsn) {
+            std::swap(best, slot);
+            if (!slot) {
+                slot = std::make_unique<Page>();
+            }
+        }
+    }
+    
+    std::size_t repaired = 0;
+    Page current;
+    for (auto& [page_id, copy] : copies) {
+        // Целая или ни разу не записанная страница на месте не трогается
+        if (page_id < next_page_id_.load() &&
+            transfer_full(::pread, fd_, current.data(), PAGE_SIZE, page_offset(page_id)) &&
+            (current.verify_checksum() || is_zero_page(current.data()))) {
+            continue;
+        }
+        
+        if (!transfer_full(::pwrite, fd_, copy->data(), PAGE_SIZE, page_offset(page_id))) {
+            Logger::error("DiskManager: failed to repair torn page {}", page_id);
+            return false;
+        }
+        if (page_id >= next_page_id_.load()) {
+            next_page_id_.store(page_id + 1);
+        }
+        Logger::warn("DiskManager: torn page {} restored from double-write (lsn={})",
+                     page_id, copy->get_lsn());
+        ++repaired;
+    }
+    
+    if (repaired > 0 && !durable(fd_)) {
+        return false;
+    }
+    torn_pages_repaired_.store(repaired, std::memory_order_relaxed);
     return true;
 }
 
 PageId DiskManager::allocate_page() {
-    PageId new_id = next_page_id_.fetch_add(1);
+    std::lock_guard lock(alloc_mutex_);
+    
+    PageId page_id;
+    if (!free_pages_.empty()) {
+        // Наименьший ID — файл остаётся плотным
+        page_id = *free_pages_.begin();
+        free_pages_.erase(free_pages_.begin());
+    } else {
+        page_id = next_page_id_.load();
+        if (!extend_file(page_id + 1)) {
+            // Без места в файле страницу не выдаём: её запись провалилась бы
+            Logger::error("DiskManager: failed to extend data file for page {}", page_id);
+            return INVALID_PAGE_ID;
+        }
+        next_page_id_.store(page_id + 1);
+    }
+    set_map_entry(page_id, 0);
     
-    // Расширяем файл
+    Logger::debug("DiskManager: allocated page {}", page_id);
+    return page_id;
+}
+
+void DiskManager::deallocate_page(PageId page_id, Lsn freed_lsn) {
+    std::lock_guard lock(alloc_mutex_);
+    
+    if (page_id >= next_page_id_.load() || page_id >= space_map_.size() ||
+        space_map_[page_id] == FREE_PAGE || space_map_[page_id] == PENDING_PAGE) {
+        Logger::warn("DiskManager: deallocate of free or invalid page {}", page_id);
+        return;
+    }
+    
+    set_map_entry(page_id, PENDING_PAGE);
+    pending_free_.emplace_back(page_id, freed_lsn);
+    Logger::debug("DiskManager: deallocated page {} (lsn={})", page_id, freed_lsn);
+}
+
+std::size_t DiskManager::recycle_pages(Lsn redo_lsn) {
+    std::vector<PageId> ready;
     {
-        std::lock_guard lock(io_mutex_);
-        auto offset = static_cast<std::streamoff>(new_id + 1) * PAGE_SIZE - 1;
-        data_file_.seekp(offset);
-        char zero = 0;
-        data_file_.write(&zero, 1);
-        data_file_.flush();
+        std::lock_guard lock(alloc_mutex_);
+        auto keep = std::partition(pending_free_.begin(), pending_free_.end(),
+                                   [&](const auto& entry) { return entry.second >= redo_lsn; });
+        for (auto it = keep; it != pending_free_.end(); ++it) {
+            ready.push_back(it->first);
+        }
+        pending_free_.erase(keep, pending_free_.end());
+    }
+    if (ready.empty()) {
+        return 0;
+    }
+    
+    // Нули на диске до того, как страница станет свободной в карте:
+    // изменения нового владельца в логе считаются от нулей
+    std::sort(ready.begin(), ready.end());
+    bool zeroed = zero_pages(ready) &&
+                  (io_config_.sync.policy == SyncPolicy::None || durable(fd_));
+    
+    std::lock_guard lock(alloc_mutex_);
+    for (PageId page_id : ready) {
+        if (!zeroed) {
+            pending_free_.emplace_back(page_id, INVALID_LSN);
+            continue;
+        }
+        set_map_entry(page_id, FREE_PAGE);
+        free_pages_.insert(page_id);
     }
+    if (!zeroed) {
+        Logger::error("DiskManager: failed to zero {} freed pages", ready.size());
+        return 0;
+    }
+    
+    Logger::debug("DiskManager: recycled {} pages", ready.size());
+    return ready.size();
+}
+
+bool DiskManager::ensure_allocated(PageId page_id) {
+    std::lock_guard lock(alloc_mutex_);
     
-    Logger::debug("DiskManager: allocated page {}", new_id);
-    return new_id;
+    PageId count = next_page_id_.load();
+    if (page_id >= count) {
+        // Как в allocate_page: без места в файле страница не выделяется
+        if (!extend_file(page_id + 1)) {
+            Logger::error("DiskManager: failed to extend data file for page {}", page_id);
+            return false;
+        }
+        // Пропущенные страницы за концом — нулевые, их можно выдавать
+        for (PageId gap = count; gap < page_id; ++gap) {
+            set_map_entry(gap, FREE_PAGE);
+            free_pages_.insert(gap);
+        }
+        next_page_id_.store(page_id + 1);
+        set_map_entry(page_id, 0);
+    } else if (free_pages_.erase(page_id) > 0) {
+        set_map_entry(page_id, 0);
+    }
+    return true;
 }
 
-void DiskManager::deallocate_page(PageId page_id) {
-    // TODO: implement free list
-    Logger::debug("DiskManager: deallocated page {}", page_id);
+void DiskManager::note_free_space(PageId page_id, std::size_t bytes) {
+    auto hint = static_cast<uint8_t>(
+        std::min<std::size_t>(bytes / FREE_SPACE_UNIT, MAX_SPACE_HINT));
+    
+    std::lock_guard lock(alloc_mutex_);
+    if (page_id < space_map_.size() && space_map_[page_id] != hint &&
+        space_map_[page_id] != FREE_PAGE && space_map_[page_id] != PENDING_PAGE) {
+        set_map_entry(page_id, hint);
+    }
 }
 
-void DiskManager::sync() {
-    std::lock_guard lock(io_mutex_);
-    if (data_file_.is_open()) {
-        data_file_.flush();
+std::vector<PageId> DiskManager::pages_with_free_space(std::size_t bytes) const {
+    auto needed = static_cast<uint8_t>(std::min<std::size_t>(
+        (bytes + FREE_SPACE_UNIT - 1) / FREE_SPACE_UNIT, MAX_SPACE_HINT));
+    
+    std::vector<PageId> pages;
+    std::lock_guard lock(alloc_mutex_);
+    for (std::size_t i = 0; i < space_map_.size(); ++i) {
+        if (space_map_[i] >= needed && space_map_[i] <= MAX_SPACE_HINT) {
+            pages.push_back(static_cast<PageId>(i));
+        }
     }
+    return pages;
+}
+
+std::size_t DiskManager::free_page_count() const {
+    std::lock_guard lock(alloc_mutex_);
+    return free_pages_.size() + pending_free_.size();
+}
+
+bool DiskManager::sync() {
+    if (fd_ < 0) {
+        return true;
+    }
+    if (io_config_.sync.policy == SyncPolicy::None) {
+        return write_free_map(false);
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    int rc = ::fdatasync(fd_);
+    sync_latency_.record(std::chrono::steady_clock::now() - start);
+    
+    if (rc != 0) {
+        Logger::error("DiskManager: fdatasync failed: {}", std::strerror(errno));
+        return false;
+    }
+    return write_free_map(true);
+}
+
+void DiskManager::start_writeback(PageId first, PageId last) {
+#ifdef SYNC_FILE_RANGE_WRITE
+    if (fd_ < 0 || direct_io_ || io_config_.sync.policy == SyncPolicy::None) {
+        return;
+    }
+    
+    // Только запуск записи: ни ожидания, ни гарантий — их даёт sync()
+    off_t length = page_offset(last + 1) - page_offset(first);
+    if (::sync_file_range(fd_, page_offset(first), length, SYNC_FILE_RANGE_WRITE) != 0) {
+        Logger::debug("DiskManager: sync_file_range failed: {}", std::strerror(errno));
+    }
+#else
+    (void)first;
+    (void)last;
+#endif
+}
+
+// ============================================================================
+// Карта страниц и рост файла
+// ============================================================================
+
+void DiskManager::trim_zero_tail() {
+    Page page;
+    PageId count = next_page_id_.load();
+    while (count > 0 &&
+           transfer_full(::pread, fd_, page.data(), PAGE_SIZE, page_offset(count - 1)) &&
+           is_zero_page(page.data())) {
+        --count;
+    }
+    next_page_id_.store(count);
+}
+
+bool DiskManager::open_free_map() {
+    auto path = db_path_ / "freemap.db";
+    map_fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (map_fd_ < 0) {
+        Logger::error("DiskManager: failed to open page map {}: {}",
+                      path.string(), std::strerror(errno));
+        return false;
+    }
+    
+    struct stat st {};
+    if (::fstat(map_fd_, &st) != 0) {
+        Logger::error("DiskManager: fstat failed for page map: {}", std::strerror(errno));
+        return false;
+    }
+    
+    // Страницы без записи в карте (карта старше файла) — занятые
+    PageId count = next_page_id_.load();
+    space_map_.assign(count, 0);
+    std::size_t stored = std::min<std::size_t>(static_cast<std::size_t>(st.st_size), count);
+    if (stored > 0 && !transfer_full(::pread, map_fd_, space_map_.data(), stored, 0)) {
+        Logger::error("DiskManager: failed to read page map: {}", std::strerror(errno));
+        return false;
+    }
+    
+    free_pages_.clear();
+    pending_free_.clear();
+    for (PageId page_id = 0; page_id < count; ++page_id) {
+        if (space_map_[page_id] == FREE_PAGE) {
+            free_pages_.insert(page_id);
+        } else if (space_map_[page_id] == PENDING_PAGE) {
+            space_map_[page_id] = 0;
+        }
+    }
+    map_dirty_begin_ = map_dirty_end_ = 0;
+    return true;
+}
+
+bool DiskManager::write_free_map(bool durable_write) {
+    if (map_fd_ < 0) {
+        return true;
+    }
+    
+    // Один писатель: более старый снимок не ляжет поверх нового
+    std::lock_guard write_lock(map_write_mutex_);
+    
+    std::vector<uint8_t> chunk;
+    std::size_t begin;
+    {
+        std::lock_guard lock(alloc_mutex_);
+        if (map_dirty_begin_ == map_dirty_end_) {
+            return true;
+        }
+        begin = map_dirty_begin_;
+        chunk.assign(space_map_.begin() + static_cast<std::ptrdiff_t>(begin),
+                     space_map_.begin() + static_cast<std::ptrdiff_t>(map_dirty_end_));
+        map_dirty_begin_ = map_dirty_end_ = 0;
+    }
+    std::replace(chunk.begin(), chunk.end(), PENDING_PAGE, uint8_t{0});
+    
+    if (!transfer_full(::pwrite, map_fd_, chunk.data(), chunk.size(),
+                       static_cast<off_t>(begin))) {
+        Logger::error("DiskManager: failed to write page map: {}", std::strerror(errno));
+        return false;
+    }
+    return !durable_write || durable(map_fd_);
+}
+
+void DiskManager::set_map_entry(PageId page_id, uint8_t value) {
+    if (page_id >= space_map_.size()) {
+        space_map_.resize(static_cast<std::size_t>(page_id) + 1, 0);
+    }
+    space_map_[page_id] = value;
+    
+    if (map_dirty_begin_ == map_dirty_end_) {
+        map_dirty_begin_ = page_id;
+        map_dirty_end_ = static_cast<std::size_t>(page_id) + 1;
+    } else {
+        map_dirty_begin_ = std::min<std::size_t>(map_dirty_begin_, page_id);
+        map_dirty_end_ = std::max<std::size_t>(map_dirty_end_, static_cast<std::size_t>(page_id) + 1);
+    }
+}
+
+bool DiskManager::extend_file(PageId count) {
+    if (count <= file_pages_) {
+        return true;
+    }
+    
+    std::size_t chunk = std::max<std::size_t>(io_config_.extend_chunk_pages, 1);
+    auto target = static_cast<PageId>((static_cast<std::size_t>(count) + chunk - 1) / chunk * chunk);
+    off_t offset = page_offset(file_pages_);
+    off_t length = page_offset(target) - offset;
+    
+    // fallocate резервирует блоки; ФС без него — разреженное расширение
+    if (::fallocate(fd_, 0, offset, length) != 0 &&
+        ::ftruncate(fd_, page_offset(target)) != 0) {
+        return false;
+    }
+    file_pages_ = target;
+    return true;
+}
+
+bool DiskManager::zero_pages(const std::vector<PageId>& pages) {
+    alignas(PAGE_SIZE) static const char zero_page[PAGE_SIZE] = {};
+    
+    std::size_t i = 0;
+    while (i < pages.size()) {
+        std::size_t run = 1;
+        while (i + run < pages.size() && pages[i + run] == pages[i] + run) {
+            ++run;
+        }
+        
+        // Дыра вместо блоков: место возвращается ФС, читаются нули
+        off_t offset = page_offset(pages[i]);
+        off_t length = static_cast<off_t>(run * PAGE_SIZE);
+        if (::fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, length) != 0) {
+            for (std::size_t j = 0; j < run; ++j) {
+                if (!transfer_full(::pwrite, fd_, zero_page, PAGE_SIZE,
+                                   offset + static_cast<off_t>(j * PAGE_SIZE))) {
+                    return false;
+                }
+            }
+        }
+        i += run;
+    }
+    return true;
 }
 
 uint64_t DiskManager::data_file_size() const {
@@ -2,19 +2,62 @@
 
 #include "storage/storage_types.hpp"
 #include "storage/page.hpp"
+#include "storage/io_backend.hpp"
 
 #include <string>
-#include <fstream>
-#include <mutex>
 #include <filesystem>
 #include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
 
 namespace datyredb::storage {
 
+/// Одна страница в пакетной операции read_pages/write_pages
+struct PageIo {
+    PageId page_id;
+    Page* page;
+    bool ok = false;  // Результат операции для этой страницы
+};
+
 /// Управление дисковым I/O
+///
+/// Файл данных открыт как raw fd; весь I/O позиционный (pread/pwrite),
+/// поэтому общий mutex не нужен — конкурентные операции над разными
+/// страницами не сериализуются. Пакетные read_pages/write_pages сортируют
+/// страницы и сливают соседние в один preadv/pwritev. С асинхронным
+/// backend'ом (IoConfig::backend) все серии пакета отправляются разом и
+/// находятся в полёте одновременно.
+///
+/// В режиме O_DIRECT (IoConfig::direct_io) буферы страниц должны быть
+/// выровнены по PAGE_SIZE — это обеспечивают Page и PageArena.
+///
+/// Double-write (IoConfig::double_write): страницы сначала пишутся подряд
+/// в doublewrite.db и доводятся до диска, затем — на место в файле данных
+/// с fdatasync до повторного использования области. Пакет write_pages
+/// занимает общую область на 256 страниц (один последовательный pwritev и
+/// два fdatasync на пакет), одиночный write_page — один из слотов.
+/// initialize() восстанавливает страницы с неверным checksum (порванная
+/// при сбое питания запись) из самой свежей по page_lsn копии.
+///
+/// Карта страниц (freemap.db) — байт на страницу: FREE_PAGE у свободной,
+/// у занятой — подсказка свободного места внутри (в единицах
+/// FREE_SPACE_UNIT). allocate_page() берёт свободную страницу с
+/// наименьшим ID и лишь без них растит файл — блоками
+/// IoConfig::extend_chunk_pages через fallocate. Освобождённая страница
+/// возвращается в оборот только recycle_pages(), когда redo уже не
+/// повторит её прежние изменения; тело страницы при этом обнуляется
+/// (punch hole), и новый владелец пишет в лог изменения поверх нулей.
+/// Карта пишется в sync(); после сбоя освобождённые с последнего
+/// checkpoint'а страницы остаются занятыми, повторно не выдаются.
+/// Незаписанные нулевые страницы в конце файла initialize() не считает
+/// выделенными — нужные redo выделит ensure_allocated().
 class DiskManager {
 public:
-    explicit DiskManager(const std::filesystem::path& db_path);
+    explicit DiskManager(const std::filesystem::path& db_path, IoConfig io_config = {});
     ~DiskManager();
     
     // Запретить копирование
@@ -30,17 +73,82 @@ public:
     /// Чтение страницы с диска
     bool read_page(PageId page_id, Page& page);
     
-    /// Запись страницы на диск
-    bool write_page(PageId page_id, const Page& page);
+    /// Правило write-ahead для записи: force лога до LSN; false — ошибка
+    using LogForce = std::function<bool(Lsn)>;
+    
+    /// Запись страницы на диск. Пишется снимок (Page::snapshot) с новым
+    /// checksum — сама page не меняется. force_log, если задан, получает
+    /// page_lsn снимка до записи; без лога на диске страница не пишется
+    bool write_page(PageId page_id, const Page& page, const LogForce& force_log = {});
+    
+    /// Пакетное чтение. Порядок batch не меняется, результат — в PageIo::ok.
+    /// Возвращает количество успешно прочитанных страниц
+    std::size_t read_pages(std::vector<PageIo>& batch);
     
-    /// Выделение новой страницы
+    /// Пакетная запись снимков страниц, как write_page: один force_log
+    /// до наибольшего page_lsn пакета. Возвращает количество успешно
+    /// записанных страниц
+    std::size_t write_pages(std::vector<PageIo>& batch, const LogForce& force_log = {});
+    
+    /// Пакетная запись страниц, на которые ещё ничего не ссылается
+    /// (узлы bulk load'а): мимо double-write — порванная при сбое копия
+    /// никому не нужна. Возвращает количество успешно записанных страниц
+    std::size_t write_new_pages(std::vector<PageIo>& batch);
+    
+    /// Байт карты свободной страницы
+    static constexpr uint8_t FREE_PAGE = 0xFF;
+    
+    /// Единица подсказки свободного места в карте
+    static constexpr std::size_t FREE_SPACE_UNIT = 32;
+    
+    /// Выделение страницы: свободная с наименьшим ID или новая в конце файла.
+    /// INVALID_PAGE_ID — файл не удалось расширить
     PageId allocate_page();
     
-    /// Освобождение страницы
-    void deallocate_page(PageId page_id);
+    /// Освобождение страницы. freed_lsn — LSN, после которого страница не
+    /// нужна (коммит освободившей транзакции); INVALID_LSN — изменений
+    /// страницы в логе нет. В оборот страницу возвращает recycle_pages()
+    void deallocate_page(PageId page_id, Lsn freed_lsn = INVALID_LSN);
+    
+    /// Вернуть в оборот страницы, освобождённые до redo_lsn (начала redo
+    /// завершённого checkpoint'а). Возвращает их количество
+    std::size_t recycle_pages(Lsn redo_lsn);
     
-    /// fsync
-    void sync();
+    /// Страница нужна redo: выделить, если она за концом файла или свободна.
+    /// false — файл не расширен; карта и счётчик страниц не меняются
+    bool ensure_allocated(PageId page_id);
+    
+    /// Подсказка: у занятой страницы свободно bytes байт
+    void note_free_space(PageId page_id, std::size_t bytes);
+    
+    /// Занятые страницы, у которых по подсказке свободно не меньше bytes
+    std::vector<PageId> pages_with_free_space(std::size_t bytes) const;
+    
+    /// Свободных страниц (в обороте и ждущих recycle_pages())
+    std::size_t free_page_count() const;
+    
+    /// fdatasync файла данных (кроме SyncPolicy::None) и запись карты страниц
+    bool sync();
+    
+    /// Начать writeback страниц [first, last] без ожидания
+    /// (sync_file_range). Последующий sync() ждёт меньше
+    void start_writeback(PageId first, PageId last);
+    
+    /// Латентность sync()
+    const LatencyHistogram& sync_latency() const { return sync_latency_; }
+    
+    /// Double-write включён (IoConfig::double_write, политика не None)
+    bool double_write() const { return dw_fd_ >= 0; }
+    
+    /// Страниц записано через область double-write
+    uint64_t double_write_pages() const {
+        return double_write_pages_.load(std::memory_order_relaxed);
+    }
+    
+    /// Порванных страниц восстановлено из double-write в initialize()
+    uint64_t torn_pages_repaired() const {
+        return torn_pages_repaired_.load(std::memory_order_relaxed);
+    }
     
     /// Размер файла данных
     uint64_t data_file_size() const;
@@ -53,13 +161,92 @@ public:
     /// Путь к данным
     const std::filesystem::path& data_path() const { return db_path_; }
     
+    /// Файл данных открыт с O_DIRECT (IoConfig::direct_io и поддержка ФС)
+    bool direct_io() const { return direct_io_; }
+    
+    /// Асинхронный backend (nullptr для IoBackendType::Sync). Создаётся
+    /// в initialize(); общий с WAL
+    std::shared_ptr<IoBackend> io_backend() const { return io_backend_; }
+    
 private:
+    /// Проверка прочитанной страницы: ID, dirty flag, checksum
+    bool finish_read(PageId page_id, Page& page);
+    
+    /// Пакетная запись копий с обновлённым checksum (write_pages)
+    std::size_t write_copies(std::vector<PageIo>& batch);
+    
+    /// Запись страницы на место без double-write
+    bool write_page_in_place(PageId page_id, const Page& page);
+    
+    /// Пакетная запись на место без double-write (checksum уже обновлён)
+    std::size_t write_pages_in_place(std::vector<PageIo>& batch);
+    
+    /// Открыть doublewrite.db и восстановить порванные страницы
+    bool open_double_write();
+    
+    /// Записать страницы подряд в doublewrite.db с first_slot и довести до диска
+    bool stage_double_write(const std::vector<const Page*>& pages, std::size_t first_slot);
+    
+    /// Восстановить страницы данных с неверным checksum из копий double-write
+    bool repair_torn_pages();
+    
+    /// Не считать выделенными нулевые страницы в конце файла
+    void trim_zero_tail();
+    
+    /// Открыть freemap.db и загрузить карту страниц
+    bool open_free_map();
+    
+    /// Записать изменённую часть карты; durable — и довести до диска
+    bool write_free_map(bool durable);
+    
+    /// Байт карты страницы (под alloc_mutex_)
+    void set_map_entry(PageId page_id, uint8_t value);
+    
+    /// Нарастить файл до count страниц блоками (под alloc_mutex_)
+    bool extend_file(PageId count);
+    
+    /// Обнулить тела страниц (отсортированы) и освободить их блоки
+    bool zero_pages(const std::vector<PageId>& pages);
+    
+    /// Сортировка batch и разбиение на непрерывные серии page ID.
+    /// fn(first, count) получает индексы batch'а отсортированной серии
+    template <typename Fn>
+    void for_each_run(const std::vector<PageIo>& batch, Fn&& fn);
+    
+    /// Отправить все серии batch'а через io_backend_ и дождаться их.
+    /// Для каждой серии fn(run, count, ok), ok — серия передана целиком
+    template <typename Fn>
+    void submit_runs(std::vector<PageIo>& batch, IoRequest::Op op, Fn&& fn);
+    
     std::filesystem::path db_path_;
     std::filesystem::path data_file_path_;
-    std::fstream data_file_;
-    std::mutex io_mutex_;
+    int fd_ = -1;
+    bool direct_io_ = false;
+    IoConfig io_config_;
+    std::shared_ptr<IoBackend> io_backend_;
+    LatencyHistogram sync_latency_;
     std::atomic<PageId> next_page_id_{0};
     bool initialized_ = false;
+    
+    // Выделение страниц и карта; next_page_id_ меняется под alloc_mutex_
+    mutable std::mutex alloc_mutex_;
+    PageId file_pages_ = 0;                             // Размер файла в страницах
+    std::set<PageId> free_pages_;                       // В обороте
+    std::vector<std::pair<PageId, Lsn>> pending_free_;  // Ждут recycle_pages()
+    std::vector<uint8_t> space_map_;
+    std::size_t map_dirty_begin_ = 0;
+    std::size_t map_dirty_end_ = 0;
+    std::mutex map_write_mutex_;
+    int map_fd_ = -1;
+    
+    // Double-write: общая область пакетов и свободные одиночные слоты
+    int dw_fd_ = -1;
+    std::mutex dw_batch_mutex_;
+    std::mutex dw_slot_mutex_;
+    std::condition_variable dw_slot_cv_;
+    std::vector<std::size_t> dw_free_slots_;
+    std::atomic<uint64_t> double_write_pages_{0};
+    std::atomic<uint64_t> torn_pages_repaired_{0};
 };
 
 } // namespace datyredb::storage
@@ -0,0 +1,346 @@
+#include "storage/eviction_policy.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace datyredb::storage {
+
+std::unique_ptr<EvictionPolicy> make_eviction_policy(const BufferPoolConfig& config,
+                                                     std::size_t frame_count) {
+    switch (config.eviction_policy) {
+        case EvictionPolicyType::LruK:
+            return std::make_unique<LruKPolicy>(frame_count, std::max<std::size_t>(config.lru_k, 1));
+        case EvictionPolicyType::Arc:
+            return std::make_unique<ArcPolicy>(frame_count);
+        case EvictionPolicyType::ClockSweep:
+        default:
+            return std::make_unique<ClockSweepPolicy>(frame_count);
+    }
+}
+
+// ============================================================================
+// ClockSweepPolicy
+// ============================================================================
+
+ClockSweepPolicy::ClockSweepPolicy(std::size_t frame_count)
+    : frame_count_(frame_count)
+    , referenced_(std::make_unique<std::atomic<bool>[]>(frame_count))
+{
+    for (std::size_t i = 0; i < frame_count_; ++i) {
+        referenced_[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+void ClockSweepPolicy::record_access(std::size_t frame_idx) {
+    referenced_[frame_idx].store(true, std::memory_order_relaxed);
+}
+
+void ClockSweepPolicy::record_load(std::size_t frame_idx, PageId) {
+    referenced_[frame_idx].store(true, std::memory_order_relaxed);
+}
+
+void ClockSweepPolicy::record_remove(std::size_t frame_idx) {
+    referenced_[frame_idx].store(false, std::memory_order_relaxed);
+}
+
+std::size_t ClockSweepPolicy::evict(const TryEvict& try_evict) {
+    // Два прохода: первый сбрасывает reference bit
+    for (int pass = 0; pass < 2; ++pass) {
+        for (std::size_t i = 0; i < frame_count_; ++i) {
+            std::size_t idx = (clock_hand_ + i) % frame_count_;
+            
+            if (referenced_[idx].exchange(false, std::memory_order_relaxed)) {
+                // Даём второй шанс
+                continue;
+            }
+            
+            if (!try_evict(idx)) {
+                continue;  // Pinned, свободен или не удалось evict
+            }
+            
+            clock_hand_ = (idx + 1) % frame_count_;
+            return idx;
+        }
+    }
+    
+    return NO_VICTIM;
+}
+
+// ============================================================================
+// LruKPolicy
+// ============================================================================
+
+LruKPolicy::LruKPolicy(std::size_t frame_count, std::size_t k)
+    : frame_count_(frame_count)
+    , k_(k)
+    , history_(std::make_unique<std::atomic<uint64_t>[]>(frame_count * k))
+    , frame_page_(frame_count, INVALID_PAGE_ID)
+{
+    for (std::size_t i = 0; i < frame_count_ * k_; ++i) {
+        history_[i].store(0, std::memory_order_relaxed);
+    }
+    candidates_.reserve(frame_count_);
+}
+
+uint64_t LruKPolicy::now() {
+    return static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+void LruKPolicy::record_access(std::size_t frame_idx) {
+    // Сдвиг истории; гонка двух hit'ов безвредна — теряется одна отметка
+    auto* hist = history(frame_idx);
+    for (std::size_t i = k_ - 1; i > 0; --i) {
+        hist[i].store(hist[i - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    hist[0].store(now(), std::memory_order_relaxed);
+}
+
+void LruKPolicy::record_load(std::size_t frame_idx, PageId page_id) {
+    auto* hist = history(frame_idx);
+    
+    auto ghost = ghost_.find(page_id);
+    if (ghost != ghost_.end()) {
+        for (std::size_t i = 0; i < k_; ++i) {
+            hist[i].store(ghost->second.history[i], std::memory_order_relaxed);
+        }
+        ghost_.erase(ghost);
+    } else {
+        for (std::size_t i = 0; i < k_; ++i) {
+            hist[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    frame_page_[frame_idx] = page_id;
+    record_access(frame_idx);
+}
+
+void LruKPolicy::record_remove(std::size_t frame_idx) {
+    auto* hist = history(frame_idx);
+    for (std::size_t i = 0; i < k_; ++i) {
+        hist[i].store(0, std::memory_order_relaxed);
+    }
+    frame_page_[frame_idx] = INVALID_PAGE_ID;
+}
+
+std::size_t LruKPolicy::evict(const TryEvict& try_evict) {
+    // Ключ: (класс, время). Класс 0 — меньше K обращений (бесконечная
+    // K-distance), внутри — по последнему обращению; класс 1 — по K-му.
+    candidates_.clear();
+    for (std::size_t idx = 0; idx < frame_count_; ++idx) {
+        if (frame_page_[idx] == INVALID_PAGE_ID) {
+            continue;
+        }
+        
+        auto* hist = history(idx);
+        uint64_t kth = hist[k_ - 1].load(std::memory_order_relaxed);
+        if (kth == 0) {
+            candidates_.push_back({{0, hist[0].load(std::memory_order_relaxed)}, idx});
+        } else {
+            candidates_.push_back({{1, kth}, idx});
+        }
+    }
+    
+    // Min-heap: обычно victim находится с первой-второй попытки
+    auto cmp = [](const auto& a, const auto& b) { return a.first > b.first; };
+    std::make_heap(candidates_.begin(), candidates_.end(), cmp);
+    
+    while (!candidates_.empty()) {
+        std::pop_heap(candidates_.begin(), candidates_.end(), cmp);
+        std::size_t idx = candidates_.back().second;
+        candidates_.pop_back();
+        
+        if (!try_evict(idx)) {
+            continue;
+        }
+        
+        // Сохраняем историю вытесненной страницы
+        PageId page_id = frame_page_[idx];
+        auto* hist = history(idx);
+        auto& saved = ghost_[page_id];
+        saved.history.resize(k_);
+        saved.seq = ++ghost_seq_;
+        for (std::size_t i = 0; i < k_; ++i) {
+            saved.history[i] = hist[i].load(std::memory_order_relaxed);
+            hist[i].store(0, std::memory_order_relaxed);
+        }
+        ghost_order_.emplace_back(page_id, saved.seq);
+        frame_page_[idx] = INVALID_PAGE_ID;
+        
+        // Ограничиваем историю размером партиции
+        while (ghost_order_.size() > frame_count_) {
+            auto [oldest, seq] = ghost_order_.front();
+            ghost_order_.pop_front();
+            auto it = ghost_.find(oldest);
+            if (it != ghost_.end() && it->second.seq == seq) {
+                ghost_.erase(it);
+            }
+        }
+        
+        return idx;
+    }
+    
+    return NO_VICTIM;
+}
+
+// ============================================================================
+// ArcPolicy
+// ============================================================================
+
+ArcPolicy::ArcPolicy(std::size_t frame_count)
+    : capacity_(frame_count)
+    , where_(frame_count, Where::None)
+    , position_(frame_count)
+    , frame_page_(frame_count, INVALID_PAGE_ID)
+    , referenced_(std::make_unique<std::atomic<bool>[]>(frame_count))
+    , tried_(frame_count, false)
+{
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        referenced_[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+void ArcPolicy::record_access(std::size_t frame_idx) {
+    // Повторное обращение; перенос в MRU T2 — в evict()
+    referenced_[frame_idx].store(true, std::memory_order_relaxed);
+}
+
+void ArcPolicy::record_load(std::size_t frame_idx, PageId page_id) {
+    unlink(frame_idx);
+    frame_page_[frame_idx] = page_id;
+    referenced_[frame_idx].store(false, std::memory_order_relaxed);
+    
+    auto ghost = ghost_index_.find(page_id);
+    if (ghost == ghost_index_.end()) {
+        // Новая страница — в T1
+        t1_.push_front(frame_idx);
+        position_[frame_idx] = t1_.begin();
+        where_[frame_idx] = Where::T1;
+        trim_ghosts();
+        return;
+    }
+    
+    bool in_b1 = ghost->second.first;
+    if (in_b1) {
+        // Промах по недавно вытесненной из T1 — растим T1
+        std::size_t delta = std::max<std::size_t>(b2_.size() / std::max<std::size_t>(b1_.size(), 1), 1);
+        target_t1_ = std::min(capacity_, target_t1_ + delta);
+        b1_.erase(ghost->second.second);
+    } else {
+        // Промах по вытесненной из T2 — растим T2
+        std::size_t delta = std::max<std::size_t>(b1_.size() / std::max<std::size_t>(b2_.size(), 1), 1);
+        target_t1_ = target_t1_ > delta ? target_t1_ - delta : 0;
+        b2_.erase(ghost->second.second);
+    }
+    ghost_index_.erase(ghost);
+    
+    t2_.push_front(frame_idx);
+    position_[frame_idx] = t2_.begin();
+    where_[frame_idx] = Where::T2;
+    trim_ghosts();
+}
+
+void ArcPolicy::record_remove(std::size_t frame_idx) {
+    unlink(frame_idx);
+    frame_page_[frame_idx] = INVALID_PAGE_ID;
+    referenced_[frame_idx].store(false, std::memory_order_relaxed);
+}
+
+std::size_t ArcPolicy::evict(const TryEvict& try_evict) {
+    std::vector<std::size_t> touched;
+    std::size_t victim = NO_VICTIM;
+    
+    // Hit'ы не ждут evict(), поэтому отметки могут появляться снова;
+    // после 2c переносов отметки больше не учитываются
+    std::size_t moves_left = 2 * capacity_;
+    
+    for (;;) {
+        bool prefer_t1 = !t1_.empty() && (t1_.size() > target_t1_ || t2_.empty());
+        auto* list = prefer_t1 ? &t1_ : &t2_;
+        std::size_t idx = lru_candidate(*list);
+        if (idx == NO_VICTIM) {
+            list = prefer_t1 ? &t2_ : &t1_;
+            idx = lru_candidate(*list);
+        }
+        if (idx == NO_VICTIM) {
+            break;
+        }
+        
+        // Обращение с момента загрузки или прошлого переноса — hit ARC:
+        // frame уходит в MRU T2 вместо вытеснения
+        if (moves_left > 0 && referenced_[idx].exchange(false, std::memory_order_relaxed)) {
+            --moves_left;
+            t2_.splice(t2_.begin(), *list, position_[idx]);
+            where_[idx] = Where::T2;
+            continue;
+        }
+        
+        tried_[idx] = true;
+        touched.push_back(idx);
+        if (try_evict(idx)) {
+            victim = idx;
+            break;
+        }
+    }
+    
+    for (std::size_t idx : touched) {
+        tried_[idx] = false;
+    }
+    
+    if (victim == NO_VICTIM) {
+        return NO_VICTIM;
+    }
+    
+    // Вытесненный page ID уходит в соответствующий ghost-список
+    PageId page_id = frame_page_[victim];
+    bool from_t1 = where_[victim] == Where::T1;
+    unlink(victim);
+    frame_page_[victim] = INVALID_PAGE_ID;
+    referenced_[victim].store(false, std::memory_order_relaxed);
+    
+    if (page_id != INVALID_PAGE_ID) {
+        auto& ghost_list = from_t1 ? b1_ : b2_;
+        ghost_list.push_front(page_id);
+        ghost_index_[page_id] = {from_t1, ghost_list.begin()};
+        trim_ghosts();
+    }
+    
+    return victim;
+}
+
+std::size_t ArcPolicy::lru_candidate(const std::list<std::size_t>& list) const {
+    for (auto it = list.rbegin(); it != list.rend(); ++it) {
+        if (!tried_[*it]) {
+            return *it;
+        }
+    }
+    return NO_VICTIM;
+}
+
+void ArcPolicy::unlink(std::size_t frame_idx) {
+    switch (where_[frame_idx]) {
+        case Where::T1:
+            t1_.erase(position_[frame_idx]);
+            break;
+        case Where::T2:
+            t2_.erase(position_[frame_idx]);
+            break;
+        case Where::None:
+            break;
+    }
+    where_[frame_idx] = Where::None;
+}
+
+void ArcPolicy::trim_ghosts() {
+    // |T1| + |B1| <= c, |T1| + |T2| + |B1| + |B2| <= 2c
+    while (!b1_.empty() && t1_.size() + b1_.size() > capacity_) {
+        ghost_index_.erase(b1_.back());
+        b1_.pop_back();
+    }
+    while (!b2_.empty() && t1_.size() + t2_.size() + b1_.size() + b2_.size() > 2 * capacity_) {
+        ghost_index_.erase(b2_.back());
+        b2_.pop_back();
+    }
+}
+
+} // namespace datyredb::storage
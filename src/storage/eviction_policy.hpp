@@ -0,0 +1,177 @@
+#pragma once
+
+#include "storage/storage_types.hpp"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace datyredb::storage {
+
+/// Политика вытеснения для одной партиции buffer pool.
+///
+/// record_access() вызывается на каждый hit без latch партиции и обязан
+/// быть lock-free: только атомарные операции над состоянием frame'а, без
+/// mutex'ов, аллокаций и ожидания. Перестройку своих структур по этим
+/// отметкам политика откладывает до evict(). Остальные методы вызываются
+/// под latch партиции (т.е. сериализованы между собой).
+class EvictionPolicy {
+public:
+    static constexpr std::size_t NO_VICTIM = static_cast<std::size_t>(-1);
+    
+    /// Попытка вытеснить frame: true — frame освобождён и захвачен вызывающим
+    using TryEvict = std::function<bool(std::size_t frame_idx)>;
+    
+    virtual ~EvictionPolicy() = default;
+    
+    /// Hit по странице во frame (lock-free, см. выше)
+    virtual void record_access(std::size_t frame_idx) = 0;
+    
+    /// Страница загружена (или создана) во frame
+    virtual void record_load(std::size_t frame_idx, PageId page_id) = 0;
+    
+    /// Frame освобождён без вытеснения (delete_page)
+    virtual void record_remove(std::size_t frame_idx) = 0;
+    
+    /// Выбор и вытеснение victim'а. Учёт вытеснения — внутри политики
+    virtual std::size_t evict(const TryEvict& try_evict) = 0;
+    
+    virtual EvictionPolicyType type() const = 0;
+};
+
+/// Создать политику по конфигурации
+std::unique_ptr<EvictionPolicy> make_eviction_policy(const BufferPoolConfig& config,
+                                                     std::size_t frame_count);
+
+// ============================================================================
+// Clock-Sweep
+// ============================================================================
+
+/// Один reference bit на frame, два прохода стрелки
+class ClockSweepPolicy : public EvictionPolicy {
+public:
+    explicit ClockSweepPolicy(std::size_t frame_count);
+    
+    void record_access(std::size_t frame_idx) override;
+    void record_load(std::size_t frame_idx, PageId page_id) override;
+    void record_remove(std::size_t frame_idx) override;
+    std::size_t evict(const TryEvict& try_evict) override;
+    
+    EvictionPolicyType type() const override { return EvictionPolicyType::ClockSweep; }
+
+private:
+    std::size_t frame_count_;
+    std::unique_ptr<std::atomic<bool>[]> referenced_;
+    std::size_t clock_hand_ = 0;
+};
+
+// ============================================================================
+// LRU-K
+// ============================================================================
+
+/// LRU-K: вытесняется frame с наибольшей backward K-distance. Страницы
+/// с менее чем K обращениями (однократный scan) уходят первыми. История
+/// вытесненных страниц хранится ограниченное время, чтобы повторно
+/// загруженная горячая страница не начинала с нуля.
+class LruKPolicy : public EvictionPolicy {
+public:
+    LruKPolicy(std::size_t frame_count, std::size_t k);
+    
+    void record_access(std::size_t frame_idx) override;
+    void record_load(std::size_t frame_idx, PageId page_id) override;
+    void record_remove(std::size_t frame_idx) override;
+    std::size_t evict(const TryEvict& try_evict) override;
+    
+    EvictionPolicyType type() const override { return EvictionPolicyType::LruK; }
+
+private:
+    /// Время обращения (монотонные ns), 0 — обращения не было
+    static uint64_t now();
+    
+    std::atomic<uint64_t>* history(std::size_t frame_idx) {
+        return &history_[frame_idx * k_];
+    }
+    
+    std::size_t frame_count_;
+    std::size_t k_;
+    
+    // frame_count * k таймстемпов, [0] — самое свежее обращение
+    std::unique_ptr<std::atomic<uint64_t>[]> history_;
+    std::vector<PageId> frame_page_;
+    
+    // История вытесненных страниц (retained information).
+    // В очереди — (page_id, seq); запись в ghost_ удаляется, только если
+    // seq совпадает (страница могла быть вытеснена повторно)
+    struct GhostEntry {
+        std::vector<uint64_t> history;
+        uint64_t seq = 0;
+    };
+    std::unordered_map<PageId, GhostEntry> ghost_;
+    std::deque<std::pair<PageId, uint64_t>> ghost_order_;
+    uint64_t ghost_seq_ = 0;
+    
+    // Переиспользуемый буфер кандидатов
+    std::vector<std::pair<std::pair<int, uint64_t>, std::size_t>> candidates_;
+};
+
+// ============================================================================
+// ARC
+// ============================================================================
+
+/// Adaptive Replacement Cache (Megiddo & Modha). T1 — страницы, к которым
+/// обращались один раз, T2 — повторно; B1/B2 — ghost-списки вытесненных
+/// page ID, по попаданиям в которые адаптируется целевой размер T1.
+///
+/// Hit только ставит reference bit frame'а (как в CAR): перенос в MRU T2
+/// выполняет evict() под latch партиции, когда frame с отметкой доходит
+/// до LRU-конца своего списка. Все структуры, кроме отметок, меняются
+/// только под latch, поэтому своего mutex'а у политики нет.
+class ArcPolicy : public EvictionPolicy {
+public:
+    explicit ArcPolicy(std::size_t frame_count);
+    
+    void record_access(std::size_t frame_idx) override;
+    void record_load(std::size_t frame_idx, PageId page_id) override;
+    void record_remove(std::size_t frame_idx) override;
+    std::size_t evict(const TryEvict& try_evict) override;
+    
+    EvictionPolicyType type() const override { return EvictionPolicyType::Arc; }
+
+private:
+    enum class Where : uint8_t { None, T1, T2 };
+    
+    /// Убрать frame из T1/T2
+    void unlink(std::size_t frame_idx);
+    
+    /// Ограничить ghost-списки
+    void trim_ghosts();
+    
+    /// Ближайший к LRU-концу frame списка, ещё не опробованный в evict()
+    std::size_t lru_candidate(const std::list<std::size_t>& list) const;
+    
+    std::size_t capacity_;
+    std::size_t target_t1_ = 0;  // p в терминах ARC
+    
+    // MRU — в начале списка
+    std::list<std::size_t> t1_;
+    std::list<std::size_t> t2_;
+    std::vector<Where> where_;
+    std::vector<std::list<std::size_t>::iterator> position_;
+    std::vector<PageId> frame_page_;
+    
+    // Обращения после последнего переноса frame'а (ставит record_access)
+    std::unique_ptr<std::atomic<bool>[]> referenced_;
+    
+    std::list<PageId> b1_;
+    std::list<PageId> b2_;
+    std::unordered_map<PageId, std::pair<bool, std::list<PageId>::iterator>> ghost_index_;
+    
+    // Уже опробованные в текущем evict() frame'ы
+    std::vector<bool> tried_;
+};
+
+} // namespace datyredb::storage
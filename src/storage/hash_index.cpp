@@ -0,0 +1,303 @@
+#include "storage/hash_index.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace datyredb::storage {
+
+namespace {
+
+uint64_t pack(RecordId rid) {
+    return (static_cast<uint64_t>(rid.page_id) << 16) | rid.slot;
+}
+
+RecordId unpack(uint64_t packed) {
+    return RecordId{static_cast<PageId>(packed >> 16), static_cast<uint16_t>(packed & 0xFFFF)};
+}
+
+/// Ближайшая степень двойки не меньше n
+std::size_t round_up_pow2(std::size_t n) {
+    std::size_t result = 1;
+    while (result < n) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+// ============================================================================
+// Epoch guard
+// ============================================================================
+
+class HashIndex::ReadGuard {
+public:
+    /// Зарегистрироваться в счётчике текущей эпохи. Если эпоха сменилась
+    /// между чтением и регистрацией — повтор: писатель мог не увидеть
+    /// счётчик и освободить то, что читатель ещё найдёт
+    explicit ReadGuard(const HashIndex& index) {
+        for (;;) {
+            uint64_t epoch = index.epoch_.load();
+            counter_ = &index.readers_[epoch & 1];
+            counter_->fetch_add(1);
+            if (index.epoch_.load() == epoch) {
+                break;
+            }
+            counter_->fetch_sub(1, std::memory_order_release);
+        }
+    }
+    
+    ~ReadGuard() { counter_->fetch_sub(1, std::memory_order_release); }
+    
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+    
+private:
+    std::atomic<uint64_t>* counter_ = nullptr;
+};
+
+// ============================================================================
+// Tables
+// ============================================================================
+
+HashIndex::Table::Table(std::size_t count)
+    : mask(count - 1)
+    , buckets(new std::atomic<Node*>[count])
+    , migrated(new std::atomic<bool>[count])
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        buckets[i].store(nullptr, std::memory_order_relaxed);
+        migrated[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+HashIndex::Table::~Table() {
+    for (std::size_t i = 0; i <= mask; ++i) {
+        Node* node = buckets[i].load(std::memory_order_relaxed);
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+}
+
+HashIndex::HashIndex(std::size_t initial_buckets)
+    : state_(new State{new Table(round_up_pow2(std::max<std::size_t>(initial_buckets, 1))), nullptr})
+{
+}
+
+HashIndex::~HashIndex() {
+    free_garbage(garbage_[0]);
+    free_garbage(garbage_[1]);
+    
+    State* state = state_.load(std::memory_order_relaxed);
+    delete state->current;
+    delete state->old;
+    delete state;
+}
+
+uint64_t HashIndex::hash(std::string_view key) {
+    // Финальное перемешивание splitmix64: индекс корзины — младшие биты
+    uint64_t h = std::hash<std::string_view>{}(key);
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h;
+}
+
+// ============================================================================
+// Modifications
+// ============================================================================
+
+bool HashIndex::insert(std::string_view key, RecordId rid) {
+    uint64_t h = hash(key);
+    uint64_t packed = pack(rid);
+    
+    std::lock_guard lock(write_mutex_);
+    State* state = state_.load(std::memory_order_relaxed);
+    std::atomic<Node*>& head = bucket_of(*state, h);
+    for (Node* node = head.load(std::memory_order_relaxed); node;
+         node = node->next.load(std::memory_order_relaxed)) {
+        if (node->hash == h && node->rid == packed) {
+            return false;
+        }
+    }
+    
+    // Узел заполнен до публикации: читатель видит его целиком
+    Node* node = new Node{h, packed};
+    node->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    head.store(node, std::memory_order_release);
+    std::size_t count = size_.fetch_add(1, std::memory_order_relaxed) + 1;
+    
+    if (state->old) {
+        migrate(MIGRATE_STEP);
+    } else if (count > (state->current->mask + 1) * MAX_LOAD) {
+        start_resize((state->current->mask + 1) * 2);
+        migrate(MIGRATE_STEP);
+    }
+    try_advance_epoch();
+    return true;
+}
+
+bool HashIndex::remove(std::string_view key, RecordId rid) {
+    uint64_t h = hash(key);
+    uint64_t packed = pack(rid);
+    
+    std::lock_guard lock(write_mutex_);
+    State* state = state_.load(std::memory_order_relaxed);
+    std::atomic<Node*>* link = &bucket_of(*state, h);
+    for (Node* node = link->load(std::memory_order_relaxed); node;
+         node = link->load(std::memory_order_relaxed)) {
+        if (node->hash != h || node->rid != packed) {
+            link = &node->next;
+            continue;
+        }
+        
+        // Читатель, стоящий на узле, продолжит по его next: узел
+        // освобождается только через эпоху
+        link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+        garbage_[epoch_.load(std::memory_order_relaxed) & 1].nodes.push_back(node);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        
+        if (state->old) {
+            migrate(MIGRATE_STEP);
+        }
+        try_advance_epoch();
+        return true;
+    }
+    return false;
+}
+
+void HashIndex::reserve(std::size_t entries) {
+    std::lock_guard lock(write_mutex_);
+    if (state_.load(std::memory_order_relaxed)->old) {
+        migrate(std::numeric_limits<std::size_t>::max());
+    }
+    
+    std::size_t buckets = round_up_pow2(entries / MAX_LOAD + 1);
+    if (buckets > state_.load(std::memory_order_relaxed)->current->mask + 1) {
+        start_resize(buckets);
+        migrate(std::numeric_limits<std::size_t>::max());
+    }
+    try_advance_epoch();
+}
+
+// ============================================================================
+// Lookup
+// ============================================================================
+
+std::vector<RecordId> HashIndex::lookup(std::string_view key) const {
+    uint64_t h = hash(key);
+    std::vector<RecordId> result;
+    
+    ReadGuard guard(*this);
+    const State* state = state_.load(std::memory_order_acquire);
+    for (Node* node = bucket_of(*state, h).load(std::memory_order_acquire); node;
+         node = node->next.load(std::memory_order_acquire)) {
+        if (node->hash == h) {
+            result.push_back(unpack(node->rid));
+        }
+    }
+    return result;
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+std::size_t HashIndex::bucket_count() const {
+    ReadGuard guard(*this);
+    return state_.load(std::memory_order_acquire)->current->mask + 1;
+}
+
+bool HashIndex::resizing() const {
+    ReadGuard guard(*this);
+    return state_.load(std::memory_order_acquire)->old != nullptr;
+}
+
+// ============================================================================
+// Resize
+// ============================================================================
+
+std::atomic<HashIndex::Node*>& HashIndex::bucket_of(const State& state, uint64_t hash) {
+    if (state.old) {
+        std::size_t index = hash & state.old->mask;
+        if (!state.old->migrated[index].load(std::memory_order_acquire)) {
+            return state.old->buckets[index];
+        }
+    }
+    return state.current->buckets[hash & state.current->mask];
+}
+
+void HashIndex::start_resize(std::size_t buckets) {
+    State* state = state_.load(std::memory_order_relaxed);
+    publish(new Table(round_up_pow2(buckets)), state->current);
+    migrate_next_ = 0;
+}
+
+void HashIndex::migrate(std::size_t count) {
+    State* state = state_.load(std::memory_order_relaxed);
+    Table* old = state->old;
+    Table* current = state->current;
+    std::size_t old_buckets = old->mask + 1;
+    
+    // Размер новой таблицы кратен старому: её корзина получает узлы ровно
+    // одной старой корзины и до флага той читателям не видна
+    for (; count > 0 && migrate_next_ < old_buckets; --count, ++migrate_next_) {
+        for (Node* node = old->buckets[migrate_next_].load(std::memory_order_relaxed); node;
+             node = node->next.load(std::memory_order_relaxed)) {
+            std::atomic<Node*>& head = current->buckets[node->hash & current->mask];
+            Node* copy = new Node{node->hash, node->rid};
+            copy->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            head.store(copy, std::memory_order_relaxed);
+        }
+        old->migrated[migrate_next_].store(true, std::memory_order_release);
+    }
+    
+    if (migrate_next_ == old_buckets) {
+        publish(current, nullptr);
+        garbage_[epoch_.load(std::memory_order_relaxed) & 1].tables.push_back(old);
+        migrate_next_ = 0;
+    }
+}
+
+void HashIndex::publish(Table* current, Table* old) {
+    State* previous = state_.exchange(new State{current, old}, std::memory_order_acq_rel);
+    garbage_[epoch_.load(std::memory_order_relaxed) & 1].states.push_back(previous);
+}
+
+// ============================================================================
+// Reclamation
+// ============================================================================
+
+void HashIndex::try_advance_epoch() {
+    // Читатели эпохи e - 1 (та же чётность, что e + 1) ушли — отложенное
+    // в ней недостижимо: все оставшиеся читатели пришли после
+    uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+    if (readers_[(epoch + 1) & 1].load() != 0) {
+        return;
+    }
+    free_garbage(garbage_[(epoch + 1) & 1]);
+    epoch_.store(epoch + 1);
+}
+
+void HashIndex::free_garbage(Garbage& garbage) {
+    for (Node* node : garbage.nodes) {
+        delete node;
+    }
+    for (Table* table : garbage.tables) {
+        delete table;
+    }
+    for (State* state : garbage.states) {
+        delete state;
+    }
+    garbage.nodes.clear();
+    garbage.tables.clear();
+    garbage.states.clear();
+}
+
+} // namespace datyredb::storage
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "storage/storage_types.hpp"
+#include "storage/heap_file.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace datyredb::storage {
+
+/// Хеш-индекс в памяти: 64-битный хеш ключа → RecordId. Сами ключи не
+/// хранятся, поэтому lookup() возвращает кандидатов — совпадение ключа
+/// вызывающий проверяет по строке (как и для обрезанных ключей B+tree).
+/// На диск индекс не пишется и строится заново scan'ом heap file'а.
+///
+/// Конкурентность: писатели сериализуются внутренним mutex'ом, читатели
+/// не берут блокировок. Корзина — односвязный список с atomic-ссылками;
+/// узел публикуется одной release-записью головы, удаление — одной
+/// записью ссылки предшественника. Удалённые узлы и старые таблицы
+/// освобождаются по эпохам: читатель регистрируется в счётчике текущей
+/// эпохи, писатель продвигает эпоху, когда читателей предыдущей не
+/// осталось, и тогда освобождает отложенное две эпохи назад. Писатель
+/// читателей не ждёт.
+///
+/// Рост — удвоение с постепенным переносом: при заполнении выше
+/// MAX_LOAD создаётся новая таблица, и каждая запись переносит в неё
+/// MIGRATE_STEP корзин старой (копиями узлов; старая цепочка остаётся
+/// целой для читателей, уже идущих по ней). Перенесённая корзина
+/// помечается флагом — читатели и писатели после этого идут в новую
+/// таблицу, до этого — в старую. Пары {текущая, старая} публикуются
+/// неизменяемым снимком, поэтому читатель всегда видит согласованную
+/// пару.
+class HashIndex {
+public:
+    /// Элементов на корзину, после которого начинается рост
+    static constexpr std::size_t MAX_LOAD = 1;
+    
+    /// Корзин старой таблицы, переносимых одной записью
+    static constexpr std::size_t MIGRATE_STEP = 8;
+    
+    explicit HashIndex(std::size_t initial_buckets = 64);
+    ~HashIndex();
+    
+    // Запретить копирование
+    HashIndex(const HashIndex&) = delete;
+    HashIndex& operator=(const HashIndex&) = delete;
+    
+    static uint64_t hash(std::string_view key);
+    
+    // ========================================================================
+    // Modifications (сериализуются между собой)
+    // ========================================================================
+    
+    /// false — пара уже есть
+    bool insert(std::string_view key, RecordId rid);
+    
+    /// false — пары нет
+    bool remove(std::string_view key, RecordId rid);
+    
+    /// Подготовить место под entries элементов: дописать текущий перенос и
+    /// вырасти сразу до нужного числа корзин (для построения индекса)
+    void reserve(std::size_t entries);
+    
+    // ========================================================================
+    // Lookup (без блокировок)
+    // ========================================================================
+    
+    /// RecordId'ы с тем же хешем ключа
+    std::vector<RecordId> lookup(std::string_view key) const;
+    
+    // ========================================================================
+    // Statistics
+    // ========================================================================
+    
+    std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+    
+    /// Корзин в текущей таблице
+    std::size_t bucket_count() const;
+    
+    /// Идёт перенос в новую таблицу
+    bool resizing() const;
+    
+private:
+    struct Node {
+        uint64_t hash;
+        uint64_t rid;
+        std::atomic<Node*> next{nullptr};
+    };
+    
+    /// Таблица корзин; владеет узлами своих цепочек
+    struct Table {
+        explicit Table(std::size_t buckets);
+        ~Table();
+        
+        std::size_t mask;
+        std::unique_ptr<std::atomic<Node*>[]> buckets;
+        /// Корзина перенесена в следующую таблицу
+        std::unique_ptr<std::atomic<bool>[]> migrated;
+    };
+    
+    /// Снимок для читателей: old != nullptr, пока идёт перенос
+    struct State {
+        Table* current;
+        Table* old;
+    };
+    
+    /// Отложенное до конца эпохи освобождение
+    struct Garbage {
+        std::vector<Node*> nodes;
+        std::vector<Table*> tables;
+        std::vector<State*> states;
+    };
+    
+    /// Регистрация читателя в эпохе на время lookup()
+    class ReadGuard;
+    
+    /// Корзина, в которой сейчас живёт хеш (старая, пока не перенесена)
+    static std::atomic<Node*>& bucket_of(const State& state, uint64_t hash);
+    
+    /// Перенести до count корзин; по завершении — опубликовать новую таблицу
+    void migrate(std::size_t count);
+    
+    /// Начать рост до buckets корзин
+    void start_resize(std::size_t buckets);
+    
+    /// Опубликовать новый снимок, старый — в мусор
+    void publish(Table* current, Table* old);
+    
+    /// Продвинуть эпоху, если читателей предыдущей не осталось
+    void try_advance_epoch();
+    
+    static void free_garbage(Garbage& garbage);
+    
+    std::mutex write_mutex_;
+    std::atomic<State*> state_;
+    std::atomic<std::size_t> size_{0};
+    
+    /// Следующая корзина старой таблицы к переносу
+    std::size_t migrate_next_ = 0;
+    
+    /// Эпохи: читатели текущей и предыдущей — в счётчиках по чётности
+    std::atomic<uint64_t> epoch_{0};
+    mutable std::atomic<uint64_t> readers_[2] = {};
+    Garbage garbage_[2];
+};
+
+} // namespace datyredb::storage
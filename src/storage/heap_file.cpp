@@ -0,0 +1,861 @@
+#include "storage/heap_file.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <thread>
+
+namespace datyredb::storage {
+
+namespace {
+
+constexpr std::size_t PAYLOAD_SIZE = Page::payload_size();
+
+#pragma pack(push, 1)
+/// Заголовок slotted-страницы; last_page и счётчики — только у первой.
+/// free_end совпадает с нулевым reserved OverflowHeader: overflow-страница
+/// и освобождённая страница выглядят неразмеченными
+struct HeapHeader {
+    PageId next_page;
+    uint16_t slot_count;
+    uint16_t free_end;        // Начало области записей; 0 — не размечена
+    PageId prev_page;
+    PageId owner;             // Первая страница файла
+    PageId last_page;
+    uint32_t reserved;
+    uint64_t record_count;
+    uint64_t data_bytes;
+};
+
+struct Slot {
+    uint16_t offset;          // 0 — слот свободен
+    uint16_t length;
+};
+
+struct OverflowHeader {
+    PageId next_page;
+    uint16_t used;
+    uint16_t reserved;
+};
+
+struct OverflowStub {
+    PageId first_page;
+    uint32_t size;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(HeapHeader) == HeapFile::HEADER_SIZE, "HeapHeader size mismatch");
+static_assert(sizeof(Slot) == HeapFile::SLOT_SIZE, "Slot size mismatch");
+static_assert(sizeof(OverflowHeader) == HeapFile::OVERFLOW_HEADER_SIZE, "OverflowHeader size mismatch");
+static_assert(sizeof(OverflowStub) == HeapFile::STUB_SIZE, "OverflowStub size mismatch");
+
+constexpr std::size_t OVERFLOW_CAPACITY = PAYLOAD_SIZE - HeapFile::OVERFLOW_HEADER_SIZE;
+
+HeapHeader* heap_header(char* payload) {
+    return reinterpret_cast<HeapHeader*>(payload);
+}
+
+const HeapHeader* heap_header(const char* payload) {
+    return reinterpret_cast<const HeapHeader*>(payload);
+}
+
+Slot* slots(char* payload) {
+    return reinterpret_cast<Slot*>(payload + HeapFile::HEADER_SIZE);
+}
+
+const Slot* slots(const char* payload) {
+    return reinterpret_cast<const Slot*>(payload + HeapFile::HEADER_SIZE);
+}
+
+/// Байты записи без бита overflow
+std::size_t record_length(uint16_t length) {
+    return length & ~HeapFile::OVERFLOW_BIT;
+}
+
+/// Место записи: не меньше заглушки
+std::size_t alloc_size(std::size_t length) {
+    return std::max(length, HeapFile::STUB_SIZE);
+}
+
+std::size_t slots_end(const char* payload) {
+    return HeapFile::HEADER_SIZE + HeapFile::SLOT_SIZE * heap_header(payload)->slot_count;
+}
+
+/// Непрерывное место между каталогом слотов и записями
+std::size_t contiguous_free(const char* payload) {
+    return heap_header(payload)->free_end - slots_end(payload);
+}
+
+/// Свободное место с учётом дыр от удалённых записей
+std::size_t total_free(const char* payload) {
+    const HeapHeader* header = heap_header(payload);
+    std::size_t used = slots_end(payload);
+    for (uint16_t i = 0; i < header->slot_count; ++i) {
+        const Slot& slot = slots(payload)[i];
+        if (slot.offset != 0) {
+            used += alloc_size(record_length(slot.length));
+        }
+    }
+    return PAYLOAD_SIZE - used;
+}
+
+/// Сдвинуть записи к концу страницы — свободное место становится
+/// непрерывным
+void compact(char* payload) {
+    std::array<char, PAYLOAD_SIZE> copy;
+    std::memcpy(copy.data(), payload, PAYLOAD_SIZE);
+    
+    HeapHeader* header = heap_header(payload);
+    std::size_t end = PAYLOAD_SIZE;
+    for (uint16_t i = 0; i < header->slot_count; ++i) {
+        Slot& slot = slots(payload)[i];
+        if (slot.offset == 0) {
+            continue;
+        }
+        std::size_t size = alloc_size(record_length(slot.length));
+        end -= size;
+        std::memcpy(payload + end, copy.data() + slot.offset, size);
+        slot.offset = static_cast<uint16_t>(end);
+    }
+    header->free_end = static_cast<uint16_t>(end);
+}
+
+/// Положить запись в слот: место должно быть (total_free)
+void place(char* payload, uint16_t slot_index, std::string_view stored, uint16_t flag) {
+    std::size_t size = alloc_size(stored.size());
+    if (contiguous_free(payload) < size) {
+        compact(payload);
+    }
+    
+    HeapHeader* header = heap_header(payload);
+    header->free_end = static_cast<uint16_t>(header->free_end - size);
+    std::memset(payload + header->free_end, 0, size);
+    std::memcpy(payload + header->free_end, stored.data(), stored.size());
+    
+    Slot& slot = slots(payload)[slot_index];
+    slot.offset = header->free_end;
+    slot.length = static_cast<uint16_t>(stored.size() | flag);
+}
+
+void format_page(char* payload, PageId owner, PageId prev_page, PageId last_page) {
+    std::memset(payload, 0, PAYLOAD_SIZE);
+    HeapHeader* header = heap_header(payload);
+    header->next_page = INVALID_PAGE_ID;
+    header->free_end = static_cast<uint16_t>(PAYLOAD_SIZE);
+    header->prev_page = prev_page;
+    header->owner = owner;
+    header->last_page = last_page;
+}
+
+void apply_meta(char* payload, int64_t records, int64_t bytes, PageId last_page) {
+    HeapHeader* header = heap_header(payload);
+    header->record_count = static_cast<uint64_t>(static_cast<int64_t>(header->record_count) + records);
+    header->data_bytes = static_cast<uint64_t>(static_cast<int64_t>(header->data_bytes) + bytes);
+    if (last_page != INVALID_PAGE_ID) {
+        header->last_page = last_page;
+    }
+}
+
+std::string make_stub(PageId first_page, std::size_t size) {
+    OverflowStub stub{first_page, static_cast<uint32_t>(size)};
+    return std::string(reinterpret_cast<const char*>(&stub), sizeof(stub));
+}
+
+OverflowStub read_stub(const char* payload, const Slot& slot) {
+    OverflowStub stub;
+    std::memcpy(&stub, payload + slot.offset, sizeof(stub));
+    return stub;
+}
+
+/// Живой слот страницы
+const Slot* find_slot(const char* payload, uint16_t index) {
+    const HeapHeader* header = heap_header(payload);
+    if (header->free_end == 0 || index >= header->slot_count) {
+        return nullptr;
+    }
+    const Slot* slot = &slots(payload)[index];
+    return slot->offset != 0 ? slot : nullptr;
+}
+
+/// Удалить страницы из buffer pool'а и вернуть DiskManager'у; страница
+/// может быть ненадолго запинена фоновым writer'ом или read-ahead'ом
+void release(BufferPool& buffer_pool, const std::vector<PageId>& pages, Lsn freed_lsn) {
+    for (PageId page_id : pages) {
+        while (!buffer_pool.delete_page(page_id, freed_lsn)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// HeapFile
+// ============================================================================
+
+HeapFile::HeapFile(std::shared_ptr<BufferPool> buffer_pool,
+                   std::shared_ptr<WriteAheadLog> wal,
+                   PageId first_page)
+    : buffer_pool_(std::move(buffer_pool))
+    , wal_(std::move(wal))
+    , first_page_(first_page)
+{
+}
+
+PageId HeapFile::create(BufferPool& buffer_pool, WriteAheadLog& wal, TxnContext& txn) {
+    PageId page_id = INVALID_PAGE_ID;
+    Page* page = new_txn_page(buffer_pool, txn, &page_id);
+    if (!page) {
+        return INVALID_PAGE_ID;
+    }
+    
+    modify(buffer_pool, wal, txn, page, [&](char* payload) {
+        format_page(payload, page_id, INVALID_PAGE_ID, page_id);
+    });
+    buffer_pool.unpin_page(page_id, true);
+    return page_id;
+}
+
+bool HeapFile::format(BufferPool& buffer_pool, WriteAheadLog& wal,
+                      TxnContext& txn, PageId page_id) {
+    Page* page = buffer_pool.fetch_page(page_id);
+    if (!page) {
+        return false;
+    }
+    
+    modify(buffer_pool, wal, txn, page, [&](char* payload) {
+        format_page(payload, page_id, INVALID_PAGE_ID, page_id);
+    });
+    buffer_pool.unpin_page(page_id, true);
+    return true;
+}
+
+bool HeapFile::is_formatted(BufferPool& buffer_pool, PageId page_id) {
+    Page* page = buffer_pool.fetch_page(page_id);
+    if (!page) {
+        return false;
+    }
+    bool formatted = heap_header(page->payload())->free_end != 0;
+    buffer_pool.unpin_page(page_id, false);
+    return formatted;
+}
+
+bool HeapFile::rollback(BufferPool& buffer_pool, WriteAheadLog& wal, TxnContext& txn) {
+    bool ok = true;
+    
+    for (auto it = txn.undo.rbegin(); it != txn.undo.rend(); ++it) {
+        Page* page = buffer_pool.fetch_page(it->page_id);
+        if (!page) {
+            Logger::error("HeapFile: rollback of txn {} cannot pin page {}",
+                          txn.txn_id, it->page_id);
+            ok = false;
+            continue;
+        }
+        
+        LogRecord clr = it->compensation();
+        Lsn clr_lsn = wal.append(clr);
+        page->write_lock();
+        clr.redo(page->payload());
+        page->set_lsn(clr_lsn);
+        page->write_unlock();
+        buffer_pool.unpin_page(it->page_id, true);
+        txn.last_lsn = clr_lsn;
+    }
+    txn.undo.clear();
+    
+    LogRecord abort;
+    abort.type = LogRecordType::TXN_ABORT;
+    abort.txn_id = txn.txn_id;
+    abort.prev_lsn = txn.last_lsn;
+    txn.last_lsn = wal.append(abort);
+    
+    // Откаченные страницы снова нулевые — их можно отдать
+    release(buffer_pool, txn.allocated, txn.last_lsn);
+    txn.allocated.clear();
+    txn.freed.clear();
+    return ok;
+}
+
+void HeapFile::release_pages(BufferPool& buffer_pool, TxnContext& txn, Lsn commit_lsn) {
+    release(buffer_pool, txn.freed, commit_lsn);
+    txn.allocated.clear();
+    txn.freed.clear();
+}
+
+// ============================================================================
+// Records
+// ============================================================================
+
+std::optional<RecordId> HeapFile::insert(TxnContext& txn, std::string_view record) {
+    std::string stub;
+    std::string_view stored = record;
+    uint16_t flag = 0;
+    if (record.size() > MAX_INLINE_RECORD) {
+        PageId chain = write_overflow(txn, record);
+        if (chain == INVALID_PAGE_ID) {
+            return std::nullopt;
+        }
+        stub = make_stub(chain, record.size());
+        stored = stub;
+        flag = OVERFLOW_BIT;
+    }
+    std::size_t needed = alloc_size(stored.size()) + SLOT_SIZE;
+    
+    Page* first = pin(first_page_);
+    if (!first) {
+        return std::nullopt;
+    }
+    PageId page_id = heap_header(first->payload())->last_page;
+    buffer_pool_->unpin_page(first_page_, false);
+    
+    Page* page = pin(page_id);
+    if (!page) {
+        return std::nullopt;
+    }
+    
+    // Места нет — дыра в другой странице файла, иначе новая страница в
+    // конец цепочки
+    PageId new_last = INVALID_PAGE_ID;
+    if (total_free(page->payload()) < needed) {
+        PageId hole_id = INVALID_PAGE_ID;
+        if (Page* hole = find_space(needed, &hole_id)) {
+            buffer_pool_->unpin_page(page_id, false);
+            page = hole;
+            page_id = hole_id;
+        } else {
+            PageId fresh_id = INVALID_PAGE_ID;
+            Page* fresh = new_txn_page(*buffer_pool_, txn, &fresh_id);
+            if (!fresh) {
+                buffer_pool_->unpin_page(page_id, false);
+                return std::nullopt;
+            }
+            modify(*buffer_pool_, *wal_, txn, fresh, [&](char* payload) {
+                format_page(payload, first_page_, page_id, INVALID_PAGE_ID);
+            });
+            modify(*buffer_pool_, *wal_, txn, page, [&](char* payload) {
+                heap_header(payload)->next_page = fresh_id;
+            });
+            buffer_pool_->unpin_page(page_id, true);
+            
+            page = fresh;
+            page_id = fresh_id;
+            new_last = fresh_id;
+        }
+    }
+    
+    RecordId rid{page_id, heap_header(page->payload())->slot_count};
+    modify(*buffer_pool_, *wal_, txn, page, [&](char* payload) {
+        // Каталог растёт в непрерывное место: без него новый слот лёг бы
+        // на запись, а в промежутке лежат байты старых записей
+        if (contiguous_free(payload) < SLOT_SIZE) {
+            compact(payload);
+        }
+        heap_header(payload)->slot_count++;
+        slots(payload)[rid.slot] = Slot{0, 0};
+        place(payload, rid.slot, stored, flag);
+        if (page_id == first_page_) {
+            apply_meta(payload, 1, static_cast<int64_t>(record.size()), new_last);
+        }
+    });
+    buffer_pool_->unpin_page(page_id, true);
+    
+    if (page_id != first_page_ &&
+        !update_meta(txn, 1, static_cast<int64_t>(record.size()), new_last)) {
+        return std::nullopt;
+    }
+    return rid;
+}
+
+bool HeapFile::update(TxnContext& txn, RecordId rid, std::string_view record) {
+    Page* page = pin(rid.page_id);
+    if (!page) {
+        return false;
+    }
+    
+    const Slot* slot = find_slot(page->payload(), rid.slot);
+    if (!slot) {
+        buffer_pool_->unpin_page(rid.page_id, false);
+        return false;
+    }
+    
+    std::size_t old_alloc = alloc_size(record_length(slot->length));
+    std::size_t old_size = record_length(slot->length);
+    PageId old_chain = INVALID_PAGE_ID;
+    if (slot->length & OVERFLOW_BIT) {
+        OverflowStub old_stub = read_stub(page->payload(), *slot);
+        old_chain = old_stub.first_page;
+        old_size = old_stub.size;
+    }
+    
+    // Не помещается ни на месте, ни на странице — в overflow-цепочку:
+    // заглушка всегда встаёт на место старой записи
+    std::string stub;
+    std::string_view stored = record;
+    uint16_t flag = 0;
+    std::size_t fits = total_free(page->payload()) + old_alloc;
+    if (record.size() > MAX_INLINE_RECORD ||
+        (alloc_size(record.size()) > old_alloc && alloc_size(record.size()) > fits)) {
+        PageId chain = write_overflow(txn, record);
+        if (chain == INVALID_PAGE_ID) {
+            buffer_pool_->unpin_page(rid.page_id, false);
+            return false;
+        }
+        stub = make_stub(chain, record.size());
+        stored = stub;
+        flag = OVERFLOW_BIT;
+    }
+    
+    int64_t delta = static_cast<int64_t>(record.size()) - static_cast<int64_t>(old_size);
+    modify(*buffer_pool_, *wal_, txn, page, [&](char* payload) {
+        Slot& target = slots(payload)[rid.slot];
+        if (alloc_size(stored.size()) <= old_alloc) {
+            std::memset(payload + target.offset, 0, old_alloc);
+            std::memcpy(payload + target.offset, stored.data(), stored.size());
+            target.length = static_cast<uint16_t>(stored.size() | flag);
+        } else {
+            target.offset = 0;
+            place(payload, rid.slot, stored, flag);
+        }
+        if (rid.page_id == first_page_) {
+            apply_meta(payload, 0, delta, INVALID_PAGE_ID);
+        }
+    });
+    note_space(rid.page_id, page->payload());
+    buffer_pool_->unpin_page(rid.page_id, true);
+    
+    if (old_chain != INVALID_PAGE_ID && !free_overflow(txn, old_chain)) {
+        return false;
+    }
+    
+    if (rid.page_id != first_page_ && delta != 0) {
+        return update_meta(txn, 0, delta);
+    }
+    return true;
+}
+
+bool HeapFile::remove(TxnContext& txn, RecordId rid) {
+    Page* page = pin(rid.page_id);
+    if (!page) {
+        return false;
+    }
+    
+    const Slot* slot = find_slot(page->payload(), rid.slot);
+    if (!slot) {
+        buffer_pool_->unpin_page(rid.page_id, false);
+        return false;
+    }
+    
+    std::size_t old_size = record_length(slot->length);
+    PageId old_chain = INVALID_PAGE_ID;
+    if (slot->length & OVERFLOW_BIT) {
+        OverflowStub old_stub = read_stub(page->payload(), *slot);
+        old_chain = old_stub.first_page;
+        old_size = old_stub.size;
+    }
+    
+    bool emptied = false;
+    modify(*buffer_pool_, *wal_, txn, page, [&](char* payload) {
+        slots(payload)[rid.slot] = Slot{0, 0};
+        
+        // Свободные слоты в конце каталога отдаём; средние остаются —
+        // RecordId остальных записей не меняются
+        HeapHeader* header = heap_header(payload);
+        while (header->slot_count > 0 && slots(payload)[header->slot_count - 1].offset == 0) {
+            header->slot_count--;
+        }
+        if (header->slot_count == 0) {
+            header->free_end = static_cast<uint16_t>(PAYLOAD_SIZE);
+            emptied = true;
+        }
+        if (rid.page_id == first_page_) {
+            apply_meta(payload, -1, -static_cast<int64_t>(old_size), INVALID_PAGE_ID);
+        }
+    });
+    note_space(rid.page_id, page->payload());
+    buffer_pool_->unpin_page(rid.page_id, true);
+    
+    if (old_chain != INVALID_PAGE_ID && !free_overflow(txn, old_chain)) {
+        return false;
+    }
+    if (rid.page_id == first_page_) {
+        return true;
+    }
+    if (emptied && !unlink(txn, rid.page_id)) {
+        return false;
+    }
+    return update_meta(txn, -1, -static_cast<int64_t>(old_size));
+}
+
+bool HeapFile::destroy(TxnContext& txn) {
+    std::vector<PageId> pages;
+    std::vector<PageId> chains;
+    PageId page_id = first_page_;
+    while (page_id != INVALID_PAGE_ID) {
+        Page* page = pin(page_id);
+        if (!page) {
+            return false;
+        }
+        
+        const char* payload = page->payload();
+        const HeapHeader* header = heap_header(payload);
+        for (uint16_t i = 0; i < header->slot_count; ++i) {
+            const Slot& slot = slots(payload)[i];
+            if (slot.offset != 0 && (slot.length & OVERFLOW_BIT)) {
+                chains.push_back(read_stub(payload, slot).first_page);
+            }
+        }
+        pages.push_back(page_id);
+        
+        PageId next = header->next_page;
+        buffer_pool_->unpin_page(page_id, false);
+        page_id = next;
+    }
+    
+    for (PageId chain : chains) {
+        if (!free_overflow(txn, chain)) {
+            return false;
+        }
+    }
+    txn.freed.insert(txn.freed.end(), pages.begin(), pages.end());
+    space_candidates_.clear();
+    return true;
+}
+
+std::optional<std::string> HeapFile::get(RecordId rid) const {
+    if (HEADER_SIZE + SLOT_SIZE * (static_cast<std::size_t>(rid.slot) + 1) > PAYLOAD_SIZE) {
+        return std::nullopt;
+    }
+    Page* page = pin(rid.page_id);
+    if (!page) {
+        return std::nullopt;
+    }
+    
+    // Оптимистичное чтение, как спуск B+tree: копия записи годна, если
+    // версия страницы не сменилась. Прочитанное до validate() может быть
+    // рваным — границы проверяются до копирования
+    std::optional<std::string> result;
+    for (;;) {
+        uint64_t version = page->read_version();
+        const char* payload = page->payload();
+        
+        result.reset();
+        std::optional<OverflowStub> stub;
+        const Slot* slot = heap_header(payload)->owner == first_page_
+                               ? find_slot(payload, rid.slot) : nullptr;
+        if (slot) {
+            Slot copy = *slot;
+            std::size_t length = record_length(copy.length);
+            if (copy.offset + alloc_size(length) <= PAYLOAD_SIZE) {
+                if (copy.length & OVERFLOW_BIT) {
+                    stub = read_stub(payload, copy);
+                } else {
+                    result = std::string(payload + copy.offset, length);
+                }
+            }
+        }
+        if (!page->validate(version)) {
+            continue;
+        }
+        
+        // Overflow-цепочка не меняется, пока на неё ссылается слот:
+        // update/remove сначала меняют слот, и validate() это увидит
+        if (stub) {
+            std::string value;
+            bool read = read_overflow(stub->first_page, stub->size, value);
+            if (!page->validate(version)) {
+                continue;
+            }
+            if (read) {
+                result = std::move(value);
+            }
+        }
+        break;
+    }
+    
+    buffer_pool_->unpin_page(rid.page_id, false);
+    return result;
+}
+
+bool HeapFile::scan(const std::function<bool(RecordId, std::string_view)>& fn) const {
+    PageId page_id = first_page_;
+    std::string overflow;
+    
+    while (page_id != INVALID_PAGE_ID) {
+        Page* page = pin(page_id);
+        if (!page) {
+            return false;
+        }
+        
+        const char* payload = page->payload();
+        const HeapHeader* header = heap_header(payload);
+        bool proceed = true;
+        for (uint16_t i = 0; i < header->slot_count && proceed; ++i) {
+            const Slot& slot = slots(payload)[i];
+            if (slot.offset == 0) {
+                continue;
+            }
+            
+            std::string_view record(payload + slot.offset, record_length(slot.length));
+            if (slot.length & OVERFLOW_BIT) {
+                OverflowStub stub = read_stub(payload, slot);
+                if (!read_overflow(stub.first_page, stub.size, overflow)) {
+                    buffer_pool_->unpin_page(page_id, false);
+                    return false;
+                }
+                record = overflow;
+            }
+            proceed = fn(RecordId{page_id, i}, record);
+        }
+        
+        PageId next = proceed ? header->next_page : INVALID_PAGE_ID;
+        buffer_pool_->unpin_page(page_id, false);
+        page_id = next;
+    }
+    return true;
+}
+
+// ============================================================================
+// Stats
+// ============================================================================
+
+uint64_t HeapFile::record_count() const {
+    Page* page = pin(first_page_);
+    if (!page) {
+        return 0;
+    }
+    uint64_t count = heap_header(page->payload())->record_count;
+    buffer_pool_->unpin_page(first_page_, false);
+    return count;
+}
+
+uint64_t HeapFile::data_bytes() const {
+    Page* page = pin(first_page_);
+    if (!page) {
+        return 0;
+    }
+    uint64_t bytes = heap_header(page->payload())->data_bytes;
+    buffer_pool_->unpin_page(first_page_, false);
+    return bytes;
+}
+
+// ============================================================================
+// Private helpers
+// ============================================================================
+
+void HeapFile::modify(BufferPool& buffer_pool, WriteAheadLog& wal,
+                      TxnContext& txn, Page* page,
+                      const std::function<void(char*)>& fn, PageFlags kind) {
+    // Под latch'ем страницы: get() читает её без блокировок
+    page->write_lock();
+    bool changed = modify_page(wal, txn, page, fn);
+    page->write_unlock();
+    if (!changed) {
+        return;
+    }
+    
+    // Подсказки заголовка и карты свободного места
+    const char* payload = page->payload();
+    if (kind == PageFlags::OVERFLOW) {
+        const auto* header = reinterpret_cast<const OverflowHeader*>(payload);
+        page->set_free_space(static_cast<uint16_t>(OVERFLOW_CAPACITY - header->used));
+    } else {
+        std::size_t free = heap_header(payload)->free_end != 0 ? total_free(payload) : 0;
+        page->set_free_space(static_cast<uint16_t>(free));
+        buffer_pool.disk_manager()->note_free_space(page->page_id(), free);
+    }
+    page->set_flags(kind);
+}
+
+PageId HeapFile::write_overflow(TxnContext& txn, std::string_view data) {
+    PageId first_id = INVALID_PAGE_ID;
+    Page* page = new_txn_page(*buffer_pool_, txn, &first_id);
+    if (!page) {
+        return INVALID_PAGE_ID;
+    }
+    
+    // Следующая страница выделяется до записи текущей: ссылка на неё
+    // ложится в тот же UPDATE
+    PageId page_id = first_id;
+    std::size_t pos = 0;
+    while (true) {
+        std::size_t chunk = std::min(OVERFLOW_CAPACITY, data.size() - pos);
+        PageId next_id = INVALID_PAGE_ID;
+        Page* next = nullptr;
+        if (pos + chunk < data.size()) {
+            next = new_txn_page(*buffer_pool_, txn, &next_id);
+            if (!next) {
+                buffer_pool_->unpin_page(page_id, false);
+                return INVALID_PAGE_ID;
+            }
+        }
+        
+        modify(*buffer_pool_, *wal_, txn, page, [&](char* payload) {
+            OverflowHeader header{next_id, static_cast<uint16_t>(chunk), 0};
+            std::memcpy(payload, &header, sizeof(header));
+            std::memcpy(payload + OVERFLOW_HEADER_SIZE, data.data() + pos, chunk);
+        }, PageFlags::OVERFLOW);
+        buffer_pool_->unpin_page(page_id, true);
+        
+        pos += chunk;
+        if (!next) {
+            break;
+        }
+        page = next;
+        page_id = next_id;
+    }
+    return first_id;
+}
+
+bool HeapFile::read_overflow(PageId page_id, std::size_t size, std::string& out) const {
+    out.clear();
+    out.reserve(size);
+    
+    while (out.size() < size) {
+        if (page_id == INVALID_PAGE_ID) {
+            Logger::error("HeapFile: overflow chain of file {} ends early", first_page_);
+            return false;
+        }
+        Page* page = pin(page_id);
+        if (!page) {
+            return false;
+        }
+        
+        OverflowHeader header;
+        std::memcpy(&header, page->payload(), sizeof(header));
+        std::size_t used = std::min<std::size_t>({header.used, OVERFLOW_CAPACITY, size - out.size()});
+        if (used == 0) {
+            buffer_pool_->unpin_page(page_id, false);
+            Logger::error("HeapFile: empty overflow page {}", page_id);
+            return false;
+        }
+        out.append(page->payload() + OVERFLOW_HEADER_SIZE, used);
+        
+        buffer_pool_->unpin_page(page_id, false);
+        page_id = header.next_page;
+    }
+    return true;
+}
+
+bool HeapFile::free_overflow(TxnContext& txn, PageId page_id) {
+    while (page_id != INVALID_PAGE_ID) {
+        Page* page = pin(page_id);
+        if (!page) {
+            return false;
+        }
+        OverflowHeader header;
+        std::memcpy(&header, page->payload(), sizeof(header));
+        buffer_pool_->unpin_page(page_id, false);
+        
+        txn.freed.push_back(page_id);
+        page_id = header.next_page;
+    }
+    return true;
+}
+
+Page* HeapFile::find_space(std::size_t needed, PageId* page_id) {
+    if (!space_seeded_) {
+        space_seeded_ = true;
+        for (PageId candidate : buffer_pool_->disk_manager()->pages_with_free_space(REUSE_THRESHOLD)) {
+            space_candidates_.insert(candidate);
+        }
+    }
+    
+    // Карта общая для всех файлов и приблизительна: страница проверяется
+    // по заголовку
+    for (auto it = space_candidates_.begin(); it != space_candidates_.end();) {
+        Page* page = buffer_pool_->fetch_page(*it);
+        if (!page) {
+            it = space_candidates_.erase(it);
+            continue;
+        }
+        
+        const char* payload = page->payload();
+        const HeapHeader* header = heap_header(payload);
+        bool ours = header->free_end != 0 && header->owner == first_page_;
+        std::size_t free = ours ? total_free(payload) : 0;
+        if (free >= needed) {
+            *page_id = *it;
+            return page;
+        }
+        
+        // Заполненная страница уходит из кандидатов
+        buffer_pool_->unpin_page(*it, false);
+        if (free < REUSE_THRESHOLD) {
+            it = space_candidates_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return nullptr;
+}
+
+void HeapFile::note_space(PageId page_id, const char* payload) {
+    if (space_seeded_ && heap_header(payload)->free_end != 0 &&
+        total_free(payload) >= REUSE_THRESHOLD) {
+        space_candidates_.insert(page_id);
+    }
+}
+
+bool HeapFile::unlink(TxnContext& txn, PageId page_id) {
+    Page* page = pin(page_id);
+    if (!page) {
+        return false;
+    }
+    HeapHeader header = *heap_header(page->payload());
+    
+    // Нулевой заголовок: страница больше не размечена и не примет записи,
+    // даже если до commit попадётся в карте свободного места
+    modify(*buffer_pool_, *wal_, txn, page, [&](char* payload) {
+        std::memset(payload, 0, HEADER_SIZE);
+    });
+    buffer_pool_->unpin_page(page_id, true);
+    
+    Page* prev = pin(header.prev_page);
+    if (!prev) {
+        return false;
+    }
+    modify(*buffer_pool_, *wal_, txn, prev, [&](char* payload) {
+        heap_header(payload)->next_page = header.next_page;
+    });
+    buffer_pool_->unpin_page(header.prev_page, true);
+    
+    if (header.next_page != INVALID_PAGE_ID) {
+        Page* next = pin(header.next_page);
+        if (!next) {
+            return false;
+        }
+        modify(*buffer_pool_, *wal_, txn, next, [&](char* payload) {
+            heap_header(payload)->prev_page = header.prev_page;
+        });
+        buffer_pool_->unpin_page(header.next_page, true);
+    } else if (!update_meta(txn, 0, 0, header.prev_page)) {
+        return false;
+    }
+    
+    space_candidates_.erase(page_id);
+    txn.freed.push_back(page_id);
+    return true;
+}
+
+bool HeapFile::update_meta(TxnContext& txn, int64_t records, int64_t bytes, PageId last_page) {
+    Page* page = pin(first_page_);
+    if (!page) {
+        return false;
+    }
+    modify(*buffer_pool_, *wal_, txn, page, [&](char* payload) {
+        apply_meta(payload, records, bytes, last_page);
+    });
+    buffer_pool_->unpin_page(first_page_, true);
+    return true;
+}
+
+Page* HeapFile::pin(PageId page_id) const {
+    Page* page = buffer_pool_->fetch_page(page_id);
+    if (!page) {
+        Logger::error("HeapFile: cannot pin page {}", page_id);
+    }
+    return page;
+}
+
+} // namespace datyredb::storage
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "storage/storage_types.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/wal.hpp"
+#include "storage/txn_context.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace datyredb::storage {
+
+/// Адрес записи heap file'а: страница и слот. Не меняется при update
+struct RecordId {
+    PageId page_id = INVALID_PAGE_ID;
+    uint16_t slot = 0;
+    
+    bool valid() const { return page_id != INVALID_PAGE_ID; }
+    
+    bool operator==(const RecordId& other) const {
+        return page_id == other.page_id && slot == other.slot;
+    }
+    bool operator!=(const RecordId& other) const { return !(*this == other); }
+};
+
+/// Heap file — неупорядоченный набор записей переменной длины на
+/// цепочке slotted-страниц buffer pool'а.
+///
+/// Payload страницы: заголовок (HEADER_SIZE байт), за ним каталог
+/// слотов {uint16 offset, uint16 length}, растущий вверх; записи лежат
+/// от конца payload вниз. offset == 0 — свободный слот. Страницы связаны
+/// в двусвязную цепочку и помнят первую страницу файла (владельца).
+/// Первая страница файла хранит в заголовке последнюю страницу цепочки,
+/// число записей и их объём.
+///
+/// Записи длиннее MAX_INLINE_RECORD уходят в цепочку страниц с
+/// PageFlags::OVERFLOW; в слоте остаётся заглушка {первая страница,
+/// длина} с битом OVERFLOW_BIT в длине. Место записи не меньше
+/// заглушки, поэтому update, не помещающийся на страницу, превращает
+/// запись в заглушку на месте: RecordId и порядок scan() сохраняются.
+///
+/// Каждое изменение страницы — UPDATE в лог до изменения самой страницы
+/// (образы изменённого диапазона payload), затем set_lsn(). Recovery
+/// повторяет и откатывает их как любые физические изменения.
+/// PageHeader::free_space и flags — производные подсказки: обновляются
+/// при каждом изменении страницы и в лог не пишутся.
+///
+/// Свободное место: страница, опустевшая после remove(), выходит из
+/// цепочки, освобождённые overflow-цепочки — тоже; после commit они
+/// уходят в DiskManager (release_pages()). Свободное место страниц
+/// отмечается в карте DiskManager'а; insert() сначала заполняет дыры
+/// страниц файла и только затем растит цепочку.
+///
+/// Изменения страниц идут под version latch'ем страницы, и get() читает
+/// оптимистично — без блокировок, параллельно с изменениями. Страницу
+/// меняют только modify() и rollback(), оба под write_lock(): на этом
+/// держатся get() и снимки для записи на диск (Page::snapshot). Остальное
+/// не потокобезопасно: вызывающий исключает конкурентные insert / update /
+/// remove друг с другом и со scan().
+class HeapFile {
+public:
+    /// Заголовок страницы в payload
+    static constexpr std::size_t HEADER_SIZE = 40;
+    static constexpr std::size_t SLOT_SIZE = 4;
+    
+    /// Заголовок overflow-страницы: следующая страница и занятые байты
+    static constexpr std::size_t OVERFLOW_HEADER_SIZE = 8;
+    
+    /// Записи длиннее — в overflow-цепочку
+    static constexpr std::size_t MAX_INLINE_RECORD = Page::payload_size() / 4;
+    
+    /// Страница с таким свободным местом — кандидат для insert()
+    static constexpr std::size_t REUSE_THRESHOLD = Page::payload_size() / 4;
+    
+    static constexpr uint16_t OVERFLOW_BIT = 0x8000;
+    static constexpr std::size_t STUB_SIZE = 8;
+    
+    HeapFile(std::shared_ptr<BufferPool> buffer_pool,
+             std::shared_ptr<WriteAheadLog> wal,
+             PageId first_page);
+    
+    /// Новый пустой файл; INVALID_PAGE_ID — нет свободного frame'а
+    static PageId create(BufferPool& buffer_pool, WriteAheadLog& wal, TxnContext& txn);
+    
+    /// Разметить выделенную страницу как первую страницу пустого файла
+    static bool format(BufferPool& buffer_pool, WriteAheadLog& wal,
+                       TxnContext& txn, PageId page_id);
+    
+    /// Страница размечена format()
+    static bool is_formatted(BufferPool& buffer_pool, PageId page_id);
+    
+    /// Откатить изменения txn (CLR на каждое), записать TXN_ABORT и
+    /// вернуть выделенные страницы
+    static bool rollback(BufferPool& buffer_pool, WriteAheadLog& wal, TxnContext& txn);
+    
+    /// Вернуть освобождённые закоммиченной txn страницы DiskManager'у;
+    /// commit_lsn — LSN её TXN_COMMIT
+    static void release_pages(BufferPool& buffer_pool, TxnContext& txn, Lsn commit_lsn);
+    
+    PageId first_page() const { return first_page_; }
+    
+    // ========================================================================
+    // Records
+    // ========================================================================
+    
+    std::optional<RecordId> insert(TxnContext& txn, std::string_view record);
+    bool update(TxnContext& txn, RecordId rid, std::string_view record);
+    bool remove(TxnContext& txn, RecordId rid);
+    
+    /// Освободить все страницы файла (в txn.freed); файл больше не
+    /// используется
+    bool destroy(TxnContext& txn);
+    
+    std::optional<std::string> get(RecordId rid) const;
+    
+    /// Обход записей в порядке страниц и слотов; fn возвращает false,
+    /// чтобы остановиться. false — ошибка чтения страницы
+    bool scan(const std::function<bool(RecordId, std::string_view)>& fn) const;
+    
+    // ========================================================================
+    // Stats
+    // ========================================================================
+    
+    uint64_t record_count() const;
+    uint64_t data_bytes() const;
+    
+private:
+    /// modify_page() и подсказки страницы. kind — флаги формата
+    static void modify(BufferPool& buffer_pool, WriteAheadLog& wal,
+                       TxnContext& txn, Page* page,
+                       const std::function<void(char*)>& fn,
+                       PageFlags kind = PageFlags::NONE);
+    
+    /// Записать данные в новую overflow-цепочку; INVALID_PAGE_ID — ошибка
+    PageId write_overflow(TxnContext& txn, std::string_view data);
+    
+    /// Прочитать overflow-цепочку длиной size байт
+    bool read_overflow(PageId page_id, std::size_t size, std::string& out) const;
+    
+    /// Страницы overflow-цепочки — в txn.freed
+    bool free_overflow(TxnContext& txn, PageId page_id);
+    
+    /// Страница файла, где помещается needed байт; nullptr — нет такой
+    Page* find_space(std::size_t needed, PageId* page_id);
+    
+    /// Запомнить страницу со свободным местом для insert()
+    void note_space(PageId page_id, const char* payload);
+    
+    /// Вынуть опустевшую страницу из цепочки и освободить
+    bool unlink(TxnContext& txn, PageId page_id);
+    
+    /// Поправить счётчики первой страницы
+    bool update_meta(TxnContext& txn, int64_t records, int64_t bytes,
+                     PageId last_page = INVALID_PAGE_ID);
+    
+    /// Страница с пином; nullptr — все frame'ы заняты
+    Page* pin(PageId page_id) const;
+    
+    std::shared_ptr<BufferPool> buffer_pool_;
+    std::shared_ptr<WriteAheadLog> wal_;
+    PageId first_page_;
+    
+    /// Страницы файла с местом не меньше REUSE_THRESHOLD; заполняется из
+    /// карты DiskManager'а при первой нехватке места в последней странице
+    std::set<PageId> space_candidates_;
+    bool space_seeded_ = false;
+};
+
+} // namespace datyredb::storage
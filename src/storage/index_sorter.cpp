@@ -0,0 +1,458 @@
+#include "storage/index_sorter.hpp"
+#include "utils/logger.hpp"
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+namespace datyredb::storage {
+
+namespace {
+
+constexpr std::size_t RECORD_HEADER = sizeof(uint16_t) + sizeof(uint64_t);
+constexpr uint16_t END_OF_BLOCK = 0xFFFF;
+
+/// Буфер записи серий: до стольких блоков в одном pwritev
+constexpr std::size_t MAX_WRITE_PAGES = 32;
+
+uint16_t key_size(const char* record) {
+    uint16_t size;
+    std::memcpy(&size, record, sizeof(size));
+    return size;
+}
+
+uint64_t record_rid(const char* record) {
+    uint64_t rid;
+    std::memcpy(&rid, record + sizeof(uint16_t), sizeof(rid));
+    return rid;
+}
+
+std::string_view record_key(const char* record) {
+    return std::string_view(record + RECORD_HEADER, key_size(record));
+}
+
+std::size_t record_size(const char* record) {
+    return RECORD_HEADER + key_size(record);
+}
+
+/// Порядок BTree: ключ, затем RecordId
+int compare_records(const char* a, const char* b) {
+    int result = record_key(a).compare(record_key(b));
+    if (result != 0) {
+        return result;
+    }
+    uint64_t a_rid = record_rid(a);
+    uint64_t b_rid = record_rid(b);
+    return a_rid < b_rid ? -1 : (a_rid > b_rid ? 1 : 0);
+}
+
+/// preadv/pwritev блоков подряд до полного объёма (короткие операции и EINTR)
+template <typename Op>
+bool transfer_blocks(Op op, int fd, Page* const* blocks, std::size_t count, uint64_t first_block) {
+    std::vector<iovec> iov(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = blocks[i]->data();
+        iov[i].iov_len = PAGE_SIZE;
+    }
+    
+    std::size_t first = 0;
+    auto offset = static_cast<off_t>(first_block * PAGE_SIZE);
+    while (first < count) {
+        ssize_t n = op(fd, iov.data() + first, static_cast<int>(count - first), offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        offset += n;
+        
+        auto done = static_cast<std::size_t>(n);
+        while (first < count && done >= iov[first].iov_len) {
+            done -= iov[first].iov_len;
+            ++first;
+        }
+        if (first < count) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + done;
+            iov[first].iov_len -= done;
+        }
+    }
+    return true;
+}
+
+/// Запись серии в spill-файл через буфер из frame'ов
+class RunWriter {
+public:
+    RunWriter(int fd, uint64_t first_block, Page* const* buffers, std::size_t count)
+        : fd_(fd), first_block_(first_block), buffers_(buffers), count_(count) {}
+    
+    bool append(const char* record) {
+        std::size_t size = record_size(record);
+        if (pos_ + size > PAGE_SIZE) {
+            seal();
+            if (++frame_ == count_ && !flush()) {
+                return false;
+            }
+        }
+        std::memcpy(buffers_[frame_]->data() + pos_, record, size);
+        pos_ += size;
+        return true;
+    }
+    
+    bool finish() {
+        if (pos_ == 0) {
+            return frame_ == 0 || flush();
+        }
+        seal();
+        ++frame_;
+        return flush();
+    }
+    
+    /// Записано блоков
+    uint64_t blocks() const { return written_; }
+    
+private:
+    void seal() {
+        if (pos_ + sizeof(END_OF_BLOCK) <= PAGE_SIZE) {
+            std::memcpy(buffers_[frame_]->data() + pos_, &END_OF_BLOCK, sizeof(END_OF_BLOCK));
+        }
+        pos_ = 0;
+    }
+    
+    bool flush() {
+        if (!transfer_blocks(::pwritev, fd_, buffers_, frame_, first_block_ + written_)) {
+            Logger::error("IndexSorter: spill write failed: {}", std::strerror(errno));
+            return false;
+        }
+        written_ += frame_;
+        frame_ = 0;
+        return true;
+    }
+    
+    int fd_;
+    uint64_t first_block_;
+    Page* const* buffers_;
+    std::size_t count_;
+    std::size_t frame_ = 0;
+    std::size_t pos_ = 0;
+    uint64_t written_ = 0;
+};
+
+} // namespace
+
+// ============================================================================
+// RunReader
+// ============================================================================
+
+/// Чтение серии порциями по числу своих frame'ов
+class IndexSorter::RunReader {
+public:
+    RunReader(int fd, Run run, Page* const* buffers, std::size_t count)
+        : fd_(fd), run_(run), buffers_(buffers), count_(count) {}
+    
+    /// Текущая запись; nullptr — серия кончилась
+    const char* current() const { return current_; }
+    
+    /// К следующей записи. false — конец серии или ошибка (error())
+    bool advance() {
+        if (current_) {
+            pos_ += record_size(current_);
+            current_ = nullptr;
+        }
+        
+        for (;;) {
+            if (block_ < loaded_) {
+                const char* data = buffers_[block_]->data();
+                if (pos_ + sizeof(uint16_t) <= PAGE_SIZE && key_size(data + pos_) != END_OF_BLOCK) {
+                    current_ = data + pos_;
+                    return true;
+                }
+                ++block_;
+                pos_ = 0;
+                continue;
+            }
+            
+            if (run_.blocks == 0) {
+                return false;
+            }
+            std::size_t count = static_cast<std::size_t>(std::min<uint64_t>(count_, run_.blocks));
+            if (!transfer_blocks(::preadv, fd_, buffers_, count, run_.offset)) {
+                Logger::error("IndexSorter: spill read failed: {}", std::strerror(errno));
+                error_ = true;
+                return false;
+            }
+            run_.offset += count;
+            run_.blocks -= count;
+            loaded_ = count;
+            block_ = 0;
+            pos_ = 0;
+        }
+    }
+    
+    bool error() const { return error_; }
+    
+private:
+    int fd_;
+    Run run_;  // Непрочитанный остаток
+    Page* const* buffers_;
+    std::size_t count_;
+    std::size_t loaded_ = 0;
+    std::size_t block_ = 0;
+    std::size_t pos_ = 0;
+    const char* current_ = nullptr;
+    bool error_ = false;
+};
+
+// ============================================================================
+// IndexSorter
+// ============================================================================
+
+IndexSorter::IndexSorter(BufferPool& buffer_pool, std::size_t memory_pages,
+                         std::filesystem::path spill_dir)
+    : buffer_pool_(buffer_pool)
+    , spill_dir_(std::move(spill_dir))
+{
+    frames_ = buffer_pool_.borrow_frames(memory_pages);
+    if (frames_.size() < 3) {
+        Logger::error("IndexSorter: got {} of {} frames for sort memory",
+                      frames_.size(), memory_pages);
+        failed_ = true;
+        return;
+    }
+    write_pages_ = std::clamp<std::size_t>(frames_.size() / 8, 1, MAX_WRITE_PAGES);
+}
+
+IndexSorter::~IndexSorter() {
+    readers_.clear();
+    buffer_pool_.release_frames(frames_);
+    for (int fd : files_) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+bool IndexSorter::add(std::string_view key, RecordId rid) {
+    if (failed_ || finished_) {
+        return false;
+    }
+    if (key.size() > BTree::MAX_KEY_SIZE) {
+        Logger::error("IndexSorter: key of {} bytes is too long", key.size());
+        return fail();
+    }
+    
+    std::size_t size = RECORD_HEADER + key.size();
+    if (fill_pos_ + size > PAGE_SIZE) {
+        ++fill_frame_;
+        fill_pos_ = 0;
+    }
+    if (write_pages_ + fill_frame_ == frames_.size() && !spill()) {
+        return fail();
+    }
+    
+    auto key_length = static_cast<uint16_t>(key.size());
+    uint64_t packed = (static_cast<uint64_t>(rid.page_id) << 16) | rid.slot;
+    char* record = frames_[write_pages_ + fill_frame_]->data() + fill_pos_;
+    std::memcpy(record, &key_length, sizeof(key_length));
+    std::memcpy(record + sizeof(key_length), &packed, sizeof(packed));
+    std::memcpy(record + RECORD_HEADER, key.data(), key.size());
+    
+    records_.push_back(record);
+    fill_pos_ += size;
+    ++size_;
+    return true;
+}
+
+bool IndexSorter::finish() {
+    if (failed_ || finished_) {
+        return false;
+    }
+    finished_ = true;
+    
+    // Всё в памяти — выдача прямо из frame'ов
+    if (runs_.empty()) {
+        std::sort(records_.begin(), records_.end(), [](const char* a, const char* b) {
+            return compare_records(a, b) < 0;
+        });
+        return true;
+    }
+    
+    if (!records_.empty() && !spill()) {
+        return fail();
+    }
+    if (!merge_passes_until_fit() || !open_readers(runs_, files_[current_file_])) {
+        return fail();
+    }
+    return true;
+}
+
+bool IndexSorter::next(IndexEntry& entry) {
+    if (!finished_ || failed_) {
+        return false;
+    }
+    
+    const char* record = nullptr;
+    if (runs_.empty()) {
+        if (next_record_ == records_.size()) {
+            return false;
+        }
+        record = records_[next_record_++];
+    } else {
+        if (heap_.empty()) {
+            return false;
+        }
+        record = readers_[heap_.front()]->current();
+    }
+    
+    entry.key.assign(record_key(record));
+    uint64_t rid = record_rid(record);
+    entry.rid = RecordId{static_cast<PageId>(rid >> 16), static_cast<uint16_t>(rid & 0xFFFF)};
+    
+    if (!runs_.empty() && !advance_min()) {
+        return fail();
+    }
+    return true;
+}
+
+// ============================================================================
+// Runs
+// ============================================================================
+
+bool IndexSorter::spill() {
+    int& fd = files_[current_file_];
+    if (fd < 0 && (fd = open_spill_file()) < 0) {
+        return false;
+    }
+    
+    std::sort(records_.begin(), records_.end(), [](const char* a, const char* b) {
+        return compare_records(a, b) < 0;
+    });
+    
+    RunWriter writer(fd, file_blocks_[current_file_], frames_.data(), write_pages_);
+    for (const char* record : records_) {
+        if (!writer.append(record)) {
+            return false;
+        }
+    }
+    if (!writer.finish()) {
+        return false;
+    }
+    
+    runs_.push_back(Run{file_blocks_[current_file_], writer.blocks()});
+    file_blocks_[current_file_] += writer.blocks();
+    ++spilled_runs_;
+    
+    records_.clear();
+    fill_frame_ = 0;
+    fill_pos_ = 0;
+    return true;
+}
+
+bool IndexSorter::merge_passes_until_fit() {
+    std::size_t fan_in = frames_.size() - write_pages_;
+    
+    while (runs_.size() > fan_in) {
+        int target = 1 - current_file_;
+        if (files_[target] < 0 && (files_[target] = open_spill_file()) < 0) {
+            return false;
+        }
+        file_blocks_[target] = 0;
+        
+        std::vector<Run> merged;
+        for (std::size_t first = 0; first < runs_.size(); first += fan_in) {
+            std::vector<Run> group(runs_.begin() + first,
+                                   runs_.begin() + std::min(first + fan_in, runs_.size()));
+            if (!open_readers(group, files_[current_file_])) {
+                return false;
+            }
+            
+            RunWriter writer(files_[target], file_blocks_[target], frames_.data(), write_pages_);
+            while (!heap_.empty()) {
+                if (!writer.append(readers_[heap_.front()]->current()) || !advance_min()) {
+                    return false;
+                }
+            }
+            if (!writer.finish()) {
+                return false;
+            }
+            
+            merged.push_back(Run{file_blocks_[target], writer.blocks()});
+            file_blocks_[target] += writer.blocks();
+        }
+        
+        // Прочитанный файл больше не нужен — место возвращается сразу
+        readers_.clear();
+        if (::ftruncate(files_[current_file_], 0) != 0) {
+            Logger::warn("IndexSorter: cannot truncate spill file: {}", std::strerror(errno));
+        }
+        file_blocks_[current_file_] = 0;
+        current_file_ = target;
+        runs_ = std::move(merged);
+        ++merge_passes_;
+    }
+    return true;
+}
+
+bool IndexSorter::open_readers(const std::vector<Run>& runs, int fd) {
+    readers_.clear();
+    heap_.clear();
+    
+    std::size_t per_run = (frames_.size() - write_pages_) / runs.size();
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        Page* const* buffers = frames_.data() + write_pages_ + i * per_run;
+        readers_.push_back(std::make_unique<RunReader>(fd, runs[i], buffers, per_run));
+        if (readers_.back()->advance()) {
+            heap_.push_back(i);
+        } else if (readers_.back()->error()) {
+            return false;
+        }
+    }
+    
+    std::make_heap(heap_.begin(), heap_.end(), [this](std::size_t a, std::size_t b) {
+        return compare_records(readers_[a]->current(), readers_[b]->current()) > 0;
+    });
+    return true;
+}
+
+bool IndexSorter::advance_min() {
+    auto greater = [this](std::size_t a, std::size_t b) {
+        return compare_records(readers_[a]->current(), readers_[b]->current()) > 0;
+    };
+    
+    std::pop_heap(heap_.begin(), heap_.end(), greater);
+    RunReader& reader = *readers_[heap_.back()];
+    if (reader.advance()) {
+        std::push_heap(heap_.begin(), heap_.end(), greater);
+        return true;
+    }
+    heap_.pop_back();
+    return !reader.error();
+}
+
+int IndexSorter::open_spill_file() {
+    static std::atomic<uint64_t> counter{0};
+    auto path = spill_dir_ / ("sort-" + std::to_string(::getpid()) + "-" +
+                              std::to_string(counter.fetch_add(1)) + ".tmp");
+    
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        Logger::error("IndexSorter: cannot create spill file {}: {}",
+                      path.string(), std::strerror(errno));
+        return -1;
+    }
+    ::unlink(path.c_str());
+    return fd;
+}
+
+bool IndexSorter::fail() {
+    failed_ = true;
+    return false;
+}
+
+} // namespace datyredb::storage
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "storage/storage_types.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/btree.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace datyredb::storage {
+
+/// Внешняя сортировка элементов индекса по (ключ, RecordId) — вход
+/// BTree::bulk_load().
+///
+/// Память сортировки — frame'ы, занятые у buffer pool'а. Элементы
+/// копятся в них; когда место кончается, указатели на них сортируются и
+/// элементы уходят серией (run) в spill-файл. finish() сливает серии
+/// k-way merge'ем: у каждой входной серии свои frame'ы под чтение, поэтому
+/// fan-in ограничен памятью; лишние серии заранее сливаются группами во
+/// второй файл. Поместившееся в память на диск не пишется.
+///
+/// Серия — блоки по PAGE_SIZE; запись {uint16 длина ключа, uint64
+/// RecordId, ключ} не пересекает границу блока, хвост блока помечен
+/// длиной 0xFFFF. Spill-файлы удаляются сразу после создания:
+/// после сбоя от них ничего не остаётся.
+class IndexSorter {
+public:
+    /// memory_pages — frame'ов памяти (минимум 3: буфер записи и два
+    /// входа слияния); spill_dir — каталог временных файлов
+    IndexSorter(BufferPool& buffer_pool, std::size_t memory_pages,
+                std::filesystem::path spill_dir);
+    ~IndexSorter();
+    
+    // Запретить копирование
+    IndexSorter(const IndexSorter&) = delete;
+    IndexSorter& operator=(const IndexSorter&) = delete;
+    
+    /// false — ключ длиннее BTree::MAX_KEY_SIZE, не хватило памяти или
+    /// ошибка spill-файла
+    bool add(std::string_view key, RecordId rid);
+    
+    /// Закончить ввод: слить серии до одного прохода
+    bool finish();
+    
+    /// Следующий элемент по возрастанию. false — конец или ошибка
+    /// чтения (failed())
+    bool next(IndexEntry& entry);
+    
+    /// Сортировка прервана ошибкой; выданное next() неполно
+    bool failed() const { return failed_; }
+    
+    /// Добавлено элементов
+    uint64_t size() const { return size_; }
+    
+    /// Серий, сброшенных на диск
+    std::size_t spilled_runs() const { return spilled_runs_; }
+    
+    /// Предварительных проходов слияния
+    std::size_t merge_passes() const { return merge_passes_; }
+    
+private:
+    /// Серия в spill-файле
+    struct Run {
+        uint64_t offset;  // В блоках
+        uint64_t blocks;
+    };
+    
+    class RunReader;
+    
+    /// Отсортировать память и сбросить её серией в текущий файл
+    bool spill();
+    
+    /// Слить группы по fan-in серий в другой файл, пока серий больше fan-in
+    bool merge_passes_until_fit();
+    
+    /// Читатели серий runs; frame'ы памяти делятся между ними поровну
+    bool open_readers(const std::vector<Run>& runs, int fd);
+    
+    /// Продвинуть читателя с наименьшей текущей записью (вершина кучи).
+    /// false — ошибка чтения
+    bool advance_min();
+    
+    /// Открыть временный файл (уже удалённый из каталога)
+    int open_spill_file();
+    
+    /// Пометить сортировку прерванной; всегда false
+    bool fail();
+    
+    BufferPool& buffer_pool_;
+    std::filesystem::path spill_dir_;
+    
+    /// Frame'ы памяти: первые write_pages_ — буфер записи серий
+    std::vector<Page*> frames_;
+    std::size_t write_pages_ = 0;
+    
+    /// Элементы в памяти и место для следующего
+    std::vector<const char*> records_;
+    std::size_t fill_frame_ = 0;
+    std::size_t fill_pos_ = 0;
+    
+    /// Spill-файлы: текущий и цель прохода слияния
+    int files_[2] = {-1, -1};
+    int current_file_ = 0;
+    uint64_t file_blocks_[2] = {0, 0};
+    std::vector<Run> runs_;
+    
+    /// Выдача: из памяти или финальным слиянием
+    bool finished_ = false;
+    std::size_t next_record_ = 0;
+    std::vector<std::unique_ptr<RunReader>> readers_;
+    std::vector<std::size_t> heap_;
+    
+    uint64_t size_ = 0;
+    std::size_t spilled_runs_ = 0;
+    std::size_t merge_passes_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace datyredb::storage
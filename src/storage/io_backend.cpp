@@ -0,0 +1,458 @@
+#include "storage/io_backend.hpp"
+#include "utils/logger.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <thread>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define DATYREDB_HAVE_IO_URING 1
+#endif
+
+namespace datyredb::storage {
+
+// ============================================================================
+// IoWaitGroup
+// ============================================================================
+
+void IoWaitGroup::add(std::size_t count) {
+    std::lock_guard lock(mutex_);
+    pending_ += count;
+}
+
+void IoWaitGroup::done() {
+    std::lock_guard lock(mutex_);
+    if (--pending_ == 0) {
+        cv_.notify_all();
+    }
+}
+
+void IoWaitGroup::wait() {
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, [this] { return pending_ == 0; });
+}
+
+namespace {
+
+// ============================================================================
+// ThreadPoolIoBackend
+// ============================================================================
+
+/// Блокирующие preadv/pwritev в пуле потоков
+class ThreadPoolIoBackend : public IoBackend {
+public:
+    ThreadPoolIoBackend(std::size_t threads, std::size_t queue_depth)
+        : queue_depth_(std::max<std::size_t>(queue_depth, 1))
+    {
+        threads = std::max<std::size_t>(threads, 1);
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back(&ThreadPoolIoBackend::worker_loop, this);
+        }
+    }
+    
+    ~ThreadPoolIoBackend() override {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+    
+    void submit(std::vector<IoRequest>& requests) override {
+        {
+            std::unique_lock lock(mutex_);
+            for (auto& request : requests) {
+                space_cv_.wait(lock, [this] { return queue_.size() < queue_depth_; });
+                queue_.push_back(std::move(request));
+                work_cv_.notify_one();
+            }
+        }
+        requests.clear();
+    }
+    
+    IoBackendType type() const override { return IoBackendType::ThreadPool; }
+
+private:
+    void worker_loop() {
+        for (;;) {
+            IoRequest request;
+            {
+                std::unique_lock lock(mutex_);
+                work_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                // Очередь дорабатывается до конца даже при остановке
+                if (queue_.empty()) {
+                    return;
+                }
+                request = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            space_cv_.notify_one();
+            
+            int64_t result = execute(request);
+            if (request.callback) {
+                request.callback(result);
+            }
+        }
+    }
+    
+    static int64_t execute(const IoRequest& request) {
+        ssize_t n;
+        do {
+            auto offset = static_cast<off_t>(request.offset);
+            int count = static_cast<int>(request.iov_count);
+            n = request.op == IoRequest::Op::Read
+              ? ::preadv(request.fd, request.iov, count, offset)
+              : ::pwritev(request.fd, request.iov, count, offset);
+        } while (n < 0 && errno == EINTR);
+        return n < 0 ? -static_cast<int64_t>(errno) : static_cast<int64_t>(n);
+    }
+    
+    std::size_t queue_depth_;
+    std::deque<IoRequest> queue_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable space_cv_;
+    std::vector<std::thread> workers_;
+    bool stop_ = false;
+};
+
+#ifdef DATYREDB_HAVE_IO_URING
+
+// ============================================================================
+// IoUringBackend
+// ============================================================================
+
+/// io_uring через системные вызовы (без liburing).
+///
+/// Отправка сериализуется mutex'ом (SQ — один производитель), завершения
+/// разбирает отдельный поток. Каждая операция занимает слот; user_data
+/// SQE — индекс слота. Запросы с одним iovec внутри зарегистрированной
+/// области идут как READ_FIXED/WRITE_FIXED.
+class IoUringBackend : public IoBackend {
+public:
+    /// nullptr, если io_uring недоступен (старое ядро, seccomp)
+    static std::unique_ptr<IoUringBackend> create(std::size_t queue_depth) {
+        std::unique_ptr<IoUringBackend> backend(new IoUringBackend());
+        if (!backend->setup(static_cast<unsigned>(std::max<std::size_t>(queue_depth, 1)))) {
+            return nullptr;
+        }
+        return backend;
+    }
+    
+    ~IoUringBackend() override {
+        {
+            // Дожидаемся всех операций в полёте
+            std::unique_lock lock(submit_mutex_);
+            slot_cv_.wait(lock, [this] { return free_slots_.size() == slots_.size(); });
+            
+            // NOP с особым user_data будит и останавливает поток завершений
+            io_uring_sqe* sqe = next_sqe();
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_NOP;
+            sqe->user_data = STOP_TAG;
+            commit_sqes(1);
+        }
+        reaper_.join();
+        
+        if (registered_base_) {
+            ::syscall(__NR_io_uring_register, ring_fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+        }
+        ::munmap(sqes_, sqes_size_);
+        if (cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        ::munmap(sq_ring_, sq_ring_size_);
+        ::close(ring_fd_);
+    }
+    
+    void submit(std::vector<IoRequest>& requests) override {
+        std::unique_lock lock(submit_mutex_);
+        unsigned pending = 0;
+        
+        for (auto& request : requests) {
+            if (free_slots_.empty()) {
+                // Сначала отправляем накопленное — иначе слоты не освободятся
+                commit_sqes(pending);
+                pending = 0;
+                slot_cv_.wait(lock, [this] { return !free_slots_.empty(); });
+            }
+            
+            uint32_t slot = free_slots_.back();
+            free_slots_.pop_back();
+            slots_[slot] = std::move(request);
+            prepare_sqe(next_sqe(), slots_[slot], slot);
+            ++pending;
+        }
+        
+        commit_sqes(pending);
+        requests.clear();
+    }
+    
+    void register_buffer(char* base, std::size_t size) override {
+        std::unique_lock lock(submit_mutex_);
+        // Регистрация требует покоя кольца
+        slot_cv_.wait(lock, [this] { return free_slots_.size() == slots_.size(); });
+        
+        if (registered_base_) {
+            ::syscall(__NR_io_uring_register, ring_fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+            registered_base_ = nullptr;
+            registered_size_ = 0;
+        }
+        
+        iovec iov{base, size};
+        if (::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, &iov, 1) == 0) {
+            registered_base_ = base;
+            registered_size_ = size;
+        } else {
+            Logger::debug("IoUring: buffer registration failed ({}), using plain I/O",
+                          std::strerror(errno));
+        }
+    }
+    
+    void unregister_buffer(char* base) override {
+        std::unique_lock lock(submit_mutex_);
+        if (registered_base_ != base) {
+            return;
+        }
+        slot_cv_.wait(lock, [this] { return free_slots_.size() == slots_.size(); });
+        ::syscall(__NR_io_uring_register, ring_fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+        registered_base_ = nullptr;
+        registered_size_ = 0;
+    }
+    
+    IoBackendType type() const override { return IoBackendType::IoUring; }
+
+private:
+    static constexpr uint64_t STOP_TAG = ~uint64_t{0};
+    
+    IoUringBackend() = default;
+    
+    bool setup(unsigned depth) {
+        io_uring_params params{};
+        ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+        if (ring_fd_ < 0) {
+            Logger::warn("IoUring: io_uring_setup failed ({})", std::strerror(errno));
+            return false;
+        }
+        
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+        
+        sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            ::close(ring_fd_);
+            return false;
+        }
+        
+        cq_ring_ = single_mmap ? sq_ring_
+                               : ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                                        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (cq_ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+            if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+                ::munmap(cq_ring_, cq_ring_size_);
+            }
+            ::munmap(sq_ring_, sq_ring_size_);
+            ::close(ring_fd_);
+            return false;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+        
+        auto* sq = static_cast<char*>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        
+        auto* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        
+        // Слотов не больше, чем SQ: все они гарантированно помещаются в CQ
+        slots_.resize(params.sq_entries);
+        free_slots_.reserve(params.sq_entries);
+        for (uint32_t i = params.sq_entries; i > 0; --i) {
+            free_slots_.push_back(i - 1);
+        }
+        
+        reaper_ = std::thread(&IoUringBackend::reap_loop, this);
+        return true;
+    }
+    
+    /// Следующий SQE (под submit_mutex_, свободное место гарантируют слоты)
+    io_uring_sqe* next_sqe() {
+        unsigned index = (local_tail_ + unsubmitted_) & sq_mask_;
+        ++unsubmitted_;
+        sq_array_[index] = index;
+        return &sqes_[index];
+    }
+    
+    /// Опубликовать count подготовленных SQE и отправить их ядру
+    void commit_sqes(unsigned count) {
+        if (count == 0) {
+            return;
+        }
+        local_tail_ += count;
+        unsubmitted_ -= count;
+        __atomic_store_n(sq_tail_, local_tail_, __ATOMIC_RELEASE);
+        
+        while (count > 0) {
+            long n = ::syscall(__NR_io_uring_enter, ring_fd_, count, 0, 0, nullptr, 0);
+            if (n < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                Logger::error("IoUring: io_uring_enter failed ({})", std::strerror(errno));
+                return;
+            }
+            count -= static_cast<unsigned>(n);
+        }
+    }
+    
+    void prepare_sqe(io_uring_sqe* sqe, const IoRequest& request, uint32_t slot) {
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->fd = request.fd;
+        sqe->off = request.offset;
+        sqe->user_data = slot;
+        
+        bool read = request.op == IoRequest::Op::Read;
+        const iovec& first = request.iov[0];
+        auto* base = static_cast<char*>(first.iov_base);
+        
+        if (request.iov_count == 1 && registered_base_ && base >= registered_base_ &&
+            base + first.iov_len <= registered_base_ + registered_size_) {
+            sqe->opcode = read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+            sqe->addr = reinterpret_cast<uint64_t>(base);
+            sqe->len = static_cast<uint32_t>(first.iov_len);
+            sqe->buf_index = 0;
+        } else {
+            sqe->opcode = read ? IORING_OP_READV : IORING_OP_WRITEV;
+            sqe->addr = reinterpret_cast<uint64_t>(request.iov);
+            sqe->len = request.iov_count;
+        }
+    }
+    
+    void reap_loop() {
+        for (;;) {
+            long n = ::syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS,
+                               nullptr, 0);
+            if (n < 0 && errno != EINTR) {
+                Logger::error("IoUring: wait for completions failed ({})", std::strerror(errno));
+                std::this_thread::yield();
+            }
+            
+            unsigned head = *cq_head_;
+            unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            bool stop = false;
+            
+            while (head != tail) {
+                const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                uint64_t user_data = cqe.user_data;
+                int64_t result = cqe.res;
+                ++head;
+                __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+                
+                if (user_data == STOP_TAG) {
+                    stop = true;
+                    continue;
+                }
+                complete(static_cast<uint32_t>(user_data), result);
+            }
+            
+            if (stop) {
+                return;
+            }
+        }
+    }
+    
+    void complete(uint32_t slot, int64_t result) {
+        std::function<void(int64_t)> callback = std::move(slots_[slot].callback);
+        {
+            std::lock_guard lock(submit_mutex_);
+            slots_[slot] = IoRequest{};
+            free_slots_.push_back(slot);
+        }
+        slot_cv_.notify_all();
+        
+        if (callback) {
+            callback(result);
+        }
+    }
+    
+    int ring_fd_ = -1;
+    
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    std::size_t sq_ring_size_ = 0;
+    std::size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    std::size_t sqes_size_ = 0;
+    
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned local_tail_ = 0;
+    unsigned unsubmitted_ = 0;
+    
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    
+    // Операции в полёте; под submit_mutex_
+    std::vector<IoRequest> slots_;
+    std::vector<uint32_t> free_slots_;
+    std::mutex submit_mutex_;
+    std::condition_variable slot_cv_;
+    
+    char* registered_base_ = nullptr;
+    std::size_t registered_size_ = 0;
+    
+    std::thread reaper_;
+};
+
+#endif // DATYREDB_HAVE_IO_URING
+
+} // namespace
+
+std::unique_ptr<IoBackend> make_io_backend(const IoConfig& config) {
+    switch (config.backend) {
+        case IoBackendType::Sync:
+            return nullptr;
+        
+        case IoBackendType::IoUring:
+#ifdef DATYREDB_HAVE_IO_URING
+            if (auto backend = IoUringBackend::create(config.queue_depth)) {
+                return backend;
+            }
+#endif
+            Logger::warn("io_uring unavailable, falling back to thread pool I/O");
+            [[fallthrough]];
+        
+        case IoBackendType::ThreadPool:
+        default:
+            return std::make_unique<ThreadPoolIoBackend>(config.worker_threads,
+                                                         config.queue_depth);
+    }
+}
+
+} // namespace datyredb::storage
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "storage/storage_types.hpp"
+
+#include <sys/uio.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace datyredb::storage {
+
+/// Одна асинхронная операция ввода-вывода.
+///
+/// iov и буферы принадлежат вызывающему и должны жить до вызова callback.
+struct IoRequest {
+    enum class Op : uint8_t { Read, Write };
+    
+    Op op = Op::Read;
+    int fd = -1;
+    const iovec* iov = nullptr;
+    unsigned iov_count = 0;
+    uint64_t offset = 0;
+    
+    /// Завершение: число переданных байт или -errno.
+    /// Вызывается из потока backend'а — без долгих операций
+    std::function<void(int64_t result)> callback;
+};
+
+/// Ожидание завершения группы операций
+class IoWaitGroup {
+public:
+    void add(std::size_t count = 1);
+    void done();
+    void wait();
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::size_t pending_ = 0;
+};
+
+/// Backend асинхронного I/O.
+///
+/// submit() отправляет пакет одним системным вызовом (где это возможно)
+/// и блокируется только при заполненной очереди; завершения приходят
+/// через callback'и. Реализации: пул потоков и io_uring.
+class IoBackend {
+public:
+    virtual ~IoBackend() = default;
+    
+    /// Отправить пакет операций
+    virtual void submit(std::vector<IoRequest>& requests) = 0;
+    
+    /// Зарегистрировать область памяти (арену buffer pool) для I/O без
+    /// повторного pinning'а страниц ядром. Одна область; повторный вызов
+    /// заменяет предыдущую
+    virtual void register_buffer(char* base, std::size_t size) {
+        (void)base;
+        (void)size;
+    }
+    
+    /// Снять регистрацию, если зарегистрирована именно эта область
+    virtual void unregister_buffer(char* base) { (void)base; }
+    
+    virtual IoBackendType type() const = 0;
+};
+
+/// Создать backend по конфигурации. nullptr для IoBackendType::Sync;
+/// IoUring откатывается на ThreadPool, если ядро его не поддерживает
+std::unique_ptr<IoBackend> make_io_backend(const IoConfig& config);
+
+} // namespace datyredb::storage
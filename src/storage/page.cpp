@@ -1,97 +1,136 @@
 #include "storage/page.hpp"
+#include "storage/checksum.hpp"
 
+#include <cstdlib>
 #include <cstring>
+#include <thread>
 
 namespace datyredb::storage {
 
-// CRC32 lookup table (IEEE polynomial)
-static const uint32_t CRC32_TABLE[256] = {
-    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba,
-    0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3,
-    0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
-    0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91,
-    0x1db71064, 0x6ab020f2, 0xf3b97148, 0x84be41de,
-    0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
-    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec,
-    0x14015c4f, 0x63066cd9, 0xfa0f3d63, 0x8d080df5,
-    0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
-    0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b,
-    0x35b5a8fa, 0x42b2986c, 0xdbbbc9d6, 0xacbcf940,
-    0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
-    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116,
-    0x21b4f4b5, 0x56b3c423, 0xcfba9599, 0xb8bda50f,
-    0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
-    0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d,
-    0x76dc4190, 0x01db7106, 0x98d220bc, 0xefd5102a,
-    0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
-    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818,
-    0x7f6a0dbb, 0x086d3d2d, 0x91646c97, 0xe6635c01,
-    0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
-    0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457,
-    0x65b0d9c6, 0x12b7e950, 0x8bbeb8ea, 0xfcb9887c,
-    0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
-    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2,
-    0x4adfa541, 0x3dd895d7, 0xa4d1c46d, 0xd3d6f4fb,
-    0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
-    0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cd9,
-    0x5005713c, 0x270241aa, 0xbe0b1010, 0xc90c2086,
-    0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4,
-    0x59b33d17, 0x2eb40d81, 0xb7bd5c3b, 0xc0ba6cad,
-    0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
-    0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683,
-    0xe3630b12, 0x94643b84, 0x0d6d6a3e, 0x7a6a5aa8,
-    0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
-    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe,
-    0xf762575d, 0x806567cb, 0x196c3671, 0x6e6b06e7,
-    0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
-    0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5,
-    0xd6d6a3e8, 0xa1d1937e, 0x38d8c2c4, 0x4fdff252,
-    0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
-    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60,
-    0xdf60efc3, 0xa867df55, 0x316e8eef, 0x4669be79,
-    0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
-    0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f,
-    0xc5ba3bbe, 0xb2bd0b28, 0x2bb45a92, 0x5cb36a04,
-    0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
-    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a,
-    0x9c0906a9, 0xeb0e363f, 0x72076785, 0x05005713,
-    0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
-    0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21,
-    0x86d3d2d4, 0xf1d4e242, 0x68ddb3f8, 0x1fda836e,
-    0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
-    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c,
-    0x8f659eff, 0xf862ae69, 0x616bffd3, 0x166ccf45,
-    0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
-    0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db,
-    0xaed16a4a, 0xd9d65adc, 0x40df0b66, 0x37d83bf0,
-    0xa9bcae53, 0xdede86c5, 0x47d7977f, 0x30d0a7e9,
-    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6,
-    0xbad03605, 0xcdd70693, 0x54de5729, 0x23d967bf,
-    0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
-    0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
-};
-
 Page::Page() 
-    : page_id_(INVALID_PAGE_ID)
+    : data_(allocate_buffer())
+    , owns_data_(true)
+    , page_id_(INVALID_PAGE_ID)
     , is_dirty_(false)
     , pin_count_(0) 
 {
-    std::memset(data_.data(), 0, PAGE_SIZE);
+    std::memset(data_, 0, PAGE_SIZE);
 }
 
 Page::Page(PageId id) 
-    : page_id_(id)
+    : data_(allocate_buffer())
+    , owns_data_(true)
+    , page_id_(id)
     , is_dirty_(false)
     , pin_count_(0) 
 {
-    std::memset(data_.data(), 0, PAGE_SIZE);
+    std::memset(data_, 0, PAGE_SIZE);
     header()->page_id = id;
 }
 
+Page::Page(char* buffer)
+    : data_(buffer)
+    , owns_data_(false)
+    , page_id_(INVALID_PAGE_ID)
+    , is_dirty_(false)
+    , pin_count_(0)
+{
+    std::memset(data_, 0, PAGE_SIZE);
+}
+
+Page::~Page() {
+    if (owns_data_) {
+        std::free(data_);
+    }
+}
+
+Page::Page(Page&& other) noexcept
+    : data_(allocate_buffer())
+    , owns_data_(true)
+    , page_id_(other.page_id_.load(std::memory_order_relaxed))
+    , is_dirty_(other.is_dirty_.load(std::memory_order_relaxed))
+    , pin_count_(other.pin_count_.load(std::memory_order_relaxed))
+    , rec_lsn_(other.rec_lsn_.load(std::memory_order_relaxed))
+{
+    std::memcpy(data_, other.data_, PAGE_SIZE);
+    other.reset();
+}
+
+Page& Page::operator=(Page&& other) noexcept {
+    if (this != &other) {
+        std::memcpy(data_, other.data_, PAGE_SIZE);
+        page_id_.store(other.page_id_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        is_dirty_.store(other.is_dirty_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        pin_count_.store(other.pin_count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        rec_lsn_.store(other.rec_lsn_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.reset();
+    }
+    return *this;
+}
+
 void Page::set_page_id(PageId id) {
-    page_id_ = id;
     header()->page_id = id;
+    page_id_.store(id, std::memory_order_release);
+}
+
+void Page::unpin() {
+    int current = pin_count_.load(std::memory_order_acquire);
+    while (current > 0) {
+        if (pin_count_.compare_exchange_weak(current, current - 1,
+                                             std::memory_order_acq_rel)) {
+            return;
+        }
+    }
+}
+
+bool Page::try_pin() {
+    int current = pin_count_.load(std::memory_order_acquire);
+    while (current >= 0) {
+        if (pin_count_.compare_exchange_weak(current, current + 1,
+                                             std::memory_order_acq_rel)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Page::try_acquire_exclusive() {
+    int expected = 0;
+    return pin_count_.compare_exchange_strong(expected, -1,
+                                              std::memory_order_acq_rel);
+}
+
+void Page::release_exclusive(int pin_count) {
+    pin_count_.store(pin_count, std::memory_order_release);
+}
+
+uint64_t Page::read_version() const {
+    uint64_t version = version_.load(std::memory_order_acquire);
+    while (version & LATCH_LOCKED) {
+        std::this_thread::yield();
+        version = version_.load(std::memory_order_acquire);
+    }
+    return version;
+}
+
+bool Page::try_upgrade(uint64_t version) {
+    return version_.compare_exchange_strong(version, version + LATCH_LOCKED,
+                                            std::memory_order_acquire);
+}
+
+void Page::write_lock() {
+    while (!try_upgrade(read_version())) {
+    }
+}
+
+void Page::snapshot(Page& out) const {
+    for (;;) {
+        uint64_t version = read_version();
+        std::memcpy(out.data_, data_, PAGE_SIZE);
+        if (validate(version)) {
+            return;
+        }
+    }
 }
 
 Lsn Page::get_lsn() const {
@@ -100,32 +139,58 @@ Lsn Page::get_lsn() const {
 
 void Page::set_lsn(Lsn lsn) {
     header()->page_lsn = lsn;
+    note_rec_lsn(lsn);
+}
+
+uint16_t Page::free_space() const {
+    return header()->free_space;
+}
+
+void Page::set_free_space(uint16_t bytes) {
+    header()->free_space = bytes;
+}
+
+PageFlags Page::flags() const {
+    return static_cast<PageFlags>(header()->flags);
+}
+
+void Page::set_flags(PageFlags flags) {
+    header()->flags = static_cast<uint16_t>(flags);
+}
+
+void Page::note_rec_lsn(Lsn lsn) {
+    Lsn expected = INVALID_LSN;
+    if (lsn != INVALID_LSN && rec_lsn_.load(std::memory_order_relaxed) == INVALID_LSN) {
+        rec_lsn_.compare_exchange_strong(expected, lsn, std::memory_order_acq_rel);
+    }
+}
+
+char* Page::allocate_buffer() {
+    void* buffer = std::aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+    if (!buffer) {
+        std::abort();  // Вызывается и из noexcept move
+    }
+    return static_cast<char*>(buffer);
 }
 
 PageHeader* Page::header() {
-    return reinterpret_cast<PageHeader*>(data_.data());
+    return reinterpret_cast<PageHeader*>(data_);
 }
 
 const PageHeader* Page::header() const {
-    return reinterpret_cast<const PageHeader*>(data_.data());
+    return reinterpret_cast<const PageHeader*>(data_);
 }
 
 uint32_t Page::compute_checksum() const {
-    uint32_t crc = 0xFFFFFFFF;
-    const auto* ptr = reinterpret_cast<const uint8_t*>(data_.data());
-    
-    // Вычисляем CRC для всех данных, кроме поля checksum
+    // CRC32C страницы с обнулённым полем checksum: три куска потока
+    // вместо копии страницы — compute_checksum() не меняет данные
     constexpr std::size_t checksum_offset = offsetof(PageHeader, checksum);
+    constexpr std::size_t checksum_end = checksum_offset + sizeof(uint32_t);
+    constexpr uint32_t zero_checksum = 0;
     
-    for (std::size_t i = 0; i < PAGE_SIZE; ++i) {
-        // Пропускаем 4 байта checksum
-        if (i >= checksum_offset && i < checksum_offset + sizeof(uint32_t)) {
-            continue;
-        }
-        crc = CRC32_TABLE[(crc ^ ptr[i]) & 0xFF] ^ (crc >> 8);
-    }
-    
-    return crc ^ 0xFFFFFFFF;
+    uint32_t crc = crc32c(data_, checksum_offset);
+    crc = crc32c(&zero_checksum, sizeof(zero_checksum), crc);
+    return crc32c(data_ + checksum_end, PAGE_SIZE - checksum_end, crc);
 }
 
 bool Page::verify_checksum() const {
@@ -137,10 +202,15 @@ void Page::update_checksum() {
 }
 
 void Page::reset() {
-    std::memset(data_.data(), 0, PAGE_SIZE);
-    page_id_ = INVALID_PAGE_ID;
-    is_dirty_ = false;
-    pin_count_ = 0;
+    clear();
+    pin_count_.store(0, std::memory_order_release);
+}
+
+void Page::clear() {
+    std::memset(data_, 0, PAGE_SIZE);
+    page_id_.store(INVALID_PAGE_ID, std::memory_order_release);
+    is_dirty_.store(false, std::memory_order_release);
+    rec_lsn_.store(INVALID_LSN, std::memory_order_release);
 }
 
 } // namespace datyredb::storage
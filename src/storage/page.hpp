@@ -2,47 +2,127 @@
 
 #include "storage/storage_types.hpp"
 
-#include <array>
+#include <atomic>
 #include <cstring>
 #include <memory>
 
 namespace datyredb::storage {
 
 /// Страница фиксированного размера (4KB)
+///
+/// Тело страницы — PAGE_SIZE байт, выровненных по PAGE_SIZE. Отдельно
+/// созданная страница владеет своим буфером; страница buffer pool — лишь
+/// view на слот PageArena (буфер не освобождает).
+///
+/// page_id, dirty flag и pin count атомарны: buffer pool пинит страницы
+/// без latch'а. pin count == -1 означает эксклюзивное владение фреймом
+/// (eviction / загрузка) — в этом состоянии try_pin() не проходит.
+///
+/// rec_lsn — LSN первого изменения с тех пор, как страница была чистой:
+/// лог до него странице не нужен. Первый set_lsn() после mark_clean()
+/// задаёт его; в файл он не пишется.
+///
+/// Version latch — для оптимистичного доступа (B+tree, HeapFile::get):
+/// читатель берёт read_version(), читает без блокировки и проверяет
+/// validate(); писатель захватывает latch, и версия растёт при каждом
+/// снятии. Latch принадлежит frame'у и в файл не пишется; читать можно
+/// только запиненную страницу.
 class Page {
 public:
     Page();
     explicit Page(PageId id);
     
+    /// View на внешний буфер PAGE_SIZE байт (выровненный по PAGE_SIZE)
+    explicit Page(char* buffer);
+    
+    ~Page();
+    
+    // Перемещение копирует данные в буфер назначения
+    // (не потокобезопасно; источник сбрасывается)
+    Page(Page&& other) noexcept;
+    Page& operator=(Page&& other) noexcept;
+    
+    Page(const Page&) = delete;
+    Page& operator=(const Page&) = delete;
+    
     // ========================================================================
     // Accessors
     // ========================================================================
     
-    PageId page_id() const { return page_id_; }
+    PageId page_id() const { return page_id_.load(std::memory_order_acquire); }
     void set_page_id(PageId id);
     
-    bool is_dirty() const { return is_dirty_; }
-    void mark_dirty() { is_dirty_ = true; }
-    void mark_clean() { is_dirty_ = false; }
+    bool is_dirty() const { return is_dirty_.load(std::memory_order_acquire); }
+    
+    /// Возвращает true, если страница была чистой
+    bool mark_dirty() { return !is_dirty_.exchange(true, std::memory_order_acq_rel); }
+    
+    /// Возвращает true, если страница была dirty. Сбрасывает rec_lsn
+    bool mark_clean() {
+        rec_lsn_.store(INVALID_LSN, std::memory_order_release);
+        return is_dirty_.exchange(false, std::memory_order_acq_rel);
+    }
     
-    int pin_count() const { return pin_count_; }
-    void pin() { ++pin_count_; }
-    void unpin() { if (pin_count_ > 0) --pin_count_; }
-    bool is_pinned() const { return pin_count_ > 0; }
+    int pin_count() const { return pin_count_.load(std::memory_order_acquire); }
+    void pin() { pin_count_.fetch_add(1, std::memory_order_acq_rel); }
+    void unpin();
+    bool is_pinned() const { return pin_count() > 0; }
+    
+    /// Пин, если фрейм не захвачен эксклюзивно
+    bool try_pin();
+    
+    /// Захват эксклюзивного владения (только при pin_count == 0)
+    bool try_acquire_exclusive();
+    
+    /// Снятие эксклюзивного владения с установкой pin count
+    void release_exclusive(int pin_count);
     
     Lsn get_lsn() const;
     void set_lsn(Lsn lsn);
     
+    /// recLSN (INVALID_LSN — с момента mark_clean() не менялась)
+    Lsn rec_lsn() const { return rec_lsn_.load(std::memory_order_acquire); }
+    
+    // ========================================================================
+    // Version latch
+    // ========================================================================
+    
+    /// Текущая версия; ждёт, пока latch захвачен писателем
+    uint64_t read_version() const;
+    
+    /// Страница не менялась с read_version()
+    bool validate(uint64_t version) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version_.load(std::memory_order_relaxed) == version;
+    }
+    
+    /// Захватить latch, если версия всё ещё version
+    bool try_upgrade(uint64_t version);
+    
+    void write_lock();
+    void write_unlock() { version_.fetch_add(LATCH_LOCKED, std::memory_order_release); }
+    
+    /// Согласованная копия данных в out — для записи на диск без
+    /// latch'а: копирует и повторяет, если писатель успел её изменить
+    void snapshot(Page& out) const;
+    
+    /// Свободное место и флаги заголовка — их ведёт формат страницы
+    uint16_t free_space() const;
+    void set_free_space(uint16_t bytes);
+    
+    PageFlags flags() const;
+    void set_flags(PageFlags flags);
+    
     // ========================================================================
     // Data access
     // ========================================================================
     
-    char* data() { return data_.data(); }
-    const char* data() const { return data_.data(); }
+    char* data() { return data_; }
+    const char* data() const { return data_; }
     
     /// Данные после заголовка
-    char* payload() { return data_.data() + PageHeader::SIZE; }
-    const char* payload() const { return data_.data() + PageHeader::SIZE; }
+    char* payload() { return data_ + PageHeader::SIZE; }
+    const char* payload() const { return data_ + PageHeader::SIZE; }
     
     static constexpr std::size_t payload_size() { 
         return PAGE_SIZE - PageHeader::SIZE; 
@@ -62,14 +142,29 @@ public:
     
     void reset();
     
+    /// Сброс данных, ID и dirty flag без изменения pin count
+    void clear();
+    
 private:
     PageHeader* header();
     const PageHeader* header() const;
     
-    std::array<char, PAGE_SIZE> data_;
-    PageId page_id_;
-    bool is_dirty_;
-    int pin_count_;
+    /// Задать rec_lsn, если он ещё не задан
+    void note_rec_lsn(Lsn lsn);
+    
+    /// Выделить собственный выровненный буфер
+    static char* allocate_buffer();
+    
+    /// Бит захвата в version_; снятие прибавляет его ещё раз
+    static constexpr uint64_t LATCH_LOCKED = 2;
+    
+    char* data_;
+    bool owns_data_;
+    std::atomic<PageId> page_id_;
+    std::atomic<bool> is_dirty_;
+    std::atomic<int> pin_count_;
+    std::atomic<Lsn> rec_lsn_{INVALID_LSN};
+    std::atomic<uint64_t> version_{0};
 };
 
 using PagePtr = std::shared_ptr<Page>;
@@ -0,0 +1,74 @@
+#include "storage/page_arena.hpp"
+#include "utils/logger.hpp"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+namespace datyredb::storage {
+
+namespace {
+
+std::size_t round_up(std::size_t value, std::size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void* map_anonymous(std::size_t size, int extra_flags) {
+    void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+} // namespace
+
+PageArena::PageArena(std::size_t page_count, HugePages mode)
+    : page_count_(page_count)
+{
+    std::size_t size = std::max<std::size_t>(page_count_, 1) * PAGE_SIZE;
+    void* ptr = nullptr;
+    
+    if (mode != HugePages::Off) {
+        // Длина кратна huge page, чтобы хвост арены тоже покрывался
+        size = round_up(size, HUGE_PAGE_SIZE);
+    }
+
+#ifdef MAP_HUGETLB
+    if (mode == HugePages::Explicit) {
+        ptr = map_anonymous(size, MAP_HUGETLB);
+        if (ptr) {
+            backing_ = HugePages::Explicit;
+        } else {
+            Logger::warn("PageArena: MAP_HUGETLB failed ({}), falling back to THP",
+                         std::strerror(errno));
+        }
+    }
+#endif
+
+    if (!ptr) {
+        ptr = map_anonymous(size, 0);
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+
+#ifdef MADV_HUGEPAGE
+        if (mode != HugePages::Off && ::madvise(ptr, size, MADV_HUGEPAGE) == 0) {
+            backing_ = HugePages::Transparent;
+        }
+#endif
+    }
+    
+    // mmap отдаёт обнулённую память с выравниванием не меньше 4KB
+    base_ = static_cast<char*>(ptr);
+    mapped_size_ = size;
+}
+
+PageArena::~PageArena() {
+    if (base_) {
+        ::munmap(base_, mapped_size_);
+    }
+}
+
+} // namespace datyredb::storage
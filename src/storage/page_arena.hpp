@@ -0,0 +1,46 @@
+#pragma once
+
+#include "storage/storage_types.hpp"
+
+#include <cstddef>
+
+namespace datyredb::storage {
+
+/// Непрерывная арена под тела страниц buffer pool.
+///
+/// Память выделяется одним anonymous mmap: каждая страница выровнена
+/// по PAGE_SIZE (годится для O_DIRECT), а вся арена при возможности
+/// покрывается huge pages — меньше TLB miss'ов на больших пулах.
+/// Метаданные фреймов в арене не хранятся.
+class PageArena {
+public:
+    /// Размер huge page, под который выравнивается длина арены
+    static constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    
+    PageArena(std::size_t page_count, HugePages mode);
+    ~PageArena();
+    
+    // Запретить копирование
+    PageArena(const PageArena&) = delete;
+    PageArena& operator=(const PageArena&) = delete;
+    
+    /// Тело страницы с индексом idx
+    char* page(std::size_t idx) { return base_ + idx * PAGE_SIZE; }
+    const char* page(std::size_t idx) const { return base_ + idx * PAGE_SIZE; }
+    
+    std::size_t page_count() const { return page_count_; }
+    
+    /// Размер отображения в байтах
+    std::size_t mapped_size() const { return mapped_size_; }
+    
+    /// Фактический режим (Explicit может откатиться на Transparent/Off)
+    HugePages backing() const { return backing_; }
+
+private:
+    char* base_ = nullptr;
+    std::size_t page_count_;
+    std::size_t mapped_size_ = 0;
+    HugePages backing_ = HugePages::Off;
+};
+
+} // namespace datyredb::storage
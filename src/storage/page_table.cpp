@@ -0,0 +1,152 @@
+#include "storage/page_table.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace datyredb::storage {
+
+PageTable::PageTable(std::size_t max_entries) {
+    // Load factor <= 0.5 — короткие цепочки пробирования
+    std::size_t capacity = 16;
+    while (capacity < max_entries * 2) {
+        capacity <<= 1;
+    }
+    
+    capacity_ = capacity;
+    mask_ = capacity - 1;
+    slots_ = std::make_unique<std::atomic<uint64_t>[]>(capacity_);
+    
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        slots_[i].store(EMPTY, std::memory_order_relaxed);
+    }
+}
+
+std::size_t PageTable::home_slot(PageId page_id) const {
+    uint64_t hash = static_cast<uint64_t>(page_id) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<std::size_t>(hash >> 32) & mask_;
+}
+
+std::size_t PageTable::find(PageId page_id) const {
+    for (;;) {
+        uint64_t version = version_.load(std::memory_order_acquire);
+        if (version & 1) {
+            // Идёт rebuild под latch — пусть вызывающий идёт медленным путём
+            return NOT_FOUND;
+        }
+        
+        std::size_t result = NOT_FOUND;
+        std::size_t idx = home_slot(page_id);
+        
+        for (std::size_t probe = 0; probe < capacity_; ++probe) {
+            uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+            if (slot == EMPTY) {
+                break;
+            }
+            if (slot_key(slot) == page_id) {
+                result = slot_frame(slot);
+                break;
+            }
+            idx = (idx + 1) & mask_;
+        }
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (version_.load(std::memory_order_relaxed) == version) {
+            return result;
+        }
+        // Таблица перестраивалась во время поиска — повторяем
+    }
+}
+
+void PageTable::insert(PageId page_id, std::size_t frame_idx) {
+    std::size_t idx = home_slot(page_id);
+    std::size_t first_tombstone = NOT_FOUND;
+    
+    for (std::size_t probe = 0; probe < capacity_; ++probe) {
+        uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+        
+        if (slot == EMPTY) {
+            break;
+        }
+        if (slot == TOMBSTONE) {
+            if (first_tombstone == NOT_FOUND) {
+                first_tombstone = idx;
+            }
+        } else if (slot_key(slot) == page_id) {
+            // Обновление существующей записи
+            slots_[idx].store(make_slot(page_id, frame_idx), std::memory_order_release);
+            return;
+        }
+        idx = (idx + 1) & mask_;
+    }
+    
+    if (first_tombstone != NOT_FOUND) {
+        slots_[first_tombstone].store(make_slot(page_id, frame_idx),
+                                      std::memory_order_release);
+        --tombstones_;
+        ++size_;
+        return;
+    }
+    
+    // Занимаем пустой слот; при избытке tombstone'ов — сначала rebuild
+    if ((size_ + tombstones_ + 1) * 4 > capacity_ * 3) {
+        rebuild();
+        insert(page_id, frame_idx);
+        return;
+    }
+    
+    slots_[idx].store(make_slot(page_id, frame_idx), std::memory_order_release);
+    ++size_;
+}
+
+bool PageTable::erase(PageId page_id) {
+    std::size_t idx = home_slot(page_id);
+    
+    for (std::size_t probe = 0; probe < capacity_; ++probe) {
+        uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+        
+        if (slot == EMPTY) {
+            return false;
+        }
+        if (slot != TOMBSTONE && slot_key(slot) == page_id) {
+            // Если за слотом цепочка обрывается — tombstone не нужен
+            std::size_t next = (idx + 1) & mask_;
+            if (slots_[next].load(std::memory_order_relaxed) == EMPTY) {
+                slots_[idx].store(EMPTY, std::memory_order_release);
+            } else {
+                slots_[idx].store(TOMBSTONE, std::memory_order_release);
+                ++tombstones_;
+            }
+            --size_;
+            return true;
+        }
+        idx = (idx + 1) & mask_;
+    }
+    
+    return false;
+}
+
+void PageTable::rebuild() {
+    std::vector<std::pair<PageId, std::size_t>> live;
+    live.reserve(size_);
+    for_each([&](PageId page_id, std::size_t frame_idx) {
+        live.emplace_back(page_id, frame_idx);
+    });
+    
+    uint64_t version = version_.load(std::memory_order_relaxed);
+    version_.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        slots_[i].store(EMPTY, std::memory_order_relaxed);
+    }
+    size_ = 0;
+    tombstones_ = 0;
+    
+    for (const auto& [page_id, frame_idx] : live) {
+        insert(page_id, frame_idx);
+    }
+    
+    version_.store(version + 2, std::memory_order_release);
+}
+
+} // namespace datyredb::storage
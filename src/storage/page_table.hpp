@@ -0,0 +1,82 @@
+#pragma once
+
+#include "storage/storage_types.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace datyredb::storage {
+
+/// Конкурентная open-addressing хеш-таблица PageId -> frame index.
+///
+/// Читатели (find) не берут lock: каждый слот — один 64-битный atomic
+/// (page_id << 32 | frame), так что запись читается целиком. Писатели
+/// (insert/erase/for_each) сериализуются внешним latch'ем партиции.
+///
+/// find() может вернуть устаревший frame — вызывающий обязан после пина
+/// сверить page_id фрейма. Перестроение таблицы (при накоплении tombstone'ов)
+/// помечается нечётной версией; читатель, пересёкшийся с ним, повторяет поиск.
+class PageTable {
+public:
+    static constexpr std::size_t NOT_FOUND = static_cast<std::size_t>(-1);
+    
+    /// max_entries — верхняя граница одновременно хранимых записей
+    explicit PageTable(std::size_t max_entries);
+    
+    // Запретить копирование
+    PageTable(const PageTable&) = delete;
+    PageTable& operator=(const PageTable&) = delete;
+    
+    /// Lock-free поиск. NOT_FOUND если записи нет
+    std::size_t find(PageId page_id) const;
+    
+    /// Вставка/обновление (под внешним latch)
+    void insert(PageId page_id, std::size_t frame_idx);
+    
+    /// Удаление (под внешним latch). false если записи не было
+    bool erase(PageId page_id);
+    
+    /// Количество записей
+    std::size_t size() const { return size_; }
+    
+    /// Обход всех записей (под внешним latch)
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+            if (slot_key(slot) != INVALID_PAGE_ID) {
+                fn(slot_key(slot), slot_frame(slot));
+            }
+        }
+    }
+
+private:
+    // Пустой слот и tombstone: ключ INVALID_PAGE_ID никогда не вставляется
+    static constexpr uint64_t EMPTY = ~uint64_t{0};
+    static constexpr uint64_t TOMBSTONE = ~uint64_t{0} - 1;
+    
+    static PageId slot_key(uint64_t slot) { return static_cast<PageId>(slot >> 32); }
+    static std::size_t slot_frame(uint64_t slot) { return static_cast<std::size_t>(slot & 0xFFFFFFFFu); }
+    static uint64_t make_slot(PageId page_id, std::size_t frame_idx) {
+        return (static_cast<uint64_t>(page_id) << 32) | static_cast<uint32_t>(frame_idx);
+    }
+    
+    std::size_t home_slot(PageId page_id) const;
+    
+    /// Перестроение in-place без tombstone'ов
+    void rebuild();
+    
+    std::size_t capacity_;
+    std::size_t mask_;
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+    
+    // Нечётная — идёт rebuild
+    std::atomic<uint64_t> version_{0};
+    
+    // Изменяются только под внешним latch
+    std::size_t size_ = 0;
+    std::size_t tombstones_ = 0;
+};
+
+} // namespace datyredb::storage
@@ -0,0 +1,365 @@
+#include "storage/recovery.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace datyredb::storage {
+
+namespace {
+
+/// Пакет записей одного потока redo
+using RedoBatch = std::vector<LogRecord>;
+
+/// Ограниченная очередь пакетов потока redo. Полная очередь
+/// останавливает чтение лога, пока поток не догонит
+class RedoQueue {
+public:
+    explicit RedoQueue(std::size_t depth)
+        : depth_(std::max<std::size_t>(depth, 1))
+    {
+    }
+    
+    void push(RedoBatch&& batch) {
+        std::unique_lock lock(mutex_);
+        not_full_.wait(lock, [this] { return batches_.size() < depth_; });
+        batches_.push_back(std::move(batch));
+        not_empty_.notify_one();
+    }
+    
+    /// false — очередь закрыта и пуста
+    bool pop(RedoBatch& batch) {
+        std::unique_lock lock(mutex_);
+        not_empty_.wait(lock, [this] { return !batches_.empty() || closed_; });
+        if (batches_.empty()) {
+            return false;
+        }
+        batch = std::move(batches_.front());
+        batches_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+    
+    void close() {
+        std::lock_guard lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+private:
+    std::size_t depth_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<RedoBatch> batches_;
+    bool closed_ = false;
+};
+
+/// Счётчики одного потока redo
+struct RedoCounters {
+    std::size_t redone = 0;
+    std::size_t skipped = 0;
+};
+
+/// Поток redo страницы. Мультипликативный хеш разводит по потокам и
+/// соседние страницы, и страницы с шагом, кратным числу потоков
+std::size_t redo_worker_for(PageId page_id, std::size_t workers) {
+    uint64_t hash = static_cast<uint64_t>(page_id) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<std::size_t>(hash >> 32) % workers;
+}
+
+} // namespace
+
+RecoveryManager::RecoveryManager(std::shared_ptr<WriteAheadLog> wal,
+                                 std::shared_ptr<BufferPool> buffer_pool,
+                                 std::shared_ptr<DiskManager> disk_manager,
+                                 RecoveryConfig config)
+    : wal_(std::move(wal))
+    , buffer_pool_(std::move(buffer_pool))
+    , disk_manager_(std::move(disk_manager))
+    , config_(config)
+{
+}
+
+bool RecoveryManager::recover() {
+    auto start_time = std::chrono::steady_clock::now();
+    
+    stats_ = RecoveryStats{};
+    stats_.checkpoint_lsn = wal_->checkpoint_lsn();
+    stats_.torn_pages_repaired = disk_manager_->torn_pages_repaired();
+    active_txns_.clear();
+    
+    LogReader reader(wal_->wal_dir(), wal_->segment_size());
+    load_checkpoint(reader);
+    
+    // =========================================================================
+    // ФАЗЫ 1-2: Analysis + Redo
+    // =========================================================================
+    if (!analysis_and_redo(reader)) {
+        return false;
+    }
+    
+    if (stats_.end_lsn != wal_->current_lsn()) {
+        Logger::warn("Recovery: log ends at LSN {}, WAL continues from {}",
+                     stats_.end_lsn, wal_->current_lsn());
+    }
+    
+    // =========================================================================
+    // ФАЗА 3: Undo
+    // =========================================================================
+    stats_.loser_txns = active_txns_.size();
+    if (!undo(reader)) {
+        return false;
+    }
+    
+    // CLR и TXN_ABORT на диске до приёма новых транзакций
+    if (!wal_->force_durable(wal_->current_lsn())) {
+        Logger::error("Recovery: failed to force undo records");
+        return false;
+    }
+    
+    stats_.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    
+    Logger::info("Recovery complete: checkpoint_lsn={}, redo_lsn={}, end_lsn={}, scanned={}, "
+                 "redone={}, skipped={}, undone={}, losers={}, redo_threads={}, "
+                 "torn_pages={}, duration={}ms",
+                 stats_.checkpoint_lsn, stats_.redo_lsn, stats_.end_lsn, stats_.records_scanned,
+                 stats_.records_redone, stats_.records_skipped, stats_.records_undone,
+                 stats_.loser_txns, stats_.redo_threads, stats_.torn_pages_repaired,
+                 stats_.duration.count());
+    return true;
+}
+
+void RecoveryManager::load_checkpoint(LogReader& reader) {
+    // Без checkpoint'а лог читается с начала
+    stats_.redo_lsn = std::max(stats_.checkpoint_lsn, WriteAheadLog::FIRST_LSN);
+    if (stats_.checkpoint_lsn == INVALID_LSN) {
+        return;
+    }
+    
+    // END — цепочка частей: от последней (её хранит master) по prev_lsn
+    // до первой, prev_lsn которой — BEGIN
+    CheckpointData data;
+    Lsn lsn = wal_->checkpoint_end_lsn();
+    bool complete = false;
+    LogRecord end;
+    while (lsn > stats_.checkpoint_lsn && reader.read(lsn, end) &&
+           end.type == LogRecordType::CHECKPOINT_END && end.prev_lsn < lsn) {
+        auto part = CheckpointData::deserialize(end.data);
+        if (!part) {
+            break;
+        }
+        data.merge(std::move(*part));
+        lsn = end.prev_lsn;
+        complete = lsn == stats_.checkpoint_lsn;
+    }
+    if (!complete) {
+        Logger::error("Recovery: cannot read CHECKPOINT_END at LSN {}, starting from BEGIN",
+                      lsn);
+        return;
+    }
+    
+    // Проход от начала redo обновит last_lsn транзакций, писавших после
+    // снимка, и удалит завершившиеся
+    stats_.redo_lsn = data.redo_lsn(stats_.checkpoint_lsn);
+    for (const auto& txn : data.active_txns) {
+        active_txns_[txn.txn_id] = txn.last_lsn;
+    }
+}
+
+bool RecoveryManager::analysis_and_redo(LogReader& reader) {
+    std::size_t threads = config_.redo_threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::size_t batch_size = std::max<std::size_t>(config_.redo_batch_size, 1);
+    stats_.redo_threads = threads;
+    
+    std::vector<std::unique_ptr<RedoQueue>> queues;
+    std::vector<RedoCounters> counters(threads);
+    std::vector<std::thread> workers;
+    std::atomic<bool> failed{false};
+    
+    queues.reserve(threads);
+    workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        queues.push_back(std::make_unique<RedoQueue>(config_.redo_queue_depth));
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([this, &queue = *queues[i], &counter = counters[i], &failed] {
+            RedoBatch batch;
+            while (queue.pop(batch)) {
+                // После ошибки очередь дочитывается без применения
+                for (const auto& record : batch) {
+                    if (failed.load(std::memory_order_relaxed)) {
+                        break;
+                    }
+                    switch (apply(record, record.lsn, true)) {
+                        case ApplyResult::Applied:
+                            ++counter.redone;
+                            break;
+                        case ApplyResult::Skipped:
+                            ++counter.skipped;
+                            break;
+                        case ApplyResult::Failed:
+                            failed.store(true, std::memory_order_relaxed);
+                            break;
+                    }
+                }
+            }
+        });
+    }
+    
+    // Чтение и разбор лога идут впереди потоков redo
+    std::vector<RedoBatch> pending(threads);
+    Lsn lsn = stats_.redo_lsn;
+    LogRecord record;
+    
+    while (!failed.load(std::memory_order_relaxed) && reader.read(lsn, record)) {
+        ++stats_.records_scanned;
+        track(record);
+        lsn = LogReader::next_lsn(record);
+        
+        if (!record.modifies_page() || !in_page_bounds(record)) {
+            continue;
+        }
+        
+        if (!ensure_page(record.page_id)) {
+            failed.store(true, std::memory_order_relaxed);
+            break;
+        }
+        std::size_t worker = redo_worker_for(record.page_id, threads);
+        pending[worker].push_back(std::move(record));
+        if (pending[worker].size() >= batch_size) {
+            queues[worker]->push(std::move(pending[worker]));
+            pending[worker] = RedoBatch();
+            pending[worker].reserve(batch_size);
+        }
+    }
+    stats_.end_lsn = lsn;
+    
+    for (std::size_t i = 0; i < threads; ++i) {
+        if (!pending[i].empty()) {
+            queues[i]->push(std::move(pending[i]));
+        }
+        queues[i]->close();
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    for (const auto& counter : counters) {
+        stats_.records_redone += counter.redone;
+        stats_.records_skipped += counter.skipped;
+    }
+    return !failed.load(std::memory_order_relaxed);
+}
+
+void RecoveryManager::track(const LogRecord& record) {
+    if (record.txn_id == 0) {
+        return;
+    }
+    switch (record.type) {
+        case LogRecordType::TXN_COMMIT:
+        case LogRecordType::TXN_ABORT:
+            active_txns_.erase(record.txn_id);
+            break;
+        default:
+            active_txns_[record.txn_id] = record.lsn;
+            break;
+    }
+}
+
+bool RecoveryManager::undo(LogReader& reader) {
+    // Следующей откатываем самую позднюю запись среди всех проигравших
+    std::priority_queue<std::pair<Lsn, TxnId>> to_undo;
+    for (const auto& [txn_id, last_lsn] : active_txns_) {
+        to_undo.push({last_lsn, txn_id});
+    }
+    
+    LogRecord record;
+    while (!to_undo.empty()) {
+        auto [lsn, txn_id] = to_undo.top();
+        to_undo.pop();
+        
+        Lsn undo_next = INVALID_LSN;
+        if (!reader.read(lsn, record)) {
+            // Начало цепочки обрезано вместе со старыми сегментами
+            Logger::error("Recovery: cannot read LSN {} of txn {}, rollback incomplete",
+                          lsn, txn_id);
+        } else if (record.type == LogRecordType::CLR) {
+            undo_next = record.prev_lsn;
+        } else {
+            if (record.modifies_page() && in_page_bounds(record)) {
+                LogRecord clr = record.compensation();
+                Lsn clr_lsn = wal_->append(clr);
+                if (apply(clr, clr_lsn, false) == ApplyResult::Failed) {
+                    return false;
+                }
+                active_txns_[txn_id] = clr_lsn;
+                ++stats_.records_undone;
+            }
+            undo_next = record.prev_lsn;
+        }
+        
+        if (undo_next != INVALID_LSN) {
+            to_undo.push({undo_next, txn_id});
+            continue;
+        }
+        
+        // Откат транзакции завершён
+        LogRecord abort;
+        abort.type = LogRecordType::TXN_ABORT;
+        abort.txn_id = txn_id;
+        abort.prev_lsn = active_txns_[txn_id];
+        wal_->append(abort);
+        active_txns_.erase(txn_id);
+    }
+    return true;
+}
+
+bool RecoveryManager::in_page_bounds(const LogRecord& record) {
+    if (static_cast<std::size_t>(record.offset) + record.length > Page::payload_size()) {
+        Logger::error("Recovery: LSN {} is out of page bounds (offset={}, length={})",
+                      record.lsn, record.offset, record.length);
+        return false;
+    }
+    return true;
+}
+
+bool RecoveryManager::ensure_page(PageId page_id) {
+    if (!disk_manager_->ensure_allocated(page_id)) {
+        Logger::error("Recovery: cannot allocate page {} for redo", page_id);
+        return false;
+    }
+    return true;
+}
+
+RecoveryManager::ApplyResult RecoveryManager::apply(const LogRecord& record, Lsn lsn, bool redo) {
+    Page* page = buffer_pool_->fetch_page(record.page_id);
+    if (!page) {
+        Logger::error("Recovery: failed to fetch page {} for LSN {}", record.page_id, lsn);
+        return ApplyResult::Failed;
+    }
+    
+    // Изменение уже на диске
+    if (redo && page->get_lsn() >= lsn) {
+        buffer_pool_->unpin_page(record.page_id, false);
+        return ApplyResult::Skipped;
+    }
+    
+    record.redo(page->payload());
+    page->set_lsn(lsn);
+    buffer_pool_->unpin_page(record.page_id, true);
+    return ApplyResult::Applied;
+}
+
+} // namespace datyredb::storage
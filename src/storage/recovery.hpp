@@ -0,0 +1,122 @@
+#pragma once
+
+#include "storage/storage_types.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/disk_manager.hpp"
+#include "storage/wal.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+namespace datyredb::storage {
+
+/// Итоги recovery
+struct RecoveryStats {
+    Lsn checkpoint_lsn = INVALID_LSN;   // BEGIN последнего checkpoint'а
+    Lsn redo_lsn = INVALID_LSN;         // Начало analysis и redo
+    Lsn end_lsn = INVALID_LSN;          // Конец валидного лога
+    
+    std::size_t records_scanned = 0;
+    std::size_t records_redone = 0;
+    std::size_t records_skipped = 0;    // page_lsn страницы уже не меньше
+    std::size_t records_undone = 0;
+    std::size_t loser_txns = 0;
+    std::size_t redo_threads = 0;
+    std::size_t torn_pages_repaired = 0; // Из double-write до recovery
+    
+    std::chrono::milliseconds duration{0};
+};
+
+/// Восстановление после сбоя по WAL в стиле ARIES.
+///
+/// Checkpoint fuzzy: его END (WriteAheadLog::checkpoint_end_lsn())
+/// хранит таблицу dirty pages с rec_lsn и таблицу активных транзакций.
+/// Изменения до CheckpointData::redo_lsn() уже на диске.
+///
+/// Analysis: таблица транзакций из END дополняется проходом от начала
+/// redo до конца лога; транзакции без TXN_COMMIT / TXN_ABORT —
+/// проигравшие.
+///
+/// Redo: повтор истории с того же LSN. Запись пропускается, если
+/// page_lsn страницы не меньше её LSN.
+///
+/// Analysis и redo — один проход по логу. Поток recovery читает и
+/// разбирает записи и раздаёт их пакетами потокам redo по хешу page_id;
+/// каждый поток применяет свои страницы в порядке LSN. Порядок между
+/// разными страницами для redo не важен.
+///
+/// Undo: откат проигравших от последних записей к первым. На каждое
+/// отменённое изменение пишется CLR, prev_lsn которой — следующая запись
+/// к откату: повторный сбой во время undo не откатывает дважды. Откат
+/// завершается TXN_ABORT.
+///
+/// Порванные страницы DiskManager восстанавливает из double-write ещё в
+/// initialize(): redo видит целые страницы.
+///
+/// Вызывается при старте: после инициализации WAL и buffer pool, до
+/// новых записей в лог.
+class RecoveryManager {
+public:
+    RecoveryManager(std::shared_ptr<WriteAheadLog> wal,
+                    std::shared_ptr<BufferPool> buffer_pool,
+                    std::shared_ptr<DiskManager> disk_manager,
+                    RecoveryConfig config = {});
+    
+    // Запретить копирование
+    RecoveryManager(const RecoveryManager&) = delete;
+    RecoveryManager& operator=(const RecoveryManager&) = delete;
+    
+    /// Analysis, redo и undo. false — ошибка ввода-вывода страниц
+    bool recover();
+    
+    const RecoveryStats& stats() const { return stats_; }
+
+private:
+    /// Результат применения записи к странице
+    enum class ApplyResult {
+        Applied,
+        Skipped,    // Страница уже новее записи
+        Failed,     // Страница не читается
+    };
+    
+    /// Таблицы последнего checkpoint'а: начало redo и транзакции,
+    /// активные на момент checkpoint'а
+    void load_checkpoint(LogReader& reader);
+    
+    /// Analysis и redo одним проходом: таблица активных транзакций,
+    /// конец лога и повтор истории
+    bool analysis_and_redo(LogReader& reader);
+    
+    /// Учесть запись в таблице активных транзакций
+    void track(const LogRecord& record);
+    
+    /// Откат проигравших
+    bool undo(LogReader& reader);
+    
+    /// Образ записи помещается в payload страницы; иначе запись
+    /// пропускается с ошибкой в логе
+    static bool in_page_bounds(const LogRecord& record);
+    
+    /// Выделить страницу page_id: она могла не попасть в файл до сбоя или
+    /// числиться в карте свободной. Вызывается из одного потока.
+    /// false — файл не удалось расширить
+    bool ensure_page(PageId page_id);
+    
+    /// Повторить запись на странице и выставить page_lsn. redo —
+    /// пропустить, если страница уже новее lsn
+    ApplyResult apply(const LogRecord& record, Lsn lsn, bool redo);
+    
+    std::shared_ptr<WriteAheadLog> wal_;
+    std::shared_ptr<BufferPool> buffer_pool_;
+    std::shared_ptr<DiskManager> disk_manager_;
+    RecoveryConfig config_;
+    
+    // Активные транзакции: txn_id -> LSN последней записи
+    std::unordered_map<TxnId, Lsn> active_txns_;
+    
+    RecoveryStats stats_;
+};
+
+} // namespace datyredb::storage
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <cstddef>
 #include <chrono>
+#include <array>
 #include <atomic>
 #include <limits>
 #include <string>
@@ -31,6 +32,22 @@ constexpr PageId INVALID_PAGE_ID = std::numeric_limits<PageId>::max();
 /// Невалидный LSN
 constexpr Lsn INVALID_LSN = 0;
 
+/// Запись таблицы dirty pages: rec_lsn — первое изменение страницы с
+/// момента, когда она была чистой. INVALID_LSN — изменения не в логе.
+/// page_lsn — последнее изменение; в checkpoint не пишется
+struct DirtyPageEntry {
+    PageId page_id;
+    Lsn rec_lsn;
+    Lsn page_lsn = INVALID_LSN;
+};
+
+/// Запись таблицы активных транзакций
+struct ActiveTxn {
+    TxnId txn_id;
+    Lsn first_lsn;  // Первая запись в логе — начало цепочки undo
+    Lsn last_lsn;   // Последняя запись — с неё начинается undo
+};
+
 // ============================================================================
 // Заголовок страницы
 // ============================================================================
@@ -41,7 +58,7 @@ struct PageHeader {
     Lsn page_lsn;             // 8 bytes: LSN последней модификации
     uint16_t free_space;      // 2 bytes: Свободное место
     uint16_t flags;           // 2 bytes: Флаги
-    uint32_t checksum;        // 4 bytes: CRC32
+    uint32_t checksum;        // 4 bytes: CRC32C
     uint32_t reserved;        // 4 bytes: Резерв для выравнивания
     
     static constexpr std::size_t SIZE = 24;
@@ -124,7 +141,7 @@ enum class CheckpointTrigger {
     Timer,              // Периодический по таймеру
     WalSize,            // WAL превысил лимит
     DirtySoftLimit,     // Мягкий лимит dirty pages (фоновый)
-    DirtyHardLimit,     // Жёсткий лимит (БЛОКИРУЮЩИЙ!)
+    DirtyHardLimit,     // Жёсткий лимит (фоновая запись не успевает)
     Manual,             // Ручной вызов
     Shutdown,           // При остановке БД
 };
@@ -151,6 +168,21 @@ struct CheckpointMetrics {
     std::atomic<uint64_t> forced_checkpoint_count{0};
     std::atomic<uint64_t> blocking_checkpoint_count{0};
     std::atomic<uint64_t> pages_written_total{0};
+    std::atomic<uint64_t> background_pages_written{0};
+    
+    // Решения фоновой записи за последний раунд
+    std::atomic<uint64_t> background_rounds{0};
+    std::atomic<uint64_t> background_dirty_rate{0};     // страниц/с (EWMA)
+    std::atomic<uint64_t> background_wal_rate{0};       // байт WAL/с (EWMA)
+    std::atomic<uint64_t> background_round_quota{0};    // страниц на раунд
+    std::atomic<uint64_t> background_wal_pages{0};      // из них держат WAL
+    std::atomic<uint64_t> background_lagging_pages{0};  // dirty до checkpoint'а
+    std::atomic<uint64_t> background_wal_pages_total{0};
+    
+    // Последовательность записи: pages_written / write_runs — средняя
+    // длина серии; combined — соседи, дописанные сверх квоты
+    std::atomic<uint64_t> write_runs_total{0};
+    std::atomic<uint64_t> combined_pages_total{0};
     std::atomic<uint64_t> current_wal_size{0};
     std::atomic<std::size_t> dirty_page_count{0};
     
@@ -208,7 +240,8 @@ struct CheckpointConfig {
     /// "Мягкий" лимит dirty pages (% от buffer pool)
     float dirty_page_soft_limit_pct = 0.70f;
     
-    /// "Жёсткий" лимит dirty pages (% от buffer pool) — БЛОКИРУЮЩИЙ
+    /// "Жёсткий" лимит dirty pages (% от buffer pool): check_pressure()
+    /// задерживает транзакции, пока фоновая запись не опустит долю ниже
     float dirty_page_hard_limit_pct = 0.90f;
     
     /// Размер батча для checkpoint (страниц за раз)
@@ -216,6 +249,279 @@ struct CheckpointConfig {
     
     /// Throttle delay между батчами (микросекунды)
     std::chrono::microseconds batch_throttle_us{100};
+    
+    /// Раунд фоновой записи: квота страниц на раунд пересчитывается по
+    /// темпу загрязнения и росту WAL, запись равномерно делится на раунд
+    std::chrono::milliseconds background_flush_interval{100};
+    
+    /// Доля dirty pages, к которой фоновая запись ведёт pool (ниже soft limit)
+    float background_target_dirty_pct = 0.50f;
+    
+    /// За сколько раундов снимается превышение над целевой долей
+    std::size_t background_catchup_rounds = 10;
+    
+    /// Доля max_wal_size: страницы с rec_lsn старше этого окна за хвостом
+    /// WAL пишутся в раунде первыми
+    float background_wal_target_pct = 0.50f;
+    
+    /// Доля max_interval: страницы, dirty с до прошлого checkpoint'а,
+    /// фоновая запись равномерно пишет к этому моменту интервала
+    float checkpoint_completion_target = 0.50f;
+    
+    /// Соседние dirty страницы сверх квоты (доля квоты) — продлевают
+    /// последовательные серии записи
+    float write_combine_pct = 0.50f;
+};
+
+// ============================================================================
+// Конфигурация Recovery
+// ============================================================================
+
+struct RecoveryConfig {
+    /// Потоки redo (0 — по числу ядер). Запись попадает в поток по хешу
+    /// page_id: изменения одной страницы применяются по порядку LSN
+    std::size_t redo_threads = 0;
+    
+    /// Записей в пакете, передаваемом потоку redo
+    std::size_t redo_batch_size = 256;
+    
+    /// Пакетов в очереди потока: на столько чтение лога может опережать
+    /// применение
+    std::size_t redo_queue_depth = 16;
+};
+
+// ============================================================================
+// Политика вытеснения Buffer Pool
+// ============================================================================
+
+enum class EvictionPolicyType {
+    ClockSweep,     // Один reference bit — дёшево, но не устойчив к scan'ам
+    LruK,           // LRU-K: вытесняет по K-й последней ссылке
+    Arc,            // Adaptive Replacement Cache (recency + frequency)
+};
+
+inline const char* eviction_policy_name(EvictionPolicyType type) {
+    switch (type) {
+        case EvictionPolicyType::ClockSweep: return "clock_sweep";
+        case EvictionPolicyType::LruK: return "lru_k";
+        case EvictionPolicyType::Arc: return "arc";
+        default: return "unknown";
+    }
+}
+
+// ============================================================================
+// Huge pages для арены страниц
+// ============================================================================
+
+enum class HugePages {
+    Off,            // Обычные 4KB страницы
+    Transparent,    // madvise(MADV_HUGEPAGE) — THP, если ядро разрешает
+    Explicit,       // MAP_HUGETLB (нужен пул vm.nr_hugepages), fallback на THP
+};
+
+inline const char* huge_pages_name(HugePages mode) {
+    switch (mode) {
+        case HugePages::Off: return "off";
+        case HugePages::Transparent: return "transparent";
+        case HugePages::Explicit: return "explicit";
+        default: return "unknown";
+    }
+}
+
+// ============================================================================
+// Дисковый I/O
+// ============================================================================
+
+enum class IoBackendType {
+    Sync,           // Блокирующие pread/pwrite в потоке вызывающего
+    ThreadPool,     // Пул потоков, выполняющих блокирующие вызовы
+    IoUring,        // io_uring (Linux 5.1+), fallback на ThreadPool
+};
+
+inline const char* io_backend_name(IoBackendType type) {
+    switch (type) {
+        case IoBackendType::Sync: return "sync";
+        case IoBackendType::ThreadPool: return "thread_pool";
+        case IoBackendType::IoUring: return "io_uring";
+        default: return "unknown";
+    }
+}
+
+/// Когда WAL и файл данных доводятся до стабильного носителя (fdatasync)
+enum class SyncPolicy {
+    None,           // Без fdatasync: при сбое питания теряется всё из page cache
+    PerCommit,      // fdatasync на каждый force()
+    Group,          // force()'ы в окне group_window разделяют один fdatasync
+    Interval,       // Фоновый fdatasync раз в interval; force() не ждёт диска
+};
+
+inline const char* sync_policy_name(SyncPolicy policy) {
+    switch (policy) {
+        case SyncPolicy::None: return "none";
+        case SyncPolicy::PerCommit: return "per_commit";
+        case SyncPolicy::Group: return "group";
+        case SyncPolicy::Interval: return "interval";
+        default: return "unknown";
+    }
+}
+
+struct SyncConfig {
+    SyncPolicy policy = SyncPolicy::PerCommit;
+    
+    /// Group: сколько лидер ждёт попутчиков перед fdatasync
+    std::chrono::microseconds group_window{200};
+    
+    /// Interval: период фонового fdatasync (верхняя граница потерь)
+    std::chrono::milliseconds interval{10};
+};
+
+struct IoConfig {
+    /// Backend асинхронного I/O для данных и WAL
+    IoBackendType backend = IoBackendType::Sync;
+    
+    /// Максимум одновременно выполняющихся операций
+    std::size_t queue_depth = 128;
+    
+    /// Потоков у ThreadPool backend'а
+    std::size_t worker_threads = 4;
+    
+    /// Открывать файл данных с O_DIRECT: страницы кэширует только buffer
+    /// pool, page cache ядра не дублирует их. Если файловая система
+    /// O_DIRECT не поддерживает — обычный буферизованный I/O
+    bool direct_io = false;
+    
+    /// Защита от порванных страниц: запись через doublewrite.db (см.
+    /// DiskManager). С SyncPolicy::None не действует
+    bool double_write = true;
+    
+    /// Файл данных растёт блоками по столько страниц (fallocate): без
+    /// расширения файла на каждую выделенную страницу
+    std::size_t extend_chunk_pages = 256;
+    
+    /// Политика fdatasync
+    SyncConfig sync;
+};
+
+// ============================================================================
+// Гистограмма латентности
+// ============================================================================
+
+/// Lock-free гистограмма с логарифмическими корзинами по микросекундам:
+/// корзина i (i > 0) — [2^i, 2^(i+1)) мкс, корзина 0 — [0, 2) мкс
+struct LatencyHistogram {
+    static constexpr std::size_t BUCKETS = 32;
+    
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total_us{0};
+    std::atomic<uint64_t> max_us{0};
+    
+    void record(std::chrono::nanoseconds duration) {
+        auto us = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+        
+        std::size_t idx = 0;
+        while (idx + 1 < BUCKETS && (us >> (idx + 1)) != 0) {
+            ++idx;
+        }
+        
+        buckets[idx].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        total_us.fetch_add(us, std::memory_order_relaxed);
+        
+        uint64_t prev = max_us.load(std::memory_order_relaxed);
+        while (us > prev &&
+               !max_us.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+            // prev обновлён неудачным CAS
+        }
+    }
+    
+    /// Верхняя граница корзины, в которую попадает перцентиль p (0..1)
+    uint64_t percentile_us(double p) const {
+        uint64_t total = count.load(std::memory_order_relaxed);
+        if (total == 0) return 0;
+        
+        auto rank = static_cast<uint64_t>(p * static_cast<double>(total));
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen > rank) {
+                return uint64_t{2} << i;
+            }
+        }
+        return max_us.load(std::memory_order_relaxed);
+    }
+    
+    double mean_us() const {
+        uint64_t total = count.load(std::memory_order_relaxed);
+        if (total == 0) return 0.0;
+        return static_cast<double>(total_us.load(std::memory_order_relaxed)) / total;
+    }
+};
+
+// ============================================================================
+// Метрики Buffer Pool
+// ============================================================================
+
+/// Snapshot счётчиков buffer pool (суммируется по партициям)
+struct BufferPoolMetrics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t prefetched = 0;  // Загружено read-ahead'ом / prefetch()
+    
+    double hit_ratio() const {
+        uint64_t total = hits + misses;
+        if (total == 0) return 1.0;
+        return static_cast<double>(hits) / static_cast<double>(total);
+    }
+};
+
+// ============================================================================
+// Конфигурация Buffer Pool
+// ============================================================================
+
+struct BufferPoolConfig {
+    /// Количество партиций (шардов) buffer pool. 0 — выбрать автоматически
+    /// по числу ядер. Округляется вверх до степени двойки.
+    std::size_t partition_count = 0;
+    
+    /// Минимум фреймов на партицию при автоматическом выборе
+    std::size_t min_frames_per_partition = 64;
+    
+    /// Политика вытеснения
+    EvictionPolicyType eviction_policy = EvictionPolicyType::ClockSweep;
+    
+    /// K для LRU-K
+    std::size_t lru_k = 2;
+    
+    /// Huge pages для арены с телами страниц
+    HugePages huge_pages = HugePages::Transparent;
+    
+    /// Автоматический read-ahead при последовательных miss'ах
+    bool read_ahead = false;
+    
+    /// Окно read-ahead в страницах (не больше четверти pool)
+    std::size_t read_ahead_window = 32;
+    
+    /// Сколько подряд идущих miss'ов считается последовательным сканом
+    std::size_t read_ahead_trigger = 4;
+};
+
+// ============================================================================
+// Конфигурация сборки индексов
+// ============================================================================
+
+struct IndexBuildConfig {
+    /// Доля места в узле, заполняемая bulk load'ом; остаток — под
+    /// последующие вставки без split'ов
+    double fill_factor = 0.9;
+    
+    /// Доля buffer pool под память внешней сортировки
+    double sort_memory_fraction = 0.25;
+    
+    /// Готовых узлов в одной записи на диск
+    std::size_t write_batch_pages = 64;
 };
 
 // ============================================================================
@@ -226,6 +532,8 @@ struct StorageConfig {
     std::string data_path = "./data";
     std::size_t buffer_pool_pages = 10000;  // ~40 MB при 4KB страницах
     std::size_t wal_segment_size = 64 * 1024 * 1024;  // 64 MB
+    BufferPoolConfig buffer_pool;
+    IoConfig io;
     CheckpointConfig checkpoint;
 };
 
@@ -0,0 +1,61 @@
+#include "storage/txn_context.hpp"
+
+#include <array>
+#include <cstring>
+
+namespace datyredb::storage {
+
+bool modify_page(WriteAheadLog& wal, TxnContext& txn, Page* page,
+                 const std::function<void(char*)>& fn) {
+    constexpr std::size_t PAYLOAD_SIZE = Page::payload_size();
+    
+    char* payload = page->payload();
+    std::array<char, PAYLOAD_SIZE> after;
+    std::memcpy(after.data(), payload, PAYLOAD_SIZE);
+    fn(after.data());
+    
+    // Изменённый диапазон: от первого до последнего отличающегося байта
+    std::size_t begin = 0;
+    while (begin < PAYLOAD_SIZE && payload[begin] == after[begin]) {
+        ++begin;
+    }
+    if (begin == PAYLOAD_SIZE) {
+        return false;
+    }
+    std::size_t end = PAYLOAD_SIZE;
+    while (end > begin && payload[end - 1] == after[end - 1]) {
+        --end;
+    }
+    std::size_t length = end - begin;
+    
+    LogRecord record;
+    record.type = LogRecordType::UPDATE;
+    record.txn_id = txn.txn_id;
+    record.page_id = page->page_id();
+    record.offset = static_cast<uint16_t>(begin);
+    record.length = static_cast<uint16_t>(length);
+    record.prev_lsn = txn.last_lsn;
+    record.data.resize(2 * length);
+    std::memcpy(record.data.data(), payload + begin, length);
+    std::memcpy(record.data.data() + length, after.data() + begin, length);
+    
+    // Сначала лог, затем страница: flush не увидит изменения без записи
+    Lsn lsn = wal.append(record);
+    std::memcpy(payload + begin, after.data() + begin, length);
+    page->set_lsn(lsn);
+    
+    record.lsn = lsn;
+    txn.last_lsn = lsn;
+    txn.undo.push_back(std::move(record));
+    return true;
+}
+
+Page* new_txn_page(BufferPool& buffer_pool, TxnContext& txn, PageId* page_id) {
+    Page* page = buffer_pool.new_page(page_id);
+    if (page) {
+        txn.allocated.push_back(*page_id);
+    }
+    return page;
+}
+
+} // namespace datyredb::storage
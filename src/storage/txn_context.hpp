@@ -0,0 +1,35 @@
+#pragma once
+
+#include "storage/storage_types.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/wal.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace datyredb::storage {
+
+/// Транзакция, в которую пишутся изменения страниц. undo — записанные
+/// изменения в порядке LSN: по ним rollback() откатывает транзакцию без
+/// чтения лога. allocated — страницы, выделенные транзакцией (при откате
+/// возвращаются DiskManager'у), freed — ставшие ненужными (возвращаются
+/// после commit)
+struct TxnContext {
+    TxnId txn_id = 0;
+    Lsn last_lsn = INVALID_LSN;
+    std::vector<LogRecord> undo;
+    std::vector<PageId> allocated;
+    std::vector<PageId> freed;
+};
+
+/// Изменение payload страницы: fn меняет копию, изменённый диапазон
+/// пишется в лог UPDATE'ом с обоими образами, затем копируется в
+/// страницу. Вызывающий исключает других писателей страницы.
+/// false — fn ничего не изменила
+bool modify_page(WriteAheadLog& wal, TxnContext& txn, Page* page,
+                 const std::function<void(char*)>& fn);
+
+/// Новая страница для txn (запоминается в txn.allocated)
+Page* new_txn_page(BufferPool& buffer_pool, TxnContext& txn, PageId* page_id);
+
+} // namespace datyredb::storage
@@ -1,6 +1,11 @@
 #include "storage/wal.hpp"
+#include "storage/checksum.hpp"
 #include "utils/logger.hpp"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
 #include <cstring>
 #include <algorithm>
 
@@ -10,70 +15,703 @@ namespace datyredb::storage {
 // LogRecord
 // ============================================================================
 
+namespace {
+
+/// Фиксированная часть заголовка: размер, CRC, тип, формат
+constexpr std::size_t FIXED_HEADER = 2 * sizeof(uint32_t) + 2;
+
+/// CRC записи size байт в buf с позиции lsn: LSN, размер и всё после
+/// поля CRC. Запись, прочитанная не со своей позиции, не сходится
+uint32_t record_crc(const char* buf, std::size_t size, Lsn lsn) {
+    uint32_t crc = crc32c(&lsn, sizeof(lsn));
+    crc = crc32c(buf, sizeof(uint32_t), crc);
+    return crc32c(buf + 2 * sizeof(uint32_t), size - 2 * sizeof(uint32_t), crc);
+}
+
+/// Равных байт, на которых отрезок Runs разрывается: короче — дешевле
+/// включить их в отрезок, чем начинать новый
+constexpr std::size_t RUN_MIN_GAP = 3;
+
+std::size_t varint_size(uint64_t value) {
+    std::size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+void put_varint(char*& out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<char>(value);
+}
+
+bool get_varint(const char*& in, const char* end, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; in < end && shift < 64; shift += 7) {
+        auto byte = static_cast<uint8_t>(*in++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Образов на отрезок в формате Runs
+std::size_t images_per_run(LogRecordType type) {
+    return type == LogRecordType::UPDATE ? 2 : 1;
+}
+
+/// Образы Images-записи: до и после (nullptr — нули). false — запись
+/// не кодируется в Runs
+bool change_images(const LogRecord& record, const char*& before, const char*& after) {
+    std::size_t length = record.length;
+    switch (record.type) {
+        case LogRecordType::UPDATE:
+            if (record.data.size() != 2 * length) {
+                return false;
+            }
+            before = record.data.data();
+            after = before + length;
+            return true;
+        case LogRecordType::INSERT:
+            before = nullptr;
+            after = record.data.data();
+            return record.data.size() == length;
+        case LogRecordType::DELETE:
+            before = record.data.data();
+            after = nullptr;
+            return record.data.size() == length;
+        default:
+            return false;
+    }
+}
+
+/// Отрезки, где before и after (nullptr — нули) различаются:
+/// fn(начало, длина). Равные участки короче RUN_MIN_GAP входят в отрезок
+template <typename Fn>
+void for_each_changed_run(const char* before, const char* after, std::size_t length, Fn&& fn) {
+    auto differs = [&](std::size_t i) {
+        char b = before ? before[i] : 0;
+        char a = after ? after[i] : 0;
+        return a != b;
+    };
+    auto word = [](const char* image, std::size_t i) {
+        uint64_t value = 0;
+        if (image) {
+            std::memcpy(&value, image + i, sizeof(value));
+        }
+        return value;
+    };
+    
+    std::size_t pos = 0;
+    while (pos < length) {
+        // Равные участки — словами
+        while (pos + sizeof(uint64_t) <= length && word(before, pos) == word(after, pos)) {
+            pos += sizeof(uint64_t);
+        }
+        while (pos < length && !differs(pos)) {
+            ++pos;
+        }
+        if (pos == length) {
+            break;
+        }
+        
+        std::size_t start = pos;
+        std::size_t end = pos;
+        while (pos < length) {
+            // Слово, где различаются все байты (в XOR нет нулевого байта)
+            if (pos + sizeof(uint64_t) <= length) {
+                uint64_t x = word(before, pos) ^ word(after, pos);
+                if (((x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL) == 0) {
+                    pos += sizeof(uint64_t);
+                    end = pos;
+                    continue;
+                }
+            }
+            if (differs(pos)) {
+                end = ++pos;
+            } else if (pos - end + 1 >= RUN_MIN_GAP) {
+                break;
+            } else {
+                ++pos;
+            }
+        }
+        fn(start, end - start);
+        pos = end;
+    }
+}
+
+/// Размер data в формате Runs
+std::size_t runs_size(const LogRecord& record, const char* before, const char* after) {
+    std::size_t images = images_per_run(record.type);
+    std::size_t size = 0;
+    std::size_t prev_end = 0;
+    for_each_changed_run(before, after, record.length, [&](std::size_t start, std::size_t len) {
+        size += varint_size(start - prev_end) + varint_size(len) + images * len;
+        prev_end = start + len;
+    });
+    return size;
+}
+
+/// Закодировать data в формат Runs
+void encode_runs(const LogRecord& record, const char* before, const char* after, char*& out) {
+    std::size_t prev_end = 0;
+    for_each_changed_run(before, after, record.length, [&](std::size_t start, std::size_t len) {
+        put_varint(out, start - prev_end);
+        put_varint(out, len);
+        // У INSERT нет образа до, у DELETE — после
+        for (const char* image : {before, after}) {
+            if (image) {
+                std::memcpy(out, image + start, len);
+                out += len;
+            }
+        }
+        prev_end = start + len;
+    });
+}
+
+/// Обойти отрезки Runs: fn(начало, длина, образы). false — data
+/// повреждены или выходят за length
+template <typename Fn>
+bool for_each_run(const LogRecord& record, Fn&& fn) {
+    std::size_t images = images_per_run(record.type);
+    const char* in = record.data.data();
+    const char* end = in + record.data.size();
+    uint64_t pos = 0;
+    
+    while (in < end) {
+        uint64_t skip;
+        uint64_t len;
+        if (!get_varint(in, end, skip) || !get_varint(in, end, len) ||
+            skip > record.length || len > record.length ||
+            pos + skip + len > record.length ||
+            static_cast<uint64_t>(end - in) < images * len) {
+            return false;
+        }
+        pos += skip;
+        fn(static_cast<std::size_t>(pos), static_cast<std::size_t>(len), in);
+        pos += len;
+        in += images * len;
+    }
+    return true;
+}
+
+/// Размер data при сериализации и кодирование в Runs
+struct DataEncoding {
+    bool runs = false;
+    const char* before = nullptr;
+    const char* after = nullptr;
+    std::size_t size = 0;
+};
+
+DataEncoding choose_encoding(const LogRecord& record) {
+    DataEncoding encoding;
+    encoding.size = record.data.size();
+    
+    if (record.format == LogDataFormat::Images &&
+        change_images(record, encoding.before, encoding.after)) {
+        std::size_t size = runs_size(record, encoding.before, encoding.after);
+        if (size < encoding.size) {
+            encoding.runs = true;
+            encoding.size = size;
+        }
+    }
+    return encoding;
+}
+
+std::size_t header_size(const LogRecord& record) {
+    return FIXED_HEADER
+         + varint_size(record.txn_id)
+         + varint_size(static_cast<PageId>(record.page_id + 1))
+         + varint_size(record.offset)
+         + varint_size(record.length)
+         + varint_size(record.prev_lsn / WriteAheadLog::RECORD_ALIGN);
+}
+
+} // namespace
+
 std::size_t LogRecord::serialized_size() const {
-    return sizeof(LogRecordType)    // type
-         + sizeof(Lsn)              // lsn
-         + sizeof(TxnId)            // txn_id
-         + sizeof(PageId)           // page_id
-         + sizeof(uint16_t)         // offset
-         + sizeof(uint16_t)         // length
-         + sizeof(Lsn)              // prev_lsn
-         + sizeof(uint32_t)         // data size
-         + data.size();             // data
+    return header_size(*this) + choose_encoding(*this).size;
 }
 
 void LogRecord::serialize(std::vector<char>& buffer) const {
     buffer.resize(serialized_size());
-    char* ptr = buffer.data();
+    serialize(buffer.data(), lsn);
+}
+
+void LogRecord::serialize(char* out, Lsn record_lsn) const {
+    DataEncoding encoding = choose_encoding(*this);
+    auto size = static_cast<uint32_t>(header_size(*this) + encoding.size);
+    auto stored_format = encoding.runs ? LogDataFormat::Runs : format;
+    char* ptr = out;
     
+    // CRC — после остальных полей
+    std::memcpy(ptr, &size, sizeof(size)); ptr += sizeof(size);
+    ptr += sizeof(uint32_t);
     std::memcpy(ptr, &type, sizeof(type)); ptr += sizeof(type);
-    std::memcpy(ptr, &lsn, sizeof(lsn)); ptr += sizeof(lsn);
-    std::memcpy(ptr, &txn_id, sizeof(txn_id)); ptr += sizeof(txn_id);
-    std::memcpy(ptr, &page_id, sizeof(page_id)); ptr += sizeof(page_id);
-    std::memcpy(ptr, &offset, sizeof(offset)); ptr += sizeof(offset);
-    std::memcpy(ptr, &length, sizeof(length)); ptr += sizeof(length);
-    std::memcpy(ptr, &prev_lsn, sizeof(prev_lsn)); ptr += sizeof(prev_lsn);
+    std::memcpy(ptr, &stored_format, sizeof(stored_format)); ptr += sizeof(stored_format);
     
-    uint32_t data_size = static_cast<uint32_t>(data.size());
-    std::memcpy(ptr, &data_size, sizeof(data_size)); ptr += sizeof(data_size);
+    // INVALID_PAGE_ID хранится как 0; prev_lsn кратен RECORD_ALIGN
+    put_varint(ptr, txn_id);
+    put_varint(ptr, static_cast<PageId>(page_id + 1));
+    put_varint(ptr, offset);
+    put_varint(ptr, length);
+    put_varint(ptr, prev_lsn / WriteAheadLog::RECORD_ALIGN);
     
-    if (!data.empty()) {
+    if (encoding.runs) {
+        encode_runs(*this, encoding.before, encoding.after, ptr);
+    } else if (!data.empty()) {
         std::memcpy(ptr, data.data(), data.size());
     }
+    
+    uint32_t crc = record_crc(out, size, record_lsn);
+    std::memcpy(out + sizeof(size), &crc, sizeof(crc));
+}
+
+uint32_t LogRecord::peek_size(const char* buf) {
+    uint32_t size;
+    std::memcpy(&size, buf, sizeof(size));
+    return size;
 }
-LogRecord LogRecord::deserialize(const char* buf, [[maybe_unused]] std::size_t size) {
+
+std::optional<LogRecord> LogRecord::deserialize(const char* buf, std::size_t size, Lsn lsn) {
+    if (size < MIN_SERIALIZED_SIZE || peek_size(buf) != size) {
+        return std::nullopt;
+    }
+    
     LogRecord rec;
-    const char* ptr = buf;
+    const char* ptr = buf + sizeof(uint32_t);
+    const char* end = buf + size;
     
+    uint32_t crc;
+    std::memcpy(&crc, ptr, sizeof(crc)); ptr += sizeof(crc);
     std::memcpy(&rec.type, ptr, sizeof(rec.type)); ptr += sizeof(rec.type);
-    std::memcpy(&rec.lsn, ptr, sizeof(rec.lsn)); ptr += sizeof(rec.lsn);
-    std::memcpy(&rec.txn_id, ptr, sizeof(rec.txn_id)); ptr += sizeof(rec.txn_id);
-    std::memcpy(&rec.page_id, ptr, sizeof(rec.page_id)); ptr += sizeof(rec.page_id);
-    std::memcpy(&rec.offset, ptr, sizeof(rec.offset)); ptr += sizeof(rec.offset);
-    std::memcpy(&rec.length, ptr, sizeof(rec.length)); ptr += sizeof(rec.length);
-    std::memcpy(&rec.prev_lsn, ptr, sizeof(rec.prev_lsn)); ptr += sizeof(rec.prev_lsn);
+    std::memcpy(&rec.format, ptr, sizeof(rec.format)); ptr += sizeof(rec.format);
     
-    uint32_t data_size;
-    std::memcpy(&data_size, ptr, sizeof(data_size)); ptr += sizeof(data_size);
+    // Недописанная запись, нули и мусор за концом лога, записи прежнего
+    // круга в переиспользованном сегменте
+    if (crc != record_crc(buf, size, lsn) ||
+        rec.type == LogRecordType::INVALID || rec.type > LogRecordType::CLR ||
+        rec.format > LogDataFormat::Runs) {
+        return std::nullopt;
+    }
     
-    if (data_size > 0) {
-        rec.data.resize(data_size);
-        std::memcpy(rec.data.data(), ptr, data_size);
+    uint64_t txn_id, page_id, offset, length, prev_lsn;
+    if (!get_varint(ptr, end, txn_id) || !get_varint(ptr, end, page_id) ||
+        !get_varint(ptr, end, offset) || !get_varint(ptr, end, length) ||
+        !get_varint(ptr, end, prev_lsn) ||
+        page_id > INVALID_PAGE_ID ||
+        offset > UINT16_MAX || length > UINT16_MAX) {
+        return std::nullopt;
     }
     
+    rec.lsn = lsn;
+    rec.txn_id = txn_id;
+    rec.page_id = static_cast<PageId>(page_id) - 1;
+    rec.offset = static_cast<uint16_t>(offset);
+    rec.length = static_cast<uint16_t>(length);
+    rec.prev_lsn = prev_lsn * WriteAheadLog::RECORD_ALIGN;
+    rec.data.assign(ptr, end);
+    
+    if (rec.format == LogDataFormat::Runs &&
+        !for_each_run(rec, [](std::size_t, std::size_t, const char*) {})) {
+        return std::nullopt;
+    }
     return rec;
 }
 
+bool LogRecord::modifies_page() const {
+    switch (type) {
+        case LogRecordType::INSERT:
+        case LogRecordType::UPDATE:
+        case LogRecordType::DELETE:
+        case LogRecordType::CLR:
+            return page_id != INVALID_PAGE_ID;
+        default:
+            return false;
+    }
+}
+
+void LogRecord::redo(char* payload) const {
+    char* target = payload + offset;
+    
+    if (format == LogDataFormat::Runs) {
+        for_each_run(*this, [&](std::size_t start, std::size_t len, const char* images) {
+            switch (type) {
+                case LogRecordType::UPDATE:
+                    std::memcpy(target + start, images + len, len);
+                    break;
+                case LogRecordType::DELETE:
+                    std::memset(target + start, 0, len);
+                    break;
+                default:
+                    std::memcpy(target + start, images, len);
+                    break;
+            }
+        });
+        return;
+    }
+    
+    // Images: образ после изменения; отсутствующий — нули
+    std::size_t image_offset = type == LogRecordType::UPDATE ? length : 0;
+    if (type != LogRecordType::DELETE && data.size() >= image_offset + length) {
+        std::memcpy(target, data.data() + image_offset, length);
+    } else {
+        std::memset(target, 0, length);
+    }
+}
+
+LogRecord LogRecord::compensation() const {
+    LogRecord clr;
+    clr.type = LogRecordType::CLR;
+    clr.txn_id = txn_id;
+    clr.page_id = page_id;
+    clr.offset = offset;
+    clr.length = length;
+    clr.prev_lsn = prev_lsn;
+    clr.format = format;
+    
+    if (format == LogDataFormat::Runs) {
+        // Те же отрезки с образом до изменения (у INSERT — нули)
+        std::vector<char> out(data.size());
+        char* scratch = out.data();
+        std::size_t prev_end = 0;
+        for_each_run(*this, [&](std::size_t start, std::size_t len, const char* images) {
+            put_varint(scratch, start - prev_end);
+            put_varint(scratch, len);
+            if (type == LogRecordType::INSERT) {
+                std::memset(scratch, 0, len);
+            } else {
+                std::memcpy(scratch, images, len);
+            }
+            scratch += len;
+            prev_end = start + len;
+        });
+        out.resize(static_cast<std::size_t>(scratch - out.data()));
+        clr.data = std::move(out);
+        return clr;
+    }
+    
+    // Images: образ до изменения; отсутствующий — нули
+    clr.data.assign(length, 0);
+    if (type != LogRecordType::INSERT && data.size() >= length) {
+        std::memcpy(clr.data.data(), data.data(), length);
+    }
+    return clr;
+}
+
+// ============================================================================
+// CheckpointData
+// ============================================================================
+
+Lsn CheckpointData::redo_lsn(Lsn begin_lsn) const {
+    Lsn lsn = begin_lsn;
+    for (const auto& entry : dirty_pages) {
+        // Без rec_lsn — изменения страницы не в логе
+        if (entry.rec_lsn != INVALID_LSN) {
+            lsn = std::min(lsn, entry.rec_lsn);
+        }
+    }
+    for (const auto& txn : active_txns) {
+        lsn = std::min(lsn, txn.last_lsn);
+    }
+    return lsn;
+}
+
+Lsn CheckpointData::truncation_lsn(Lsn begin_lsn) const {
+    Lsn lsn = redo_lsn(begin_lsn);
+    for (const auto& txn : active_txns) {
+        lsn = std::min(lsn, txn.first_lsn);
+    }
+    return lsn;
+}
+
+std::vector<char> CheckpointData::serialize() const {
+    constexpr std::size_t align = WriteAheadLog::RECORD_ALIGN;
+    
+    std::size_t size = varint_size(dirty_pages.size()) + varint_size(active_txns.size());
+    for (const auto& entry : dirty_pages) {
+        size += varint_size(entry.page_id) + varint_size(entry.rec_lsn / align);
+    }
+    for (const auto& txn : active_txns) {
+        size += varint_size(txn.txn_id) + varint_size(txn.first_lsn / align) +
+                varint_size(txn.last_lsn / align);
+    }
+    
+    std::vector<char> out(size);
+    char* ptr = out.data();
+    put_varint(ptr, dirty_pages.size());
+    for (const auto& entry : dirty_pages) {
+        put_varint(ptr, entry.page_id);
+        put_varint(ptr, entry.rec_lsn / align);
+    }
+    put_varint(ptr, active_txns.size());
+    for (const auto& txn : active_txns) {
+        put_varint(ptr, txn.txn_id);
+        put_varint(ptr, txn.first_lsn / align);
+        put_varint(ptr, txn.last_lsn / align);
+    }
+    return out;
+}
+
+std::optional<CheckpointData> CheckpointData::deserialize(const std::vector<char>& data) {
+    constexpr std::size_t align = WriteAheadLog::RECORD_ALIGN;
+    const char* ptr = data.data();
+    const char* end = ptr + data.size();
+    CheckpointData result;
+    
+    // Пустая data — END без таблиц: все страницы снимка уже на диске
+    if (data.empty()) {
+        return result;
+    }
+    
+    uint64_t count;
+    if (!get_varint(ptr, end, count) || count > data.size()) {
+        return std::nullopt;
+    }
+    result.dirty_pages.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t page_id, rec_lsn;
+        if (!get_varint(ptr, end, page_id) || !get_varint(ptr, end, rec_lsn) ||
+            page_id >= INVALID_PAGE_ID) {
+            return std::nullopt;
+        }
+        result.dirty_pages.push_back({static_cast<PageId>(page_id), rec_lsn * align});
+    }
+    
+    if (!get_varint(ptr, end, count) || count > data.size()) {
+        return std::nullopt;
+    }
+    result.active_txns.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t txn_id, first_lsn, last_lsn;
+        if (!get_varint(ptr, end, txn_id) || !get_varint(ptr, end, first_lsn) ||
+            !get_varint(ptr, end, last_lsn)) {
+            return std::nullopt;
+        }
+        result.active_txns.push_back({txn_id, first_lsn * align, last_lsn * align});
+    }
+    
+    if (ptr != end) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::vector<CheckpointData> CheckpointData::split(std::size_t max_entries) const {
+    std::vector<CheckpointData> parts(1);
+    auto room = [&] {
+        const CheckpointData& last = parts.back();
+        if (last.dirty_pages.size() + last.active_txns.size() >= max_entries) {
+            parts.emplace_back();
+        }
+        return &parts.back();
+    };
+    for (const auto& entry : dirty_pages) {
+        room()->dirty_pages.push_back(entry);
+    }
+    for (const auto& txn : active_txns) {
+        room()->active_txns.push_back(txn);
+    }
+    return parts;
+}
+
+void CheckpointData::merge(CheckpointData&& part) {
+    dirty_pages.insert(dirty_pages.end(), part.dirty_pages.begin(), part.dirty_pages.end());
+    active_txns.insert(active_txns.end(), part.active_txns.begin(), part.active_txns.end());
+}
+
+// ============================================================================
+// LogReader
+// ============================================================================
+
+LogReader::LogReader(const std::filesystem::path& wal_dir, std::size_t segment_size)
+    : wal_dir_(wal_dir)
+    , segment_size_(segment_size)
+{
+}
+
+LogReader::~LogReader() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool LogReader::read(Lsn lsn, LogRecord& record) {
+    if (lsn == INVALID_LSN || !fetch(lsn, LogRecord::MIN_SERIALIZED_SIZE)) {
+        return false;
+    }
+    
+    // Нули и мусор за концом лога: размер вне допустимого
+    uint32_t size = LogRecord::peek_size(window_.data() + (lsn - window_start_));
+    if (size < LogRecord::MIN_SERIALIZED_SIZE || size > WriteAheadLog::RING_SIZE ||
+        !fetch(lsn, size)) {
+        return false;
+    }
+    
+    auto decoded = LogRecord::deserialize(window_.data() + (lsn - window_start_), size, lsn);
+    if (!decoded) {
+        return false;
+    }
+    record = std::move(*decoded);
+    return true;
+}
+
+Lsn LogReader::next_lsn(const LogRecord& record) {
+    return record.lsn + WriteAheadLog::aligned_size(record.serialized_size());
+}
+
+bool LogReader::fetch(Lsn pos, std::size_t size) {
+    if (window_start_ != INVALID_LSN && pos >= window_start_ &&
+        pos + size <= window_start_ + window_.size()) {
+        return true;
+    }
+    
+    window_.resize(std::max(size, READ_CHUNK));
+    window_.resize(read_stream(pos, window_.data(), window_.size()));
+    window_start_ = pos;
+    return window_.size() >= size;
+}
+
+std::size_t LogReader::read_stream(Lsn pos, char* out, std::size_t size) {
+    std::size_t done = 0;
+    while (done < size) {
+        uint64_t segment_id = (pos + done) / segment_size_;
+        std::size_t offset = (pos + done) % segment_size_;
+        std::size_t want = std::min(size - done, segment_size_ - offset);
+        
+        if (fd_ < 0 || fd_segment_ != segment_id) {
+            if (fd_ >= 0) {
+                ::close(fd_);
+            }
+            auto path = wal_dir_ / ("wal_" + std::to_string(segment_id));
+            fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            fd_segment_ = segment_id;
+            if (fd_ < 0) {
+                break;
+            }
+            // Recovery читает сегмент подряд: readahead ядра опережает разбор
+            ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+        
+        ssize_t n = ::pread(fd_, out + done, want, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += static_cast<std::size_t>(n);
+        
+        // Сегмент короче полного — дальше лога нет
+        if (static_cast<std::size_t>(n) < want) {
+            break;
+        }
+    }
+    return done;
+}
+
 // ============================================================================
 // WriteAheadLog
 // ============================================================================
 
+namespace {
+
+/// pwrite до полного объёма
+bool write_full(int fd, const char* data, std::size_t size, std::size_t offset) {
+    std::size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::pwrite(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+/// Номер сегмента по имени файла wal_N
+bool parse_segment_id(const std::filesystem::path& path, uint64_t& segment_id) {
+    auto filename = path.filename().string();
+    if (filename.size() <= 4 || filename.compare(0, 4, "wal_") != 0 ||
+        filename.find_first_not_of("0123456789", 4) != std::string::npos) {
+        return false;
+    }
+    try {
+        segment_id = std::stoull(filename.substr(4));
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+/// Выделить файлу сегмента size байт. zero_fill — записать нули:
+/// блоки становятся записанными, и запись в них не меняет метаданные
+bool preallocate(int fd, std::size_t size, bool zero_fill) {
+    if (::fallocate(fd, 0, 0, static_cast<off_t>(size)) != 0 &&
+        ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        return false;
+    }
+    if (!zero_fill) {
+        return true;
+    }
+    
+    static const std::vector<char> zeros(1024 * 1024, 0);
+    for (std::size_t offset = 0; offset < size; offset += zeros.size()) {
+        if (!write_full(fd, zeros.data(), std::min(zeros.size(), size - offset), offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Обнулить [from, to) файла: FALLOC_FL_ZERO_RANGE или запись нулей
+bool zero_range(int fd, std::size_t from, std::size_t to) {
+    if (from >= to) {
+        return true;
+    }
+    if (::fallocate(fd, FALLOC_FL_ZERO_RANGE, static_cast<off_t>(from),
+                    static_cast<off_t>(to - from)) == 0) {
+        return true;
+    }
+    
+    std::vector<char> zeros(std::min<std::size_t>(to - from, 1024 * 1024), 0);
+    for (std::size_t offset = from; offset < to; offset += zeros.size()) {
+        if (!write_full(fd, zeros.data(), std::min(zeros.size(), to - offset), offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void sync_directory(const std::filesystem::path& dir) {
+    int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+}
+
+} // namespace
+
 WriteAheadLog::WriteAheadLog(const std::filesystem::path& wal_dir,
                              std::size_t segment_size,
-                             std::shared_ptr<CheckpointMetrics> metrics)
+                             std::shared_ptr<CheckpointMetrics> metrics,
+                             std::shared_ptr<IoBackend> io_backend,
+                             SyncConfig sync_config)
     : wal_dir_(wal_dir)
-    , segment_size_(segment_size)
+    , segment_size_(std::max(aligned_size(segment_size), RECORD_ALIGN))
     , metrics_(std::move(metrics))
+    , io_backend_(std::move(io_backend))
+    , sync_config_(sync_config)
 {
 }
 
@@ -82,7 +720,7 @@ WriteAheadLog::~WriteAheadLog() {
 }
 
 bool WriteAheadLog::initialize() {
-    if (initialized_) {
+    if (initialized_.load(std::memory_order_acquire)) {
         return true;
     }
     
@@ -95,110 +733,608 @@ bool WriteAheadLog::initialize() {
         return false;
     }
     
-    // Находим последний сегмент
-    uint64_t max_segment = 0;
-    for (const auto& entry : std::filesystem::directory_iterator(wal_dir_)) {
-        auto filename = entry.path().filename().string();
-        if (filename.find("wal_") == 0 && filename.size() > 4) {
-            try {
-                uint64_t seg_id = std::stoull(filename.substr(4));
-                max_segment = std::max(max_segment, seg_id);
-            } catch (...) {
-                continue;
-            }
+    // Master-запись: BEGIN и END последнего завершённого checkpoint'а
+    Lsn master[2] = {INVALID_LSN, INVALID_LSN};
+    int master_fd = ::open((wal_dir_ / MASTER_FILE).c_str(), O_RDONLY | O_CLOEXEC);
+    if (master_fd >= 0) {
+        if (::pread(master_fd, master, sizeof(master), 0) != sizeof(master)) {
+            master[0] = master[1] = INVALID_LSN;
         }
+        ::close(master_fd);
     }
+    checkpoint_lsn_.store(master[0]);
+    checkpoint_end_lsn_.store(master[1]);
     
-    current_segment_id_ = max_segment;
+    // Лог продолжается с конца последней целой записи
+    Lsn pos = recover_log_end();
     
-    // Открываем текущий сегмент
-    auto path = segment_path(current_segment_id_);
-    current_segment_.open(path, 
-                          std::ios::in | std::ios::out | std::ios::binary | std::ios::app);
-    
-    if (!current_segment_.is_open()) {
-        // Создаём новый
-        current_segment_.open(path, std::ios::out | std::ios::binary);
-        if (!current_segment_.is_open()) {
-            Logger::error("WAL: failed to create segment {}", path.string());
-            return false;
-        }
-        current_segment_.close();
-        current_segment_.open(path,
-                              std::ios::in | std::ios::out | std::ios::binary | std::ios::app);
+    if (pos == INVALID_LSN) {
+        return false;
     }
     
-    // Определяем позицию в сегменте
-    current_segment_.seekp(0, std::ios::end);
-    current_segment_pos_ = static_cast<std::size_t>(current_segment_.tellp());
+    // Открываем сегмент, в который пойдут новые записи
+    uint64_t last_segment = pos / segment_size_;
+    auto path = segment_path(last_segment);
+    segment_fd_ = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (segment_fd_ < 0) {
+        Logger::error("WAL: failed to open segment {}: {}",
+                      path.string(), std::strerror(errno));
+        return false;
+    }
+    segment_fd_id_ = last_segment;
     
-    // Вычисляем общий размер WAL
-    uint64_t total_size = 0;
+    // Размер WAL — поток от начала самого старого сегмента: сегменты
+    // полного размера, их файлы не отражают заполненность
+    uint64_t oldest_segment = last_segment;
     for (const auto& entry : std::filesystem::directory_iterator(wal_dir_)) {
-        if (entry.is_regular_file()) {
-            total_size += entry.file_size();
+        uint64_t seg_id;
+        if (entry.is_regular_file() && parse_segment_id(entry.path(), seg_id)) {
+            oldest_segment = std::min(oldest_segment, seg_id);
         }
     }
-    current_size_.store(total_size);
-    metrics_->current_wal_size.store(total_size);
+    log_start_.store(oldest_segment * segment_size_);
+    metrics_->current_wal_size.store(pos - oldest_segment * segment_size_);
+    
+    // Транзакции до конца лога разрешает recovery: таблица начинается пустой
+    {
+        std::lock_guard lock(att_mutex_);
+        att_.clear();
+        att_scanned_ = pos;
+    }
+    
+    ring_ = std::make_unique<char[]>(RING_SIZE);
+    published_ = std::make_unique<std::atomic<uint32_t>[]>(RING_SIZE / RECORD_ALIGN);
+    for (std::size_t i = 0; i < RING_SIZE / RECORD_ALIGN; ++i) {
+        published_[i].store(0, std::memory_order_relaxed);
+    }
+    
+    reserve_pos_.store(pos);
+    released_pos_.store(pos);
+    written_lsn_.store(pos);
+    flushed_lsn_.store(pos);
+    requested_lsn_ = INVALID_LSN;
+    write_failed_.store(false);
+    stopping_.store(false);
+    last_sync_ = std::chrono::steady_clock::now();
+    flusher_ = std::thread(&WriteAheadLog::flusher_loop, this);
+    
+    current_segment_.store(last_segment);
+    prepared_until_ = last_segment;
+    preparer_ = std::thread(&WriteAheadLog::preparer_loop, this);
     
-    initialized_ = true;
+    initialized_.store(true, std::memory_order_release);
     
-    Logger::info("WAL initialized: dir={}, segments={}, size={} bytes",
+    Logger::info("WAL initialized: dir={}, segments={}, size={} bytes, lsn={}, "
+                 "checkpoint_lsn={}, sync={}",
                  wal_dir_.string(),
-                 current_segment_id_ + 1,
-                 total_size);
+                 last_segment + 1,
+                 pos - log_start_.load(),
+                 pos,
+                 master[0],
+                 sync_policy_name(sync_config_.policy));
     
     return true;
 }
 
 void WriteAheadLog::shutdown() {
-    if (!initialized_) {
+    if (!initialized_.load(std::memory_order_acquire)) {
         return;
     }
     
-    std::lock_guard lock(append_mutex_);
+    // Flusher дописывает всё зарезервированное и делает финальный fdatasync
+    {
+        std::lock_guard lock(flush_mutex_);
+        stopping_.store(true);
+    }
+    flush_cv_.notify_all();
+    flusher_.join();
+    
+    {
+        std::lock_guard lock(prepare_mutex_);
+    }
+    prepare_cv_.notify_all();
+    preparer_.join();
     
-    if (current_segment_.is_open()) {
-        current_segment_.flush();
-        current_segment_.close();
+    if (segment_fd_ >= 0) {
+        ::close(segment_fd_);
+        segment_fd_ = -1;
     }
     
-    initialized_ = false;
+    initialized_.store(false, std::memory_order_release);
     Logger::info("WAL shutdown");
 }
 
 Lsn WriteAheadLog::append(const LogRecord& record) {
-    std::lock_guard lock(append_mutex_);
+    std::size_t size = record.serialized_size();
+    std::size_t padded = aligned_size(size);
     
-    LogRecord rec = record;
-    rec.lsn = next_lsn_.fetch_add(1);
+    // Запись должна целиком помещаться в кольцо
+    if (padded > RING_SIZE) {
+        Logger::error("WAL: record of {} bytes exceeds log buffer", size);
+        return INVALID_LSN;
+    }
+    if (!initialized_.load(std::memory_order_acquire) ||
+        stopping_.load(std::memory_order_acquire)) {
+        return INVALID_LSN;
+    }
     
-    std::vector<char> buffer;
-    rec.serialize(buffer);
+    // Резервирование места — единственная общая операция append'а
+    Lsn start = reserve_pos_.fetch_add(padded);
+    Lsn end = start + padded;
+    if (end > released_pos_.load(std::memory_order_acquire) + RING_SIZE) {
+        wait_for_space(end);
+    }
     
-    // Проверяем, нужен ли новый сегмент
-    if (current_segment_pos_ + buffer.size() > segment_size_) {
-        if (!rotate_segment()) {
-            Logger::error("WAL: failed to rotate segment");
-            return INVALID_LSN;
+    // Сериализуем прямо в кольцо; запись через край кольца — через
+    // буфер потока
+    std::size_t ring_offset = start & (RING_SIZE - 1);
+    if (ring_offset + padded <= RING_SIZE) {
+        char* out = ring_.get() + ring_offset;
+        record.serialize(out, start);
+        std::memset(out + size, 0, padded - size);
+    } else {
+        thread_local std::vector<char> scratch;
+        scratch.assign(padded, 0);
+        record.serialize(scratch.data(), start);
+        copy_to_ring(start, scratch.data(), padded);
+    }
+    
+    // Публикация: flusher видит запись целиком, прочитав её размер
+    published_[(start / RECORD_ALIGN) & (RING_SIZE / RECORD_ALIGN - 1)]
+        .store(static_cast<uint32_t>(padded), std::memory_order_release);
+    
+    // Полный блок можно писать, не дожидаясь force(). Пробуждение без
+    // мьютекса может потеряться — тогда блок уйдёт со следующим force()
+    if (start / WRITE_CHUNK != end / WRITE_CHUNK) {
+        flush_cv_.notify_one();
+    }
+    
+    return start;
+}
+
+bool WriteAheadLog::active_transactions(Lsn before, std::vector<ActiveTxn>& out) {
+    std::lock_guard lock(att_mutex_);
+    bool complete = scan_transactions(before);
+    
+    out.clear();
+    out.reserve(att_.size());
+    for (const auto& [txn_id, txn] : att_) {
+        out.push_back(txn);
+    }
+    return complete;
+}
+
+bool WriteAheadLog::scan_transactions(Lsn until) {
+    if (until <= att_scanned_) {
+        return true;
+    }
+    
+    // Записи до until должны быть в сегментах (fdatasync не нужен)
+    force_to(until - 1, false);
+    if (written_lsn_.load() < until) {
+        Logger::error("WAL: log is not written up to LSN {}", until);
+        return false;
+    }
+    
+    LogReader reader(wal_dir_, segment_size_);
+    LogRecord record;
+    while (att_scanned_ < until) {
+        if (!reader.read(att_scanned_, record)) {
+            Logger::error("WAL: failed to read record at LSN {} for transaction table",
+                          att_scanned_);
+            return false;
+        }
+        if (record.txn_id != 0) {
+            track_txn(record);
+        }
+        att_scanned_ = LogReader::next_lsn(record);
+    }
+    return true;
+}
+
+void WriteAheadLog::track_txn(const LogRecord& record) {
+    switch (record.type) {
+        case LogRecordType::TXN_COMMIT:
+        case LogRecordType::TXN_ABORT:
+            att_.erase(record.txn_id);
+            break;
+        default: {
+            auto [it, inserted] = att_.try_emplace(record.txn_id,
+                                                   ActiveTxn{record.txn_id, record.lsn, record.lsn});
+            if (!inserted) {
+                it->second.last_lsn = record.lsn;
+            }
+            break;
+        }
+    }
+}
+
+void WriteAheadLog::copy_to_ring(Lsn pos, const char* src, std::size_t size) {
+    std::size_t ring_offset = pos & (RING_SIZE - 1);
+    std::size_t first = std::min(size, RING_SIZE - ring_offset);
+    std::memcpy(ring_.get() + ring_offset, src, first);
+    std::memcpy(ring_.get(), src + first, size - first);
+}
+
+void WriteAheadLog::wait_for_space(Lsn end) {
+    space_waiters_.fetch_add(1);
+    
+    // Flusher мог уснуть до нашего fetch_add: будим под его мьютексом
+    {
+        std::lock_guard lock(flush_mutex_);
+    }
+    flush_cv_.notify_one();
+    
+    std::unique_lock lock(wait_mutex_);
+    space_cv_.wait(lock, [&] { return end <= released_pos_.load() + RING_SIZE; });
+    space_waiters_.fetch_sub(1);
+}
+
+bool WriteAheadLog::force(Lsn lsn) {
+    // Interval и None подтверждают запись, Per-commit и Group — fdatasync
+    return force_to(lsn, sync_config_.policy == SyncPolicy::PerCommit ||
+                         sync_config_.policy == SyncPolicy::Group);
+}
+
+bool WriteAheadLog::force_durable(Lsn lsn) {
+    return force_to(lsn, sync_config_.policy != SyncPolicy::None);
+}
+
+bool WriteAheadLog::force_to(Lsn lsn, bool durable) {
+    // INVALID_LSN — append не удался: подтверждать нечего
+    if (lsn == INVALID_LSN) {
+        return false;
+    }
+    
+    const auto& watermark = durable ? flushed_lsn_ : written_lsn_;
+    
+    lsn = std::min(lsn, reserve_pos_.load() - 1);
+    if (watermark.load() > lsn) {
+        return true;
+    }
+    
+    {
+        std::lock_guard lock(flush_mutex_);
+        if (!initialized_.load(std::memory_order_acquire) || stopping_.load()) {
+            Logger::error("WAL: force to LSN {} after shutdown", lsn);
+            return false;
+        }
+        requested_lsn_ = std::max(requested_lsn_, lsn);
+    }
+    flush_cv_.notify_one();
+    
+    std::unique_lock lock(wait_mutex_);
+    flushed_cv_.wait(lock, [&] { return watermark.load() > lsn || write_failed_.load(); });
+    if (watermark.load() <= lsn) {
+        Logger::error("WAL: force to LSN {} failed", lsn);
+        return false;
+    }
+    return true;
+}
+
+Lsn WriteAheadLog::collect_published(Lsn from) {
+    constexpr std::size_t slots = RING_SIZE / RECORD_ALIGN;
+    
+    // Не дальше кольца: за его пределами слоты принадлежат следующему кругу
+    Lsn limit = from + RING_SIZE;
+    Lsn pos = from;
+    while (pos < limit) {
+        auto& slot = published_[(pos / RECORD_ALIGN) & (slots - 1)];
+        uint32_t size = slot.load(std::memory_order_acquire);
+        if (size == 0) {
+            break;
+        }
+        slot.store(0, std::memory_order_relaxed);
+        pos += size;
+    }
+    return pos;
+}
+
+void WriteAheadLog::flusher_loop() {
+    // Какой watermark ждут commit'ы (см. force())
+    bool durable = sync_config_.policy == SyncPolicy::PerCommit ||
+                   sync_config_.policy == SyncPolicy::Group;
+    const auto& watermark = durable ? flushed_lsn_ : written_lsn_;
+    
+    // Граница разобранных записей; отстаёт от written_lsn_ только после
+    // ошибки записи
+    Lsn collected = written_lsn_.load();
+    
+    for (;;) {
+        Lsn requested;
+        bool stopping;
+        {
+            std::unique_lock lock(flush_mutex_);
+            auto has_work = [&] {
+                return stopping_.load() ||
+                       (requested_lsn_ >= watermark.load() && !write_failed_.load()) ||
+                       reserve_pos_.load() - collected >= WRITE_CHUNK;
+            };
+            if (sync_config_.policy == SyncPolicy::Interval) {
+                flush_cv_.wait_for(lock, sync_config_.interval, has_work);
+            } else {
+                flush_cv_.wait(lock, has_work);
+            }
+            requested = requested_lsn_;
+            stopping = stopping_.load();
+        }
+        
+        // Group: лидер-flusher ждёт попутчиков, пока они дописывают
+        // свои commit-записи в кольцо
+        if (sync_config_.policy == SyncPolicy::Group && !stopping &&
+            requested >= watermark.load()) {
+            std::this_thread::sleep_for(sync_config_.group_window);
+        }
+        
+        // Пишем только непрерывный готовый префикс: за незавершённой
+        // записью другого потока ждём следующего прохода
+        Lsn begin = collected;
+        Lsn end = collect_published(begin);
+        if (end > begin) {
+            // После ошибки записи лог не продолжаем: за дырой нет durable LSN
+            if (!write_failed_.load()) {
+                flush_count_.fetch_add(1, std::memory_order_relaxed);
+                if (write_range(begin, end)) {
+                    written_lsn_.store(end);
+                    metrics_->current_wal_size.store(end - log_start_.load(), std::memory_order_relaxed);
+                } else {
+                    write_failed_.store(true);
+                }
+            }
+            collected = end;
+            
+            // Записанная часть кольца свободна для новых записей
+            released_pos_.store(end);
+            if (space_waiters_.load() > 0) {
+                {
+                    std::lock_guard lock(wait_mutex_);
+                }
+                space_cv_.notify_all();
+            }
+        }
+        
+        // fdatasync: по запросу commit'а (PerCommit/Group), по таймеру
+        // (Interval) и всегда при остановке
+        Lsn written = written_lsn_.load();
+        bool need_sync = false;
+        switch (sync_config_.policy) {
+            case SyncPolicy::None:
+                flushed_lsn_.store(written);
+                break;
+            case SyncPolicy::PerCommit:
+            case SyncPolicy::Group:
+                need_sync = requested >= flushed_lsn_.load() || stopping;
+                break;
+            case SyncPolicy::Interval:
+                need_sync = stopping || std::chrono::steady_clock::now() - last_sync_ >=
+                                        sync_config_.interval;
+                break;
+        }
+        
+        if (need_sync && written > flushed_lsn_.load() && !write_failed_.load()) {
+            if (timed_sync(segment_fd_)) {
+                flushed_lsn_.store(written);
+            } else {
+                write_failed_.store(true);
+            }
+            last_sync_ = std::chrono::steady_clock::now();
+        }
+        
+        {
+            std::lock_guard lock(wait_mutex_);
+        }
+        flushed_cv_.notify_all();
+        
+        if (stopping && collected == reserve_pos_.load()) {
+            return;
+        }
+        
+        // Ждём, пока другой поток допишет запись, закрывающую дыру
+        if (end == begin && reserve_pos_.load() > collected) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool WriteAheadLog::write_range(Lsn from, Lsn to) {
+    Lsn pos = from;
+    while (pos < to) {
+        // Участок одного сегмента: не больше двух кусков кольца
+        uint64_t segment_id = pos / segment_size_;
+        Lsn segment_end = std::min<Lsn>(to, (segment_id + 1) * segment_size_);
+        
+        int fd = segment_fd(segment_id);
+        if (fd < 0) {
+            return false;
+        }
+        
+        std::vector<iovec> iov;
+        std::vector<uint64_t> offsets;
+        while (pos < segment_end) {
+            std::size_t ring_offset = pos & (RING_SIZE - 1);
+            std::size_t len = std::min<std::size_t>({segment_end - pos,
+                                                     RING_SIZE - ring_offset,
+                                                     WRITE_CHUNK});
+            iov.push_back({ring_.get() + ring_offset, len});
+            offsets.push_back(pos % segment_size_);
+            pos += len;
+        }
+        
+        if (!io_backend_) {
+            for (std::size_t i = 0; i < iov.size(); ++i) {
+                if (!write_full(fd, static_cast<const char*>(iov[i].iov_base),
+                                iov[i].iov_len, offsets[i])) {
+                    Logger::error("WAL: write to segment {} failed: {}",
+                                  segment_id, std::strerror(errno));
+                    return false;
+                }
+            }
+            continue;
+        }
+        
+        // Асинхронно: все блоки участка в полёте одновременно
+        std::vector<IoRequest> requests(iov.size());
+        std::atomic<bool> failed{false};
+        IoWaitGroup wait_group;
+        wait_group.add(iov.size());
+        
+        for (std::size_t i = 0; i < iov.size(); ++i) {
+            std::size_t len = iov[i].iov_len;
+            
+            IoRequest& request = requests[i];
+            request.op = IoRequest::Op::Write;
+            request.fd = fd;
+            request.iov = &iov[i];
+            request.iov_count = 1;
+            request.offset = offsets[i];
+            request.callback = [&failed, &wait_group, len](int64_t result) {
+                if (result != static_cast<int64_t>(len)) {
+                    failed.store(true);
+                }
+                wait_group.done();
+            };
+        }
+        io_backend_->submit(requests);
+        wait_group.wait();
+        
+        if (failed.load()) {
+            Logger::error("WAL: async write to segment {} failed", segment_id);
+            return false;
+        }
+    }
+    return true;
+}
+
+int WriteAheadLog::segment_fd(uint64_t segment_id) {
+    if (segment_fd_ >= 0 && segment_fd_id_ == segment_id) {
+        return segment_fd_;
+    }
+    
+    // Хвост прежнего сегмента доводим до диска: дальнейшие fdatasync
+    // касаются только нового
+    if (segment_fd_ >= 0) {
+        if (sync_config_.policy != SyncPolicy::None && !timed_sync(segment_fd_)) {
+            return -1;
+        }
+        ::close(segment_fd_);
+        segment_fd_ = -1;
+    }
+    
+    // Обычно сегмент уже подготовлен; если preparer отстал — создаём
+    // сами. Остатки прежнего круга не обрезаем: их отсекает CRC
+    auto path = segment_path(segment_id);
+    bool created = false;
+    {
+        std::lock_guard lock(segments_mutex_);
+        segment_fd_ = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (segment_fd_ < 0 && errno == ENOENT) {
+            segment_fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+            created = segment_fd_ >= 0;
+        }
+    }
+    if (segment_fd_ < 0) {
+        Logger::error("WAL: failed to open segment {}: {}", path.string(), std::strerror(errno));
+        return -1;
+    }
+    segment_fd_id_ = segment_id;
+    
+    if (created) {
+        Logger::warn("WAL: segment {} was not prepared in advance", segment_id);
+        preallocate(segment_fd_, segment_size_, false);
+        
+        // Запись о новом файле в каталоге тоже должна пережить сбой
+        if (sync_config_.policy != SyncPolicy::None) {
+            sync_directory(wal_dir_);
         }
     }
     
-    // Пишем запись
-    current_segment_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
-    current_segment_pos_ += buffer.size();
+    {
+        std::lock_guard lock(prepare_mutex_);
+        current_segment_.store(segment_id);
+    }
+    prepare_cv_.notify_one();
     
-    uint64_t new_size = current_size_.fetch_add(buffer.size()) + buffer.size();
-    metrics_->current_wal_size.store(new_size);
+    Logger::debug("WAL: rotated to segment {}", segment_id);
+    return segment_fd_;
+}
+
+void WriteAheadLog::preparer_loop() {
+    while (true) {
+        {
+            std::unique_lock lock(prepare_mutex_);
+            prepare_cv_.wait(lock, [this] {
+                return stopping_.load() ||
+                       prepared_until_ < current_segment_.load() + PREPARED_SEGMENTS;
+            });
+            if (stopping_.load()) {
+                return;
+            }
+        }
+        
+        uint64_t segment_id = std::max(prepared_until_, current_segment_.load()) + 1;
+        prepare_segment(segment_id);
+        prepared_until_ = segment_id;
+    }
+}
+
+void WriteAheadLog::prepare_segment(uint64_t segment_id) {
+    auto target = segment_path(segment_id);
+    std::error_code ec;
     
-    return rec.lsn;
+    // Запасной сегмент уже выделен и записан целиком
+    auto spares = spare_segments();
+    if (!spares.empty()) {
+        std::lock_guard lock(segments_mutex_);
+        if (!std::filesystem::exists(target)) {
+            std::filesystem::rename(spares.front(), target, ec);
+        }
+    } else {
+        // Новый файл заполняется нулями под временным именем: flusher
+        // не должен открыть его недоготовленным
+        auto tmp_path = wal_dir_ / "wal_new.tmp";
+        int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            Logger::error("WAL: failed to create {}: {}", tmp_path.string(), std::strerror(errno));
+            return;
+        }
+        bool ok = preallocate(fd, segment_size_, true) &&
+                  (sync_config_.policy == SyncPolicy::None || ::fdatasync(fd) == 0);
+        ::close(fd);
+        if (!ok) {
+            Logger::error("WAL: failed to preallocate segment {}", segment_id);
+            std::filesystem::remove(tmp_path, ec);
+            return;
+        }
+        
+        // Если flusher успел создать сегмент сам — файл идёт в запас
+        std::lock_guard lock(segments_mutex_);
+        if (std::filesystem::exists(target)) {
+            target = wal_dir_ / ("wal_spare_new_" + std::to_string(segment_id));
+        }
+        std::filesystem::rename(tmp_path, target, ec);
+    }
+    
+    if (ec) {
+        Logger::error("WAL: failed to prepare segment {}: {}", segment_id, ec.message());
+        return;
+    }
+    if (sync_config_.policy != SyncPolicy::None) {
+        sync_directory(wal_dir_);
+    }
+    Logger::debug("WAL: prepared segment {}", segment_id);
 }
 
-void WriteAheadLog::force(Lsn lsn) {
-    std::lock_guard lock(append_mutex_);
-    current_segment_.flush();
-    flushed_lsn_.store(lsn);
+bool WriteAheadLog::timed_sync(int fd) {
+    auto start = std::chrono::steady_clock::now();
+    int rc = ::fdatasync(fd);
+    sync_latency_.record(std::chrono::steady_clock::now() - start);
+    
+    if (rc != 0) {
+        Logger::error("WAL: fdatasync of segment {} failed: {}",
+                      segment_fd_id_, std::strerror(errno));
+        return false;
+    }
+    return true;
 }
 
 Lsn WriteAheadLog::write_checkpoint_begin() {
@@ -212,74 +1348,174 @@ Lsn WriteAheadLog::write_checkpoint_begin() {
     return lsn;
 }
 
-Lsn WriteAheadLog::write_checkpoint_end(Lsn begin_lsn) {
-    LogRecord rec;
-    rec.type = LogRecordType::CHECKPOINT_END;
-    rec.txn_id = 0;
-    rec.page_id = INVALID_PAGE_ID;
-    rec.prev_lsn = begin_lsn;
+Lsn WriteAheadLog::write_checkpoint_end(Lsn begin_lsn, const CheckpointData& data) {
+    // Цепочка частей: запись больше кольца append() не примет
+    Lsn lsn = begin_lsn;
+    for (const auto& part : data.split(CHECKPOINT_CHUNK_ENTRIES)) {
+        LogRecord rec;
+        rec.type = LogRecordType::CHECKPOINT_END;
+        rec.txn_id = 0;
+        rec.page_id = INVALID_PAGE_ID;
+        rec.prev_lsn = lsn;
+        rec.data = part.serialize();
+        
+        lsn = append(rec);
+        if (lsn == INVALID_LSN) {
+            Logger::error("WAL: failed to append CHECKPOINT_END (begin={})", begin_lsn);
+            return INVALID_LSN;
+        }
+    }
     
-    Lsn lsn = append(rec);
-    force(lsn);
+    // Master указывает только на checkpoint, END которого уже на диске
+    if (force_durable(lsn) && write_master(begin_lsn, lsn)) {
+        checkpoint_lsn_.store(begin_lsn);
+        checkpoint_end_lsn_.store(lsn);
+    }
     
-    Logger::debug("WAL: CHECKPOINT_END at LSN {} (begin={})", lsn, begin_lsn);
+    Logger::debug("WAL: CHECKPOINT_END at LSN {} (begin={}, dirty_pages={}, active_txns={})",
+                  lsn, begin_lsn, data.dirty_pages.size(), data.active_txns.size());
     return lsn;
 }
 
-void WriteAheadLog::truncate_before(Lsn lsn) {
-    std::lock_guard lock(append_mutex_);
-    (void)lsn;
+bool WriteAheadLog::write_master(Lsn checkpoint_lsn, Lsn end_lsn) {
+    auto tmp_path = wal_dir_ / (std::string(MASTER_FILE) + ".tmp");
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        Logger::error("WAL: failed to create {}: {}", tmp_path.string(), std::strerror(errno));
+        return false;
+    }
     
-    // Удаляем старые сегменты (упрощённая логика)
-    // В production нужно отслеживать LSN в каждом сегменте
+    bool durable = sync_config_.policy != SyncPolicy::None;
+    const Lsn master[2] = {checkpoint_lsn, end_lsn};
+    bool ok = write_full(fd, reinterpret_cast<const char*>(master), sizeof(master), 0) &&
+              (!durable || ::fdatasync(fd) == 0);
+    ::close(fd);
     
-    uint64_t freed = 0;
+    // rename атомарен: после сбоя виден прежний или новый master целиком
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tmp_path, wal_dir_ / MASTER_FILE, ec);
+    }
+    if (!ok || ec) {
+        Logger::error("WAL: failed to write master record");
+        return false;
+    }
     
+    if (durable) {
+        sync_directory(wal_dir_);
+    }
+    return true;
+}
+
+Lsn WriteAheadLog::recover_log_end() {
+    // До master-записи лог мог быть обрезан; без неё лог начинается с
+    // FIRST_LSN
+    Lsn pos = std::max(checkpoint_lsn_.load(), FIRST_LSN);
+    {
+        LogReader reader(wal_dir_, segment_size_);
+        LogRecord record;
+        while (reader.read(pos, record)) {
+            pos = LogReader::next_lsn(record);
+        }
+    }
+    
+    // Хвост за последней целой записью — недописанный при сбое. Его
+    // записи этого круга прошли бы проверку CRC, когда новые записи
+    // сомкнутся с ними: хвост обнуляем, сегменты после него удаляем
+    uint64_t last_segment = pos / segment_size_;
+    std::error_code ec;
     for (const auto& entry : std::filesystem::directory_iterator(wal_dir_)) {
-        auto filename = entry.path().filename().string();
-        if (filename.find("wal_") != 0) continue;
-        
-        try {
-            uint64_t seg_id = std::stoull(filename.substr(4));
-            // Удаляем сегменты кроме текущего и предыдущего
-            if (seg_id + 2 <= current_segment_id_) {
-                freed += entry.file_size();
-                std::filesystem::remove(entry.path());
-                Logger::debug("WAL: removed old segment {}", filename);
-            }
-        } catch (...) {
-            continue;
+        uint64_t seg_id;
+        if (parse_segment_id(entry.path(), seg_id) && seg_id > last_segment) {
+            Logger::debug("WAL: removing segment {} past end of log", seg_id);
+            std::filesystem::remove(entry.path(), ec);
+        } else if (entry.path().filename() == "wal_new.tmp") {
+            std::filesystem::remove(entry.path(), ec);
         }
     }
     
-    if (freed > 0) {
-        current_size_.fetch_sub(freed);
-        metrics_->current_wal_size.store(current_size_.load());
-        Logger::info("WAL: truncated {} bytes", freed);
+    auto path = segment_path(last_segment);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    bool ok = fd >= 0 &&
+              preallocate(fd, segment_size_, false) &&
+              zero_range(fd, pos % segment_size_, segment_size_) &&
+              (sync_config_.policy == SyncPolicy::None || ::fdatasync(fd) == 0);
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (!ok) {
+        Logger::error("WAL: failed to reset tail of segment {}: {}",
+                      path.string(), std::strerror(errno));
+        return INVALID_LSN;
+    }
+    if (sync_config_.policy != SyncPolicy::None) {
+        sync_directory(wal_dir_);
     }
+    
+    return pos;
 }
 
-bool WriteAheadLog::rotate_segment() {
-    current_segment_.flush();
-    current_segment_.close();
+void WriteAheadLog::truncate_before(Lsn lsn) {
+    // Сегмент удаляем, только если он целиком до lsn и уже записан
+    Lsn limit = std::min(lsn, written_lsn_.load());
+    Lsn new_start = limit / segment_size_ * segment_size_;
+    if (new_start <= log_start_.load()) {
+        return;
+    }
     
-    ++current_segment_id_;
-    current_segment_pos_ = 0;
+    // Записи удаляемых сегментов, ещё не прочитанные снимком таблицы
+    // транзакций, учитываются до удаления
+    {
+        std::lock_guard lock(att_mutex_);
+        if (!scan_transactions(new_start)) {
+            Logger::error("WAL: truncation skipped, transaction table is incomplete");
+            return;
+        }
+    }
     
-    auto path = segment_path(current_segment_id_);
-    current_segment_.open(path, std::ios::out | std::ios::binary);
+    uint64_t freed = 0;
+    std::size_t spares = spare_segments().size();
+    std::error_code ec;
     
-    if (!current_segment_.is_open()) {
-        Logger::error("WAL: failed to create new segment {}", path.string());
-        return false;
+    for (const auto& entry : std::filesystem::directory_iterator(wal_dir_)) {
+        uint64_t seg_id;
+        if (!parse_segment_id(entry.path(), seg_id)) continue;
+        
+        if ((seg_id + 1) * segment_size_ <= limit) {
+            // Освобождённый сегмент — запас для ротации, лишние удаляем
+            if (spares < PREPARED_SEGMENTS) {
+                std::filesystem::rename(
+                    entry.path(), wal_dir_ / ("wal_spare_" + std::to_string(seg_id)), ec);
+                ++spares;
+                Logger::debug("WAL: recycled old segment {}", entry.path().filename().string());
+            } else {
+                std::filesystem::remove(entry.path(), ec);
+                Logger::debug("WAL: removed old segment {}", entry.path().filename().string());
+            }
+            freed += segment_size_;
+        }
     }
     
-    Logger::debug("WAL: rotated to segment {}", current_segment_id_);
-    return true;
+    log_start_.store(new_start);
+    metrics_->current_wal_size.store(current_size());
+    if (freed > 0) {
+        Logger::info("WAL: truncated {} bytes", freed);
+    }
 }
 
 std::filesystem::path WriteAheadLog::segment_path(uint64_t segment_id) const {
     return wal_dir_ / ("wal_" + std::to_string(segment_id));
 }
 
+std::vector<std::filesystem::path> WriteAheadLog::spare_segments() const {
+    std::vector<std::filesystem::path> spares;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(wal_dir_, ec)) {
+        if (entry.path().filename().string().rfind("wal_spare_", 0) == 0) {
+            spares.push_back(entry.path());
+        }
+    }
+    return spares;
+}
+
 } // namespace datyredb::storage
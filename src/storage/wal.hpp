@@ -1,17 +1,49 @@
 #pragma once
 
 #include "storage/storage_types.hpp"
+#include "storage/io_backend.hpp"
 
+#include <condition_variable>
 #include <filesystem>
-#include <fstream>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <atomic>
 #include <memory>
+#include <optional>
 
 namespace datyredb::storage {
 
-/// WAL запись
+/// Представление data в LogRecord
+enum class LogDataFormat : uint8_t {
+    Images = 0,     // Образы всего диапазона
+    Runs = 1,       // Только изменённые отрезки диапазона
+};
+
+/// WAL запись.
+///
+/// INSERT/UPDATE/DELETE и CLR — физические изменения диапазона
+/// [offset, offset + length) в payload() страницы page_id. В формате
+/// Images data хранит образы диапазона:
+///   UPDATE — до изменения и после (2 * length байт);
+///   INSERT — только после (до — нули);
+///   DELETE — только до (после — нули);
+///   CLR    — записанное при откате (redo-only).
+/// prev_lsn — предыдущая запись транзакции; у CLR — следующая запись,
+/// которую нужно откатить (UndoNxtLSN в терминах ARIES).
+///
+/// Формат Runs — физиологическая дельта: последовательность отрезков
+/// (varint пропуск, varint длина, образы отрезка). Пропущенные байты
+/// одинаковы до и после изменения, поэтому redo и undo их не трогают и
+/// остаются идемпотентными. Образов на отрезок столько же, сколько в
+/// Images: у UPDATE — до и после, у остальных — один. Запись в формате
+/// Images WAL при сериализации сам кодирует в Runs, если так короче.
+///
+/// На диске: uint32 размер записи, uint32 CRC32C, тип, формат и
+/// varint-поля заголовка. LSN записи — её позиция в потоке лога и не
+/// хранится, но входит в CRC: запись сходится только на своём месте.
+/// prev_lsn хранится в единицах RECORD_ALIGN.
 struct LogRecord {
     LogRecordType type = LogRecordType::INVALID;
     Lsn lsn = INVALID_LSN;
@@ -20,24 +52,185 @@ struct LogRecord {
     uint16_t offset = 0;
     uint16_t length = 0;
     Lsn prev_lsn = INVALID_LSN;
+    LogDataFormat format = LogDataFormat::Images;
     std::vector<char> data;
     
+    /// Минимальный размер сериализованной записи
+    static constexpr std::size_t MIN_SERIALIZED_SIZE = 15;
+    
     /// Размер записи при сериализации
     std::size_t serialized_size() const;
     
     /// Сериализация в буфер
     void serialize(std::vector<char>& buffer) const;
     
-    /// Десериализация
-    static LogRecord deserialize(const char* data, std::size_t size);
+    /// Сериализация по адресу out (serialized_size() байт) с заданным
+    /// LSN — WAL выдаёт LSN в момент записи, не копируя запись
+    void serialize(char* out, Lsn record_lsn) const;
+    
+    /// Десериализация записи, сериализованной с LSN lsn; nullopt —
+    /// байты не являются целой записью
+    static std::optional<LogRecord> deserialize(const char* data, std::size_t size, Lsn lsn);
+    
+    /// Размер записи по её первым 4 байтам
+    static uint32_t peek_size(const char* data);
+    
+    /// Запись меняет страницу (нужна в redo)
+    bool modifies_page() const;
+    
+    /// Повторить изменение на payload страницы. Диапазон должен
+    /// помещаться в payload
+    void redo(char* payload) const;
+    
+    /// CLR, откатывающая изменение: redo-only образ, prev_lsn — UndoNxtLSN
+    LogRecord compensation() const;
+};
+
+/// Данные CHECKPOINT_END fuzzy checkpoint'а: таблица dirty pages и
+/// таблица активных транзакций, снятые после записи BEGIN. Страницы
+/// checkpoint не пишет — redo начинается с самого старого rec_lsn.
+///
+/// Последняя запись активной транзакции могла лечь в лог, а страница —
+/// ещё не стать dirty: redo начинается и не позже неё.
+///
+/// В data записи: varint-счётчики и varint-поля; LSN хранятся в
+/// единицах RECORD_ALIGN. Таблицы больше CHECKPOINT_CHUNK_ENTRIES
+/// записей пишутся цепочкой END (split()), recovery собирает их merge().
+struct CheckpointData {
+    std::vector<DirtyPageEntry> dirty_pages;
+    std::vector<ActiveTxn> active_txns;
+    
+    /// Начало redo: min(begin_lsn, rec_lsn страниц, last_lsn транзакций)
+    Lsn redo_lsn(Lsn begin_lsn) const;
+    
+    /// Граница обрезки лога: начало redo и начала цепочек undo
+    /// активных транзакций
+    Lsn truncation_lsn(Lsn begin_lsn) const;
+    
+    /// Сериализация в data записи
+    std::vector<char> serialize() const;
+    
+    /// nullopt — data повреждены
+    static std::optional<CheckpointData> deserialize(const std::vector<char>& data);
+    
+    /// Части не больше max_entries записей (хотя бы одна, пусть пустая)
+    std::vector<CheckpointData> split(std::size_t max_entries) const;
+    
+    /// Дописать таблицы части
+    void merge(CheckpointData&& part);
+};
+
+/// Чтение записей WAL из сегментов по LSN — для recovery.
+///
+/// Последовательное чтение идёт окнами по READ_CHUNK байт; запись,
+/// пересекающая границу сегмента, склеивается. Повреждённая или
+/// недописанная запись (размер вне диапазона, CRC не сходится с
+/// позицией, обрыв файла) считается концом лога.
+class LogReader {
+public:
+    /// Размер окна чтения
+    static constexpr std::size_t READ_CHUNK = 1024 * 1024;
+    
+    /// segment_size — как у WriteAheadLog::segment_size()
+    LogReader(const std::filesystem::path& wal_dir, std::size_t segment_size);
+    ~LogReader();
+    
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+    
+    /// Прочитать запись по lsn; false — конец лога или запись повреждена
+    bool read(Lsn lsn, LogRecord& record);
+    
+    /// LSN записи, следующей за record
+    static Lsn next_lsn(const LogRecord& record);
+    
+private:
+    /// Окно содержит [pos, pos + size); дочитывает из сегментов
+    bool fetch(Lsn pos, std::size_t size);
+    
+    /// Прочитать до size байт потока с позиции pos; возвращает прочитанное
+    std::size_t read_stream(Lsn pos, char* out, std::size_t size);
+    
+    std::filesystem::path wal_dir_;
+    std::size_t segment_size_;
+    
+    // Открытый сегмент
+    int fd_ = -1;
+    uint64_t fd_segment_ = 0;
+    
+    // Окно [window_start_, window_start_ + window_.size())
+    std::vector<char> window_;
+    Lsn window_start_ = INVALID_LSN;
 };
 
-/// Write-Ahead Log
+/// Write-Ahead Log с group commit и lock-free буфером лога.
+///
+/// Лог — непрерывный поток байт, нарезанный на сегменты wal_N по
+/// segment_size; LSN записи — смещение её начала в потоке. Записи
+/// выровнены по RECORD_ALIGN и могут пересекать границу сегмента.
+///
+/// append() резервирует место в кольцевом буфере одним fetch_add,
+/// сериализует запись прямо в кольцо и публикует её размер в
+/// side-массиве. Поток-flusher идёт по опубликованным записям,
+/// пишет только непрерывный готовый префикс и делает fdatasync:
+/// один fdatasync подтверждает commit'ы всех потоков, успевших
+/// записаться. force() только будит flusher и ждёт своего LSN.
+/// С асинхронным backend'ом блоки по WRITE_CHUNK байт уходят в полёт
+/// одновременно.
+///
+/// Durability задаёт SyncConfig: flushed_lsn() — граница в потоке,
+/// до которой лог доведён до стабильного носителя (для
+/// SyncPolicy::None — отдан ОС); записи с LSN < flushed_lsn() durable.
+///
+/// Сегменты всегда полного размера. Фоновый поток держит наготове
+/// PREPARED_SEGMENTS сегментов после текущего: заполненные нулями новые
+/// файлы или сегменты, освобождённые truncate_before(), — их
+/// переименовывают в запасные wal_spare_N, а не удаляют. Ротация лишь
+/// открывает готовый файл: без создания, выделения блоков и fsync
+/// каталога, а fdatasync не меняет размер файла. Остатки прежнего круга
+/// в переиспользованном сегменте отсекает CRC записи с её LSN.
+///
+/// Таблицу активных транзакций для fuzzy checkpoint'а append() не ведёт:
+/// её строит active_transactions(), дочитывая лог с места прошлого
+/// снимка. Записи с LSN меньше BEGIN к этому моменту записаны, поэтому
+/// снимок видит каждую транзакцию, чья запись легла в лог до BEGIN, а
+/// append() остаётся одним fetch_add без блокировок.
 class WriteAheadLog {
 public:
+    /// Выравнивание записей в потоке лога
+    static constexpr std::size_t RECORD_ALIGN = 8;
+    
+    /// LSN первой записи нового лога (0 — INVALID_LSN)
+    static constexpr Lsn FIRST_LSN = RECORD_ALIGN;
+    
+    /// Размер блока записи в сегмент
+    static constexpr std::size_t WRITE_CHUNK = 64 * 1024;
+    
+    /// Ёмкость кольцевого буфера (степень двойки): append() ждёт
+    /// flusher, если тот отстал на весь буфер
+    static constexpr std::size_t RING_SIZE = 8 * 1024 * 1024;
+    
+    /// Записей таблиц checkpoint'а в одной END (не больше ~2MB data):
+    /// запись должна поместиться в кольцо
+    static constexpr std::size_t CHECKPOINT_CHUNK_ENTRIES = 64 * 1024;
+    
+    /// Master-файл с LSN последнего завершённого checkpoint'а
+    static constexpr const char* MASTER_FILE = "checkpoint";
+    
+    /// Готовых сегментов впереди текущего; столько же запасных хранится
+    /// для переиспользования
+    static constexpr std::size_t PREPARED_SEGMENTS = 2;
+    
+    /// Размер записи в потоке с учётом выравнивания
+    static std::size_t aligned_size(std::size_t size) {
+        return (size + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+    }
+    
     WriteAheadLog(const std::filesystem::path& wal_dir,
                   std::size_t segment_size,
-                  std::shared_ptr<CheckpointMetrics> metrics);
+                  std::shared_ptr<CheckpointMetrics> metrics,
+                  std::shared_ptr<IoBackend> io_backend = nullptr,
+                  SyncConfig sync_config = {});
     ~WriteAheadLog();
     
     // Запретить копирование
@@ -53,26 +246,55 @@ public:
     /// Записать лог запись
     Lsn append(const LogRecord& record);
     
-    /// Force WAL до указанного LSN
-    void force(Lsn lsn);
+    /// Force WAL до указанного LSN. Возвращается, когда запись lsn
+    /// durable по SyncPolicy (для Interval — после записи, без ожидания
+    /// fdatasync). false — запись не доведена: ошибка записи или
+    /// fdatasync, WAL закрыт, lsn == INVALID_LSN
+    bool force(Lsn lsn);
+    
+    /// Force с fdatasync при любой SyncPolicy, кроме None: правило
+    /// write-ahead перед записью страницы и END checkpoint'а
+    bool force_durable(Lsn lsn);
     
     /// Checkpoint BEGIN
     Lsn write_checkpoint_begin();
     
-    /// Checkpoint END
-    Lsn write_checkpoint_end(Lsn begin_lsn);
+    /// Checkpoint END с таблицами fuzzy checkpoint'а. После fdatasync
+    /// записи begin_lsn и LSN END сохраняются в master-файле: recovery
+    /// читает таблицы из END и начинает с них чтение лога.
+    ///
+    /// Большие таблицы — цепочка END по CHECKPOINT_CHUNK_ENTRIES записей:
+    /// prev_lsn первой — BEGIN, каждой следующей — предыдущая часть.
+    /// Возвращает LSN последней части (её хранит master)
+    Lsn write_checkpoint_end(Lsn begin_lsn, const CheckpointData& data = {});
+    
+    /// BEGIN последнего завершённого checkpoint'а (INVALID_LSN — не было)
+    Lsn checkpoint_lsn() const {
+        return checkpoint_lsn_.load(std::memory_order_relaxed);
+    }
+    
+    /// END последнего завершённого checkpoint'а
+    Lsn checkpoint_end_lsn() const {
+        return checkpoint_end_lsn_.load(std::memory_order_relaxed);
+    }
+    
+    /// Таблица активных транзакций по записям с LSN < before: дочитывает
+    /// лог с прошлого снимка (ждёт записи лога до before). false — лог
+    /// не прочитан до before, таблица неполна
+    bool active_transactions(Lsn before, std::vector<ActiveTxn>& out);
     
-    /// Обрезка WAL
+    /// Удалить сегменты, целиком лежащие до lsn
     void truncate_before(Lsn lsn);
     
     /// Текущий размер WAL
     uint64_t current_size() const { 
-        return current_size_.load(std::memory_order_relaxed); 
+        return reserve_pos_.load(std::memory_order_relaxed) -
+               log_start_.load(std::memory_order_relaxed); 
     }
     
-    /// Текущий LSN
+    /// LSN, который получит следующая запись
     Lsn current_lsn() const { 
-        return next_lsn_.load(std::memory_order_relaxed); 
+        return reserve_pos_.load(std::memory_order_relaxed); 
     }
     
     /// Flushed LSN
@@ -80,27 +302,137 @@ public:
         return flushed_lsn_.load(std::memory_order_relaxed);
     }
     
+    /// Латентность fdatasync сегментов
+    const LatencyHistogram& sync_latency() const { return sync_latency_; }
+    
+    /// Проходов flusher'а с записью; commit'ы / flush_count — средний
+    /// размер группы
+    uint64_t flush_count() const {
+        return flush_count_.load(std::memory_order_relaxed);
+    }
+    
+    /// Размер сегмента (кратен RECORD_ALIGN)
+    std::size_t segment_size() const { return segment_size_; }
+    
+    /// Каталог сегментов
+    const std::filesystem::path& wal_dir() const { return wal_dir_; }
+    
 private:
-    /// Переход к новому сегменту
-    bool rotate_segment();
+    /// Ждать, пока запись lsn будет записана (durable — и доведена
+    /// fdatasync до диска). false — не дождались
+    bool force_to(Lsn lsn, bool durable);
+    
+    /// Поток записи и fdatasync
+    void flusher_loop();
+    
+    /// Граница непрерывного опубликованного префикса, начиная с from;
+    /// поглощённые слоты side-массива обнуляются (поток flusher'а)
+    Lsn collect_published(Lsn from);
+    
+    /// Записать [from, to) потока из кольца в сегменты (поток flusher'а)
+    bool write_range(Lsn from, Lsn to);
+    
+    /// fd сегмента segment_id; прежний сегмент доводится до диска и
+    /// закрывается (поток flusher'а)
+    int segment_fd(uint64_t segment_id);
+    
+    /// Поток подготовки сегментов впрок
+    void preparer_loop();
+    
+    /// Подготовить сегмент segment_id из запасного или нового файла
+    void prepare_segment(uint64_t segment_id);
+    
+    /// Скопировать в кольцо size байт по позиции потока pos
+    void copy_to_ring(Lsn pos, const char* src, std::size_t size);
+    
+    /// Дождаться, пока flusher освободит кольцо под запись до end
+    void wait_for_space(Lsn end);
+    
+    /// fdatasync с записью латентности
+    bool timed_sync(int fd);
+    
+    /// Конец валидного лога: обход записей от последнего checkpoint'а.
+    /// Хвост за концом обнуляется, а сегменты после него удаляются:
+    /// их записи этого круга сошлись бы с CRC после новых записей
+    Lsn recover_log_end();
+    
+    /// Сохранить master-запись (BEGIN и END checkpoint'а) атомарной
+    /// заменой файла
+    bool write_master(Lsn checkpoint_lsn, Lsn end_lsn);
+    
+    /// Учесть записи [att_scanned_, until) в таблице активных транзакций
+    /// (под att_mutex_). false — лог не прочитан до until
+    bool scan_transactions(Lsn until);
+    
+    /// Учесть запись в таблице активных транзакций (под att_mutex_)
+    void track_txn(const LogRecord& record);
     
     /// Путь к сегменту
     std::filesystem::path segment_path(uint64_t segment_id) const;
     
+    /// Запасные сегменты wal_spare_N
+    std::vector<std::filesystem::path> spare_segments() const;
+    
     std::filesystem::path wal_dir_;
     std::size_t segment_size_;
     std::shared_ptr<CheckpointMetrics> metrics_;
+    std::shared_ptr<IoBackend> io_backend_;
+    SyncConfig sync_config_;
+    
+    // Кольцо и side-массив размеров: слот i — запись, начинающаяся в
+    // позиции кольца i * RECORD_ALIGN (0 — не опубликована)
+    std::unique_ptr<char[]> ring_;
+    std::unique_ptr<std::atomic<uint32_t>[]> published_;
+    
+    // Позиции в потоке
+    alignas(64) std::atomic<Lsn> reserve_pos_{FIRST_LSN};   // следующая свободная
+    alignas(64) std::atomic<Lsn> released_pos_{FIRST_LSN};  // кольцо свободно до
+    alignas(64) std::atomic<Lsn> written_lsn_{FIRST_LSN};   // отдано ОС до
+    std::atomic<Lsn> flushed_lsn_{FIRST_LSN};               // durable до
+    std::atomic<bool> write_failed_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<Lsn> log_start_{0};  // начало самого старого сегмента
+    std::atomic<Lsn> checkpoint_lsn_{INVALID_LSN};
+    std::atomic<Lsn> checkpoint_end_lsn_{INVALID_LSN};
+    
+    // Таблица активных транзакций: txn_id -> первая и последняя запись;
+    // учтены записи до att_scanned_
+    std::mutex att_mutex_;
+    std::unordered_map<TxnId, ActiveTxn> att_;
+    Lsn att_scanned_ = FIRST_LSN;
+    
+    // Запросы force() и пробуждение flusher'а
+    std::mutex flush_mutex_;
+    std::condition_variable flush_cv_;
+    Lsn requested_lsn_ = INVALID_LSN;
+    
+    // Ожидание watermark'ов в force() и места в кольце в append()
+    std::mutex wait_mutex_;
+    std::condition_variable flushed_cv_;
+    std::condition_variable space_cv_;
+    std::atomic<int> space_waiters_{0};
+    
+    // Принадлежит flusher'у
+    std::thread flusher_;
+    int segment_fd_ = -1;
+    uint64_t segment_fd_id_ = 0;
+    std::chrono::steady_clock::time_point last_sync_;
     
-    std::fstream current_segment_;
-    uint64_t current_segment_id_ = 0;
-    std::size_t current_segment_pos_ = 0;
+    // Подготовка сегментов: текущий сегмент flusher'а и сколько готово
+    // после него. segments_mutex_ — появление файлов wal_N
+    std::thread preparer_;
+    std::mutex prepare_mutex_;
+    std::condition_variable prepare_cv_;
+    std::mutex segments_mutex_;
+    std::atomic<uint64_t> current_segment_{0};
+    uint64_t prepared_until_ = 0;  // принадлежит preparer'у
     
-    std::atomic<Lsn> next_lsn_{1};
-    std::atomic<Lsn> flushed_lsn_{0};
-    std::atomic<uint64_t> current_size_{0};
+    LatencyHistogram sync_latency_;
+    std::atomic<uint64_t> flush_count_{0};
     
-    std::mutex append_mutex_;
-    bool initialized_ = false;
+    // append() читает без мьютекса: release в initialize()/shutdown()
+    // публикует состояние, подготовленное до него
+    std::atomic<bool> initialized_{false};
 };
 
 } // namespace datyredb::storage
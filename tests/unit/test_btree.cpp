@@ -0,0 +1,505 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - B+tree Unit Tests                                                ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <gtest/gtest.h>
+
+#include "internal/storage/btree.hpp"
+#include "internal/storage/recovery.hpp"
+#include "internal/storage/buffer_pool.hpp"
+#include "internal/storage/disk_manager.hpp"
+#include "internal/storage/wal.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace datyredb::storage;
+
+namespace {
+
+/// Стек хранения с деревом
+struct Stack {
+    explicit Stack(const std::filesystem::path& dir, std::size_t pool_pages = 256) {
+        metrics = std::make_shared<CheckpointMetrics>();
+        disk_manager = std::make_shared<DiskManager>(dir);
+        disk_manager->initialize();
+        wal = std::make_shared<WriteAheadLog>(dir / "wal", 16 * 1024 * 1024, metrics);
+        wal->initialize();
+        buffer_pool = std::make_shared<BufferPool>(pool_pages, disk_manager, metrics,
+                                                   BufferPoolConfig{}, wal);
+        RecoveryManager recovery(wal, buffer_pool, disk_manager, RecoveryConfig{});
+        EXPECT_TRUE(recovery.recover());
+    }
+    
+    ~Stack() {
+        buffer_pool.reset();
+        wal->shutdown();
+        disk_manager->shutdown();
+    }
+    
+    TxnContext begin(TxnId txn_id) {
+        TxnContext txn;
+        txn.txn_id = txn_id;
+        LogRecord record;
+        record.type = LogRecordType::TXN_BEGIN;
+        record.txn_id = txn_id;
+        txn.last_lsn = wal->append(record);
+        return txn;
+    }
+    
+    void commit(TxnContext& txn) {
+        LogRecord record;
+        record.type = LogRecordType::TXN_COMMIT;
+        record.txn_id = txn.txn_id;
+        record.prev_lsn = txn.last_lsn;
+        wal->force(wal->append(record));
+        txn.undo.clear();
+    }
+    
+    /// Первое дерево стека — с корнем на странице 0
+    BTree open(TxnId txn_id = 1) {
+        if (disk_manager->page_count() == 0) {
+            TxnContext txn = begin(txn_id);
+            EXPECT_EQ(BTree::create(*buffer_pool, *wal, txn), 0u);
+            commit(txn);
+        }
+        return BTree(buffer_pool, wal, 0);
+    }
+    
+    std::vector<std::string> keys(const BTree& tree, std::string_view from = "") {
+        std::vector<std::string> out;
+        EXPECT_TRUE(tree.scan(from, [&](std::string_view key, RecordId) {
+            out.emplace_back(key);
+            return true;
+        }));
+        return out;
+    }
+    
+    std::shared_ptr<CheckpointMetrics> metrics;
+    std::shared_ptr<DiskManager> disk_manager;
+    std::shared_ptr<WriteAheadLog> wal;
+    std::shared_ptr<BufferPool> buffer_pool;
+};
+
+/// Выполнить body в дочернем процессе и выйти без flush — как при kill -9
+void run_and_crash(const std::filesystem::path& dir, const std::function<void(Stack&)>& body) {
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        auto* stack = new Stack(dir);
+        body(*stack);
+        ::_exit(0);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+}
+
+/// Ключи с нулями впереди: порядок строк совпадает с порядком чисел
+std::string key_of(std::size_t i) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "key-%08zu", i);
+    return buffer;
+}
+
+RecordId rid_of(std::size_t i) {
+    return RecordId{static_cast<PageId>(i / 100), static_cast<uint16_t>(i % 100)};
+}
+
+std::vector<std::size_t> shuffled(std::size_t count, unsigned seed = 42) {
+    std::vector<std::size_t> order(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(seed));
+    return order;
+}
+
+} // namespace
+
+class BTreeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "datyredb_btree_test";
+        std::filesystem::remove_all(test_dir_);
+    }
+    
+    void TearDown() override {
+        std::filesystem::remove_all(test_dir_);
+    }
+    
+    std::filesystem::path test_dir_;
+};
+
+// ==============================================================================
+// Поиск и изменения
+// ==============================================================================
+
+TEST_F(BTreeTest, InsertLookupAndDuplicateKeys) {
+    Stack stack(test_dir_);
+    BTree tree = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    ASSERT_TRUE(tree.insert(txn, "b", RecordId{7, 1}));
+    ASSERT_TRUE(tree.insert(txn, "a", RecordId{3, 0}));
+    ASSERT_TRUE(tree.insert(txn, "b", RecordId{2, 5}));
+    
+    // Пара (ключ, RecordId) уникальна; ключ — нет
+    EXPECT_FALSE(tree.insert(txn, "b", RecordId{7, 1}));
+    EXPECT_FALSE(tree.insert(txn, std::string(BTree::MAX_KEY_SIZE + 1, 'x'), RecordId{1, 1}));
+    stack.commit(txn);
+    
+    auto rids = tree.lookup("b");
+    ASSERT_EQ(rids.size(), 2u);
+    EXPECT_EQ(rids[0], (RecordId{2, 5}));
+    EXPECT_EQ(rids[1], (RecordId{7, 1}));
+    EXPECT_EQ(tree.lookup("a").size(), 1u);
+    EXPECT_TRUE(tree.lookup("c").empty());
+    EXPECT_EQ(tree.height(), 1u);
+}
+
+TEST_F(BTreeTest, SplitsKeepKeysOrdered) {
+    Stack stack(test_dir_, 64);
+    BTree tree = stack.open();
+    
+    constexpr std::size_t COUNT = 20000;
+    TxnContext txn = stack.begin(2);
+    for (std::size_t i : shuffled(COUNT)) {
+        ASSERT_TRUE(tree.insert(txn, key_of(i), rid_of(i)));
+        txn.undo.clear();
+    }
+    stack.commit(txn);
+    
+    EXPECT_GE(tree.height(), 3u);
+    auto keys = stack.keys(tree);
+    ASSERT_EQ(keys.size(), COUNT);
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    for (std::size_t i = 0; i < COUNT; i += 997) {
+        auto rids = tree.lookup(key_of(i));
+        ASSERT_EQ(rids.size(), 1u);
+        EXPECT_EQ(rids[0], rid_of(i));
+    }
+}
+
+TEST_F(BTreeTest, RangeScanFollowsSiblings) {
+    Stack stack(test_dir_);
+    BTree tree = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    for (std::size_t i = 0; i < 5000; ++i) {
+        ASSERT_TRUE(tree.insert(txn, key_of(i * 2), rid_of(i)));
+    }
+    stack.commit(txn);
+    
+    // От ключа, которого нет, до остановки по верхней границе
+    std::vector<std::string> range;
+    ASSERT_TRUE(tree.scan(key_of(1001), [&](std::string_view key, RecordId) {
+        if (key > key_of(3000)) {
+            return false;
+        }
+        range.emplace_back(key);
+        return true;
+    }));
+    ASSERT_EQ(range.size(), 1000u);
+    EXPECT_EQ(range.front(), key_of(1002));
+    EXPECT_EQ(range.back(), key_of(3000));
+    EXPECT_TRUE(stack.keys(tree, key_of(99999)).empty());
+}
+
+TEST_F(BTreeTest, RemoveEntries) {
+    Stack stack(test_dir_);
+    BTree tree = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    for (std::size_t i = 0; i < 3000; ++i) {
+        ASSERT_TRUE(tree.insert(txn, key_of(i), rid_of(i)));
+    }
+    for (std::size_t i = 0; i < 3000; i += 2) {
+        ASSERT_TRUE(tree.remove(txn, key_of(i), rid_of(i)));
+    }
+    EXPECT_FALSE(tree.remove(txn, key_of(0), rid_of(0)));
+    EXPECT_FALSE(tree.remove(txn, key_of(1), rid_of(2)));
+    
+    // Место удалённых записей снова занимается
+    for (std::size_t i = 0; i < 3000; i += 2) {
+        ASSERT_TRUE(tree.insert(txn, key_of(i), rid_of(i + 1)));
+    }
+    stack.commit(txn);
+    
+    EXPECT_EQ(stack.keys(tree).size(), 3000u);
+    EXPECT_EQ(tree.lookup(key_of(10)), std::vector<RecordId>{rid_of(11)});
+    EXPECT_EQ(tree.lookup(key_of(11)), std::vector<RecordId>{rid_of(11)});
+}
+
+TEST_F(BTreeTest, RollbackRestoresTree) {
+    Stack stack(test_dir_);
+    BTree tree = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    ASSERT_TRUE(tree.insert(txn, "kept", RecordId{1, 1}));
+    stack.commit(txn);
+    
+    TxnContext aborted = stack.begin(3);
+    for (std::size_t i = 0; i < 2000; ++i) {
+        ASSERT_TRUE(tree.insert(aborted, key_of(i), rid_of(i)));
+    }
+    ASSERT_TRUE(tree.remove(aborted, "kept", RecordId{1, 1}));
+    ASSERT_TRUE(HeapFile::rollback(*stack.buffer_pool, *stack.wal, aborted));
+    
+    EXPECT_EQ(stack.keys(tree), std::vector<std::string>{"kept"});
+    EXPECT_EQ(tree.height(), 1u);
+}
+
+// ==============================================================================
+// Bulk load
+// ==============================================================================
+
+TEST_F(BTreeTest, BulkLoadBuildsSearchableTree) {
+    Stack stack(test_dir_, 64);
+    BTree tree = stack.open();
+    
+    constexpr std::size_t COUNT = 30000;
+    IndexBuildConfig config;
+    config.fill_factor = 1.0;
+    TxnContext txn = stack.begin(2);
+    std::size_t next = 0;
+    ASSERT_TRUE(tree.bulk_load(txn, [&](IndexEntry& entry) {
+        if (next == COUNT) {
+            return false;
+        }
+        entry.key = key_of(next * 2);
+        entry.rid = rid_of(next);
+        ++next;
+        return true;
+    }, config));
+    stack.commit(txn);
+    
+    EXPECT_GE(tree.height(), 3u);
+    auto keys = stack.keys(tree);
+    ASSERT_EQ(keys.size(), COUNT);
+    EXPECT_EQ(keys.back(), key_of((COUNT - 1) * 2));
+    EXPECT_EQ(tree.lookup(key_of(4242)), std::vector<RecordId>{rid_of(2121)});
+    
+    // Полные после загрузки узлы делятся при вставке
+    TxnContext more = stack.begin(3);
+    for (std::size_t i = 0; i < 2000; ++i) {
+        ASSERT_TRUE(tree.insert(more, key_of(i * 2 + 1), rid_of(i)));
+    }
+    stack.commit(more);
+    EXPECT_EQ(stack.keys(tree).size(), COUNT + 2000);
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+}
+
+TEST_F(BTreeTest, BulkLoadHonorsFillFactor) {
+    constexpr std::size_t COUNT = 20000;
+    auto load = [&](double fill_factor) {
+        std::filesystem::remove_all(test_dir_);
+        Stack stack(test_dir_);
+        BTree tree = stack.open();
+        
+        IndexBuildConfig config;
+        config.fill_factor = fill_factor;
+        TxnContext txn = stack.begin(2);
+        std::size_t next = 0;
+        EXPECT_TRUE(tree.bulk_load(txn, [&](IndexEntry& entry) {
+            if (next == COUNT) {
+                return false;
+            }
+            entry.key = key_of(next);
+            entry.rid = rid_of(next);
+            ++next;
+            return true;
+        }, config));
+        stack.commit(txn);
+        EXPECT_EQ(stack.keys(tree).size(), COUNT);
+        return txn.allocated.size();
+    };
+    
+    std::size_t full = load(1.0);
+    std::size_t half = load(0.5);
+    EXPECT_GT(full, 0u);
+    EXPECT_GE(half * 10, full * 19);
+    EXPECT_LE(half * 10, full * 21);
+}
+
+TEST_F(BTreeTest, BulkLoadLogsOnlyRoot) {
+    Stack stack(test_dir_);
+    BTree tree = stack.open();
+    
+    // Узлы пишутся мимо лога: WAL растёт на изменение корня, не на дерево
+    constexpr std::size_t COUNT = 50000;
+    TxnContext txn = stack.begin(2);
+    Lsn before = stack.wal->current_lsn();
+    std::size_t next = 0;
+    ASSERT_TRUE(tree.bulk_load(txn, [&](IndexEntry& entry) {
+        if (next == COUNT) {
+            return false;
+        }
+        entry.key = key_of(next);
+        entry.rid = rid_of(next);
+        ++next;
+        return true;
+    }));
+    EXPECT_LT(stack.wal->current_lsn() - before, 3 * PAGE_SIZE);
+    EXPECT_GT(txn.allocated.size(), 100u);
+    stack.commit(txn);
+    
+    EXPECT_GE(tree.height(), 3u);
+    EXPECT_EQ(stack.keys(tree).size(), COUNT);
+    EXPECT_EQ(tree.lookup(key_of(31337)), std::vector<RecordId>{rid_of(31337)});
+}
+
+TEST_F(BTreeTest, BulkLoadRejectsUnsortedInput) {
+    Stack stack(test_dir_);
+    BTree tree = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    std::vector<std::string> input{"a", "c", "b"};
+    std::size_t next = 0;
+    EXPECT_FALSE(tree.bulk_load(txn, [&](IndexEntry& entry) {
+        if (next == input.size()) {
+            return false;
+        }
+        entry.key = input[next++];
+        entry.rid = RecordId{1, 0};
+        return true;
+    }));
+}
+
+// ==============================================================================
+// Конкурентность
+// ==============================================================================
+
+TEST_F(BTreeTest, ConcurrentInsertsAndLookups) {
+    Stack stack(test_dir_);
+    BTree tree = stack.open();
+    
+    // Читатели ищут заранее вставленные ключи, писатели добавляют свои
+    constexpr std::size_t PRELOADED = 5000;
+    constexpr std::size_t PER_WRITER = 5000;
+    constexpr std::size_t WRITERS = 4;
+    TxnContext txn = stack.begin(2);
+    for (std::size_t i = 0; i < PRELOADED; ++i) {
+        ASSERT_TRUE(tree.insert(txn, key_of(i * 10), rid_of(i)));
+    }
+    stack.commit(txn);
+    
+    std::atomic<bool> done{false};
+    std::atomic<std::size_t> misses{0};
+    std::vector<std::thread> threads;
+    for (std::size_t w = 0; w < WRITERS; ++w) {
+        threads.emplace_back([&, w] {
+            TxnContext writer = stack.begin(10 + w);
+            for (std::size_t i : shuffled(PER_WRITER, static_cast<unsigned>(w))) {
+                std::size_t n = i * 10 + w + 1;
+                if (!tree.insert(writer, key_of(n), rid_of(n))) {
+                    misses.fetch_add(1);
+                }
+                writer.undo.clear();
+            }
+            stack.commit(writer);
+        });
+    }
+    for (std::size_t r = 0; r < 2; ++r) {
+        threads.emplace_back([&, r] {
+            std::size_t i = r * 7919;
+            while (!done.load()) {
+                std::size_t n = (i % PRELOADED) * 10;
+                if (tree.lookup(key_of(n)) != std::vector<RecordId>{rid_of(n / 10)}) {
+                    misses.fetch_add(1);
+                }
+                i += 31;
+            }
+        });
+    }
+    for (std::size_t w = 0; w < WRITERS; ++w) {
+        threads[w].join();
+    }
+    done = true;
+    for (std::size_t t = WRITERS; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    
+    EXPECT_EQ(misses.load(), 0u);
+    auto keys = stack.keys(tree);
+    EXPECT_EQ(keys.size(), PRELOADED + WRITERS * PER_WRITER);
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    EXPECT_TRUE(std::adjacent_find(keys.begin(), keys.end()) == keys.end());
+}
+
+// ==============================================================================
+// Recovery
+// ==============================================================================
+
+TEST_F(BTreeTest, BulkLoadedTreeSurvivesCrash) {
+    constexpr std::size_t COUNT = 20000;
+    run_and_crash(test_dir_, [](Stack& stack) {
+        BTree tree = stack.open();
+        
+        TxnContext txn = stack.begin(2);
+        std::size_t next = 0;
+        tree.bulk_load(txn, [&](IndexEntry& entry) {
+            if (next == COUNT) {
+                return false;
+            }
+            entry.key = key_of(next);
+            entry.rid = rid_of(next);
+            ++next;
+            return true;
+        });
+        stack.commit(txn);
+        
+        // После commit'а — вставки поверх загруженных листьев
+        TxnContext more = stack.begin(3);
+        for (std::size_t i = COUNT; i < COUNT + 500; ++i) {
+            tree.insert(more, key_of(i), rid_of(i));
+        }
+        stack.commit(more);
+    });
+    
+    Stack stack(test_dir_);
+    BTree tree = stack.open();
+    auto keys = stack.keys(tree);
+    ASSERT_EQ(keys.size(), COUNT + 500);
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    EXPECT_EQ(tree.lookup(key_of(12345)), std::vector<RecordId>{rid_of(12345)});
+}
+
+TEST_F(BTreeTest, CommittedEntriesSurviveCrash) {
+    run_and_crash(test_dir_, [](Stack& stack) {
+        BTree tree = stack.open();
+        
+        TxnContext committed = stack.begin(2);
+        for (std::size_t i = 0; i < 3000; ++i) {
+            tree.insert(committed, key_of(i), rid_of(i));
+        }
+        stack.commit(committed);
+        
+        // Незакоммиченная транзакция — откатывается recovery
+        TxnContext loser = stack.begin(3);
+        for (std::size_t i = 3000; i < 4000; ++i) {
+            tree.insert(loser, key_of(i), rid_of(i));
+        }
+        tree.remove(loser, key_of(5), rid_of(5));
+        stack.wal->force(loser.last_lsn);
+        stack.buffer_pool->sync_all();
+    });
+    
+    Stack stack(test_dir_);
+    BTree tree = stack.open();
+    auto keys = stack.keys(tree);
+    ASSERT_EQ(keys.size(), 3000u);
+    EXPECT_EQ(keys.back(), key_of(2999));
+    EXPECT_EQ(tree.lookup(key_of(5)), std::vector<RecordId>{rid_of(5)});
+}
@@ -9,9 +9,15 @@
 #include "internal/storage/wal.hpp"
 #include "internal/storage/disk_manager.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
+#include <memory>
+#include <random>
 #include <thread>
-#include <chrono>
+#include <vector>
 
 using namespace datyredb::storage;
 
@@ -25,79 +31,148 @@ protected:
         metrics_ = std::make_shared<CheckpointMetrics>();
         
         disk_manager_ = std::make_shared<DiskManager>(test_dir_);
-        ASSERT_TRUE(disk_manager_->open().has_value());
+        disk_manager_->initialize();
         
         wal_ = std::make_shared<WriteAheadLog>(test_dir_ / "wal", 1024 * 1024, metrics_);
-        ASSERT_TRUE(wal_->open().has_value());
+        wal_->initialize();
         
-        buffer_pool_ = std::make_shared<BufferPool>(100, disk_manager_, metrics_);
+        buffer_pool_ = std::make_shared<BufferPool>(kPoolPages, disk_manager_, metrics_,
+                                                    BufferPoolConfig{}, wal_);
     }
     
     void TearDown() override {
-        if (checkpoint_manager_) {
-            checkpoint_manager_->stop();
-            checkpoint_manager_.reset();
-        }
+        checkpoint_manager_.reset();
         buffer_pool_.reset();
-        wal_->close();
-        wal_.reset();
-        disk_manager_->close();
-        disk_manager_.reset();
+        wal_->shutdown();
+        disk_manager_->shutdown();
         std::filesystem::remove_all(test_dir_);
     }
     
     void create_checkpoint_manager(CheckpointConfig config = {}) {
-        checkpoint_manager_ = std::make_shared<CheckpointManager>(
+        checkpoint_manager_ = std::make_unique<CheckpointManager>(
             config, buffer_pool_, wal_, metrics_
         );
     }
     
-    void create_dirty_pages(int count) {
-        for (int i = 0; i < count; ++i) {
-            auto result = buffer_pool_->new_page();
-            ASSERT_TRUE(result.has_value());
-            ASSERT_TRUE(buffer_pool_->unpin_page((*result)->id(), true).has_value());
+    /// fetch_page с повтором: страницы могут быть запинены фоновой записью
+    Page* pin(PageId page_id) {
+        for (int attempt = 0; attempt < 1000; ++attempt) {
+            if (Page* page = buffer_pool_->fetch_page(page_id)) {
+                return page;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return nullptr;
+    }
+    
+    Lsn log(LogRecordType type, TxnId txn, Lsn prev) {
+        LogRecord record;
+        record.type = type;
+        record.txn_id = txn;
+        record.prev_lsn = prev;
+        return wal_->append(record);
+    }
+    
+    void commit(TxnId txn, Lsn prev) {
+        wal_->force(log(LogRecordType::TXN_COMMIT, txn, prev));
+    }
+    
+    /// Транзакционное изменение: UPDATE в лог, затем в страницу
+    void update(TxnId txn, Lsn& prev, PageId page_id, int64_t value) {
+        while (disk_manager_->page_count() <= page_id) {
+            disk_manager_->allocate_page();
         }
+        Page* page = pin(page_id);
+        ASSERT_NE(page, nullptr);
+        
+        LogRecord record;
+        record.type = LogRecordType::UPDATE;
+        record.txn_id = txn;
+        record.page_id = page_id;
+        record.offset = 0;
+        record.length = sizeof(value);
+        record.prev_lsn = prev;
+        record.data.resize(2 * sizeof(value));
+        std::memcpy(record.data.data(), page->payload(), sizeof(value));
+        std::memcpy(record.data.data() + sizeof(value), &value, sizeof(value));
+        
+        prev = wal_->append(record);
+        std::memcpy(page->payload(), &value, sizeof(value));
+        page->set_lsn(prev);
+        buffer_pool_->unpin_page(page_id, true);
     }
     
+    /// count dirty страниц одной закоммиченной транзакцией
+    void create_dirty_pages(PageId count) {
+        Lsn prev = log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+        for (PageId i = 0; i < count; ++i) {
+            update(1, prev, i, static_cast<int64_t>(i));
+        }
+        commit(1, prev);
+    }
+    
+    static constexpr std::size_t kPoolPages = 100;
+    
     std::filesystem::path test_dir_;
     std::shared_ptr<CheckpointMetrics> metrics_;
     std::shared_ptr<DiskManager> disk_manager_;
     std::shared_ptr<WriteAheadLog> wal_;
     std::shared_ptr<BufferPool> buffer_pool_;
-    std::shared_ptr<CheckpointManager> checkpoint_manager_;
+    std::unique_ptr<CheckpointManager> checkpoint_manager_;
 };
 
 // ==============================================================================
 // Manual Checkpoint
 // ==============================================================================
 
-TEST_F(CheckpointTest, ManualCheckpointSync) {
+TEST_F(CheckpointTest, ManualCheckpointWritesDirtyPages) {
     create_checkpoint_manager();
     
     create_dirty_pages(10);
-    EXPECT_EQ(buffer_pool_->dirty_count(), 10);
-    EXPECT_EQ(metrics_->checkpoint_count.load(), 0);
+    EXPECT_EQ(buffer_pool_->dirty_page_count(), 10u);
+    EXPECT_EQ(metrics_->checkpoint_count.load(), 0u);
     
-    auto status = checkpoint_manager_->checkpoint_sync();
-    EXPECT_TRUE(status.has_value());
+    checkpoint_manager_->manual_checkpoint();
     
-    EXPECT_EQ(buffer_pool_->dirty_count(), 0);
-    EXPECT_EQ(metrics_->checkpoint_count.load(), 1);
-    EXPECT_GT(metrics_->pages_written.load(), 0);
+    EXPECT_EQ(buffer_pool_->dirty_page_count(), 0u);
+    EXPECT_EQ(metrics_->checkpoint_count.load(), 1u);
+    EXPECT_EQ(metrics_->pages_written_total.load(), 10u);
+    EXPECT_NE(wal_->checkpoint_lsn(), INVALID_LSN);
 }
 
 TEST_F(CheckpointTest, ManualCheckpointNoDirtyPages) {
     create_checkpoint_manager();
     
-    // No dirty pages
-    EXPECT_EQ(buffer_pool_->dirty_count(), 0);
+    EXPECT_EQ(buffer_pool_->dirty_page_count(), 0u);
     
-    auto status = checkpoint_manager_->checkpoint_sync();
-    EXPECT_TRUE(status.has_value());
+    checkpoint_manager_->manual_checkpoint();
     
-    EXPECT_EQ(metrics_->checkpoint_count.load(), 1);
-    EXPECT_EQ(metrics_->pages_written.load(), 0);
+    EXPECT_EQ(metrics_->checkpoint_count.load(), 1u);
+    EXPECT_EQ(metrics_->pages_written_total.load(), 0u);
+}
+
+TEST_F(CheckpointTest, CheckpointWritesInPageOrder) {
+    std::vector<PageId> pages;
+    for (PageId i = 0; i < 40; ++i) {
+        pages.push_back(i);
+    }
+    for (PageId i = 50; i < 60; ++i) {
+        pages.push_back(i);
+    }
+    std::shuffle(pages.begin(), pages.end(), std::mt19937(1));
+    
+    Lsn prev = log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+    for (PageId page_id : pages) {
+        update(1, prev, page_id, page_id);
+    }
+    commit(1, prev);
+    
+    create_checkpoint_manager();
+    checkpoint_manager_->manual_checkpoint();
+    
+    // Две последовательные серии вместо 50 случайных записей
+    EXPECT_EQ(metrics_->pages_written_total.load(), 50u);
+    EXPECT_EQ(metrics_->write_runs_total.load(), 2u);
 }
 
 // ==============================================================================
@@ -114,69 +189,77 @@ TEST_F(CheckpointTest, BackgroundCheckpointTimer) {
     
     create_dirty_pages(5);
     
-    // Wait for timer checkpoint
-    std::this_thread::sleep_for(std::chrono::seconds(3));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (metrics_->checkpoint_count.load() == 0 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
     
-    EXPECT_GT(metrics_->checkpoint_count.load(), 0);
+    EXPECT_GT(metrics_->checkpoint_count.load(), 0u);
 }
 
-TEST_F(CheckpointTest, BackgroundCheckpointRequest) {
-    CheckpointConfig config;
-    config.max_interval = std::chrono::seconds(300);  // Disable timer
-    config.min_interval = std::chrono::seconds(0);
+TEST_F(CheckpointTest, BackgroundWriterPacesSteadyLoad) {
+    constexpr PageId kHotPages = 88;
     
+    CheckpointConfig config;
+    config.background_flush_interval = std::chrono::milliseconds(10);
     create_checkpoint_manager(config);
     checkpoint_manager_->start();
     
-    create_dirty_pages(5);
-    
-    checkpoint_manager_->request_checkpoint();
+    // Ровный поток изменений по горячему набору больше целевой доли pool'а
+    std::size_t peak = 0;
+    Lsn prev = log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+    for (int i = 0; i < 1500; ++i) {
+        EXPECT_FALSE(checkpoint_manager_->check_pressure());
+        update(1, prev, static_cast<PageId>(i % kHotPages), i);
+        peak = std::max(peak, buffer_pool_->dirty_page_count());
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    commit(1, prev);
     
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_EQ(metrics_->blocking_checkpoint_count.load(), 0u);
+    EXPECT_LT(static_cast<float>(peak), config.dirty_page_soft_limit_pct * kPoolPages);
+    EXPECT_GT(metrics_->background_rounds.load(), 10u);
+    EXPECT_GT(metrics_->background_dirty_rate.load(), 0u);
+    EXPECT_GT(metrics_->background_wal_rate.load(), 0u);
+    EXPECT_GT(metrics_->background_pages_written.load(), 0u);
     
-    EXPECT_GT(metrics_->checkpoint_count.load(), 0);
+    checkpoint_manager_.reset();
+    EXPECT_EQ(buffer_pool_->dirty_page_count(), 0u);
 }
 
-// ==============================================================================
-// Soft Limit Trigger
-// ==============================================================================
-
-TEST_F(CheckpointTest, SoftLimitTrigger) {
-    CheckpointConfig config;
-    config.dirty_soft_limit = 0.10f;  // 10% = 10 pages (pool size 100)
-    config.min_interval = std::chrono::seconds(0);
-    config.max_interval = std::chrono::seconds(300);
+TEST_F(CheckpointTest, BackgroundWriterSpreadsPagesBeforeCheckpoint) {
+    create_dirty_pages(40);
     
+    // Поток изменений не растёт: пишутся только страницы, держащие обрезку
+    CheckpointConfig config;
+    config.max_interval = std::chrono::seconds(1);
+    config.background_target_dirty_pct = 0.9f;
     create_checkpoint_manager(config);
+    checkpoint_manager_->fuzzy_checkpoint();
     checkpoint_manager_->start();
     
-    // Create more than 10% dirty pages
-    create_dirty_pages(15);
-    
-    std::this_thread::sleep_for(std::chrono::seconds(3));
-    
-    EXPECT_GT(metrics_->checkpoint_count.load(), 0);
-    EXPECT_LT(buffer_pool_->dirty_count(), 15);
-}
-
-// ==============================================================================
-// Metrics
-// ==============================================================================
-
-TEST_F(CheckpointTest, Metrics) {
-    create_checkpoint_manager();
-    
-    create_dirty_pages(20);
-    
-    auto status = checkpoint_manager_->checkpoint_sync();
-    EXPECT_TRUE(status.has_value());
-    
-    EXPECT_EQ(metrics_->checkpoint_count.load(), 1);
-    EXPECT_GE(metrics_->pages_written.load(), 20);
-    EXPECT_GT(metrics_->total_duration_us.load(), 0);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (buffer_pool_->dirty_page_count() > 0 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
     
-    auto avg_duration = metrics_->average_duration();
-    EXPECT_GT(avg_duration.count(), 0);
+    // Равными долями за completion target, а не одним залпом
+    EXPECT_EQ(buffer_pool_->dirty_page_count(), 0u);
+    EXPECT_GE(metrics_->background_rounds.load(), 3u);
+    EXPECT_EQ(metrics_->background_pages_written.load(), 40u);
+    EXPECT_GT(metrics_->combined_pages_total.load(), 0u);
+    EXPECT_LT(metrics_->write_runs_total.load(), metrics_->background_pages_written.load());
+    
+    // Следующий checkpoint обрезает WAL до своего BEGIN
+    checkpoint_manager_->fuzzy_checkpoint();
+    LogReader reader(wal_->wal_dir(), wal_->segment_size());
+    LogRecord end;
+    ASSERT_TRUE(reader.read(wal_->checkpoint_end_lsn(), end));
+    auto data = CheckpointData::deserialize(end.data);
+    ASSERT_TRUE(data.has_value());
+    EXPECT_EQ(data->redo_lsn(wal_->checkpoint_lsn()), wal_->checkpoint_lsn());
 }
 
 // ==============================================================================
@@ -188,13 +271,12 @@ TEST_F(CheckpointTest, ShutdownCheckpoint) {
     checkpoint_manager_->start();
     
     create_dirty_pages(10);
-    EXPECT_EQ(buffer_pool_->dirty_count(), 10);
     
-    // Stop should do final checkpoint
-    checkpoint_manager_->stop();
+    // Остановка делает финальный checkpoint
+    checkpoint_manager_->shutdown();
     
-    EXPECT_EQ(buffer_pool_->dirty_count(), 0);
-    EXPECT_GT(metrics_->checkpoint_count.load(), 0);
+    EXPECT_EQ(buffer_pool_->dirty_page_count(), 0u);
+    EXPECT_GT(metrics_->checkpoint_count.load(), 0u);
 }
 
 // ==============================================================================
@@ -204,21 +286,21 @@ TEST_F(CheckpointTest, ShutdownCheckpoint) {
 TEST_F(CheckpointTest, ConcurrentPageCreation) {
     CheckpointConfig config;
     config.max_interval = std::chrono::seconds(1);
-    config.min_interval = std::chrono::seconds(0); // Using 0 for immediate effect
+    config.min_interval = std::chrono::seconds(0);
     
     create_checkpoint_manager(config);
     checkpoint_manager_->start();
     
     std::atomic<int> pages_created{0};
     
-    // Multiple threads creating pages
+    // Несколько потоков создают страницы
     std::vector<std::thread> threads;
     for (int t = 0; t < 4; ++t) {
         threads.emplace_back([this, &pages_created]() {
             for (int i = 0; i < 20; ++i) {
-                auto result = buffer_pool_->new_page();
-                if (result.has_value()) {
-                    (void)buffer_pool_->unpin_page((*result)->id(), true);
+                PageId page_id = INVALID_PAGE_ID;
+                if (buffer_pool_->new_page(&page_id)) {
+                    buffer_pool_->unpin_page(page_id, true);
                     pages_created.fetch_add(1);
                 }
                 std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -232,8 +314,8 @@ TEST_F(CheckpointTest, ConcurrentPageCreation) {
     
     EXPECT_GT(pages_created.load(), 0);
     
-    // Final checkpoint
-    checkpoint_manager_->stop();
+    // Финальный checkpoint
+    checkpoint_manager_->shutdown();
     
-    EXPECT_EQ(buffer_pool_->dirty_count(), 0);
+    EXPECT_EQ(buffer_pool_->dirty_page_count(), 0u);
 }
@@ -0,0 +1,177 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - Hash Index Unit Tests                                            ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <gtest/gtest.h>
+
+#include "internal/storage/hash_index.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace datyredb::storage;
+
+namespace {
+
+std::string key_of(std::size_t i) {
+    return "key-" + std::to_string(i);
+}
+
+RecordId rid_of(std::size_t i) {
+    return RecordId{static_cast<PageId>(i / 100 + 1), static_cast<uint16_t>(i % 100)};
+}
+
+bool contains(const std::vector<RecordId>& rids, RecordId rid) {
+    return std::any_of(rids.begin(), rids.end(), [&](RecordId r) {
+        return r.page_id == rid.page_id && r.slot == rid.slot;
+    });
+}
+
+} // namespace
+
+// ==============================================================================
+// Insert / remove / lookup
+// ==============================================================================
+
+TEST(HashIndexTest, InsertAndLookup) {
+    HashIndex index;
+    EXPECT_TRUE(index.insert("alpha", RecordId{1, 0}));
+    EXPECT_TRUE(index.insert("beta", RecordId{1, 1}));
+    EXPECT_EQ(index.size(), 2u);
+    
+    auto rids = index.lookup("alpha");
+    ASSERT_EQ(rids.size(), 1u);
+    EXPECT_EQ(rids[0].page_id, 1u);
+    EXPECT_EQ(rids[0].slot, 0u);
+    EXPECT_TRUE(index.lookup("gamma").empty());
+}
+
+TEST(HashIndexTest, DuplicateKeysKeepAllRecords) {
+    HashIndex index;
+    EXPECT_TRUE(index.insert("same", RecordId{1, 0}));
+    EXPECT_TRUE(index.insert("same", RecordId{2, 5}));
+    EXPECT_FALSE(index.insert("same", RecordId{1, 0}));
+    
+    auto rids = index.lookup("same");
+    EXPECT_EQ(rids.size(), 2u);
+    EXPECT_TRUE(contains(rids, RecordId{1, 0}));
+    EXPECT_TRUE(contains(rids, RecordId{2, 5}));
+}
+
+TEST(HashIndexTest, RemoveDropsOnlyThatRecord) {
+    HashIndex index;
+    index.insert("k", RecordId{1, 0});
+    index.insert("k", RecordId{1, 1});
+    
+    EXPECT_TRUE(index.remove("k", RecordId{1, 0}));
+    EXPECT_FALSE(index.remove("k", RecordId{1, 0}));
+    EXPECT_FALSE(index.remove("other", RecordId{1, 1}));
+    
+    auto rids = index.lookup("k");
+    ASSERT_EQ(rids.size(), 1u);
+    EXPECT_EQ(rids[0].slot, 1u);
+    EXPECT_EQ(index.size(), 1u);
+}
+
+// ==============================================================================
+// Resize
+// ==============================================================================
+
+TEST(HashIndexTest, GrowsIncrementallyWithoutLosingEntries) {
+    HashIndex index(4);
+    constexpr std::size_t count = 5000;
+    
+    bool saw_resizing = false;
+    for (std::size_t i = 0; i < count; ++i) {
+        ASSERT_TRUE(index.insert(key_of(i), rid_of(i)));
+        saw_resizing = saw_resizing || index.resizing();
+        
+        // Во время переноса видны и перенесённые, и оставшиеся корзины
+        if (i % 97 == 0) {
+            for (std::size_t j = 0; j <= i; j += 13) {
+                ASSERT_TRUE(contains(index.lookup(key_of(j)), rid_of(j))) << j;
+            }
+        }
+    }
+    EXPECT_TRUE(saw_resizing);
+    EXPECT_GE(index.bucket_count() * HashIndex::MAX_LOAD * 2, count);
+    
+    // Удаление посреди переноса
+    for (std::size_t i = 0; i < count; i += 2) {
+        ASSERT_TRUE(index.remove(key_of(i), rid_of(i)));
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(contains(index.lookup(key_of(i)), rid_of(i)), i % 2 == 1) << i;
+    }
+    EXPECT_EQ(index.size(), count / 2);
+}
+
+TEST(HashIndexTest, ReserveFinishesMigration) {
+    HashIndex index(4);
+    for (std::size_t i = 0; i < 100; ++i) {
+        index.insert(key_of(i), rid_of(i));
+    }
+    
+    index.reserve(10000);
+    EXPECT_FALSE(index.resizing());
+    EXPECT_GE(index.bucket_count(), 10000u);
+    for (std::size_t i = 0; i < 100; ++i) {
+        EXPECT_TRUE(contains(index.lookup(key_of(i)), rid_of(i)));
+    }
+    
+    // Места хватает: новые вставки рост не запускают
+    for (std::size_t i = 100; i < 5000; ++i) {
+        index.insert(key_of(i), rid_of(i));
+    }
+    EXPECT_FALSE(index.resizing());
+}
+
+// ==============================================================================
+// Concurrency
+// ==============================================================================
+
+TEST(HashIndexTest, ReadersSeeStableKeysDuringWrites) {
+    HashIndex index(4);
+    constexpr std::size_t stable = 2000;
+    constexpr std::size_t churn = 20000;
+    for (std::size_t i = 0; i < stable; ++i) {
+        index.insert(key_of(i), rid_of(i));
+    }
+    
+    // Писатель растит таблицу и удаляет свои ключи; постоянные ключи
+    // читатели должны находить всегда
+    std::atomic<bool> done{false};
+    std::atomic<std::size_t> misses{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            std::size_t i = static_cast<std::size_t>(t);
+            while (!done.load()) {
+                std::size_t k = i % stable;
+                if (!contains(index.lookup(key_of(k)), rid_of(k))) {
+                    misses.fetch_add(1);
+                }
+                i += 7;
+            }
+        });
+    }
+    
+    for (std::size_t i = stable; i < stable + churn; ++i) {
+        index.insert(key_of(i), rid_of(i));
+        if (i % 3 == 0) {
+            index.remove(key_of(i), rid_of(i));
+        }
+    }
+    done.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    
+    EXPECT_EQ(misses.load(), 0u);
+    for (std::size_t i = stable; i < stable + churn; ++i) {
+        EXPECT_EQ(contains(index.lookup(key_of(i)), rid_of(i)), i % 3 != 0);
+    }
+}
@@ -0,0 +1,463 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - Heap File Unit Tests                                             ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <gtest/gtest.h>
+
+#include "internal/storage/heap_file.hpp"
+#include "internal/storage/recovery.hpp"
+#include "internal/storage/buffer_pool.hpp"
+#include "internal/storage/disk_manager.hpp"
+#include "internal/storage/wal.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace datyredb::storage;
+
+namespace {
+
+/// Стек хранения с heap file'ом
+struct Stack {
+    explicit Stack(const std::filesystem::path& dir, std::size_t pool_pages = 64) {
+        metrics = std::make_shared<CheckpointMetrics>();
+        disk_manager = std::make_shared<DiskManager>(dir);
+        disk_manager->initialize();
+        wal = std::make_shared<WriteAheadLog>(dir / "wal", 1024 * 1024, metrics);
+        wal->initialize();
+        buffer_pool = std::make_shared<BufferPool>(pool_pages, disk_manager, metrics,
+                                                   BufferPoolConfig{}, wal);
+        RecoveryManager recovery(wal, buffer_pool, disk_manager, RecoveryConfig{});
+        EXPECT_TRUE(recovery.recover());
+    }
+    
+    ~Stack() {
+        buffer_pool.reset();
+        wal->shutdown();
+        disk_manager->shutdown();
+    }
+    
+    TxnContext begin(TxnId txn_id) {
+        TxnContext txn;
+        txn.txn_id = txn_id;
+        LogRecord record;
+        record.type = LogRecordType::TXN_BEGIN;
+        record.txn_id = txn_id;
+        txn.last_lsn = wal->append(record);
+        return txn;
+    }
+    
+    void commit(TxnContext& txn) {
+        LogRecord record;
+        record.type = LogRecordType::TXN_COMMIT;
+        record.txn_id = txn.txn_id;
+        record.prev_lsn = txn.last_lsn;
+        wal->force(wal->append(record));
+    }
+    
+    /// Первый heap file стека — на странице 0
+    HeapFile open(TxnId txn_id = 1) {
+        if (disk_manager->page_count() == 0) {
+            TxnContext txn = begin(txn_id);
+            EXPECT_EQ(HeapFile::create(*buffer_pool, *wal, txn), 0u);
+            commit(txn);
+        }
+        return HeapFile(buffer_pool, wal, 0);
+    }
+    
+    std::vector<std::string> records(const HeapFile& heap) {
+        std::vector<std::string> out;
+        EXPECT_TRUE(heap.scan([&](RecordId, std::string_view record) {
+            out.emplace_back(record);
+            return true;
+        }));
+        return out;
+    }
+    
+    std::shared_ptr<CheckpointMetrics> metrics;
+    std::shared_ptr<DiskManager> disk_manager;
+    std::shared_ptr<WriteAheadLog> wal;
+    std::shared_ptr<BufferPool> buffer_pool;
+};
+
+/// Выполнить body в дочернем процессе и выйти без flush — как при kill -9
+void run_and_crash(const std::filesystem::path& dir, const std::function<void(Stack&)>& body) {
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        auto* stack = new Stack(dir);
+        body(*stack);
+        ::_exit(0);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+}
+
+std::string record_of(std::size_t i, std::size_t size = 40) {
+    std::string record = "record-" + std::to_string(i) + "-";
+    record.resize(size, static_cast<char>('a' + i % 26));
+    return record;
+}
+
+} // namespace
+
+class HeapFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "datyredb_heap_file_test";
+        std::filesystem::remove_all(test_dir_);
+    }
+    
+    void TearDown() override {
+        std::filesystem::remove_all(test_dir_);
+    }
+    
+    std::filesystem::path test_dir_;
+};
+
+// ==============================================================================
+// Записи
+// ==============================================================================
+
+TEST_F(HeapFileTest, InsertGetAndScanInOrder) {
+    Stack stack(test_dir_);
+    HeapFile heap = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    std::vector<RecordId> rids;
+    for (std::size_t i = 0; i < 300; ++i) {
+        auto rid = heap.insert(txn, record_of(i));
+        ASSERT_TRUE(rid.has_value());
+        rids.push_back(*rid);
+    }
+    stack.commit(txn);
+    
+    // 300 записей по 40 байт не помещаются на одну страницу
+    EXPECT_NE(rids.front().page_id, rids.back().page_id);
+    EXPECT_EQ(heap.record_count(), 300u);
+    EXPECT_EQ(heap.data_bytes(), 300u * 40);
+    EXPECT_EQ(heap.get(rids[123]), record_of(123));
+    
+    auto all = stack.records(heap);
+    ASSERT_EQ(all.size(), 300u);
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        EXPECT_EQ(all[i], record_of(i));
+    }
+}
+
+TEST_F(HeapFileTest, UpdateAndRemoveKeepRecordIds) {
+    Stack stack(test_dir_);
+    HeapFile heap = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    std::vector<RecordId> rids;
+    for (std::size_t i = 0; i < 20; ++i) {
+        rids.push_back(*heap.insert(txn, record_of(i)));
+    }
+    
+    // Короче, длиннее (с уплотнением страницы) и пустая запись
+    ASSERT_TRUE(heap.update(txn, rids[3], "short"));
+    ASSERT_TRUE(heap.update(txn, rids[5], record_of(5, 600)));
+    ASSERT_TRUE(heap.update(txn, rids[7], ""));
+    ASSERT_TRUE(heap.remove(txn, rids[4]));
+    EXPECT_FALSE(heap.remove(txn, rids[4]));
+    EXPECT_FALSE(heap.get(rids[4]).has_value());
+    stack.commit(txn);
+    
+    EXPECT_EQ(heap.get(rids[3]), "short");
+    EXPECT_EQ(heap.get(rids[5]), record_of(5, 600));
+    EXPECT_EQ(heap.get(rids[7]), "");
+    EXPECT_EQ(heap.get(rids[19]), record_of(19));
+    EXPECT_EQ(heap.record_count(), 19u);
+    EXPECT_EQ(heap.data_bytes(), 16u * 40 + 5 + 600);
+}
+
+TEST_F(HeapFileTest, LargeRecordsUseOverflowPages) {
+    Stack stack(test_dir_);
+    HeapFile heap = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    std::string large = record_of(1, 3 * PAGE_SIZE);
+    auto rid = heap.insert(txn, large);
+    ASSERT_TRUE(rid.has_value());
+    
+    // Первая страница файла — заглушка, дальше цепочка из 4 страниц
+    EXPECT_EQ(rid->page_id, 0u);
+    EXPECT_EQ(stack.disk_manager->page_count(), 5u);
+    Page* overflow = stack.buffer_pool->fetch_page(1);
+    ASSERT_NE(overflow, nullptr);
+    EXPECT_TRUE(has_flag(overflow->flags(), PageFlags::OVERFLOW));
+    stack.buffer_pool->unpin_page(1, false);
+    EXPECT_EQ(heap.get(*rid), large);
+    
+    // Запись, не помещающаяся на заполненную страницу, уходит в
+    // overflow на месте
+    std::vector<RecordId> small;
+    while (small.size() < 60) {
+        small.push_back(*heap.insert(txn, record_of(small.size(), 60)));
+    }
+    ASSERT_EQ(small.back().page_id, 0u);
+    ASSERT_TRUE(heap.update(txn, small[0], record_of(0, 900)));
+    EXPECT_EQ(heap.get(small[0]), record_of(0, 900));
+    
+    ASSERT_TRUE(heap.update(txn, *rid, "inline again"));
+    stack.commit(txn);
+    
+    EXPECT_EQ(heap.get(*rid), "inline again");
+    EXPECT_EQ(stack.records(heap).size(), 61u);
+}
+
+TEST_F(HeapFileTest, TableLargerThanBufferPool) {
+    Stack stack(test_dir_, 16);
+    HeapFile heap = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    for (std::size_t i = 0; i < 2000; ++i) {
+        ASSERT_TRUE(heap.insert(txn, record_of(i, 200)).has_value());
+        txn.undo.clear();
+    }
+    stack.commit(txn);
+    
+    EXPECT_GT(stack.disk_manager->page_count(), 16u * 5);
+    auto all = stack.records(heap);
+    ASSERT_EQ(all.size(), 2000u);
+    EXPECT_EQ(all[1999], record_of(1999, 200));
+}
+
+TEST_F(HeapFileTest, RollbackRestoresPages) {
+    Stack stack(test_dir_);
+    HeapFile heap = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    RecordId kept = *heap.insert(txn, "kept");
+    stack.commit(txn);
+    
+    TxnContext aborted = stack.begin(3);
+    heap.insert(aborted, record_of(1, 5000));
+    heap.update(aborted, kept, "changed");
+    ASSERT_TRUE(HeapFile::rollback(*stack.buffer_pool, *stack.wal, aborted));
+    
+    EXPECT_EQ(heap.get(kept), "kept");
+    EXPECT_EQ(heap.record_count(), 1u);
+    EXPECT_EQ(stack.records(heap), std::vector<std::string>{"kept"});
+}
+
+TEST_F(HeapFileTest, RandomChangesKeepRecords) {
+    Stack stack(test_dir_);
+    HeapFile heap = stack.open();
+    
+    // Вставки в страницы с дырами, но без непрерывного места под слот
+    std::map<std::pair<PageId, uint16_t>, std::string> expected;
+    std::mt19937 rng(7);
+    TxnContext txn = stack.begin(2);
+    for (std::size_t i = 0; i < 3000; ++i) {
+        std::string record = record_of(i, 1 + rng() % 600);
+        if (expected.empty() || rng() % 3 == 0) {
+            auto rid = heap.insert(txn, record);
+            ASSERT_TRUE(rid.has_value());
+            expected[{rid->page_id, rid->slot}] = record;
+            continue;
+        }
+        
+        auto it = std::next(expected.begin(), static_cast<std::ptrdiff_t>(rng() % expected.size()));
+        RecordId rid{it->first.first, it->first.second};
+        if (rng() % 2 == 0) {
+            ASSERT_TRUE(heap.update(txn, rid, record));
+            it->second = record;
+        } else {
+            ASSERT_TRUE(heap.remove(txn, rid));
+            expected.erase(it);
+        }
+    }
+    stack.commit(txn);
+    
+    for (const auto& [key, record] : expected) {
+        EXPECT_EQ(heap.get(RecordId{key.first, key.second}), record);
+    }
+    EXPECT_EQ(stack.records(heap).size(), expected.size());
+}
+
+TEST_F(HeapFileTest, GetDuringUpdatesSeesWholeRecords) {
+    Stack stack(test_dir_);
+    HeapFile heap = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    std::vector<RecordId> rids;
+    for (std::size_t i = 0; i < 40; ++i) {
+        rids.push_back(*heap.insert(txn, record_of(i)));
+    }
+    stack.commit(txn);
+    
+    // Короткая, длинная (с уплотнением страницы) и overflow-версия
+    auto version = [](std::size_t i, int round) {
+        static const std::size_t sizes[] = {40, 300, 2 * PAGE_SIZE};
+        return record_of(i, sizes[round % 3]);
+    };
+    
+    // get() без блокировок видит одну из целых версий записи
+    std::atomic<bool> stop{false};
+    std::atomic<std::size_t> torn{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]() {
+            while (!stop.load()) {
+                for (std::size_t i = 0; i < rids.size(); ++i) {
+                    auto record = heap.get(rids[i]);
+                    bool whole = record && (*record == version(i, 0) || *record == version(i, 1) ||
+                                            *record == version(i, 2));
+                    if (!whole) {
+                        torn.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+    
+    // EXPECT, не ASSERT: ранний выход оставил бы читателей без join
+    for (int round = 0; round < 30; ++round) {
+        TxnContext writer = stack.begin(static_cast<TxnId>(3 + round));
+        for (std::size_t i = 0; i < rids.size(); i += 3) {
+            EXPECT_TRUE(heap.update(writer, rids[i], version(i, round)));
+        }
+        stack.commit(writer);
+    }
+    stop.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    
+    EXPECT_EQ(torn.load(), 0u);
+}
+
+// ==============================================================================
+// Свободное место
+// ==============================================================================
+
+TEST_F(HeapFileTest, EmptiedPagesFreedAndReused) {
+    Stack stack(test_dir_);
+    HeapFile heap = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    std::vector<RecordId> rids;
+    for (std::size_t i = 0; i < 400; ++i) {
+        rids.push_back(*heap.insert(txn, record_of(i, 200)));
+    }
+    rids.push_back(*heap.insert(txn, record_of(400, 3 * PAGE_SIZE)));
+    stack.commit(txn);
+    PageId pages = stack.disk_manager->page_count();
+    
+    // Всё, кроме первой записи: опустевшие страницы и overflow-цепочка
+    // выходят из файла, но до commit остаются занятыми
+    TxnContext removal = stack.begin(3);
+    for (std::size_t i = 1; i < rids.size(); ++i) {
+        ASSERT_TRUE(heap.remove(removal, rids[i]));
+    }
+    EXPECT_EQ(stack.disk_manager->free_page_count(), 0u);
+    stack.commit(removal);
+    HeapFile::release_pages(*stack.buffer_pool, removal, removal.last_lsn);
+    EXPECT_EQ(stack.disk_manager->free_page_count(), pages - 1);
+    EXPECT_EQ(stack.records(heap), std::vector<std::string>{record_of(0, 200)});
+    
+    // После точки redo страницы выдаются снова: файл не растёт
+    EXPECT_EQ(stack.disk_manager->recycle_pages(stack.wal->current_lsn()), pages - 1);
+    TxnContext again = stack.begin(4);
+    for (std::size_t i = 0; i < 400; ++i) {
+        ASSERT_TRUE(heap.insert(again, record_of(i, 200)).has_value());
+    }
+    stack.commit(again);
+    EXPECT_EQ(stack.disk_manager->page_count(), pages);
+    EXPECT_EQ(heap.record_count(), 401u);
+    EXPECT_EQ(stack.records(heap).back(), record_of(399, 200));
+}
+
+TEST_F(HeapFileTest, InsertFillsHolesBeforeGrowing) {
+    Stack stack(test_dir_);
+    HeapFile heap = stack.open();
+    
+    TxnContext txn = stack.begin(2);
+    std::vector<RecordId> rids;
+    for (std::size_t i = 0; i < 400; ++i) {
+        rids.push_back(*heap.insert(txn, record_of(i, 200)));
+    }
+    
+    // Каждая вторая запись: страницы наполовину пусты, но в цепочке
+    for (std::size_t i = 0; i < rids.size(); i += 2) {
+        ASSERT_TRUE(heap.remove(txn, rids[i]));
+    }
+    stack.commit(txn);
+    PageId pages = stack.disk_manager->page_count();
+    
+    TxnContext refill = stack.begin(3);
+    for (std::size_t i = 0; i < 150; ++i) {
+        ASSERT_TRUE(heap.insert(refill, record_of(i, 200)).has_value());
+    }
+    stack.commit(refill);
+    EXPECT_EQ(stack.disk_manager->page_count(), pages);
+    EXPECT_EQ(stack.records(heap).size(), 350u);
+}
+
+TEST_F(HeapFileTest, RollbackReturnsAllocatedPages) {
+    Stack stack(test_dir_);
+    HeapFile heap = stack.open();
+    
+    TxnContext aborted = stack.begin(2);
+    for (std::size_t i = 0; i < 100; ++i) {
+        heap.insert(aborted, record_of(i, 200));
+    }
+    PageId pages = stack.disk_manager->page_count();
+    ASSERT_TRUE(HeapFile::rollback(*stack.buffer_pool, *stack.wal, aborted));
+    
+    EXPECT_EQ(stack.disk_manager->free_page_count(), pages - 1);
+    EXPECT_EQ(heap.record_count(), 0u);
+    EXPECT_TRUE(stack.records(heap).empty());
+}
+
+// ==============================================================================
+// Recovery
+// ==============================================================================
+
+TEST_F(HeapFileTest, CommittedRecordsSurviveCrash) {
+    run_and_crash(test_dir_, [](Stack& stack) {
+        HeapFile heap = stack.open();
+        
+        TxnContext committed = stack.begin(2);
+        for (std::size_t i = 0; i < 200; ++i) {
+            heap.insert(committed, record_of(i));
+        }
+        heap.insert(committed, record_of(200, 10000));
+        stack.commit(committed);
+        
+        // Незакоммиченная транзакция — откатывается recovery
+        TxnContext loser = stack.begin(3);
+        for (std::size_t i = 0; i < 100; ++i) {
+            heap.insert(loser, record_of(1000 + i));
+        }
+        stack.wal->force(loser.last_lsn);
+        stack.buffer_pool->sync_all();
+    });
+    
+    Stack stack(test_dir_);
+    HeapFile heap = stack.open();
+    auto all = stack.records(heap);
+    ASSERT_EQ(all.size(), 201u);
+    EXPECT_EQ(all[0], record_of(0));
+    EXPECT_EQ(all[200], record_of(200, 10000));
+    EXPECT_EQ(heap.record_count(), 201u);
+    
+    // После recovery файл снова принимает записи
+    TxnContext txn = stack.begin(4);
+    ASSERT_TRUE(heap.insert(txn, "after recovery").has_value());
+    stack.commit(txn);
+    EXPECT_EQ(stack.records(heap).back(), "after recovery");
+}
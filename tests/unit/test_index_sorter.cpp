@@ -0,0 +1,182 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - Index Sorter Unit Tests                                          ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <gtest/gtest.h>
+
+#include "internal/storage/index_sorter.hpp"
+#include "internal/storage/buffer_pool.hpp"
+#include "internal/storage/disk_manager.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace datyredb::storage;
+
+namespace {
+
+std::string key_of(std::size_t i) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "key-%08zu", i);
+    return buffer;
+}
+
+/// Ключи в перемешанном порядке, у каждого — copies записей
+std::vector<IndexEntry> shuffled_entries(std::size_t keys, std::size_t copies) {
+    std::vector<IndexEntry> entries;
+    for (std::size_t i = 0; i < keys; ++i) {
+        for (std::size_t c = 0; c < copies; ++c) {
+            entries.push_back(IndexEntry{key_of(i), RecordId{static_cast<PageId>(c * 7 + 1),
+                                                             static_cast<uint16_t>(i % 100)}});
+        }
+    }
+    std::shuffle(entries.begin(), entries.end(), std::mt19937(7));
+    return entries;
+}
+
+bool less(const IndexEntry& a, const IndexEntry& b) {
+    if (a.key != b.key) {
+        return a.key < b.key;
+    }
+    return a.rid.page_id != b.rid.page_id ? a.rid.page_id < b.rid.page_id : a.rid.slot < b.rid.slot;
+}
+
+} // namespace
+
+class IndexSorterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "datyredb_index_sorter_test";
+        std::filesystem::remove_all(test_dir_);
+        
+        metrics_ = std::make_shared<CheckpointMetrics>();
+        disk_manager_ = std::make_shared<DiskManager>(test_dir_);
+        disk_manager_->initialize();
+        buffer_pool_ = std::make_shared<BufferPool>(64, disk_manager_, metrics_);
+    }
+    
+    void TearDown() override {
+        buffer_pool_.reset();
+        disk_manager_->shutdown();
+        std::filesystem::remove_all(test_dir_);
+    }
+    
+    /// Отсортировать entries сортировщиком с memory_pages frame'ами
+    std::vector<IndexEntry> sort(const std::vector<IndexEntry>& entries, std::size_t memory_pages,
+                                 std::size_t* runs = nullptr, std::size_t* passes = nullptr) {
+        IndexSorter sorter(*buffer_pool_, memory_pages, test_dir_);
+        for (const auto& entry : entries) {
+            EXPECT_TRUE(sorter.add(entry.key, entry.rid));
+        }
+        EXPECT_TRUE(sorter.finish());
+        
+        std::vector<IndexEntry> out;
+        IndexEntry entry;
+        while (sorter.next(entry)) {
+            out.push_back(entry);
+        }
+        EXPECT_FALSE(sorter.failed());
+        EXPECT_EQ(sorter.size(), entries.size());
+        if (runs) {
+            *runs = sorter.spilled_runs();
+        }
+        if (passes) {
+            *passes = sorter.merge_passes();
+        }
+        return out;
+    }
+    
+    std::filesystem::path test_dir_;
+    std::shared_ptr<CheckpointMetrics> metrics_;
+    std::shared_ptr<DiskManager> disk_manager_;
+    std::shared_ptr<BufferPool> buffer_pool_;
+};
+
+// ==============================================================================
+// Сортировка
+// ==============================================================================
+
+TEST_F(IndexSorterTest, SortsInMemoryWithoutSpill) {
+    auto entries = shuffled_entries(1000, 2);
+    std::size_t runs = 0;
+    auto out = sort(entries, 32, &runs);
+    
+    EXPECT_EQ(runs, 0u);
+    ASSERT_EQ(out.size(), entries.size());
+    EXPECT_TRUE(std::is_sorted(out.begin(), out.end(), less));
+}
+
+TEST_F(IndexSorterTest, SpillsRunsAndMergesInPasses) {
+    // 8 frame'ов: один под запись, семь — под элементы и входы слияния
+    auto entries = shuffled_entries(10000, 3);
+    std::size_t runs = 0;
+    std::size_t passes = 0;
+    auto out = sort(entries, 8, &runs, &passes);
+    
+    EXPECT_GT(runs, 7u);
+    EXPECT_GE(passes, 1u);
+    ASSERT_EQ(out.size(), entries.size());
+    EXPECT_TRUE(std::is_sorted(out.begin(), out.end(), less));
+    
+    // Одинаковые ключи — по возрастанию RecordId
+    EXPECT_EQ(out[0].key, key_of(0));
+    EXPECT_EQ(out[1].key, key_of(0));
+    EXPECT_LT(out[0].rid.page_id, out[1].rid.page_id);
+    EXPECT_EQ(out.back().key, key_of(9999));
+}
+
+TEST_F(IndexSorterTest, SingleMergePassWhenRunsFit) {
+    auto entries = shuffled_entries(3000, 1);
+    std::size_t runs = 0;
+    std::size_t passes = 0;
+    auto out = sort(entries, 16, &runs, &passes);
+    
+    EXPECT_GT(runs, 1u);
+    EXPECT_EQ(passes, 0u);
+    ASSERT_EQ(out.size(), entries.size());
+    EXPECT_TRUE(std::is_sorted(out.begin(), out.end(), less));
+}
+
+// ==============================================================================
+// Ограничения
+// ==============================================================================
+
+TEST_F(IndexSorterTest, RejectsTooLongKey) {
+    IndexSorter sorter(*buffer_pool_, 8, test_dir_);
+    EXPECT_TRUE(sorter.add("short", RecordId{1, 0}));
+    EXPECT_FALSE(sorter.add(std::string(BTree::MAX_KEY_SIZE + 1, 'x'), RecordId{1, 1}));
+    EXPECT_TRUE(sorter.failed());
+    EXPECT_FALSE(sorter.finish());
+}
+
+TEST_F(IndexSorterTest, ReturnsFramesToPool) {
+    {
+        IndexSorter sorter(*buffer_pool_, 60, test_dir_);
+        for (std::size_t i = 0; i < 100; ++i) {
+            ASSERT_TRUE(sorter.add(key_of(i), RecordId{1, static_cast<uint16_t>(i)}));
+        }
+        
+        // Занятые frame'ы pool'у недоступны
+        std::vector<PageId> pinned;
+        PageId page_id;
+        while (buffer_pool_->new_page(&page_id)) {
+            pinned.push_back(page_id);
+        }
+        EXPECT_EQ(pinned.size(), 4u);
+        for (PageId id : pinned) {
+            buffer_pool_->unpin_page(id, false);
+        }
+    }
+    
+    std::size_t created = 0;
+    PageId page_id;
+    while (created < 64 && buffer_pool_->new_page(&page_id)) {
+        ++created;
+    }
+    EXPECT_EQ(created, 64u);
+}
@@ -0,0 +1,124 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - Page Arena Unit Tests                                            ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <gtest/gtest.h>
+
+#include "internal/storage/page_arena.hpp"
+#include "internal/storage/page.hpp"
+#include "internal/storage/buffer_pool.hpp"
+#include "internal/storage/disk_manager.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+
+using namespace datyredb::storage;
+
+// ==============================================================================
+// Layout
+// ==============================================================================
+
+TEST(PageArenaTest, PagesAreAlignedAndContiguous) {
+    PageArena arena(16, HugePages::Off);
+    
+    EXPECT_EQ(arena.page_count(), 16);
+    EXPECT_EQ(arena.backing(), HugePages::Off);
+    EXPECT_GE(arena.mapped_size(), 16 * PAGE_SIZE);
+    
+    for (std::size_t i = 0; i < arena.page_count(); ++i) {
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(arena.page(i)) % PAGE_SIZE, 0u);
+        EXPECT_EQ(arena.page(i), arena.page(0) + i * PAGE_SIZE);
+    }
+}
+
+TEST(PageArenaTest, MemoryIsZeroedAndWritable) {
+    PageArena arena(4, HugePages::Off);
+    
+    for (std::size_t i = 0; i < arena.page_count(); ++i) {
+        EXPECT_EQ(arena.page(i)[0], 0);
+        EXPECT_EQ(arena.page(i)[PAGE_SIZE - 1], 0);
+        std::memset(arena.page(i), static_cast<int>(i + 1), PAGE_SIZE);
+    }
+    
+    // Страницы не перекрываются
+    for (std::size_t i = 0; i < arena.page_count(); ++i) {
+        EXPECT_EQ(arena.page(i)[0], static_cast<char>(i + 1));
+        EXPECT_EQ(arena.page(i)[PAGE_SIZE - 1], static_cast<char>(i + 1));
+    }
+}
+
+// ==============================================================================
+// Huge Pages
+// ==============================================================================
+
+TEST(PageArenaTest, HugePageModesRoundUpMapping) {
+    for (auto mode : {HugePages::Transparent, HugePages::Explicit}) {
+        PageArena arena(3, mode);
+        
+        EXPECT_EQ(arena.mapped_size() % PageArena::HUGE_PAGE_SIZE, 0u);
+        std::memset(arena.page(2), 0x5A, PAGE_SIZE);
+        EXPECT_EQ(static_cast<unsigned char>(arena.page(2)[PAGE_SIZE - 1]), 0x5A);
+    }
+}
+
+TEST(PageArenaTest, ExplicitFallsBackWhenHugeTlbUnavailable) {
+    // Без пула vm.nr_hugepages MAP_HUGETLB не проходит — арена всё равно создаётся
+    PageArena arena(8, HugePages::Explicit);
+    
+    EXPECT_NE(arena.page(0), nullptr);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(arena.page(7)) % PAGE_SIZE, 0u);
+}
+
+// ==============================================================================
+// Page Buffers
+// ==============================================================================
+
+TEST(PageArenaTest, OwnedBufferIsPageAligned) {
+    Page page;
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(page.data()) % PAGE_SIZE, 0u);
+}
+
+TEST(PageArenaTest, ViewUsesExternalBuffer) {
+    PageArena arena(1, HugePages::Off);
+    char* buffer = arena.page(0);
+    std::memset(buffer, 0xFF, PAGE_SIZE);
+    
+    {
+        Page view(buffer);
+        EXPECT_EQ(view.data(), buffer);
+        EXPECT_EQ(view.pin_count(), 0);
+        
+        // Буфер обнуляется при создании view
+        EXPECT_EQ(buffer[PAGE_SIZE - 1], 0);
+        
+        std::memset(view.payload(), 0xCD, 10);
+    }
+    
+    // View не освобождает и не трогает буфер при разрушении
+    EXPECT_EQ(static_cast<unsigned char>(buffer[PageHeader::SIZE]), 0xCD);
+}
+
+TEST(PageArenaTest, PageDataIsPageAligned) {
+    auto dir = std::filesystem::temp_directory_path() / "datyredb_arena_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    
+    auto disk_manager = std::make_shared<DiskManager>(dir);
+    ASSERT_TRUE(disk_manager->initialize());
+    {
+        BufferPoolConfig config;
+        config.huge_pages = HugePages::Off;
+        BufferPool pool(16, disk_manager, std::make_shared<CheckpointMetrics>(), config);
+        EXPECT_EQ(pool.huge_pages(), HugePages::Off);
+        
+        for (int i = 0; i < 16; ++i) {
+            Page* page = pool.new_page();
+            ASSERT_NE(page, nullptr);
+            EXPECT_EQ(reinterpret_cast<std::uintptr_t>(page->data()) % PAGE_SIZE, 0u);
+        }
+    }
+    disk_manager->shutdown();
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,34 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - Page Pin Unit Tests                                              ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <gtest/gtest.h>
+
+#include "internal/storage/page.hpp"
+
+using namespace datyredb::storage;
+
+// ==============================================================================
+// Exclusive ownership
+// ==============================================================================
+
+TEST(PagePinTest, ExclusiveBlocksTryPin) {
+    Page page;
+    EXPECT_TRUE(page.try_acquire_exclusive());
+    EXPECT_FALSE(page.try_pin());
+    EXPECT_FALSE(page.is_pinned());
+    
+    page.release_exclusive(1);
+    EXPECT_EQ(page.pin_count(), 1);
+    EXPECT_TRUE(page.try_pin());
+    EXPECT_EQ(page.pin_count(), 2);
+}
+
+TEST(PagePinTest, PinnedPageCannotBeAcquired) {
+    Page page;
+    page.pin();
+    EXPECT_FALSE(page.try_acquire_exclusive());
+    
+    page.unpin();
+    EXPECT_TRUE(page.try_acquire_exclusive());
+}
@@ -0,0 +1,125 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - Page Table Unit Tests                                            ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <gtest/gtest.h>
+
+#include "internal/storage/page_table.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace datyredb::storage;
+
+// ==============================================================================
+// Basic Operations
+// ==============================================================================
+
+TEST(PageTableTest, InsertAndFind) {
+    PageTable table(100);
+    
+    for (PageId id = 0; id < 100; ++id) {
+        table.insert(id * 3, id);
+    }
+    
+    EXPECT_EQ(table.size(), 100);
+    for (PageId id = 0; id < 100; ++id) {
+        EXPECT_EQ(table.find(id * 3), id);
+    }
+    EXPECT_EQ(table.find(1), PageTable::NOT_FOUND);
+}
+
+TEST(PageTableTest, UpdateExisting) {
+    PageTable table(10);
+    
+    table.insert(42, 1);
+    table.insert(42, 7);
+    
+    EXPECT_EQ(table.size(), 1);
+    EXPECT_EQ(table.find(42), 7);
+}
+
+TEST(PageTableTest, Erase) {
+    PageTable table(10);
+    
+    table.insert(42, 1);
+    EXPECT_TRUE(table.erase(42));
+    EXPECT_FALSE(table.erase(42));
+    EXPECT_EQ(table.find(42), PageTable::NOT_FOUND);
+    EXPECT_EQ(table.size(), 0);
+}
+
+TEST(PageTableTest, ChurnTriggersRebuild) {
+    PageTable table(64);
+    std::vector<PageId> current(64);
+    
+    for (PageId frame = 0; frame < 64; ++frame) {
+        current[frame] = frame;
+        table.insert(frame, frame);
+    }
+    
+    // Много циклов erase/insert — tombstone'ы должны вычищаться rebuild'ом
+    PageId next_id = 64;
+    for (int round = 0; round < 10000; ++round) {
+        std::size_t frame = static_cast<std::size_t>(round) % 64;
+        ASSERT_TRUE(table.erase(current[frame]));
+        current[frame] = next_id++;
+        table.insert(current[frame], frame);
+    }
+    
+    EXPECT_EQ(table.size(), 64);
+    for (std::size_t frame = 0; frame < 64; ++frame) {
+        EXPECT_EQ(table.find(current[frame]), frame);
+    }
+}
+
+// ==============================================================================
+// Concurrency
+// ==============================================================================
+
+TEST(PageTableTest, ReadersNeverSeeForeignMapping) {
+    PageTable table(256);
+    std::mutex writer_latch;
+    
+    // Стабильные записи: page_id == frame
+    for (PageId id = 0; id < 128; ++id) {
+        table.insert(id, id);
+    }
+    
+    std::atomic<bool> stop{false};
+    std::atomic<int> errors{0};
+    
+    std::thread writer([&] {
+        for (PageId round = 0; round < 50000; ++round) {
+            std::lock_guard lock(writer_latch);
+            PageId id = 1000 + round % 128;
+            table.insert(id, id);
+            table.erase(id);
+        }
+        stop = true;
+    });
+    
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                for (PageId id = 0; id < 128; ++id) {
+                    std::size_t frame = table.find(id);
+                    // Стабильная запись может быть не найдена только во время rebuild
+                    if (frame != PageTable::NOT_FOUND && frame != id) {
+                        errors.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+    
+    writer.join();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    
+    EXPECT_EQ(errors.load(), 0);
+}
@@ -0,0 +1,151 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - Read-Ahead Unit Tests                                            ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <gtest/gtest.h>
+
+#include "internal/storage/buffer_pool.hpp"
+#include "internal/storage/disk_manager.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace datyredb::storage;
+
+namespace {
+
+/// Ждёт, пока фоновый поток загрузит хотя бы expected страниц
+bool wait_prefetched(const BufferPool& pool, uint64_t expected) {
+    for (int i = 0; i < 500; ++i) {
+        if (pool.metrics().prefetched >= expected) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return false;
+}
+
+} // namespace
+
+class ReadAheadTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "datyredb_read_ahead_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        
+        metrics_ = std::make_shared<CheckpointMetrics>();
+        disk_manager_ = std::make_shared<DiskManager>(test_dir_);
+        ASSERT_TRUE(disk_manager_->initialize());
+    }
+    
+    void TearDown() override {
+        disk_manager_->shutdown();
+        disk_manager_.reset();
+        std::filesystem::remove_all(test_dir_);
+    }
+    
+    /// Записать count страниц на диск через отдельный pool
+    std::vector<PageId> write_pages(std::size_t count) {
+        std::vector<PageId> page_ids;
+        BufferPool writer(count * 2, disk_manager_, metrics_);
+        for (std::size_t i = 0; i < count; ++i) {
+            PageId page_id;
+            Page* page = writer.new_page(&page_id);
+            EXPECT_NE(page, nullptr);
+            if (!page) {
+                break;
+            }
+            page->payload()[0] = static_cast<char>(i);
+            page_ids.push_back(page_id);
+            writer.unpin_page(page_id, true);
+        }
+        writer.flush_pages(page_ids);
+        return page_ids;
+    }
+    
+    std::filesystem::path test_dir_;
+    std::shared_ptr<CheckpointMetrics> metrics_;
+    std::shared_ptr<DiskManager> disk_manager_;
+};
+
+// ==============================================================================
+// Prefetch
+// ==============================================================================
+
+TEST_F(ReadAheadTest, PrefetchInstallsPagesUnpinned) {
+    std::vector<PageId> page_ids = write_pages(32);
+    ASSERT_EQ(page_ids.size(), 32u);
+    
+    BufferPool pool(64, disk_manager_, metrics_);
+    pool.prefetch(page_ids.front(), 16);
+    ASSERT_TRUE(wait_prefetched(pool, 16));
+    EXPECT_EQ(pool.page_count(), 16u);
+    
+    // Загруженные страницы отдаются как hit, и пин — только наш
+    auto before = pool.metrics();
+    for (std::size_t i = 0; i < 16; ++i) {
+        Page* page = pool.fetch_page(page_ids[i]);
+        ASSERT_NE(page, nullptr);
+        EXPECT_EQ(page->pin_count(), 1);
+        EXPECT_EQ(page->payload()[0], static_cast<char>(i));
+        EXPECT_TRUE(pool.unpin_page(page_ids[i], false));
+    }
+    EXPECT_EQ(pool.metrics().hits - before.hits, 16u);
+    EXPECT_EQ(pool.metrics().misses, before.misses);
+}
+
+// ==============================================================================
+// Sequential Detection
+// ==============================================================================
+
+TEST_F(ReadAheadTest, SequentialMissesTriggerReadAhead) {
+    std::vector<PageId> page_ids = write_pages(128);
+    ASSERT_EQ(page_ids.size(), 128u);
+    
+    BufferPoolConfig config;
+    config.read_ahead = true;
+    config.read_ahead_window = 16;
+    config.read_ahead_trigger = 4;
+    BufferPool pool(256, disk_manager_, metrics_, config);
+    
+    // Четыре подряд идущих miss'а — детектор запрашивает окно
+    for (std::size_t i = 0; i < 4; ++i) {
+        ASSERT_NE(pool.fetch_page(page_ids[i]), nullptr);
+        EXPECT_TRUE(pool.unpin_page(page_ids[i], false));
+    }
+    ASSERT_TRUE(wait_prefetched(pool, 16));
+    
+    // Дальше скан идёт по маркерам окон: каждое следующее окно запрошено
+    // заранее, сканер лишь даёт фоновому потоку его дочитать
+    for (std::size_t i = 4; i < page_ids.size(); ++i) {
+        ASSERT_TRUE(wait_prefetched(pool, i - 3));
+        ASSERT_NE(pool.fetch_page(page_ids[i]), nullptr);
+        EXPECT_TRUE(pool.unpin_page(page_ids[i], false));
+    }
+    
+    auto metrics = pool.metrics();
+    EXPECT_EQ(metrics.misses, 4u);
+    EXPECT_EQ(metrics.prefetched, page_ids.size() - 4);
+}
+
+TEST_F(ReadAheadTest, RandomMissesDoNotTriggerReadAhead) {
+    std::vector<PageId> page_ids = write_pages(32);
+    ASSERT_EQ(page_ids.size(), 32u);
+    
+    BufferPoolConfig config;
+    config.read_ahead = true;
+    BufferPool pool(64, disk_manager_, metrics_, config);
+    
+    for (int i : {7, 2, 19, 11, 30, 5, 23, 14}) {
+        ASSERT_NE(pool.fetch_page(page_ids[i]), nullptr);
+        EXPECT_TRUE(pool.unpin_page(page_ids[i], false));
+    }
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(pool.metrics().prefetched, 0u);
+}
@@ -0,0 +1,752 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - Crash Recovery Unit Tests                                        ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <gtest/gtest.h>
+
+#include "internal/storage/recovery.hpp"
+#include "internal/storage/checkpoint.hpp"
+#include "internal/storage/buffer_pool.hpp"
+#include "internal/storage/disk_manager.hpp"
+#include "internal/storage/wal.hpp"
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace datyredb::storage;
+
+namespace {
+
+/// Стек хранения, как его собирает StorageEngine
+struct Stack {
+    explicit Stack(const std::filesystem::path& dir, std::size_t pool_pages = 64) {
+        metrics = std::make_shared<CheckpointMetrics>();
+        disk_manager = std::make_shared<DiskManager>(dir);
+        disk_manager->initialize();
+        wal = std::make_shared<WriteAheadLog>(dir / "wal", 64 * 1024, metrics);
+        wal->initialize();
+        buffer_pool = std::make_shared<BufferPool>(pool_pages, disk_manager, metrics,
+                                                   BufferPoolConfig{}, wal);
+    }
+    
+    ~Stack() {
+        buffer_pool.reset();
+        wal->shutdown();
+        disk_manager->shutdown();
+    }
+    
+    RecoveryStats recover(RecoveryConfig config = {}) {
+        RecoveryManager recovery(wal, buffer_pool, disk_manager, config);
+        EXPECT_TRUE(recovery.recover());
+        return recovery.stats();
+    }
+    
+    /// Транзакционное изменение: UPDATE в лог, затем в страницу
+    void update(TxnId txn, Lsn& prev, PageId page_id, uint16_t offset, int64_t value) {
+        while (disk_manager->page_count() <= page_id) {
+            disk_manager->allocate_page();
+        }
+        Page* page = pin(page_id);
+        ASSERT_NE(page, nullptr);
+        
+        LogRecord record;
+        record.type = LogRecordType::UPDATE;
+        record.txn_id = txn;
+        record.page_id = page_id;
+        record.offset = offset;
+        record.length = sizeof(value);
+        record.prev_lsn = prev;
+        record.data.resize(2 * sizeof(value));
+        std::memcpy(record.data.data(), page->payload() + offset, sizeof(value));
+        std::memcpy(record.data.data() + sizeof(value), &value, sizeof(value));
+        
+        prev = wal->append(record);
+        std::memcpy(page->payload() + offset, &value, sizeof(value));
+        page->set_lsn(prev);
+        buffer_pool->unpin_page(page_id, true);
+    }
+    
+    /// fetch_page с повтором: маленький pool может быть целиком
+    /// запинен идущим checkpoint'ом
+    Page* pin(PageId page_id) {
+        for (int attempt = 0; attempt < 1000; ++attempt) {
+            if (Page* page = buffer_pool->fetch_page(page_id)) {
+                return page;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return nullptr;
+    }
+    
+    Lsn log(LogRecordType type, TxnId txn, Lsn prev) {
+        LogRecord record;
+        record.type = type;
+        record.txn_id = txn;
+        record.prev_lsn = prev;
+        return wal->append(record);
+    }
+    
+    void commit(TxnId txn, Lsn prev) {
+        wal->force(log(LogRecordType::TXN_COMMIT, txn, prev));
+    }
+    
+    int64_t read(PageId page_id, uint16_t offset) {
+        int64_t value = 0;
+        Page* page = pin(page_id);
+        EXPECT_NE(page, nullptr);
+        if (page) {
+            std::memcpy(&value, page->payload() + offset, sizeof(value));
+            buffer_pool->unpin_page(page_id, false);
+        }
+        return value;
+    }
+    
+    std::shared_ptr<CheckpointMetrics> metrics;
+    std::shared_ptr<DiskManager> disk_manager;
+    std::shared_ptr<WriteAheadLog> wal;
+    std::shared_ptr<BufferPool> buffer_pool;
+};
+
+/// Выполнить body над стеком в дочернем процессе и "уронить" его: _exit
+/// без flush buffer pool и без shutdown WAL — как при kill -9
+void run_and_crash(const std::filesystem::path& dir, const std::function<void(Stack&)>& body) {
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        // Стек намеренно не разрушается
+        auto* stack = new Stack(dir);
+        body(*stack);
+        ::_exit(0);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+}
+
+} // namespace
+
+class RecoveryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "datyredb_recovery_test";
+        std::filesystem::remove_all(test_dir_);
+    }
+    
+    void TearDown() override {
+        std::filesystem::remove_all(test_dir_);
+    }
+    
+    std::filesystem::path test_dir_;
+};
+
+// ==============================================================================
+// Кодирование записей
+// ==============================================================================
+
+namespace {
+
+/// Сериализовать с LSN lsn и прочитать обратно
+LogRecord round_trip(const LogRecord& record, Lsn lsn) {
+    std::vector<char> buffer(record.serialized_size());
+    record.serialize(buffer.data(), lsn);
+    auto decoded = LogRecord::deserialize(buffer.data(), buffer.size(), lsn);
+    EXPECT_TRUE(decoded.has_value());
+    return decoded ? std::move(*decoded) : LogRecord{};
+}
+
+} // namespace
+
+TEST(LogRecordEncodingTest, UpdateStoresOnlyChangedRuns) {
+    constexpr uint16_t kLength = 512;
+    std::vector<char> before(kLength, 'a');
+    std::vector<char> after = before;
+    std::memset(after.data() + 10, 'b', 8);
+    std::memset(after.data() + 300, 'c', 4);
+    
+    LogRecord record;
+    record.type = LogRecordType::UPDATE;
+    record.txn_id = 7;
+    record.page_id = 3;
+    record.offset = 100;
+    record.length = kLength;
+    record.prev_lsn = 4096;
+    record.data = before;
+    record.data.insert(record.data.end(), after.begin(), after.end());
+    
+    // Два отрезка по образу до и после вместо двух полных образов
+    EXPECT_LT(record.serialized_size(), 64u);
+    
+    LogRecord decoded = round_trip(record, 8192);
+    EXPECT_EQ(decoded.format, LogDataFormat::Runs);
+    EXPECT_EQ(decoded.lsn, 8192u);
+    EXPECT_EQ(decoded.txn_id, 7u);
+    EXPECT_EQ(decoded.page_id, 3u);
+    EXPECT_EQ(decoded.offset, 100);
+    EXPECT_EQ(decoded.length, kLength);
+    EXPECT_EQ(decoded.prev_lsn, 4096u);
+    
+    // Redo даёт образ после, CLR — образ до; байты вне отрезков не трогаются
+    Page page;
+    std::memcpy(page.payload() + 100, before.data(), kLength);
+    decoded.redo(page.payload());
+    EXPECT_EQ(std::memcmp(page.payload() + 100, after.data(), kLength), 0);
+    
+    LogRecord clr = round_trip(decoded.compensation(), 16384);
+    EXPECT_EQ(clr.type, LogRecordType::CLR);
+    EXPECT_EQ(clr.prev_lsn, 4096u);
+    clr.redo(page.payload());
+    EXPECT_EQ(std::memcmp(page.payload() + 100, before.data(), kLength), 0);
+}
+
+TEST(LogRecordEncodingTest, InsertAndDeleteSkipZeros) {
+    constexpr uint16_t kLength = 256;
+    std::vector<char> image(kLength, 0);
+    std::memset(image.data() + 64, 'x', 16);
+    
+    LogRecord insert;
+    insert.type = LogRecordType::INSERT;
+    insert.page_id = 1;
+    insert.length = kLength;
+    insert.data = image;
+    LogRecord decoded = round_trip(insert, 64);
+    EXPECT_EQ(decoded.format, LogDataFormat::Runs);
+    
+    Page page;
+    decoded.redo(page.payload());
+    EXPECT_EQ(std::memcmp(page.payload(), image.data(), kLength), 0);
+    round_trip(decoded.compensation(), 128).redo(page.payload());
+    EXPECT_EQ(std::count(page.payload(), page.payload() + kLength, 0), kLength);
+    
+    LogRecord remove = insert;
+    remove.type = LogRecordType::DELETE;
+    decoded = round_trip(remove, 64);
+    round_trip(decoded.compensation(), 128).redo(page.payload());
+    EXPECT_EQ(std::memcmp(page.payload(), image.data(), kLength), 0);
+    decoded.redo(page.payload());
+    EXPECT_EQ(std::count(page.payload(), page.payload() + kLength, 0), kLength);
+}
+
+TEST(LogRecordEncodingTest, CompactHeaderAndPositionCheck) {
+    LogRecord commit;
+    commit.type = LogRecordType::TXN_COMMIT;
+    commit.txn_id = 1000;
+    commit.prev_lsn = 1ULL << 30;
+    
+    // Вместо 35 байт фиксированного заголовка
+    EXPECT_LE(commit.serialized_size(), 20u);
+    
+    std::vector<char> buffer(commit.serialized_size());
+    commit.serialize(buffer.data(), 1ULL << 31);
+    EXPECT_TRUE(LogRecord::deserialize(buffer.data(), buffer.size(), 1ULL << 31).has_value());
+    
+    // Запись с другой позиции, обрезанная запись и нули — не записи
+    EXPECT_FALSE(LogRecord::deserialize(buffer.data(), buffer.size(), 1ULL << 30).has_value());
+    EXPECT_FALSE(LogRecord::deserialize(buffer.data(), buffer.size() - 1, 1ULL << 31).has_value());
+    std::vector<char> zeros(buffer.size(), 0);
+    EXPECT_FALSE(LogRecord::deserialize(zeros.data(), zeros.size(), 1ULL << 31).has_value());
+}
+
+// ==============================================================================
+// Redo / Undo
+// ==============================================================================
+
+TEST_F(RecoveryTest, RedoCommittedChanges) {
+    run_and_crash(test_dir_, [](Stack& stack) {
+        Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+        stack.update(1, prev, 0, 0, 111);
+        stack.update(1, prev, 3, 16, 333);
+        stack.commit(1, prev);
+    });
+    
+    Stack stack(test_dir_);
+    auto stats = stack.recover();
+    
+    EXPECT_EQ(stats.records_redone, 2u);
+    EXPECT_EQ(stats.loser_txns, 0u);
+    EXPECT_EQ(stack.read(0, 0), 111);
+    EXPECT_EQ(stack.read(3, 16), 333);
+}
+
+TEST_F(RecoveryTest, UndoLoserWithStolenPages) {
+    run_and_crash(test_dir_, [](Stack& stack) {
+        Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+        stack.update(1, prev, 0, 0, 100);
+        stack.commit(1, prev);
+        
+        // Незакоммиченное изменение успело попасть на диск
+        prev = stack.log(LogRecordType::TXN_BEGIN, 2, INVALID_LSN);
+        stack.update(2, prev, 0, 0, 200);
+        stack.update(2, prev, 1, 8, 201);
+        stack.buffer_pool->flush_pages(stack.buffer_pool->get_dirty_pages());
+    });
+    
+    {
+        Stack stack(test_dir_);
+        auto stats = stack.recover();
+        
+        EXPECT_EQ(stats.loser_txns, 1u);
+        EXPECT_EQ(stats.records_undone, 2u);
+        EXPECT_EQ(stack.read(0, 0), 100);
+        EXPECT_EQ(stack.read(1, 8), 0);
+    }
+    
+    // CLR и TXN_ABORT в логе: повторный recovery ничего не откатывает
+    Stack stack(test_dir_);
+    auto stats = stack.recover();
+    EXPECT_EQ(stats.loser_txns, 0u);
+    EXPECT_EQ(stack.read(0, 0), 100);
+}
+
+TEST_F(RecoveryTest, RedoSkipsPagesWithCurrentLsn) {
+    run_and_crash(test_dir_, [](Stack& stack) {
+        Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+        stack.update(1, prev, 0, 0, 7);
+        stack.update(1, prev, 1, 0, 8);
+        stack.commit(1, prev);
+        stack.buffer_pool->flush_page(0);
+    });
+    
+    Stack stack(test_dir_);
+    auto stats = stack.recover();
+    
+    EXPECT_EQ(stats.records_skipped, 1u);
+    EXPECT_EQ(stats.records_redone, 1u);
+    EXPECT_EQ(stack.read(0, 0), 7);
+    EXPECT_EQ(stack.read(1, 0), 8);
+}
+
+TEST_F(RecoveryTest, StartsFromLastCheckpoint) {
+    {
+        Stack stack(test_dir_);
+        for (TxnId txn = 1; txn <= 50; ++txn) {
+            Lsn prev = stack.log(LogRecordType::TXN_BEGIN, txn, INVALID_LSN);
+            stack.update(txn, prev, txn % 4, 0, static_cast<int64_t>(txn));
+            stack.commit(txn, prev);
+        }
+        
+        CheckpointManager checkpoint(CheckpointConfig{}, stack.buffer_pool, stack.wal,
+                                     stack.metrics);
+        checkpoint.start();
+        checkpoint.manual_checkpoint();
+        EXPECT_NE(stack.wal->checkpoint_lsn(), INVALID_LSN);
+    }
+    
+    Stack stack(test_dir_);
+    auto stats = stack.recover();
+    
+    // Только записи checkpoint'а (BEGIN, END и END при shutdown)
+    EXPECT_EQ(stats.checkpoint_lsn, stack.wal->checkpoint_lsn());
+    EXPECT_LE(stats.records_scanned, 4u);
+    EXPECT_EQ(stats.records_redone, 0u);
+    EXPECT_EQ(stack.read(2, 0), 50);
+}
+
+TEST_F(RecoveryTest, FuzzyCheckpointWritesNoPages) {
+    Stack stack(test_dir_);
+    Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+    stack.update(1, prev, 0, 0, 10);
+    Lsn first_change = prev;
+    stack.update(1, prev, 1, 0, 11);
+    stack.commit(1, prev);
+    
+    // Транзакция 2 активна на момент checkpoint'а
+    Lsn open_prev = stack.log(LogRecordType::TXN_BEGIN, 2, INVALID_LSN);
+    Lsn open_first = open_prev;
+    stack.update(2, open_prev, 2, 0, 20);
+    
+    CheckpointManager checkpoint(CheckpointConfig{}, stack.buffer_pool, stack.wal,
+                                 stack.metrics);
+    checkpoint.fuzzy_checkpoint();
+    
+    EXPECT_EQ(stack.metrics->checkpoint_count.load(), 1u);
+    EXPECT_EQ(stack.metrics->pages_written_total.load(), 0u);
+    EXPECT_EQ(stack.buffer_pool->dirty_page_count(), 3u);
+    ASSERT_NE(stack.wal->checkpoint_end_lsn(), INVALID_LSN);
+    
+    // END хранит таблицу dirty pages и таблицу активных транзакций
+    LogReader reader(stack.wal->wal_dir(), stack.wal->segment_size());
+    LogRecord end;
+    ASSERT_TRUE(reader.read(stack.wal->checkpoint_end_lsn(), end));
+    EXPECT_EQ(end.type, LogRecordType::CHECKPOINT_END);
+    auto data = CheckpointData::deserialize(end.data);
+    ASSERT_TRUE(data.has_value());
+    EXPECT_EQ(data->dirty_pages.size(), 3u);
+    ASSERT_EQ(data->active_txns.size(), 1u);
+    EXPECT_EQ(data->active_txns[0].txn_id, 2u);
+    EXPECT_EQ(data->active_txns[0].first_lsn, open_first);
+    EXPECT_EQ(data->active_txns[0].last_lsn, open_prev);
+    EXPECT_EQ(data->redo_lsn(stack.wal->checkpoint_lsn()), first_change);
+    EXPECT_EQ(data->truncation_lsn(stack.wal->checkpoint_lsn()), first_change);
+}
+
+TEST_F(RecoveryTest, RedoStartsFromOldestRecLsn) {
+    run_and_crash(test_dir_, [](Stack& stack) {
+        Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+        stack.update(1, prev, 0, 0, 10);
+        stack.update(1, prev, 1, 0, 11);
+        stack.commit(1, prev);
+        stack.buffer_pool->flush_page(1);
+        
+        // Страница 0 остаётся dirty: её rec_lsn раньше BEGIN
+        auto* checkpoint = new CheckpointManager(CheckpointConfig{}, stack.buffer_pool,
+                                                 stack.wal, stack.metrics);
+        checkpoint->fuzzy_checkpoint();
+        
+        prev = stack.log(LogRecordType::TXN_BEGIN, 2, INVALID_LSN);
+        stack.update(2, prev, 3, 0, 30);
+        stack.commit(2, prev);
+    });
+    
+    Stack stack(test_dir_);
+    auto stats = stack.recover();
+    
+    EXPECT_NE(stats.checkpoint_lsn, INVALID_LSN);
+    EXPECT_LT(stats.redo_lsn, stats.checkpoint_lsn);
+    EXPECT_EQ(stats.records_redone, 2u);
+    EXPECT_EQ(stats.records_skipped, 1u);
+    EXPECT_EQ(stack.read(0, 0), 10);
+    EXPECT_EQ(stack.read(1, 0), 11);
+    EXPECT_EQ(stack.read(3, 0), 30);
+}
+
+TEST_F(RecoveryTest, CheckpointTablesLargerThanLogBuffer) {
+    run_and_crash(test_dir_, [](Stack& stack) {
+        Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+        stack.update(1, prev, 0, 0, 10);
+        Lsn first_change = prev;
+        stack.commit(1, prev);
+        
+        // Таблица dirty pages больше кольца: END пишется цепочкой, и
+        // самый старый rec_lsn — в первой части, дальше всего от master
+        Lsn begin_lsn = stack.wal->write_checkpoint_begin();
+        CheckpointData data;
+        data.dirty_pages.push_back({0, first_change});
+        for (PageId id = 1; id <= 3'000'000; ++id) {
+            data.dirty_pages.push_back({id, begin_lsn});
+        }
+        stack.wal->write_checkpoint_end(begin_lsn, data);
+    });
+    
+    Stack stack(test_dir_);
+    auto stats = stack.recover();
+    
+    ASSERT_NE(stats.checkpoint_lsn, INVALID_LSN);
+    EXPECT_GT(stack.wal->checkpoint_end_lsn() - stats.checkpoint_lsn, WriteAheadLog::RING_SIZE);
+    EXPECT_LT(stats.redo_lsn, stats.checkpoint_lsn);
+    EXPECT_EQ(stack.read(0, 0), 10);
+}
+
+TEST_F(RecoveryTest, FuzzyCheckpointKeepsLoserChain) {
+    run_and_crash(test_dir_, [](Stack& stack) {
+        Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+        stack.update(1, prev, 0, 0, 100);
+        stack.commit(1, prev);
+        
+        auto* checkpoint = new CheckpointManager(CheckpointConfig{}, stack.buffer_pool,
+                                                 stack.wal, stack.metrics);
+        
+        // Проигравший начинается задолго до checkpoint'ов, его изменение
+        // вытеснено на диск
+        Lsn loser_prev = stack.log(LogRecordType::TXN_BEGIN, 2, INVALID_LSN);
+        for (TxnId txn = 3; txn < 3003; ++txn) {
+            if (txn == 1500) {
+                stack.update(2, loser_prev, 0, 0, 200);
+            }
+            Lsn p = stack.log(LogRecordType::TXN_BEGIN, txn, INVALID_LSN);
+            stack.update(txn, p, 1, 0, static_cast<int64_t>(txn));
+            stack.commit(txn, p);
+            if (txn % 500 == 0) {
+                stack.buffer_pool->flush_pages(stack.buffer_pool->get_dirty_pages());
+                checkpoint->fuzzy_checkpoint();
+            }
+        }
+    });
+    
+    // Обрезка остановилась на начале проигравшего
+    EXPECT_TRUE(std::filesystem::exists(test_dir_ / "wal" / "wal_0"));
+    
+    Stack stack(test_dir_);
+    auto stats = stack.recover();
+    
+    EXPECT_EQ(stats.loser_txns, 1u);
+    EXPECT_EQ(stats.records_undone, 1u);
+    EXPECT_EQ(stack.read(0, 0), 100);
+    EXPECT_EQ(stack.read(1, 0), 3002);
+}
+
+TEST_F(RecoveryTest, ParallelRedoKeepsPerPageOrder) {
+    // Много изменений одних и тех же слотов: итог определяется последней
+    // по LSN записью каждой страницы
+    constexpr int kPages = 37;
+    constexpr int kUpdates = 5000;
+    run_and_crash(test_dir_, [](Stack& stack) {
+        Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+        for (int i = 0; i < kUpdates; ++i) {
+            stack.update(1, prev, static_cast<PageId>(i % kPages),
+                         static_cast<uint16_t>((i % 5) * 8), i);
+        }
+        stack.commit(1, prev);
+    });
+    
+    Stack stack(test_dir_, 16);
+    RecoveryConfig config;
+    config.redo_threads = 4;
+    config.redo_batch_size = 7;
+    config.redo_queue_depth = 2;
+    auto stats = stack.recover(config);
+    
+    EXPECT_EQ(stats.redo_threads, 4u);
+    EXPECT_EQ(stats.records_redone + stats.records_skipped, static_cast<std::size_t>(kUpdates));
+    for (int i = kUpdates - kPages * 5; i < kUpdates; ++i) {
+        EXPECT_EQ(stack.read(static_cast<PageId>(i % kPages),
+                             static_cast<uint16_t>((i % 5) * 8)), i);
+    }
+}
+
+// ==============================================================================
+// Конец лога
+// ==============================================================================
+
+TEST_F(RecoveryTest, TornTailIsCutOff) {
+    Lsn end = INVALID_LSN;
+    {
+        Stack stack(test_dir_);
+        Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+        stack.commit(1, prev);
+        end = stack.wal->current_lsn();
+    }
+    
+    // Мусор за последней целой записью — как недописанный хвост
+    auto segment_path = test_dir_ / "wal" / "wal_0";
+    {
+        std::fstream segment(segment_path, std::ios::binary | std::ios::in | std::ios::out);
+        segment.seekp(static_cast<std::streamoff>(end));
+        std::vector<char> garbage(100, '\x05');
+        segment.write(garbage.data(), static_cast<std::streamsize>(garbage.size()));
+    }
+    
+    // Хвост обнулён, сегмент сохраняет полный размер
+    Stack stack(test_dir_);
+    EXPECT_EQ(stack.wal->current_lsn(), end);
+    EXPECT_EQ(std::filesystem::file_size(segment_path), 64u * 1024);
+    {
+        std::ifstream segment(segment_path, std::ios::binary);
+        segment.seekg(static_cast<std::streamoff>(end));
+        std::vector<char> tail(100);
+        segment.read(tail.data(), static_cast<std::streamsize>(tail.size()));
+        EXPECT_EQ(std::count(tail.begin(), tail.end(), '\0'), 100);
+    }
+    
+    // Новые записи идут встык и читаются следующим recovery
+    Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 2, INVALID_LSN);
+    EXPECT_EQ(prev, end);
+    stack.commit(2, prev);
+    
+    auto stats = stack.recover();
+    EXPECT_EQ(stats.records_scanned, 4u);
+}
+
+TEST_F(RecoveryTest, TornDataPageRestoredBeforeRedo) {
+    run_and_crash(test_dir_, [](Stack& stack) {
+        Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+        stack.update(1, prev, 0, 0, 10);
+        stack.update(1, prev, 1, 0, 11);
+        stack.commit(1, prev);
+        stack.buffer_pool->flush_pages(stack.buffer_pool->get_dirty_pages());
+        
+        // Лог с изменениями страницы 0 обрезан: восстановить её может
+        // только double-write
+        auto* checkpoint = new CheckpointManager(CheckpointConfig{}, stack.buffer_pool,
+                                                 stack.wal, stack.metrics);
+        checkpoint->fuzzy_checkpoint();
+    });
+    
+    // Сбой питания посреди записи страницы 0
+    {
+        std::fstream data(test_dir_ / "data.db", std::ios::binary | std::ios::in | std::ios::out);
+        data.seekp(PAGE_SIZE / 2);
+        std::vector<char> garbage(PAGE_SIZE / 2, 0x5a);
+        data.write(garbage.data(), static_cast<std::streamsize>(garbage.size()));
+    }
+    
+    Stack stack(test_dir_);
+    auto stats = stack.recover();
+    
+    EXPECT_EQ(stats.torn_pages_repaired, 1u);
+    EXPECT_EQ(stats.records_redone, 0u);
+    EXPECT_EQ(stack.read(0, 0), 10);
+    EXPECT_EQ(stack.read(1, 0), 11);
+}
+
+TEST_F(RecoveryTest, RecycledSegmentsAreNotReplayed) {
+    // Каждый checkpoint отдаёт старые сегменты в запас: лог много раз
+    // пишется поверх записей прежних кругов
+    constexpr TxnId kRounds = 8;
+    constexpr TxnId kTxnsPerRound = 1000;
+    constexpr TxnId kTail = 100;
+    run_and_crash(test_dir_, [&](Stack& stack) {
+        // Не разрушается, как и стек: иначе shutdown сделал бы checkpoint
+        auto* checkpoint = new CheckpointManager(CheckpointConfig{}, stack.buffer_pool,
+                                                 stack.wal, stack.metrics);
+        checkpoint->start();
+        TxnId txn = 1;
+        for (TxnId round = 0; round < kRounds; ++round) {
+            for (TxnId i = 0; i < kTxnsPerRound; ++i, ++txn) {
+                Lsn prev = stack.log(LogRecordType::TXN_BEGIN, txn, INVALID_LSN);
+                stack.update(txn, prev, txn % 4, 0, static_cast<int64_t>(txn));
+                stack.commit(txn, prev);
+            }
+            checkpoint->manual_checkpoint();
+        }
+        for (TxnId i = 0; i < kTail; ++i, ++txn) {
+            Lsn prev = stack.log(LogRecordType::TXN_BEGIN, txn, INVALID_LSN);
+            stack.update(txn, prev, txn % 4, 0, static_cast<int64_t>(txn));
+            stack.commit(txn, prev);
+        }
+    });
+    
+    std::size_t segments = 0;
+    std::size_t spares = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(test_dir_ / "wal")) {
+        auto name = entry.path().filename().string();
+        segments += name.rfind("wal_", 0) == 0 && name.rfind("wal_spare_", 0) != 0;
+        spares += name.rfind("wal_spare_", 0) == 0;
+    }
+    EXPECT_LE(spares, WriteAheadLog::PREPARED_SEGMENTS);
+    EXPECT_LE(segments, 2 + 2 * WriteAheadLog::PREPARED_SEGMENTS);
+    
+    // После checkpoint'а — его BEGIN и END и хвост; старые записи в
+    // переиспользованных сегментах конец лога не продлевают
+    Stack stack(test_dir_);
+    auto stats = stack.recover();
+    EXPECT_EQ(stats.records_scanned, 2 + 3 * kTail);
+    EXPECT_EQ(stats.end_lsn, stack.wal->current_lsn());
+    
+    constexpr TxnId kLast = kRounds * kTxnsPerRound + kTail;
+    for (PageId page_id = 0; page_id < 4; ++page_id) {
+        EXPECT_EQ(stack.read(page_id, 0) % 4, page_id);
+        EXPECT_GT(stack.read(page_id, 0), static_cast<int64_t>(kLast - 4));
+    }
+}
+
+// ==============================================================================
+// Crash test: kill -9 в случайный момент
+// ==============================================================================
+
+TEST_F(RecoveryTest, RandomCrashesPreserveInvariants) {
+    // Счета — по 8 на страницу на 8 страницах, счётчик commit'ов — на
+    // странице 8. Переводы сохраняют сумму; каждый commit увеличивает счётчик
+    constexpr int kAccounts = 64;
+    constexpr int64_t kInitial = 1000;
+    constexpr PageId kCounterPage = 8;
+    auto account_page = [](int a) { return static_cast<PageId>(a / 8); };
+    auto account_offset = [](int a) { return static_cast<uint16_t>((a % 8) * 8); };
+    
+    {
+        Stack stack(test_dir_);
+        Lsn prev = stack.log(LogRecordType::TXN_BEGIN, 1, INVALID_LSN);
+        for (int a = 0; a < kAccounts; ++a) {
+            stack.update(1, prev, account_page(a), account_offset(a), kInitial);
+        }
+        stack.update(1, prev, kCounterPage, 0, 0);
+        stack.commit(1, prev);
+    }
+    
+    std::mt19937 rng(12345);
+    int64_t committed = 0;
+    
+    for (int round = 0; round < 10; ++round) {
+        int pipe_fds[2];
+        ASSERT_EQ(::pipe(pipe_fds), 0);
+        
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            ::close(pipe_fds[0]);
+            
+            // Маленький pool: изменения незакоммиченных транзакций
+            // вытесняются на диск
+            Stack stack(test_dir_, 4);
+            stack.recover();
+            
+            CheckpointConfig config;
+            config.dirty_page_soft_limit_pct = 2.0f;
+            config.dirty_page_hard_limit_pct = 2.0f;
+            CheckpointManager checkpoint(config, stack.buffer_pool, stack.wal, stack.metrics);
+            checkpoint.start();
+            
+            std::mt19937 child_rng(static_cast<unsigned>(round));
+            for (TxnId txn = (round + 1) * 1000000ULL;; ++txn) {
+                int from = static_cast<int>(child_rng() % kAccounts);
+                int to = static_cast<int>(child_rng() % kAccounts);
+                int64_t amount = static_cast<int64_t>(child_rng() % 100);
+                
+                Lsn prev = stack.log(LogRecordType::TXN_BEGIN, txn, INVALID_LSN);
+                stack.update(txn, prev, account_page(from), account_offset(from),
+                             stack.read(account_page(from), account_offset(from)) - amount);
+                stack.update(txn, prev, account_page(to), account_offset(to),
+                             stack.read(account_page(to), account_offset(to)) + amount);
+                stack.update(txn, prev, kCounterPage, 0, stack.read(kCounterPage, 0) + 1);
+                stack.commit(txn, prev);
+                
+                // Подтверждение клиенту — после durable commit
+                char ack = 1;
+                if (::write(pipe_fds[1], &ack, 1) != 1) {
+                    ::_exit(1);
+                }
+                
+                if (txn % 64 == 0) {
+                    checkpoint.manual_checkpoint();
+                }
+            }
+        }
+        
+        ::close(pipe_fds[1]);
+        
+        // Отсчёт до сбоя — с первого подтверждённого commit'а: recovery
+        // и checkpoint на медленном диске иначе съедают весь раунд
+        char first = 0;
+        int64_t acked = ::read(pipe_fds[0], &first, 1) == 1 ? 1 : 0;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20 + rng() % 80));
+        ::kill(pid, SIGKILL);
+        ::waitpid(pid, nullptr, 0);
+        
+        char buf[4096];
+        ssize_t n;
+        while ((n = ::read(pipe_fds[0], buf, sizeof(buf))) > 0) {
+            acked += n;
+        }
+        ::close(pipe_fds[0]);
+        
+        Stack stack(test_dir_);
+        stack.recover();
+        
+        int64_t total = 0;
+        for (int a = 0; a < kAccounts; ++a) {
+            total += stack.read(account_page(a), account_offset(a));
+        }
+        int64_t counter = stack.read(kCounterPage, 0);
+        
+        // Атомарность: переводы целиком или никак. Durability: каждый
+        // подтверждённый commit виден; сверх них — не больше одного,
+        // durable, но не успевший подтвердиться
+        EXPECT_EQ(total, kAccounts * kInitial) << "round " << round;
+        EXPECT_GE(counter, committed + acked) << "round " << round;
+        EXPECT_LE(counter, committed + acked + 1) << "round " << round;
+        committed = counter;
+    }
+    
+    EXPECT_GT(committed, 0);
+}
@@ -0,0 +1,398 @@
+// ╔══════════════════════════════════════════════════════════════════════════════╗
+// ║  DatyreDB - WAL Writer Unit Tests                                            ║
+// ╚══════════════════════════════════════════════════════════════════════════════╝
+
+#include <gtest/gtest.h>
+
+#include "internal/storage/wal.hpp"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace datyredb::storage;
+
+namespace {
+
+// Сбой диска: пока флаг поднят, fdatasync процесса возвращает EIO
+std::atomic<bool> fail_fdatasync{false};
+
+} // namespace
+
+// Подменяет fdatasync из libc для всего тестового процесса
+extern "C" int fdatasync(int fd) noexcept {
+    if (fail_fdatasync.load()) {
+        errno = EIO;
+        return -1;
+    }
+    return static_cast<int>(::syscall(SYS_fdatasync, fd));
+}
+
+class WALWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "datyredb_wal_writer_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        metrics_ = std::make_shared<CheckpointMetrics>();
+    }
+    
+    void TearDown() override {
+        fail_fdatasync.store(false);
+        if (wal_) {
+            wal_->shutdown();
+            wal_.reset();
+        }
+        std::filesystem::remove_all(test_dir_);
+    }
+    
+    void open_wal(SyncPolicy policy, std::size_t segment_size = 1024 * 1024) {
+        SyncConfig sync;
+        sync.policy = policy;
+        sync.group_window = std::chrono::milliseconds(2);
+        sync.interval = std::chrono::milliseconds(5);
+        wal_ = std::make_shared<WriteAheadLog>(test_dir_, segment_size, metrics_, nullptr, sync);
+        ASSERT_TRUE(wal_->initialize());
+    }
+    
+    /// append + force одной commit-записи
+    Lsn commit(TxnId txn_id) {
+        LogRecord record;
+        record.type = LogRecordType::TXN_COMMIT;
+        record.txn_id = txn_id;
+        Lsn lsn = wal_->append(record);
+        EXPECT_NE(lsn, INVALID_LSN);
+        EXPECT_TRUE(wal_->force(lsn));
+        return lsn;
+    }
+    
+    std::filesystem::path test_dir_;
+    std::shared_ptr<CheckpointMetrics> metrics_;
+    std::shared_ptr<WriteAheadLog> wal_;
+};
+
+// ==============================================================================
+// Sync Policy
+// ==============================================================================
+
+TEST_F(WALWriterTest, PerCommitSyncsEveryForce) {
+    open_wal(SyncPolicy::PerCommit);
+    
+    for (TxnId txn = 1; txn <= 3; ++txn) {
+        Lsn lsn = commit(txn);
+        EXPECT_GT(wal_->flushed_lsn(), lsn);
+    }
+    
+    EXPECT_EQ(wal_->sync_latency().count.load(), 3u);
+    EXPECT_GT(wal_->sync_latency().percentile_us(0.99), 0u);
+}
+
+TEST_F(WALWriterTest, NoneNeverSyncs) {
+    open_wal(SyncPolicy::None);
+    
+    Lsn lsn = commit(1);
+    
+    EXPECT_GT(wal_->flushed_lsn(), lsn);
+    EXPECT_EQ(wal_->sync_latency().count.load(), 0u);
+}
+
+TEST_F(WALWriterTest, GroupCommitSharesSyncs) {
+    open_wal(SyncPolicy::Group);
+    
+    constexpr int kThreads = 4;
+    constexpr int kCommits = 20;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < kCommits; ++i) {
+                Lsn lsn = commit(static_cast<TxnId>(t + 1));
+                EXPECT_GT(wal_->flushed_lsn(), lsn);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    // Попутчики лидера не делают собственный fdatasync
+    EXPECT_LT(wal_->sync_latency().count.load(), static_cast<uint64_t>(kThreads * kCommits));
+}
+
+TEST_F(WALWriterTest, IntervalSyncsInBackground) {
+    open_wal(SyncPolicy::Interval);
+    
+    Lsn lsn = commit(1);
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (wal_->flushed_lsn() <= lsn && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GT(wal_->flushed_lsn(), lsn);
+    EXPECT_GE(wal_->sync_latency().count.load(), 1u);
+}
+
+// ==============================================================================
+// Group Commit
+// ==============================================================================
+
+TEST_F(WALWriterTest, ConcurrentCommitsShareFlushes) {
+    open_wal(SyncPolicy::PerCommit);
+    
+    constexpr int kThreads = 8;
+    constexpr int kCommits = 50;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < kCommits; ++i) {
+                Lsn lsn = commit(static_cast<TxnId>(t + 1));
+                EXPECT_GT(wal_->flushed_lsn(), lsn);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    // Flusher забирает commit'ы, накопившиеся за время предыдущего fdatasync
+    EXPECT_LT(wal_->flush_count(), static_cast<uint64_t>(kThreads * kCommits));
+    EXPECT_EQ(wal_->flushed_lsn(), wal_->current_lsn());
+}
+
+TEST_F(WALWriterTest, GroupCommitReportsSyncFailure) {
+    open_wal(SyncPolicy::Group);
+    commit(1);
+    
+    // Все участники группы узнают, что их общий fdatasync не прошёл
+    fail_fdatasync.store(true);
+    constexpr int kThreads = 4;
+    std::atomic<int> failed{0};
+    std::vector<Lsn> lsns(kThreads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&, t] {
+            LogRecord record;
+            record.type = LogRecordType::TXN_COMMIT;
+            record.txn_id = static_cast<TxnId>(t + 2);
+            lsns[t] = wal_->append(record);
+            if (!wal_->force(lsns[t])) {
+                failed.fetch_add(1);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    EXPECT_EQ(failed.load(), kThreads);
+    for (Lsn lsn : lsns) {
+        EXPECT_LE(wal_->flushed_lsn(), lsn);
+    }
+    
+    // После сбоя лог не продолжается: следующий commit тоже не durable
+    fail_fdatasync.store(false);
+    LogRecord record;
+    record.type = LogRecordType::TXN_COMMIT;
+    record.txn_id = 10;
+    EXPECT_FALSE(wal_->force(wal_->append(record)));
+}
+
+TEST_F(WALWriterTest, FlusherRotatesSegments) {
+    open_wal(SyncPolicy::PerCommit, 4096);
+    
+    Lsn expected = WriteAheadLog::FIRST_LSN;
+    Lsn last = INVALID_LSN;
+    for (int i = 0; i < 200; ++i) {
+        LogRecord record;
+        record.type = LogRecordType::INSERT;
+        record.txn_id = 1;
+        record.data.resize(100, 'S');
+        last = wal_->append(record);
+        ASSERT_EQ(last, expected);
+        expected += WriteAheadLog::aligned_size(record.serialized_size());
+    }
+    wal_->force(last);
+    EXPECT_GT(wal_->flushed_lsn(), last);
+    
+    // Сегменты всегда полного размера; заполненность — по LSN
+    std::size_t segments = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(test_dir_)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("wal_", 0) == 0 &&
+            name.find_first_not_of("0123456789", 4) == std::string::npos) {
+            ++segments;
+            EXPECT_EQ(entry.file_size(), 4096u);
+        }
+    }
+    EXPECT_GT(segments, 1u);
+    EXPECT_EQ(wal_->current_lsn(), expected);
+}
+
+// ==============================================================================
+// Segment Preallocation
+// ==============================================================================
+
+TEST_F(WALWriterTest, SegmentsArePreparedAhead) {
+    open_wal(SyncPolicy::PerCommit, 4096);
+    commit(1);
+    
+    // Следующие сегменты готовит фоновый поток: полного размера, в нулях
+    auto prepared = [&](uint64_t segment_id) {
+        auto path = test_dir_ / ("wal_" + std::to_string(segment_id));
+        for (int attempt = 0; attempt < 1000 && !std::filesystem::exists(path); ++attempt) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return path;
+    };
+    for (uint64_t segment_id = 1; segment_id <= WriteAheadLog::PREPARED_SEGMENTS; ++segment_id) {
+        auto path = prepared(segment_id);
+        ASSERT_TRUE(std::filesystem::exists(path));
+        EXPECT_EQ(std::filesystem::file_size(path), 4096u);
+        
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> content(4096);
+        in.read(content.data(), static_cast<std::streamsize>(content.size()));
+        EXPECT_EQ(std::count(content.begin(), content.end(), '\0'), 4096);
+    }
+    
+    // Ротация сдвигает окно подготовки
+    while (wal_->current_lsn() < 4096 + WriteAheadLog::FIRST_LSN) {
+        commit(2);
+    }
+    EXPECT_TRUE(std::filesystem::exists(prepared(1 + WriteAheadLog::PREPARED_SEGMENTS)));
+}
+
+// ==============================================================================
+// Lock-free Log Buffer
+// ==============================================================================
+
+TEST_F(WALWriterTest, ConcurrentAppendsAreContiguous) {
+    open_wal(SyncPolicy::None);
+    
+    constexpr int kThreads = 8;
+    constexpr int kRecords = 500;
+    std::vector<std::vector<Lsn>> lsns(kThreads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < kRecords; ++i) {
+                LogRecord record;
+                record.type = LogRecordType::INSERT;
+                record.txn_id = static_cast<TxnId>(t + 1);
+                record.data.resize(40, 'L');
+                lsns[t].push_back(wal_->append(record));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    std::vector<Lsn> all;
+    for (const auto& thread_lsns : lsns) {
+        all.insert(all.end(), thread_lsns.begin(), thread_lsns.end());
+    }
+    std::sort(all.begin(), all.end());
+    wal_->force(all.back());
+    EXPECT_EQ(wal_->flushed_lsn(), wal_->current_lsn());
+    
+    // Записи идут встык: LSN — смещение в потоке, с которого читается
+    // заголовок записи (первые 4 байта — её размер)
+    LogRecord sample;
+    sample.type = LogRecordType::INSERT;
+    sample.txn_id = 1;
+    sample.data.resize(40, 'L');
+    Lsn step = WriteAheadLog::aligned_size(sample.serialized_size());
+    ASSERT_EQ(all.size(), static_cast<std::size_t>(kThreads * kRecords));
+    EXPECT_EQ(all.front(), WriteAheadLog::FIRST_LSN);
+    
+    std::ifstream in(test_dir_ / "wal_0", std::ios::binary);
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        if (i > 0) {
+            ASSERT_EQ(all[i], all[i - 1] + step);
+        }
+        uint32_t stored = 0;
+        in.seekg(static_cast<std::streamoff>(all[i]));
+        in.read(reinterpret_cast<char*>(&stored), sizeof(stored));
+        ASSERT_EQ(stored, sample.serialized_size());
+    }
+}
+
+TEST_F(WALWriterTest, RecordsWrapLogBuffer) {
+    open_wal(SyncPolicy::Group, 4 * 1024 * 1024);
+    
+    // Втрое больше кольца: записи переходят через его край
+    Lsn last = INVALID_LSN;
+    while (wal_->current_lsn() < 3 * WriteAheadLog::RING_SIZE) {
+        LogRecord record;
+        record.type = LogRecordType::INSERT;
+        record.txn_id = 1;
+        record.data.resize(60000, 'R');
+        last = wal_->append(record);
+        ASSERT_NE(last, INVALID_LSN);
+    }
+    wal_->force(last);
+    EXPECT_EQ(wal_->flushed_lsn(), wal_->current_lsn());
+    
+    // Последняя запись читается из сегментов целиком
+    LogReader reader(test_dir_, 4 * 1024 * 1024);
+    LogRecord record;
+    ASSERT_TRUE(reader.read(last, record));
+    EXPECT_EQ(record.data.size(), 60000u);
+    EXPECT_EQ(record.data.back(), 'R');
+}
+
+// ==============================================================================
+// Active Transactions
+// ==============================================================================
+
+TEST_F(WALWriterTest, ActiveTransactionsAreReadFromLog) {
+    open_wal(SyncPolicy::None, 4096);
+    
+    auto append = [&](LogRecordType type, TxnId txn_id) {
+        LogRecord record;
+        record.type = type;
+        record.txn_id = txn_id;
+        record.data.resize(64, 'T');
+        return wal_->append(record);
+    };
+    
+    Lsn first = append(LogRecordType::TXN_BEGIN, 1);
+    append(LogRecordType::TXN_BEGIN, 2);
+    append(LogRecordType::TXN_COMMIT, 2);
+    
+    // Записи транзакции 1 — в сегментах, которые truncate_before удалит
+    Lsn last = INVALID_LSN;
+    while (wal_->current_lsn() < 3 * 4096) {
+        last = append(LogRecordType::INSERT, 1);
+    }
+    wal_->force(last);
+    wal_->truncate_before(2 * 4096);
+    
+    Lsn begin = wal_->write_checkpoint_begin();
+    Lsn after = append(LogRecordType::TXN_BEGIN, 3);
+    
+    std::vector<ActiveTxn> txns;
+    ASSERT_TRUE(wal_->active_transactions(begin, txns));
+    ASSERT_EQ(txns.size(), 1u);
+    EXPECT_EQ(txns[0].txn_id, 1u);
+    EXPECT_EQ(txns[0].first_lsn, first);
+    EXPECT_EQ(txns[0].last_lsn, last);
+    
+    // Следующий снимок дочитывает лог с места предыдущего
+    append(LogRecordType::TXN_COMMIT, 1);
+    ASSERT_TRUE(wal_->active_transactions(wal_->current_lsn(), txns));
+    ASSERT_EQ(txns.size(), 1u);
+    EXPECT_EQ(txns[0].txn_id, 3u);
+    EXPECT_EQ(txns[0].first_lsn, after);
+}